@@ -0,0 +1,164 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.cpp
+//
+// Identification: src/buffer/arc_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/arc_replacer.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ARCReplacer::ARCReplacer(size_t num_frames) : capacity_(num_frames), frames_(num_frames) {}
+
+auto ARCReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock sl(latch_);
+  if (curr_size_ == 0) {
+    return false;
+  }
+  // T1超过目标大小时从T1驱逐，否则从T2驱逐；首选的链表里没有可驱逐的frame时退回到另一个
+  const ListType preferred = !t1_.empty() && t1_.size() > target_t1_ ? ListType::T1 : ListType::T2;
+  const ListType other = preferred == ListType::T1 ? ListType::T2 : ListType::T1;
+  const bool evicted = EvictFrom(preferred, frame_id) || EvictFrom(other, frame_id);
+  BUSTUB_ASSERT(evicted, "curr_size_ > 0 but no evictable frame");
+  curr_size_--;
+  TrimGhosts();
+  return true;
+}
+
+auto ARCReplacer::EvictFrom(ListType list, frame_id_t *frame_id) -> bool {
+  auto &frames = ListOf(list);
+  for (auto it = frames.begin(); it != frames.end(); ++it) {
+    auto &entry = frames_[*it];
+    if (!entry.evictable_) {
+      continue;
+    }
+    if (entry.page_id_ != INVALID_PAGE_ID) {
+      (list == ListType::T1 ? b1_ : b2_).Push(entry.page_id_);
+    }
+    *frame_id = *it;
+    entry = FrameEntry{};
+    frames.erase(it);
+    return true;
+  }
+  return false;
+}
+
+void ARCReplacer::TrimGhosts() {
+  while (t1_.size() + b1_.Size() > capacity_ && b1_.Size() > 0) {
+    b1_.PopOldest();
+  }
+  while (t1_.size() + t2_.size() + b1_.Size() + b2_.Size() > 2 * capacity_) {
+    if (b2_.Size() > 0) {
+      b2_.PopOldest();
+    } else {
+      b1_.PopOldest();
+    }
+  }
+}
+
+void ARCReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (entry.list_ != ListType::NONE) {
+    // 命中：移到T2的MRU端
+    ListOf(entry.list_).erase(entry.pos_);
+    entry.list_ = ListType::T2;
+    entry.pos_ = t2_.insert(t2_.end(), frame_id);
+    return;
+  }
+
+  entry.page_id_ = page_id;
+  entry.evictable_ = true;
+  curr_size_++;
+  const size_t b1_size = b1_.Size();
+  const size_t b2_size = b2_.Size();
+  if (page_id != INVALID_PAGE_ID && b1_.Erase(page_id)) {
+    // 命中B1：T1太小了，调大目标
+    target_t1_ = std::min(capacity_, target_t1_ + std::max<size_t>(1, b2_size / b1_size));
+    entry.list_ = ListType::T2;
+  } else if (page_id != INVALID_PAGE_ID && b2_.Erase(page_id)) {
+    // 命中B2：T2太小了，调小目标
+    const size_t delta = std::max<size_t>(1, b1_size / b2_size);
+    target_t1_ = target_t1_ > delta ? target_t1_ - delta : 0;
+    entry.list_ = ListType::T2;
+  } else {
+    entry.list_ = ListType::T1;
+  }
+  auto &frames = ListOf(entry.list_);
+  entry.pos_ = frames.insert(frames.end(), frame_id);
+  TrimGhosts();
+}
+
+void ARCReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (entry.list_ == ListType::NONE || entry.evictable_ == set_evictable) {
+    return;
+  }
+  entry.evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void ARCReplacer::Remove(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (entry.list_ == ListType::NONE) {
+    return;
+  }
+  if (entry.evictable_) {
+    curr_size_--;
+  }
+  ListOf(entry.list_).erase(entry.pos_);
+  entry = FrameEntry{};
+}
+
+auto ARCReplacer::Size() -> size_t {
+  std::scoped_lock sl(latch_);
+  return curr_size_;
+}
+
+auto ARCReplacer::EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> {
+  std::scoped_lock sl(latch_);
+  const ListType preferred = !t1_.empty() && t1_.size() > target_t1_ ? ListType::T1 : ListType::T2;
+  const ListType other = preferred == ListType::T1 ? ListType::T2 : ListType::T1;
+  std::vector<frame_id_t> frames;
+  for (ListType list : {preferred, other}) {
+    for (auto it = ListOf(list).begin(); it != ListOf(list).end() && frames.size() < max_cnt; ++it) {
+      if (frames_[*it].evictable_) {
+        frames.push_back(*it);
+      }
+    }
+  }
+  return frames;
+}
+
+void ARCReplacer::Resize(size_t num_frames) {
+  std::scoped_lock sl(latch_);
+  for (size_t i = num_frames; i < frames_.size(); i++) {
+    BUSTUB_ASSERT(frames_[i].list_ == ListType::NONE, "frames dropped by Resize must not be tracked");
+  }
+  frames_.resize(num_frames);
+  capacity_ = num_frames;
+  target_t1_ = std::min(target_t1_, capacity_);
+  // 缓存变小后幽灵列表也要跟着缩
+  TrimGhosts();
+}
+
+}  // namespace bustub
@@ -0,0 +1,42 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_manager.cpp
+//
+// Identification: src/buffer/buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_manager.h"
+
+namespace bustub {
+
+auto BufferPoolManager::RegisterTag(const std::string &name) -> BufferPoolTag {
+  std::scoped_lock sl(tag_latch_);
+  if (tag_names_.size() >= BUFFER_POOL_MAX_TAGS) {
+    return {};
+  }
+  tag_names_.push_back(name);
+  return BufferPoolTag(static_cast<uint32_t>(tag_names_.size() - 1));
+}
+
+auto BufferPoolManager::GetStats() -> BufferPoolStats {
+  auto counters = GetTagCounters();
+  BufferPoolStats stats;
+  for (const auto &tag_counters : counters) {
+    stats.total_ += tag_counters;
+  }
+  if (!counters.empty()) {
+    stats.untagged_ = counters[0];
+  }
+  std::scoped_lock sl(tag_latch_);
+  for (size_t id = 1; id < tag_names_.size(); id++) {
+    stats.tags_.emplace_back(tag_names_[id], id < counters.size() ? counters[id] : BufferPoolCounters{});
+  }
+  return stats;
+}
+
+}  // namespace bustub
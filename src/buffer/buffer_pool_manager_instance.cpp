@@ -11,27 +11,69 @@
 //===----------------------------------------------------------------------===//
 
 #include "buffer/buffer_pool_manager_instance.h"
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <tuple>
+#include <utility>
+
 #include "common/exception.h"
 #include "common/macros.h"
 
 namespace bustub {
 
 BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k,
-                                                     LogManager *log_manager)
-    : pool_size_(pool_size), disk_manager_(disk_manager), log_manager_(log_manager) {
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : BufferPoolManagerInstance(pool_size, 1, 0, disk_manager, replacer_k, log_manager, replacer_type) {}
+
+BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                                                     DiskManager *disk_manager, size_t replacer_k,
+                                                     LogManager *log_manager, ReplacerType replacer_type)
+    : pool_size_(pool_size),
+      num_instances_(num_instances),
+      instance_index_(instance_index),
+      next_page_id_(static_cast<page_id_t>(instance_index)),
+      disk_manager_(disk_manager),
+      log_manager_(log_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "If BPI is not part of a pool, then the pool size should just be 1");
+  BUSTUB_ASSERT(
+      instance_index < num_instances,
+      "BPI index cannot be greater than the number of BPIs in the pool. In non-parallel case, index should just be 0.");
   /**
    * 对BufferPoolManager进行初始化操作
    */
-  // 初始化page数组，连续的内存
-  pages_ = new Page[pool_size_];
+  // 初始化page数组，第一块连续的内存；Resize时再按块追加
+  frame_chunks_.push_back(MakeFrameChunk(0, pool_size));
+  for (auto &page : frame_chunks_.back().pages_) {
+    pages_.push_back(&page);
+  }
   // 初始化page_id -> frame_id 的 映射表
   page_table_ = new ExtendibleHashTable<page_id_t, frame_id_t>(bucket_size_);
-  // LRUK缓存策略
-  replacer_ = new LRUKReplacer(pool_size, replacer_k);
+  // 缓存替换策略，默认LRU-K
+  replacer_ = MakeReplacer(replacer_type, pool_size, replacer_k);
+  // 标记每个frame是否正在读盘/写回
+  io_in_progress_.resize(pool_size_, false);
+  // 被扫描借走的环形缓冲frame不在replacer里，记录它属于哪个strategy
+  frame_owner_.resize(pool_size_, nullptr);
   // free_list 存放了所有可用的frame_id
   for (size_t i = 0; i < pool_size_; ++i) {
     free_list_.emplace_back(static_cast<int>(i));
   }
+  // 主记录里有本分片的空闲页表槽位，说明这个文件的页是本分片分配和回收的：
+  // 文件里已有的页都分配过，新页从文件末尾之后本分片的第一个页号开始，再读回上次FlushAllPages写盘的空闲页表
+  if (disk_manager_->ReadFreePageMapRoot(instance_index_, &free_page_map_root_)) {
+    const page_id_t page_cnt = disk_manager_->GetNumPages();
+    const auto n = static_cast<page_id_t>(num_instances_);
+    const auto index = static_cast<page_id_t>(instance_index_);
+    next_page_id_ = page_cnt + (index - page_cnt % n + n) % n;
+    free_page_map_ = FreePageMap::Load(disk_manager_, free_page_map_root_, page_cnt);
+    free_page_map_.Retain([n, index](page_id_t page_id) { return page_id % n == index; });
+    if (free_page_map_.Size() == 0) {
+      // 读出来的链表不完整时当作没有写盘的表
+      free_page_map_root_ = INVALID_PAGE_ID;
+    }
+  }
 
   // TODO(students): remove this line after you have implemented the buffer pool
   // manager throw NotImplementedException(
@@ -40,90 +82,284 @@ BufferPoolManagerInstance::BufferPoolManagerInstance(size_t pool_size, DiskManag
   //     `buffer_pool_manager_instance.cpp`.");
 }
 
+auto BufferPoolManagerInstance::MakeFrameChunk(size_t first_frame, size_t frame_cnt) -> FrameChunk {
+  FrameChunk chunk{first_frame, FrameMemory(frame_cnt, BUFFER_POOL_HUGE_PAGES), {}};
+  // 页数据按页大小对齐放在一整块内存里，打开O_DIRECT时可以直接作为读写的缓冲区
+  for (size_t i = 0; i < frame_cnt; i++) {
+    chunk.pages_.emplace_back(chunk.memory_.GetFrame(i));
+  }
+  return chunk;
+}
+
 BufferPoolManagerInstance::~BufferPoolManagerInstance() {
-  delete[] pages_;
+  StopBackgroundWriter();
+  StopPrefetcher();
   delete page_table_;
-  delete replacer_;
 }
 
 auto BufferPoolManagerInstance::NewPgImp(page_id_t *page_id) -> Page * {
-  latch_.lock();
-  // 如果没有可以使用的页框 且 没有可驱逐的页面，则直接返回
-  if (this->free_list_.empty() && this->replacer_->Size() == 0) {
-    latch_.unlock();
+  std::unique_lock lock(latch_);
+  return CreatePage(&lock, INVALID_PAGE_ID, page_id);
+}
+
+auto BufferPoolManagerInstance::NewPgInExtentImp(page_id_t page_id) -> Page * {
+  ValidatePageId(page_id);
+  std::unique_lock lock(latch_);
+  frame_id_t frame_id;
+  if (page_table_->Find(page_id, frame_id) || writing_back_.count(page_id) > 0) {
+    // 区段里前面的页被扫描时，预读可能已经把这一页（还没写过，读出来全是0）读了进来，走读页的路径拿到后清零；
+    // 别的线程可能正拿着读锁看这一页，清零要持写锁，清零后和新建的页一样是脏的
+    lock.unlock();
+    Page *page = FetchPageImpl(page_id, nullptr, BufferPoolTag{});
+    if (page != nullptr) {
+      page->WLatch();
+      page->ResetMemory();
+      page->WUnlatch();
+      lock.lock();
+      page->is_dirty_ = true;
+      page->disk_lsn_ = NewPageDiskLsn();
+    }
+    return page;
+  }
+  // 预读进来又被换出的那份副本可能还在压缩层里
+  compressed_tier_.Erase(page_id);
+  return CreatePage(&lock, page_id, &page_id);
+}
+
+auto BufferPoolManagerInstance::CreatePage(std::unique_lock<std::mutex> *lock, page_id_t page_id,
+                                           page_id_t *new_page_id) -> Page * {
+  frame_id_t frame_id;
+  page_id_t victim_page_id;
+  bool victim_dirty;
+  if (!AcquireFrame(&frame_id, &victim_page_id, &victim_dirty, BufferPoolTag{})) {
     return nullptr;
   }
-  frame_id_t f_id;
-  if (!this->free_list_.empty()) {
-    // 首先考虑从空闲框中创建一个页
-    f_id = this->free_list_.back();
-    this->free_list_.pop_back();
-    page_id_t new_page_id = AllocatePage();  // 分配一个新的page_id
-    page_table_->Insert(new_page_id, f_id);
-    pages_[f_id].page_id_ = new_page_id;
-    replacer_->RecordAccess(f_id);
-    replacer_->SetEvictable(f_id, false);
-    pages_[f_id].pin_count_++;
-    *page_id = new_page_id;
-    latch_.unlock();
-    return &pages_[f_id];
+  *new_page_id = page_id == INVALID_PAGE_ID ? AllocatePage() : page_id;
+  InstallPage(frame_id, *new_page_id, true);
+
+  // 放锁之后pages_可能被Resize扩容，先取出页指针；frame本身不会移动
+  Page *page = pages_[frame_id];
+  if (victim_page_id == INVALID_PAGE_ID) {
+    // 没有脏页需要写回，新页只需清零，不值得为此放锁
+    page->ResetMemory();
+    page->disk_lsn_ = NewPageDiskLsn();
+    return page;
   }
-  // 如果free_list中没有，那么我们就驱逐一个页
-  replacer_->Evict(&f_id);
-  page_id_t p_id = this->pages_[f_id].GetPageId();
-  latch_.unlock();
-  this->DeletePgImp(p_id);
-  return NewPgImp(page_id);
+  io_in_progress_[frame_id] = true;
+  lock->unlock();
+  EvictVictim(page, victim_page_id, victim_dirty, true, BufferPoolTag{});
+  page->ResetMemory();
+  lock->lock();
+  FinishFrameIo(frame_id, victim_page_id);
+  page->disk_lsn_ = NewPageDiskLsn();
+  return page;
 }
 
 auto BufferPoolManagerInstance::FetchPgImp(page_id_t page_id) -> Page * {
-  latch_.lock();
+  return FetchPageImpl(page_id, nullptr, BufferPoolTag{});
+}
+
+auto BufferPoolManagerInstance::FetchPgTaggedImp(page_id_t page_id, BufferAccessStrategy *strategy, BufferPoolTag tag)
+    -> Page * {
+  return FetchPageImpl(page_id, strategy, tag);
+}
+
+auto BufferPoolManagerInstance::FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  return FetchPageImpl(page_id, strategy, BufferPoolTag{});
+}
 
+auto BufferPoolManagerInstance::FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy, BufferPoolTag tag)
+    -> Page * {
+  std::unique_lock lock(latch_);
   frame_id_t frame_id;
+  while (true) {
+    if (page_table_->Find(page_id, frame_id)) {
+      // 先pin住，这样即使该页还在读盘，frame也不会被别人换掉；等读盘的线程完成I/O后再返回
+      // 环形缓冲里的frame不归replacer管；带strategy的访问不计入访问历史，扫描不会把页变"热"
+      if (frame_owner_[frame_id] == nullptr) {
+        if (strategy == nullptr) {
+          replacer_->RecordAccess(frame_id, page_id);
+        }
+        replacer_->SetEvictable(frame_id, false);
+      }
+      pages_[frame_id]->pin_count_++;
+      metrics_.Add(tag, BufferPoolMetrics::Counter::HIT);
+      if (io_in_progress_[frame_id]) {
+        metrics_.Add(tag, BufferPoolMetrics::Counter::PIN_WAIT);
+        io_cv_.wait(lock, [&] { return !io_in_progress_[frame_id]; });
+      }
+      return pages_[frame_id];
+    }
+    if (writing_back_.count(page_id) == 0) {
+      break;
+    }
+    // 该页刚被换出，脏数据还在写回磁盘的路上，此时读盘会读到旧数据，等写回完成再重试
+    metrics_.Add(tag, BufferPoolMetrics::Counter::PIN_WAIT);
+    io_cv_.wait(lock);
+  }
 
-  bool find_able = page_table_->Find(page_id, frame_id);
-  if (find_able) {
-    this->replacer_->RecordAccess(frame_id);
-    this->pages_[frame_id].pin_count_++;
-    this->replacer_->SetEvictable(frame_id, false);
-    latch_.unlock();
-    return &this->pages_[frame_id];
+  metrics_.Add(tag, BufferPoolMetrics::Counter::MISS);
+  if (!LoadPage(&lock, page_id, &frame_id, strategy, tag)) {
+    return nullptr;
   }
-  // 如果根本没有缓存这个page
+  return pages_[frame_id];
+}
 
-  // 1. 从free_list中寻找空位，然后将其加入到缓存池中
-  if (!free_list_.empty()) {
-    frame_id = free_list_.back();
-    free_list_.pop_back();
-    // 有了空位之后然后开始读取
-    disk_manager_->ReadPage(page_id, this->pages_[frame_id].GetData());
-    this->pages_[frame_id].page_id_ = page_id;
-    // 加入到映射中
-    page_table_->Insert(page_id, frame_id);
-    // 读取完之后pincount++就可以直接返回了
-    this->replacer_->RecordAccess(frame_id);
-    this->pages_[frame_id].pin_count_++;
-    this->replacer_->SetEvictable(frame_id, false);
+auto BufferPoolManagerInstance::LoadPage(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t *frame_id,
+                                         BufferAccessStrategy *strategy, BufferPoolTag tag) -> bool {
+  page_id_t victim_page_id;
+  bool victim_dirty;
+  const bool ring_frame =
+      strategy != nullptr && AcquireRingFrame(strategy, frame_id, &victim_page_id, &victim_dirty, tag);
+  if (!ring_frame && !AcquireFrame(frame_id, &victim_page_id, &victim_dirty, tag)) {
+    return false;
+  }
+  InstallPage(*frame_id, page_id, !ring_frame);
+  io_in_progress_[*frame_id] = true;
+  Page *page = pages_[*frame_id];
+
+  lock->unlock();
+  if (victim_page_id != INVALID_PAGE_ID) {
+    EvictVictim(page, victim_page_id, victim_dirty, !ring_frame, tag);
+  }
+  // 先查压缩层，命中就不用读盘；命中的副本从压缩层里取走了
+  if (!compressed_tier_.Get(page_id, page->GetData())) {
+    BUSTUB_ENSURE(disk_manager_->ReadPage(page_id, page->GetData()), "failed to read the page");
+  }
+  lock->lock();
+  FinishFrameIo(*frame_id, victim_page_id);
+  return true;
+}
+
+void BufferPoolManagerInstance::LoadPages(std::unique_lock<std::mutex> *lock, const std::vector<PendingLoad> &loads,
+                                          BufferPoolTag tag) {
+  lock->unlock();
+  // 换出的脏页一起写回；写完之后才能把frame交给压缩层和读盘
+  std::vector<DiskRequest> writes;
+  lsn_t max_lsn = INVALID_LSN;
+  for (const auto &load : loads) {
+    if (load.victim_dirty_) {
+      writes.push_back({true, load.victim_page_id_, load.page_->GetData(), {}});
+      max_lsn = std::max(max_lsn, load.page_->GetLSN());
+    }
+  }
+  if (!writes.empty()) {
+    ForceLogUpTo(max_lsn);
+    const size_t write_cnt = writes.size();
+    // 换出的页写不回去的话，frame马上会被新页覆盖，这一页的修改就丢了
+    BUSTUB_ENSURE(disk_manager_->ScheduleAndWait(std::move(writes)), "failed to write back the evicted pages");
+    foreground_writes_ += write_cnt;
+    metrics_.Add(tag, BufferPoolMetrics::Counter::DIRTY_WRITE, write_cnt);
+  }
+  // 压缩层里没有的页按page id顺序一起读
+  std::vector<DiskRequest> reads;
+  for (const auto &load : loads) {
+    if (load.victim_page_id_ != INVALID_PAGE_ID) {
+      compressed_tier_.Put(load.victim_page_id_, load.page_->GetData());
+    }
+    if (!compressed_tier_.Get(load.page_id_, load.page_->GetData())) {
+      reads.push_back({false, load.page_id_, load.page_->GetData(), {}});
+    }
+  }
+  std::sort(reads.begin(), reads.end(),
+            [](const DiskRequest &a, const DiskRequest &b) { return a.page_id_ < b.page_id_; });
+  BUSTUB_ENSURE(disk_manager_->ScheduleAndWait(std::move(reads)), "failed to read the pages");
+  lock->lock();
+  for (const auto &load : loads) {
+    FinishFrameIo(load.frame_id_, load.victim_page_id_);
+  }
+}
 
-    latch_.unlock();
-    return &this->pages_[frame_id];
+auto BufferPoolManagerInstance::FetchPagesImp(const std::vector<page_id_t> &page_ids, BufferPoolTag tag)
+    -> std::vector<Page *> {
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  std::vector<PendingLoad> misses;
+  // 命中但可能还在做I/O的frame，读完自己的页之后再等
+  std::vector<frame_id_t> hits;
+  // 刚被换出、还在写回的页，最后单独走FetchPage
+  std::vector<size_t> deferred;
+
+  std::unique_lock lock(latch_);
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    const page_id_t page_id = page_ids[i];
+    frame_id_t frame_id;
+    if (page_table_->Find(page_id, frame_id)) {
+      if (frame_owner_[frame_id] == nullptr) {
+        replacer_->RecordAccess(frame_id, page_id);
+        replacer_->SetEvictable(frame_id, false);
+      }
+      pages_[frame_id]->pin_count_++;
+      pages[i] = pages_[frame_id];
+      hits.push_back(frame_id);
+      metrics_.Add(tag, BufferPoolMetrics::Counter::HIT);
+      continue;
+    }
+    if (writing_back_.count(page_id) > 0) {
+      deferred.push_back(i);
+      continue;
+    }
+    metrics_.Add(tag, BufferPoolMetrics::Counter::MISS);
+    PendingLoad miss{page_id, INVALID_PAGE_ID, nullptr, INVALID_PAGE_ID, false};
+    if (!AcquireFrame(&miss.frame_id_, &miss.victim_page_id_, &miss.victim_dirty_, tag)) {
+      // 所有frame都被pin住了，剩下的缺页都拿不到frame
+      continue;
+    }
+    // 和LoadPage一样先映射、pin住并标记I/O；同一批里重复的页会在上面命中
+    InstallPage(miss.frame_id_, page_id, true);
+    io_in_progress_[miss.frame_id_] = true;
+    miss.page_ = pages_[miss.frame_id_];
+    pages[i] = miss.page_;
+    misses.push_back(miss);
   }
 
-  if (this->replacer_->Size() > 0) {
-    // 如果有可以驱逐的，则先驱逐掉原来的page，然后重新读取数据进page中
-    this->replacer_->Evict(&frame_id);
+  if (!misses.empty()) {
+    LoadPages(&lock, misses, tag);
+  }
+  for (auto frame_id : hits) {
+    if (io_in_progress_[frame_id]) {
+      metrics_.Add(tag, BufferPoolMetrics::Counter::PIN_WAIT);
+      io_cv_.wait(lock, [&] { return !io_in_progress_[frame_id]; });
+    }
+  }
+  lock.unlock();
 
-    page_id_t old_page = this->pages_[frame_id].GetPageId();
-    latch_.unlock();
-    this->DeletePgImp(old_page);
-    return FetchPgImp(page_id);
+  for (auto i : deferred) {
+    pages[i] = FetchPageImpl(page_ids[i], nullptr, tag);
   }
-  latch_.unlock();
-  return nullptr;
+  return pages;
+}
+
+void BufferPoolManagerInstance::ReleaseStrategy(BufferAccessStrategy *strategy) {
+  std::scoped_lock sl(latch_);
+  auto &ring = strategy->GetRing(instance_index_);
+  for (auto frame_id : ring.frames_) {
+    frame_owner_[frame_id] = nullptr;
+    Page &page = *pages_[frame_id];
+    if (page.page_id_ == INVALID_PAGE_ID) {
+      free_list_.push_back(frame_id);
+      continue;
+    }
+    // 交还给replacer：只记一次访问，在LRU-K里是最冷的一批，会被优先换出
+    replacer_->RecordAccess(frame_id, page.page_id_);
+    replacer_->SetEvictable(frame_id, page.pin_count_ == 0);
+  }
+  ring.frames_.clear();
+  ring.next_ = 0;
 }
 
 auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
   std::scoped_lock sl(this->latch_);
+  return UnpinPageLocked(page_id, is_dirty);
+}
+
+void BufferPoolManagerInstance::UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) {
+  std::scoped_lock sl(latch_);
+  for (const auto &[page_id, is_dirty] : pages) {
+    UnpinPageLocked(page_id, is_dirty);
+  }
+}
+
+auto BufferPoolManagerInstance::UnpinPageLocked(page_id_t page_id, bool is_dirty) -> bool {
   frame_id_t frame_id;
   bool find_able = page_table_->Find(page_id, frame_id);
   if (!find_able) {
@@ -131,43 +367,115 @@ auto BufferPoolManagerInstance::UnpinPgImp(page_id_t page_id, bool is_dirty) ->
     return false;
   }
   // 先看pin值是否为0，如果为0则直接返回
-  if (this->pages_[frame_id].pin_count_ > 0) {
-    this->pages_[frame_id].pin_count_--;
-    this->pages_[frame_id].is_dirty_ |= is_dirty;
-  } else {
-    this->pages_[frame_id].is_dirty_ |= is_dirty;
+  this->pages_[frame_id]->is_dirty_ |= is_dirty;
+  if (this->pages_[frame_id]->pin_count_ <= 0) {
     return false;
   }
-  // 更新完pin数值之后，然后对更新evictable
-  if (this->pages_[frame_id].pin_count_ == 0) {
-    this->pages_[frame_id].is_dirty_ |= is_dirty;
-    this->replacer_->SetEvictable(frame_id, true);
-  }
+  // 更新pin数值，降到0时更新evictable
+  ReleasePin(frame_id);
   return true;
 }
 
 auto BufferPoolManagerInstance::FlushPgImp(page_id_t page_id) -> bool {
-  std::scoped_lock sl(this->latch_);
+  std::unique_lock lock(latch_);
   frame_id_t frame_id;
   bool find_able = this->page_table_->Find(page_id, frame_id);
   // 如果这个页不存在
   if (!find_able) {
     return false;
   }
-  disk_manager_->WritePage(page_id, this->pages_[frame_id].GetData());
+  // 临时pin住frame再放锁写盘，防止写盘期间frame被换出；脏标记在写之前清除，写盘期间的修改会重新置脏
+  const bool in_replacer = frame_owner_[frame_id] == nullptr;
+  pages_[frame_id]->pin_count_++;
+  if (in_replacer) {
+    replacer_->SetEvictable(frame_id, false);
+  }
+  io_cv_.wait(lock, [&] { return !io_in_progress_[frame_id]; });
+  Page *page = pages_[frame_id];
+  page->is_dirty_ = false;
+  const lsn_t lsn = page->GetLSN();
+  lock.unlock();
 
-  this->pages_[frame_id].is_dirty_ = false;
+  ForceLogUpTo(lsn);
+  const bool written = disk_manager_->WritePage(page_id, page->GetData());
 
-  return true;
+  lock.lock();
+  // 没写成功的页还是脏的，留给下一次刷盘
+  if (written) {
+    page->disk_lsn_ = lsn;
+  } else {
+    page->is_dirty_ = true;
+  }
+  ReleasePin(frame_id);
+  return written;
 }
 
 void BufferPoolManagerInstance::FlushAllPgsImp() {
-  std::scoped_lock sl(this->latch_);
-  for (int i = 0; i < static_cast<int>(pool_size_); i++) {
-    if (this->pages_[i].GetPageId() != INVALID_PAGE_ID) {
-      this->FlushPage(this->pages_[i].GetPageId());
+  // 只写脏页，按page id排好序后相邻的页合并成一次pwritev
+  auto dirty_pages = PinDirtyPages();
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  writes.reserve(dirty_pages.size());
+  for (const auto &page : dirty_pages) {
+    writes.emplace_back(page.page_id_, page.data_);
+  }
+  disk_manager_->WritePages(std::move(writes));
+  UnpinFlushedPages(dirty_pages);
+  // 写页只到了page cache，落盘之后FlushAllPages才算完成
+  disk_manager_->Sync();
+  SaveFreePageMap();
+}
+
+auto BufferPoolManagerInstance::PinDirtyPages() -> std::vector<DirtyPage> {
+  std::vector<DirtyPage> dirty_pages;
+  lsn_t max_lsn = INVALID_LSN;
+  std::unique_lock lock(this->latch_);
+  for (size_t i = 0; i < pool_size_; i++) {
+    Page &page = *pages_[i];
+    // 正在读盘的frame刚装上新页，不会是脏的
+    if (page.page_id_ == INVALID_PAGE_ID || !page.is_dirty_) {
+      continue;
     }
+    // 和FlushPgImp一样临时pin住frame，写盘期间不会被换出
+    const auto frame_id = static_cast<frame_id_t>(i);
+    page.pin_count_++;
+    if (frame_owner_[frame_id] == nullptr) {
+      replacer_->SetEvictable(frame_id, false);
+    }
+    page.is_dirty_ = false;
+    dirty_pages.push_back({frame_id, page.page_id_, page.GetData(), page.GetLSN()});
+    max_lsn = std::max(max_lsn, page.GetLSN());
   }
+  lock.unlock();
+  // 调用方拿到之后就写盘，先把日志刷到这些页的LSN
+  ForceLogUpTo(max_lsn);
+  return dirty_pages;
+}
+
+void BufferPoolManagerInstance::UnpinFlushedPages(const std::vector<DirtyPage> &pages) {
+  std::scoped_lock sl(this->latch_);
+  for (const auto &page : pages) {
+    pages_[page.frame_id_]->disk_lsn_ = page.lsn_;
+    ReleasePin(page.frame_id_);
+  }
+}
+
+void BufferPoolManagerInstance::SaveFreePageMap() {
+  // 空闲页表也写盘；它存放在空闲页里，写盘期间AllocatePage不从表里拿页
+  FreePageMap snapshot;
+  {
+    std::scoped_lock sl(this->latch_);
+    snapshot = free_page_map_;
+    free_page_map_savers_++;
+  }
+  const page_id_t root = snapshot.Save(disk_manager_);
+  if (root != INVALID_PAGE_ID) {
+    disk_manager_->Sync();
+  }
+  std::scoped_lock sl(this->latch_);
+  free_page_map_savers_--;
+  free_page_map_root_ = root;
+  // 表的页已经落盘，再记下表头，重启时从这里读回
+  disk_manager_->WriteFreePageMapRoot(instance_index_, root);
 }
 
 auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
@@ -175,29 +483,669 @@ auto BufferPoolManagerInstance::DeletePgImp(page_id_t page_id) -> bool {
   frame_id_t frame_id;
   bool find_able = page_table_->Find(page_id, frame_id);
   if (!find_able) {
-    // 如果没有找到，则直接返回false
+    // 不在缓冲池里，只需回收磁盘上的页，压缩层里的副本一并丢掉；不是本分片分配过的页不管
+    compressed_tier_.Erase(page_id);
+    if (page_id >= 0 && page_id < next_page_id_ && static_cast<uint32_t>(page_id) % num_instances_ == instance_index_) {
+      DeallocatePage(page_id);
+    }
     return true;
   }
 
-  if (pages_[frame_id].pin_count_ > 0) {
+  // 正在做I/O的frame一定被读盘的线程pin着，这里一并拒绝
+  if (pages_[frame_id]->pin_count_ > 0) {
     return false;
   }
 
-  // 从hash中删除page_id的映射
-  if (this->pages_[frame_id].is_dirty_) {
-    FlushPgImp(page_id);
-  }
+  // 页已被删除，脏数据无需写回；从hash中删除page_id的映射，并让replacer不再追踪该frame
   page_table_->Remove(page_id);
-  this->pages_[frame_id].is_dirty_ = false;
-  // 然后将空闲的frame添加进对应的free_list中
-  free_list_.push_back(frame_id);
-  this->pages_[frame_id].is_dirty_ = false;
-  this->pages_[frame_id].page_id_ = INVALID_PAGE_ID;
-  this->pages_[frame_id].SetLSN(0);
+  if (frame_owner_[frame_id] == nullptr) {
+    replacer_->Remove(frame_id);
+    // 然后将空闲的frame添加进对应的free_list中；正在被Resize收回的frame不再放回去
+    if (static_cast<size_t>(frame_id) < pool_size_) {
+      free_list_.push_back(frame_id);
+    }
+  }
+  // 环形缓冲的frame留在环里，下次轮到它时直接复用
+  this->pages_[frame_id]->is_dirty_ = false;
+  this->pages_[frame_id]->page_id_ = INVALID_PAGE_ID;
+  this->pages_[frame_id]->ResetMemory();
   DeallocatePage(page_id);
   return true;
 }
 
-auto BufferPoolManagerInstance::AllocatePage() -> page_id_t { return next_page_id_++; }
+auto BufferPoolManagerInstance::GetFrame(frame_id_t frame_id) -> Page * {
+  std::scoped_lock sl(latch_);
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < pages_.size(), "invalid frame id");
+  return pages_[frame_id];
+}
+
+void BufferPoolManagerInstance::Resize(size_t new_size) {
+  BUSTUB_ASSERT(new_size > 0, "the buffer pool needs at least one frame");
+  std::scoped_lock resize_lock(resize_latch_);
+  // 只有Resize会改pages_的长度，持有resize_latch_时可以不加latch_读；新的一块内存在锁外分配
+  const size_t capacity = pages_.size();
+  std::optional<FrameChunk> chunk;
+  if (new_size > capacity) {
+    chunk = MakeFrameChunk(capacity, new_size - capacity);
+  }
+  // 缩容后不再使用的内存块，放锁之后再析构
+  std::vector<FrameChunk> dropped_chunks;
+
+  std::unique_lock lock(latch_);
+  const size_t old_size = pool_size_;
+  if (new_size >= old_size) {
+    if (chunk.has_value()) {
+      for (auto &page : chunk->pages_) {
+        pages_.push_back(&page);
+      }
+      frame_chunks_.push_back(std::move(*chunk));
+      io_in_progress_.resize(new_size, false);
+      frame_owner_.resize(new_size, nullptr);
+    }
+    replacer_->Resize(new_size);
+    // 上次缩容留下的frame已经清空了，和新分配的frame一起放进free_list
+    for (size_t i = old_size; i < new_size; i++) {
+      free_list_.push_back(static_cast<frame_id_t>(i));
+    }
+    pool_size_ = new_size;
+    return;
+  }
+
+  // 先改pool_size_：之后尾部的frame不会再被分配出去，unpin到0时也不再交给replacer
+  pool_size_ = new_size;
+  free_list_.remove_if([new_size](frame_id_t frame_id) { return static_cast<size_t>(frame_id) >= new_size; });
+  RetireFrames(&lock, new_size);
+  replacer_->Resize(new_size);
+  while (frame_chunks_.back().first_frame_ >= new_size) {
+    dropped_chunks.push_back(std::move(frame_chunks_.back()));
+    frame_chunks_.pop_back();
+  }
+  if (!dropped_chunks.empty()) {
+    const size_t new_capacity = dropped_chunks.back().first_frame_;
+    pages_.resize(new_capacity);
+    io_in_progress_.resize(new_capacity);
+    frame_owner_.resize(new_capacity);
+  }
+}
+
+void BufferPoolManagerInstance::RetireFrames(std::unique_lock<std::mutex> *lock, size_t new_size) {
+  for (size_t i = new_size; i < pages_.size(); i++) {
+    const auto frame_id = static_cast<frame_id_t>(i);
+    // 先全部移出replacer，否则下面放锁写盘时别的线程可能把还没处理的frame驱逐出去再用
+    // 被pin着的frame也要移出，Remove只接受可驱逐的frame
+    replacer_->SetEvictable(frame_id, true);
+    replacer_->Remove(frame_id);
+    // 环形缓冲借走的frame从环里摘下来，之后和普通frame一样处理
+    auto *strategy = frame_owner_[i];
+    if (strategy == nullptr) {
+      continue;
+    }
+    auto &ring = strategy->GetRing(instance_index_);
+    auto pos = std::find(ring.frames_.begin(), ring.frames_.end(), frame_id);
+    const auto index = static_cast<size_t>(pos - ring.frames_.begin());
+    ring.frames_.erase(pos);
+    if (ring.next_ > index) {
+      ring.next_--;
+    }
+    if (ring.next_ >= ring.frames_.size()) {
+      ring.next_ = 0;
+    }
+    frame_owner_[i] = nullptr;
+  }
+
+  while (true) {
+    bool busy = false;
+    for (size_t i = new_size; i < pages_.size(); i++) {
+      const auto frame_id = static_cast<frame_id_t>(i);
+      Page *page = pages_[i];
+      // 还被pin着（包括正在做I/O），等最后一个pin放掉，ReleasePin会唤醒这里
+      if (page->pin_count_ > 0) {
+        busy = true;
+        continue;
+      }
+      if (page->page_id_ == INVALID_PAGE_ID) {
+        continue;
+      }
+      // 和驱逐一样先解除映射；命中时可能又被RecordAccess记进了replacer，unpin时不会再设为可驱逐
+      const page_id_t page_id = page->page_id_;
+      replacer_->SetEvictable(frame_id, true);
+      replacer_->Remove(frame_id);
+      page_table_->Remove(page_id);
+      page->page_id_ = INVALID_PAGE_ID;
+      if (page->is_dirty_) {
+        // 脏页写回期间记在writing_back_里，想读这一页的线程会等写回完成
+        page->is_dirty_ = false;
+        writing_back_.insert(page_id);
+        io_in_progress_[frame_id] = true;
+        lock->unlock();
+        ForceLogUpTo(page->GetLSN());
+        BUSTUB_ENSURE(disk_manager_->WritePage(page_id, page->GetData()), "failed to write back the dropped page");
+        metrics_.Add(BufferPoolTag{}, BufferPoolMetrics::Counter::DIRTY_WRITE);
+        lock->lock();
+        FinishFrameIo(frame_id, page_id);
+      }
+      page->ResetMemory();
+    }
+    if (!busy) {
+      return;
+    }
+    io_cv_.wait(*lock);
+  }
+}
+
+auto BufferPoolManagerInstance::SnapshotResidentPages() -> PoolSnapshot {
+  std::scoped_lock sl(latch_);
+  // 可驱逐的frame按驱逐顺序排在前面，最冷的最先；被pin着的页正在用，排在最后
+  std::vector<frame_id_t> frames = replacer_->EvictionCandidates(pool_size_);
+  std::vector<bool> listed(pool_size_, false);
+  for (auto frame_id : frames) {
+    listed[frame_id] = true;
+  }
+  for (size_t i = 0; i < pool_size_; i++) {
+    if (!listed[i]) {
+      frames.push_back(static_cast<frame_id_t>(i));
+    }
+  }
+
+  PoolSnapshot snapshot;
+  for (auto frame_id : frames) {
+    const Page &page = *pages_[frame_id];
+    // 环形缓冲里是扫描读进来的页，不值得预热
+    if (page.page_id_ == INVALID_PAGE_ID || frame_owner_[frame_id] != nullptr) {
+      continue;
+    }
+    snapshot.entries_.push_back({page.page_id_, replacer_->GetAccessHistory(frame_id)});
+  }
+  return snapshot;
+}
+
+auto BufferPoolManagerInstance::WarmUp(const PoolSnapshot &snapshot, size_t thread_cnt) -> size_t {
+  struct Load {
+    size_t entry_;
+    frame_id_t frame_id_;
+    Page *page_;
+  };
+  std::vector<Load> loads;
+  // 快照可能是删掉或者换掉的数据库留下的，文件里没有的页不读，否则会装进全0的页并把next_page_id_推到文件末尾之后
+  const page_id_t page_cnt = disk_manager_->GetNumPages();
+  {
+    std::scoped_lock sl(latch_);
+    // 只用空闲frame，不为预热换出页；放不下时保留最热的，也就是列表末尾的那些
+    for (size_t i = snapshot.entries_.size(); i > 0 && !free_list_.empty(); i--) {
+      const page_id_t page_id = snapshot.entries_[i - 1].page_id_;
+      frame_id_t frame_id;
+      if (page_id < 0 || page_id >= page_cnt || static_cast<uint32_t>(page_id) % num_instances_ != instance_index_ ||
+          page_table_->Find(page_id, frame_id) || free_page_map_.IsFree(page_id)) {
+        continue;
+      }
+      frame_id = free_list_.back();
+      free_list_.pop_back();
+      // 直接读盘，压缩层里的旧副本不能留着
+      compressed_tier_.Erase(page_id);
+      // 和缺页一样先映射、pin住并标记I/O，读盘期间来取这一页的线程会等读完
+      InstallPage(frame_id, page_id, false);
+      io_in_progress_[frame_id] = true;
+      loads.push_back({i - 1, frame_id, pages_[frame_id]});
+      // 这些页上次运行时分配过，之后NewPage不能再把它们分出去
+      if (page_id >= next_page_id_) {
+        next_page_id_ = page_id + static_cast<page_id_t>(num_instances_);
+      }
+    }
+  }
+  if (loads.empty()) {
+    return 0;
+  }
+
+  // 按page id排序，每个线程顺序读连续的一段
+  auto page_id_of = [&snapshot](const Load &load) { return snapshot.entries_[load.entry_].page_id_; };
+  std::sort(loads.begin(), loads.end(), [&](const Load &a, const Load &b) { return page_id_of(a) < page_id_of(b); });
+  const size_t slice = (loads.size() + std::max<size_t>(thread_cnt, 1) - 1) / std::max<size_t>(thread_cnt, 1);
+  std::vector<std::thread> readers;
+  std::atomic<bool> read{true};
+  for (size_t begin = 0; begin < loads.size(); begin += slice) {
+    readers.emplace_back([&, begin] {
+      for (size_t i = begin; i < std::min(begin + slice, loads.size()); i++) {
+        if (!disk_manager_->ReadPage(page_id_of(loads[i]), loads[i].page_->GetData())) {
+          read = false;
+        }
+      }
+    });
+  }
+  for (auto &reader : readers) {
+    reader.join();
+  }
+  BUSTUB_ENSURE(read, "failed to read the warm-up pages");
+
+  // 按快照里从冷到热的顺序交给replacer，恢复原来的冷热顺序
+  std::sort(loads.begin(), loads.end(), [](const Load &a, const Load &b) { return a.entry_ < b.entry_; });
+  std::scoped_lock sl(latch_);
+  for (const auto &load : loads) {
+    replacer_->RestoreAccessHistory(load.frame_id_, page_id_of(load), snapshot.entries_[load.entry_].history_);
+    replacer_->SetEvictable(load.frame_id_, false);
+    FinishFrameIo(load.frame_id_, INVALID_PAGE_ID);
+    ReleasePin(load.frame_id_);
+  }
+  return loads.size();
+}
+
+void BufferPoolManagerInstance::Prefetch(page_id_t first_page_id, size_t page_cnt) {
+  std::scoped_lock sl(prefetch_latch_);
+  for (size_t i = 0; i < page_cnt && prefetch_queue_.size() < pool_size_; i++) {
+    const page_id_t page_id = first_page_id + static_cast<page_id_t>(i);
+    // 只预读已经分配过的页，否则读进来的页会和之后NewPage分配出的同一个page_id冲突
+    if (page_id < 0 || page_id >= next_page_id_) {
+      break;
+    }
+    if (static_cast<uint32_t>(page_id) % num_instances_ != instance_index_) {
+      continue;
+    }
+    prefetch_queue_.push_back(page_id);
+  }
+  if (prefetch_queue_.empty()) {
+    return;
+  }
+  if (prefetch_thread_ == nullptr) {
+    prefetch_stop_ = false;
+    prefetch_thread_ = new std::thread([this] {
+      std::unique_lock lock(prefetch_latch_);
+      while (true) {
+        prefetch_cv_.wait(lock, [this] { return prefetch_stop_ || !prefetch_queue_.empty(); });
+        if (prefetch_stop_) {
+          return;
+        }
+        // 一次取一批，让这些页的读请求同时在路上
+        const size_t batch_size = std::min(prefetch_queue_.size(), ASYNC_IO_QUEUE_DEPTH);
+        std::vector<page_id_t> page_ids(prefetch_queue_.begin(), prefetch_queue_.begin() + batch_size);
+        prefetch_queue_.erase(prefetch_queue_.begin(), prefetch_queue_.begin() + batch_size);
+        lock.unlock();
+        PrefetchPages(page_ids);
+        lock.lock();
+      }
+    });
+  }
+  prefetch_cv_.notify_one();
+}
+
+void BufferPoolManagerInstance::StopPrefetcher() {
+  std::thread *thread;
+  {
+    std::scoped_lock sl(prefetch_latch_);
+    thread = prefetch_thread_;
+    prefetch_thread_ = nullptr;
+    prefetch_stop_ = true;
+    prefetch_queue_.clear();
+  }
+  if (thread == nullptr) {
+    return;
+  }
+  prefetch_cv_.notify_all();
+  thread->join();
+  delete thread;
+}
+
+void BufferPoolManagerInstance::PrefetchPages(const std::vector<page_id_t> &page_ids) {
+  std::unique_lock lock(latch_);
+  std::vector<PendingLoad> loads;
+  for (auto page_id : page_ids) {
+    frame_id_t frame_id;
+    // 已经在缓存池里、正在写回或已被删除的页跳过；没有空闲/可驱逐的frame时放弃剩下的，预读只是一个提示
+    if (page_table_->Find(page_id, frame_id) || writing_back_.count(page_id) > 0 || free_page_map_.IsFree(page_id)) {
+      continue;
+    }
+    PendingLoad load{page_id, INVALID_PAGE_ID, nullptr, INVALID_PAGE_ID, false};
+    if (!AcquireFrame(&load.frame_id_, &load.victim_page_id_, &load.victim_dirty_, BufferPoolTag{})) {
+      break;
+    }
+    InstallPage(load.frame_id_, page_id, true);
+    io_in_progress_[load.frame_id_] = true;
+    load.page_ = pages_[load.frame_id_];
+    loads.push_back(load);
+  }
+  if (loads.empty()) {
+    return;
+  }
+  LoadPages(&lock, loads, BufferPoolTag{});
+  prefetch_reads_ += loads.size();
+  for (const auto &load : loads) {
+    ReleasePin(load.frame_id_);
+  }
+}
+
+void BufferPoolManagerInstance::StartBackgroundWriter(const BackgroundWriterOptions &options) {
+  std::scoped_lock sl(bg_writer_latch_);
+  if (bg_writer_thread_ != nullptr) {
+    return;
+  }
+  bg_writer_options_ = options;
+  bg_writer_stop_ = false;
+  bg_writer_thread_ = new std::thread([this] {
+    std::unique_lock lock(bg_writer_latch_);
+    while (!bg_writer_stop_) {
+      const BackgroundWriterOptions options = bg_writer_options_;
+      lock.unlock();
+      BackgroundWriteRound(options);
+      lock.lock();
+      bg_writer_cv_.wait_for(lock, options.interval_, [this] { return bg_writer_stop_; });
+    }
+  });
+}
+
+void BufferPoolManagerInstance::StopBackgroundWriter() {
+  std::thread *thread;
+  {
+    std::scoped_lock sl(bg_writer_latch_);
+    thread = bg_writer_thread_;
+    bg_writer_thread_ = nullptr;
+    bg_writer_stop_ = true;
+  }
+  if (thread == nullptr) {
+    return;
+  }
+  bg_writer_cv_.notify_all();
+  thread->join();
+  delete thread;
+}
+
+auto BufferPoolManagerInstance::BackgroundWriteRound(const BackgroundWriterOptions &options) -> size_t {
+  std::vector<std::tuple<frame_id_t, page_id_t, Page *>> dirty_frames;
+  {
+    std::scoped_lock sl(latch_);
+    for (auto frame_id : replacer_->EvictionCandidates(options.clean_frame_target_)) {
+      if (dirty_frames.size() >= options.max_writes_per_round_) {
+        break;
+      }
+      Page &page = *pages_[frame_id];
+      if (!page.is_dirty_) {
+        continue;
+      }
+      // 和FlushPgImp一样临时pin住frame再放锁写盘；不调用RecordAccess，写回不算一次访问，不改变冷热顺序
+      page.pin_count_++;
+      replacer_->SetEvictable(frame_id, false);
+      page.is_dirty_ = false;
+      dirty_frames.emplace_back(frame_id, page.page_id_, &page);
+    }
+  }
+  if (dirty_frames.empty()) {
+    return 0;
+  }
+
+  // 持读锁拷贝一份再写，避免写出一个正在被修改的半成品页；一次只持一个页的读锁，拷完后所有写请求一起提交
+  FrameMemory copies(dirty_frames.size());
+  std::vector<DiskRequest> writes;
+  lsn_t max_lsn = INVALID_LSN;
+  std::vector<lsn_t> copy_lsns(dirty_frames.size());
+  for (size_t i = 0; i < dirty_frames.size(); i++) {
+    Page *page = std::get<2>(dirty_frames[i]);
+    char *copy = copies.GetFrame(i);
+    page->RLatch();
+    memcpy(copy, page->GetData(), BUSTUB_PAGE_SIZE);
+    copy_lsns[i] = page->GetLSN();
+    max_lsn = std::max(max_lsn, copy_lsns[i]);
+    page->RUnlatch();
+    writes.push_back({true, std::get<1>(dirty_frames[i]), copy, {}});
+  }
+  ForceLogUpTo(max_lsn);
+  const bool written = disk_manager_->ScheduleAndWait(std::move(writes));
+  if (written) {
+    background_writes_ += dirty_frames.size();
+    metrics_.Add(BufferPoolTag{}, BufferPoolMetrics::Counter::DIRTY_WRITE, dirty_frames.size());
+  }
+
+  std::scoped_lock sl(latch_);
+  for (size_t i = 0; i < dirty_frames.size(); i++) {
+    if (written) {
+      std::get<2>(dirty_frames[i])->disk_lsn_ = copy_lsns[i];
+    } else {
+      // 有页没写成功，不知道是哪些，全部重新标脏，下一轮再写
+      std::get<2>(dirty_frames[i])->is_dirty_ = true;
+    }
+    ReleasePin(std::get<0>(dirty_frames[i]));
+  }
+  return written ? dirty_frames.size() : 0;
+}
+
+auto BufferPoolManagerInstance::AcquireFrame(frame_id_t *frame_id, page_id_t *victim_page_id, bool *victim_dirty,
+                                             BufferPoolTag tag) -> bool {
+  *victim_page_id = INVALID_PAGE_ID;
+  *victim_dirty = false;
+  // 首先考虑从空闲框中取
+  if (!free_list_.empty()) {
+    *frame_id = free_list_.back();
+    free_list_.pop_back();
+    return true;
+  }
+  // 如果free_list中没有，那么我们就驱逐一个页
+  if (!replacer_->Evict(frame_id)) {
+    return false;
+  }
+  metrics_.Add(tag, BufferPoolMetrics::Counter::EVICTION);
+  Page &victim = *pages_[*frame_id];
+  page_table_->Remove(victim.page_id_);
+  // 干净的页要放进压缩层时也走写回的流程：放进去之前来读这一页的线程要等，否则会读盘后又留下一份旧副本
+  if (victim.is_dirty_ || compressed_tier_.IsEnabled()) {
+    *victim_page_id = victim.page_id_;
+    *victim_dirty = victim.is_dirty_;
+    writing_back_.insert(victim.page_id_);
+  }
+  victim.is_dirty_ = false;
+  return true;
+}
+
+void BufferPoolManagerInstance::EvictVictim(Page *page, page_id_t victim_page_id, bool victim_dirty, bool keep_in_tier,
+                                            BufferPoolTag tag) {
+  if (victim_dirty) {
+    ForceLogUpTo(page->GetLSN());
+    BUSTUB_ENSURE(disk_manager_->WritePage(victim_page_id, page->GetData()), "failed to write back the evicted page");
+    foreground_writes_++;
+    metrics_.Add(tag, BufferPoolMetrics::Counter::DIRTY_WRITE);
+  }
+  if (keep_in_tier) {
+    compressed_tier_.Put(victim_page_id, page->GetData());
+  }
+}
+
+auto BufferPoolManagerInstance::NewPageDiskLsn() -> lsn_t {
+  // 新页在盘上还没有内容，它的第一条日志记录（NEWPAGE）在现在之后才追加，恢复时从那里开始重做它
+  return log_manager_ != nullptr ? log_manager_->GetNextLSN() - 1 : INVALID_LSN;
+}
+
+auto BufferPoolManagerInstance::GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> {
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  std::unique_lock lock(latch_);
+  // 换出的脏页已经不在缓冲池里了，等它写完，否则它的改动既不在表里也不在盘上
+  io_cv_.wait(lock, [&] { return writing_back_.empty(); });
+  for (size_t i = 0; i < pool_size_; i++) {
+    Page &page = *pages_[i];
+    // 正在读盘的frame刚装上新页，和盘上一样；正在写盘的页盘上的LSN还没更新，按旧的算只会让重做多读一段日志
+    if (page.page_id_ == INVALID_PAGE_ID || io_in_progress_[i]) {
+      continue;
+    }
+    if (page.GetLSN() > page.disk_lsn_) {
+      dirty_pages.emplace_back(page.page_id_, page.disk_lsn_ + 1);
+    }
+  }
+  return dirty_pages;
+}
+
+void BufferPoolManagerInstance::ForceLogUpTo(lsn_t lsn) {
+  if (log_manager_ != nullptr && lsn > log_manager_->GetPersistentLSN()) {
+    log_manager_->Flush(lsn);
+  }
+}
+
+auto BufferPoolManagerInstance::AcquireRingFrame(BufferAccessStrategy *strategy, frame_id_t *frame_id,
+                                                 page_id_t *victim_page_id, bool *victim_dirty, BufferPoolTag tag)
+    -> bool {
+  auto &ring = strategy->GetRing(instance_index_);
+  // 环还没满时从缓存池正常借一个frame；被驱逐出replacer的frame已经没有访问历史了
+  if (ring.frames_.size() < strategy->GetRingSize()) {
+    if (!AcquireFrame(frame_id, victim_page_id, victim_dirty, tag)) {
+      return false;
+    }
+    ring.frames_.push_back(*frame_id);
+    frame_owner_[*frame_id] = strategy;
+    return true;
+  }
+  const frame_id_t candidate = ring.frames_[ring.next_];
+  ring.next_ = (ring.next_ + 1) % ring.frames_.size();
+  Page &page = *pages_[candidate];
+  // 该frame还被pin着（包括正在做I/O），这次退回到普通路径
+  if (page.pin_count_ > 0) {
+    return false;
+  }
+  *victim_page_id = INVALID_PAGE_ID;
+  *victim_dirty = false;
+  if (page.page_id_ != INVALID_PAGE_ID) {
+    metrics_.Add(tag, BufferPoolMetrics::Counter::EVICTION);
+    page_table_->Remove(page.page_id_);
+    if (page.is_dirty_) {
+      *victim_page_id = page.page_id_;
+      *victim_dirty = true;
+      writing_back_.insert(page.page_id_);
+    }
+  }
+  page.is_dirty_ = false;
+  *frame_id = candidate;
+  return true;
+}
+
+void BufferPoolManagerInstance::InstallPage(frame_id_t frame_id, page_id_t page_id, bool track_in_replacer) {
+  Page &page = *pages_[frame_id];
+  page.page_id_ = page_id;
+  page.pin_count_ = 1;
+  page.is_dirty_ = false;
+  page_table_->Insert(page_id, frame_id);
+  if (track_in_replacer) {
+    replacer_->RecordAccess(frame_id, page_id);
+    replacer_->SetEvictable(frame_id, false);
+  }
+}
+
+void BufferPoolManagerInstance::ReleasePin(frame_id_t frame_id) {
+  if (--pages_[frame_id]->pin_count_ > 0) {
+    return;
+  }
+  if (static_cast<size_t>(frame_id) >= pool_size_) {
+    // Resize正在收回这个frame，不再交给replacer
+    io_cv_.notify_all();
+    return;
+  }
+  // 环形缓冲的frame由strategy自己回收
+  if (frame_owner_[frame_id] == nullptr) {
+    replacer_->SetEvictable(frame_id, true);
+  }
+}
+
+void BufferPoolManagerInstance::FinishFrameIo(frame_id_t frame_id, page_id_t victim_page_id) {
+  if (victim_page_id != INVALID_PAGE_ID) {
+    writing_back_.erase(victim_page_id);
+  }
+  // 刚读进来的页和盘上的一样；新建的页由CreatePage另外设置
+  pages_[frame_id]->disk_lsn_ = pages_[frame_id]->GetLSN();
+  io_in_progress_[frame_id] = false;
+  io_cv_.notify_all();
+}
+
+auto BufferPoolManagerInstance::AllocatePage() -> page_id_t {
+  // 每个分片只分配 page_id % num_instances_ == instance_index_ 的页，这样路由时无需查表
+  page_id_t page_id = INVALID_PAGE_ID;
+  // 删除之后又被读回缓冲池（比如预读）的页这次先不分配，放回表里等它被换出
+  std::vector<page_id_t> resident;
+  // 先复用删除过的页，文件就不会一直变大；空闲页表正在写盘时不能动它
+  while (free_page_map_savers_ == 0 && free_page_map_.Allocate(&page_id)) {
+    if (free_page_map_root_ != INVALID_PAGE_ID) {
+      // 上次写盘的空闲页表可能就存在这一页里，盘上那份也作废，否则重启后会把在用的页再分出去
+      free_page_map_root_ = INVALID_PAGE_ID;
+      disk_manager_->WriteFreePageMapRoot(instance_index_, INVALID_PAGE_ID);
+    }
+    frame_id_t frame_id;
+    if (!page_table_->Find(page_id, frame_id)) {
+      break;
+    }
+    resident.push_back(page_id);
+    page_id = INVALID_PAGE_ID;
+  }
+  for (const page_id_t resident_page_id : resident) {
+    free_page_map_.Free(resident_page_id);
+  }
+  if (page_id != INVALID_PAGE_ID) {
+    return page_id;
+  }
+  const page_id_t next_page_id = next_page_id_.fetch_add(static_cast<page_id_t>(num_instances_));
+  ValidatePageId(next_page_id);
+  return next_page_id;
+}
+
+void BufferPoolManagerInstance::DeallocatePage(page_id_t page_id) {
+  // 被换出的脏页还在写回，现在复用的话新页写盘可能被这次写回覆盖，干脆不回收
+  if (writing_back_.count(page_id) > 0) {
+    return;
+  }
+  free_page_map_.Free(page_id);
+}
+
+auto BufferPoolManagerInstance::AllocateExtent(size_t page_cnt) -> page_id_t {
+  // 分片的页号不连续，区段由ParallelBufferPoolManager在所有分片上一起预留
+  if (num_instances_ > 1) {
+    return INVALID_PAGE_ID;
+  }
+  while (true) {
+    const page_id_t first_page_id = next_page_id_;
+    if (ReservePageIds(first_page_id, first_page_id + static_cast<page_id_t>(page_cnt))) {
+      return first_page_id;
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::ReservePageIds(page_id_t first_page_id, page_id_t end_page_id) -> bool {
+  // 本分片在区间里的第一个页号，以及区间之后的第一个页号
+  const auto num_instances = static_cast<page_id_t>(num_instances_);
+  const auto index = static_cast<page_id_t>(instance_index_);
+  const page_id_t first = first_page_id + (index - first_page_id % num_instances + num_instances) % num_instances;
+  const page_id_t end = end_page_id + (index - end_page_id % num_instances + num_instances) % num_instances;
+  std::scoped_lock sl(latch_);
+  if (next_page_id_ > first) {
+    return false;
+  }
+  // 为了对齐区段跳过的页号放进空闲页表，NewPage之后会先用掉它们
+  for (page_id_t page_id = next_page_id_; page_id < first; page_id += num_instances) {
+    DeallocatePage(page_id);
+  }
+  next_page_id_ = end;
+  return true;
+}
+
+void BufferPoolManagerInstance::FreePageIds(page_id_t first_page_id, page_id_t end_page_id) {
+  const auto num_instances = static_cast<page_id_t>(num_instances_);
+  const auto index = static_cast<page_id_t>(instance_index_);
+  const page_id_t first = first_page_id + (index - first_page_id % num_instances + num_instances) % num_instances;
+  const page_id_t end = end_page_id + (index - end_page_id % num_instances + num_instances) % num_instances;
+  std::scoped_lock sl(latch_);
+  // 预留之后还没分配过新页，直接退回去，文件不会因为这次失败的预留变大
+  if (next_page_id_ == end) {
+    next_page_id_ = first;
+    return;
+  }
+  for (page_id_t page_id = first_page_id; page_id < end_page_id; page_id++) {
+    if (static_cast<uint32_t>(page_id) % num_instances_ == instance_index_) {
+      DeallocatePage(page_id);
+    }
+  }
+}
+
+auto BufferPoolManagerInstance::GetFreePageCount() -> size_t {
+  std::scoped_lock sl(latch_);
+  return free_page_map_.Size();
+}
+
+auto BufferPoolManagerInstance::GetFreePageMapRoot() -> page_id_t {
+  std::scoped_lock sl(latch_);
+  return free_page_map_root_;
+}
+
+void BufferPoolManagerInstance::ValidatePageId(const page_id_t page_id) const {
+  // allocated pages mod back to this BPI
+  BUSTUB_ASSERT(page_id % num_instances_ == instance_index_, "page id does not belong to this instance");
+}
 
 }  // namespace bustub
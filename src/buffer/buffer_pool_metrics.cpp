@@ -0,0 +1,55 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.cpp
+//
+// Identification: src/buffer/buffer_pool_metrics.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/buffer_pool_metrics.h"
+
+namespace bustub {
+
+auto BufferPoolCounters::operator+=(const BufferPoolCounters &that) -> BufferPoolCounters & {
+  hits_ += that.hits_;
+  misses_ += that.misses_;
+  evictions_ += that.evictions_;
+  dirty_writes_ += that.dirty_writes_;
+  pin_waits_ += that.pin_waits_;
+  return *this;
+}
+
+auto BufferPoolCounters::HitRatio() const -> double {
+  if (hits_ + misses_ == 0) {
+    return 0;
+  }
+  return static_cast<double>(hits_) / static_cast<double>(hits_ + misses_);
+}
+
+auto BufferPoolMetrics::StripeIndex() -> size_t {
+  static std::atomic<size_t> next_stripe{0};
+  // 每个线程第一次计数时分到一个stripe，之后一直用它
+  thread_local const size_t stripe = next_stripe.fetch_add(1, std::memory_order_relaxed) % STRIPE_CNT;
+  return stripe;
+}
+
+auto BufferPoolMetrics::Collect() const -> std::vector<BufferPoolCounters> {
+  std::vector<BufferPoolCounters> counters(BUFFER_POOL_MAX_TAGS);
+  for (const auto &stripe : stripes_) {
+    for (size_t id = 0; id < BUFFER_POOL_MAX_TAGS; id++) {
+      const auto &values = stripe.counters_[id];
+      counters[id].hits_ += values[static_cast<size_t>(Counter::HIT)].load(std::memory_order_relaxed);
+      counters[id].misses_ += values[static_cast<size_t>(Counter::MISS)].load(std::memory_order_relaxed);
+      counters[id].evictions_ += values[static_cast<size_t>(Counter::EVICTION)].load(std::memory_order_relaxed);
+      counters[id].dirty_writes_ += values[static_cast<size_t>(Counter::DIRTY_WRITE)].load(std::memory_order_relaxed);
+      counters[id].pin_waits_ += values[static_cast<size_t>(Counter::PIN_WAIT)].load(std::memory_order_relaxed);
+    }
+  }
+  return counters;
+}
+
+}  // namespace bustub
@@ -0,0 +1,270 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.cpp
+//
+// Identification: src/buffer/clock_pro_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/clock_pro_replacer.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ClockProReplacer::ClockProReplacer(size_t num_frames)
+    : capacity_(num_frames),
+      hand_hot_(clock_.end()),
+      hand_cold_(clock_.end()),
+      hand_test_(clock_.end()),
+      frames_(num_frames),
+      cold_target_(std::max<size_t>(1, num_frames / 2)) {}
+
+auto ClockProReplacer::Next(EntryIter it) -> EntryIter {
+  ++it;
+  return it == clock_.end() ? clock_.begin() : it;
+}
+
+auto ClockProReplacer::InsertAtHead(const Entry &entry) -> EntryIter {
+  if (clock_.empty()) {
+    hand_hot_ = hand_cold_ = hand_test_ = clock_.insert(clock_.end(), entry);
+    return hand_hot_;
+  }
+  return clock_.insert(hand_hot_, entry);
+}
+
+void ClockProReplacer::EraseEntry(EntryIter it) {
+  const EntryIter next = clock_.size() == 1 ? clock_.end() : Next(it);
+  for (EntryIter *hand : {&hand_hot_, &hand_cold_, &hand_test_}) {
+    if (*hand == it) {
+      *hand = next;
+    }
+  }
+  clock_.erase(it);
+}
+
+void ClockProReplacer::GrowColdTarget() {
+  cold_target_ = std::min(cold_target_ + 1, std::max<size_t>(1, capacity_ - 1));
+}
+
+void ClockProReplacer::ShrinkColdTarget() { cold_target_ = std::max<size_t>(1, cold_target_ - 1); }
+
+void ClockProReplacer::HandHot() {
+  while (hot_cnt_ > 0) {
+    const EntryIter it = hand_hot_;
+    hand_hot_ = Next(hand_hot_);
+    if (it->frame_id_ == NON_RESIDENT) {
+      // 热指针经过的非驻留页：测试期结束，冷页的份额减小
+      non_resident_.erase(it->page_id_);
+      EraseEntry(it);
+      ShrinkColdTarget();
+      continue;
+    }
+    if (!it->hot_) {
+      if (it->test_) {
+        it->test_ = false;
+        ShrinkColdTarget();
+      }
+      continue;
+    }
+    if (it->referenced_) {
+      it->referenced_ = false;
+      continue;
+    }
+    // 没被访问过的热页降级为冷页
+    it->hot_ = false;
+    hot_cnt_--;
+    cold_cnt_++;
+    return;
+  }
+}
+
+void ClockProReplacer::HandTest() {
+  for (size_t i = 0; i < clock_.size(); i++) {
+    const EntryIter it = hand_test_;
+    hand_test_ = Next(hand_test_);
+    if (it->frame_id_ == NON_RESIDENT) {
+      non_resident_.erase(it->page_id_);
+      EraseEntry(it);
+      ShrinkColdTarget();
+      return;
+    }
+    if (!it->hot_ && it->test_) {
+      it->test_ = false;
+      ShrinkColdTarget();
+      return;
+    }
+  }
+}
+
+auto ClockProReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock sl(latch_);
+  if (curr_size_ == 0) {
+    return false;
+  }
+  size_t steps = 0;
+  while (true) {
+    // 冷指针转了两圈还没找到（可驱逐的页都是热页）：让热指针降级一个热页
+    if (steps > 2 * clock_.size()) {
+      HandHot();
+      steps = 0;
+    }
+    steps++;
+    const EntryIter it = hand_cold_;
+    hand_cold_ = Next(hand_cold_);
+    if (it->frame_id_ == NON_RESIDENT || it->hot_ || !frames_[it->frame_id_].evictable_) {
+      continue;
+    }
+    if (it->referenced_) {
+      it->referenced_ = false;
+      if (it->test_) {
+        // 测试期内被再次访问：升级为热页
+        it->hot_ = true;
+        it->test_ = false;
+        cold_cnt_--;
+        hot_cnt_++;
+        while (hot_cnt_ > capacity_ - cold_target_ && hot_cnt_ > 0) {
+          HandHot();
+        }
+      } else {
+        // 开始新的测试期，并移到时钟头部
+        it->test_ = true;
+        if (it != hand_hot_) {
+          clock_.splice(hand_hot_, clock_, it);
+        }
+      }
+      continue;
+    }
+
+    *frame_id = it->frame_id_;
+    frames_[it->frame_id_] = FrameEntry{};
+    cold_cnt_--;
+    curr_size_--;
+    if (it->test_ && it->page_id_ != INVALID_PAGE_ID) {
+      // 仍在测试期内：保留为非驻留页
+      it->frame_id_ = NON_RESIDENT;
+      non_resident_[it->page_id_] = it;
+      while (non_resident_.size() > capacity_) {
+        HandTest();
+      }
+    } else {
+      EraseEntry(it);
+    }
+    return true;
+  }
+}
+
+void ClockProReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &frame = frames_[frame_id];
+  if (frame.tracked_) {
+    frame.pos_->referenced_ = true;
+    return;
+  }
+
+  frame.tracked_ = true;
+  frame.evictable_ = true;
+  curr_size_++;
+  auto ghost = page_id != INVALID_PAGE_ID ? non_resident_.find(page_id) : non_resident_.end();
+  if (ghost != non_resident_.end()) {
+    // 在测试期内被再次读入：冷页的份额太小了，直接作为热页插入
+    EraseEntry(ghost->second);
+    non_resident_.erase(ghost);
+    GrowColdTarget();
+    frame.pos_ = InsertAtHead(Entry{page_id, frame_id, true, false, false});
+    hot_cnt_++;
+    while (hot_cnt_ > capacity_ - cold_target_ && hot_cnt_ > 0) {
+      HandHot();
+    }
+    return;
+  }
+  if (hot_cnt_ < capacity_ - cold_target_) {
+    // 热页还没占满它的份额（刚启动时），新页直接作为热页
+    frame.pos_ = InsertAtHead(Entry{page_id, frame_id, true, false, false});
+    hot_cnt_++;
+    return;
+  }
+  frame.pos_ = InsertAtHead(Entry{page_id, frame_id, false, false, true});
+  cold_cnt_++;
+}
+
+void ClockProReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &frame = frames_[frame_id];
+  if (!frame.tracked_ || frame.evictable_ == set_evictable) {
+    return;
+  }
+  frame.evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void ClockProReplacer::Remove(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &frame = frames_[frame_id];
+  if (!frame.tracked_) {
+    return;
+  }
+  if (frame.evictable_) {
+    curr_size_--;
+  }
+  if (frame.pos_->hot_) {
+    hot_cnt_--;
+  } else {
+    cold_cnt_--;
+  }
+  EraseEntry(frame.pos_);
+  frame = FrameEntry{};
+}
+
+auto ClockProReplacer::Size() -> size_t {
+  std::scoped_lock sl(latch_);
+  return curr_size_;
+}
+
+auto ClockProReplacer::EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> {
+  std::scoped_lock sl(latch_);
+  // 近似：从冷指针开始，先是未被访问的冷页，再是被访问过的冷页，最后是热页
+  std::vector<frame_id_t> frames;
+  for (int pass = 0; pass < 3; pass++) {
+    EntryIter it = hand_cold_;
+    for (size_t i = 0; i < clock_.size() && frames.size() < max_cnt; i++, it = Next(it)) {
+      if (it->frame_id_ == NON_RESIDENT || !frames_[it->frame_id_].evictable_) {
+        continue;
+      }
+      const int entry_pass = it->hot_ ? 2 : (it->referenced_ ? 1 : 0);
+      if (entry_pass == pass) {
+        frames.push_back(it->frame_id_);
+      }
+    }
+  }
+  return frames;
+}
+
+void ClockProReplacer::Resize(size_t num_frames) {
+  std::scoped_lock sl(latch_);
+  for (size_t i = num_frames; i < frames_.size(); i++) {
+    BUSTUB_ASSERT(!frames_[i].tracked_, "frames dropped by Resize must not be tracked");
+  }
+  frames_.resize(num_frames);
+  capacity_ = num_frames;
+  // 冷页份额保持在 [1, c-1]；热页超出份额的部分由之后的访问慢慢降级
+  cold_target_ = std::min(cold_target_, std::max<size_t>(1, capacity_ - 1));
+  while (non_resident_.size() > capacity_) {
+    HandTest();
+  }
+}
+
+}  // namespace bustub
@@ -12,18 +12,108 @@
 
 #include "buffer/clock_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-ClockReplacer::ClockReplacer(size_t num_pages) {}
+ClockReplacer::ClockReplacer(size_t num_pages) : frames_(num_pages) {}
 
 ClockReplacer::~ClockReplacer() = default;
 
-auto ClockReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+auto ClockReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock sl(latch_);
+  if (curr_size_ == 0) {
+    return false;
+  }
+  // 至少有一个可驱逐的frame，最多转两圈：第一圈清掉引用位，第二圈一定能找到
+  while (true) {
+    auto &entry = frames_[hand_];
+    const auto current = static_cast<frame_id_t>(hand_);
+    hand_ = (hand_ + 1) % frames_.size();
+    if (!entry.tracked_ || !entry.evictable_) {
+      continue;
+    }
+    if (entry.referenced_) {
+      entry.referenced_ = false;
+      continue;
+    }
+    entry = FrameEntry{};
+    curr_size_--;
+    *frame_id = current;
+    return true;
+  }
+}
+
+void ClockReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (!entry.tracked_) {
+    entry.tracked_ = true;
+    entry.evictable_ = true;
+    curr_size_++;
+  }
+  entry.referenced_ = true;
+}
+
+void ClockReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (!entry.tracked_ || entry.evictable_ == set_evictable) {
+    return;
+  }
+  entry.evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void ClockReplacer::Remove(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (!entry.tracked_) {
+    return;
+  }
+  if (entry.evictable_) {
+    curr_size_--;
+  }
+  entry = FrameEntry{};
+}
 
-void ClockReplacer::Pin(frame_id_t frame_id) {}
+auto ClockReplacer::Size() -> size_t {
+  std::scoped_lock sl(latch_);
+  return curr_size_;
+}
 
-void ClockReplacer::Unpin(frame_id_t frame_id) {}
+auto ClockReplacer::EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> {
+  std::scoped_lock sl(latch_);
+  // 从指针处开始：先是引用位为0的frame（第一圈就会被驱逐），再是引用位为1的frame（第二圈）
+  std::vector<frame_id_t> frames;
+  for (bool referenced : {false, true}) {
+    for (size_t i = 0; i < frames_.size() && frames.size() < max_cnt; i++) {
+      const size_t index = (hand_ + i) % frames_.size();
+      const auto &entry = frames_[index];
+      if (entry.tracked_ && entry.evictable_ && entry.referenced_ == referenced) {
+        frames.push_back(static_cast<frame_id_t>(index));
+      }
+    }
+  }
+  return frames;
+}
 
-auto ClockReplacer::Size() -> size_t { return 0; }
+void ClockReplacer::Resize(size_t num_frames) {
+  std::scoped_lock sl(latch_);
+  for (size_t i = num_frames; i < frames_.size(); i++) {
+    BUSTUB_ASSERT(!frames_[i].tracked_, "frames dropped by Resize must not be tracked");
+  }
+  frames_.resize(num_frames);
+  if (hand_ >= num_frames) {
+    hand_ = 0;
+  }
+}
 
 }  // namespace bustub
@@ -0,0 +1,120 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.cpp
+//
+// Identification: src/buffer/compressed_page_cache.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/compressed_page_cache.h"
+
+#include <cstring>
+#include <utility>
+
+#include "common/macros.h"
+#include "common/util/lz_codec.h"
+
+namespace bustub {
+
+void CompressedPageCache::Put(page_id_t page_id, const char *data) {
+  if (!IsEnabled()) {
+    return;
+  }
+  // 在锁外压缩；压不小的页直接原样存
+  Entry entry;
+  LZCodec::Compress(data, BUSTUB_PAGE_SIZE, &entry.data_);
+  entry.compressed_ = entry.data_.size() < static_cast<size_t>(BUSTUB_PAGE_SIZE);
+  if (!entry.compressed_) {
+    entry.data_.assign(data, data + BUSTUB_PAGE_SIZE);
+  }
+  entry.data_.shrink_to_fit();
+
+  std::scoped_lock sl(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end()) {
+    RemoveEntry(it);
+  }
+  if (entry.data_.size() > capacity_) {
+    return;
+  }
+  EvictUntil(capacity_ - entry.data_.size());
+  used_bytes_ += entry.data_.size();
+  lru_.push_front(page_id);
+  entry.lru_pos_ = lru_.begin();
+  entries_.emplace(page_id, std::move(entry));
+}
+
+auto CompressedPageCache::Get(page_id_t page_id, char *data) -> bool {
+  Entry entry;
+  {
+    std::scoped_lock sl(latch_);
+    auto it = entries_.find(page_id);
+    if (it == entries_.end()) {
+      misses_++;
+      return false;
+    }
+    // 取出来之后页就回到缓冲池里了，这里不再留副本
+    used_bytes_ -= it->second.data_.size();
+    lru_.erase(it->second.lru_pos_);
+    entry = std::move(it->second);
+    entries_.erase(it);
+  }
+  hits_++;
+  if (!entry.compressed_) {
+    std::memcpy(data, entry.data_.data(), BUSTUB_PAGE_SIZE);
+    return true;
+  }
+  const bool ok = LZCodec::Decompress(entry.data_.data(), entry.data_.size(), data, BUSTUB_PAGE_SIZE);
+  BUSTUB_ASSERT(ok, "compressed page is damaged");
+  return true;
+}
+
+void CompressedPageCache::Erase(page_id_t page_id) {
+  std::scoped_lock sl(latch_);
+  auto it = entries_.find(page_id);
+  if (it != entries_.end()) {
+    RemoveEntry(it);
+  }
+}
+
+void CompressedPageCache::SetCapacity(size_t capacity) {
+  std::scoped_lock sl(latch_);
+  capacity_ = capacity;
+  EvictUntil(capacity);
+}
+
+auto CompressedPageCache::Size() -> size_t {
+  std::scoped_lock sl(latch_);
+  return entries_.size();
+}
+
+auto CompressedPageCache::GetUsedBytes() -> size_t {
+  std::scoped_lock sl(latch_);
+  return used_bytes_;
+}
+
+auto CompressedPageCache::GetCompressionRatio() -> double {
+  std::scoped_lock sl(latch_);
+  if (used_bytes_ == 0) {
+    return 0;
+  }
+  return static_cast<double>(entries_.size() * BUSTUB_PAGE_SIZE) / static_cast<double>(used_bytes_);
+}
+
+void CompressedPageCache::EvictUntil(size_t capacity) {
+  while (used_bytes_ > capacity) {
+    RemoveEntry(entries_.find(lru_.back()));
+  }
+}
+
+void CompressedPageCache::RemoveEntry(std::unordered_map<page_id_t, Entry>::iterator it) {
+  used_bytes_ -= it->second.data_.size();
+  lru_.erase(it->second.lru_pos_);
+  entries_.erase(it);
+}
+
+}  // namespace bustub
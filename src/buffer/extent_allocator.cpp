@@ -0,0 +1,53 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_allocator.cpp
+//
+// Identification: src/buffer/extent_allocator.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/extent_allocator.h"
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+ExtentAllocator::ExtentAllocator(BufferPoolManager *bpm, size_t extent_page_cnt)
+    : bpm_(bpm), extent_page_cnt_(extent_page_cnt) {
+  BUSTUB_ASSERT(extent_page_cnt > 0, "an extent needs at least one page");
+}
+
+auto ExtentAllocator::NewPage(page_id_t *page_id) -> Page * {
+  std::scoped_lock sl(latch_);
+  if (next_page_id_ == end_page_id_) {
+    const page_id_t first_page_id = bpm_->AllocateExtent(extent_page_cnt_);
+    // 缓冲池不支持区段，退回逐页分配
+    if (first_page_id == INVALID_PAGE_ID) {
+      return bpm_->NewPage(page_id);
+    }
+    next_page_id_ = first_page_id;
+    end_page_id_ = first_page_id + static_cast<page_id_t>(extent_page_cnt_);
+  }
+  // 建页失败时不前进，这个页号留给下一次
+  Page *page = bpm_->NewPageInExtent(next_page_id_);
+  if (page != nullptr) {
+    *page_id = next_page_id_++;
+  }
+  return page;
+}
+
+auto ExtentAllocator::NewPageWrite(page_id_t *page_id) -> WritePageGuard {
+  Page *page = NewPage(page_id);
+  if (page == nullptr) {
+    return {};
+  }
+  page->WLatch();
+  return {bpm_, page};
+}
+
+}  // namespace bustub
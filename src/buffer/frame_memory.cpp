@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_memory.cpp
+//
+// Identification: src/buffer/frame_memory.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/frame_memory.h"
+
+#include <sys/mman.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
+
+namespace bustub {
+
+/** Size of a huge page on x86-64 and most aarch64 kernels; a MAP_HUGETLB mapping is rounded up to it. */
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+FrameMemory::FrameMemory(size_t frame_cnt, bool huge_pages) {
+  const size_t size = std::max<size_t>(frame_cnt, 1) * BUSTUB_PAGE_SIZE;
+  if (huge_pages) {
+    // 先试预留的大页，失败了（通常是系统没有预留）再用普通映射加透明大页
+    size_ = (size + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    huge_pages_ = ptr != MAP_FAILED;
+    if (ptr == MAP_FAILED) {
+      ptr = mmap(nullptr, size_, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (ptr == MAP_FAILED) {
+        throw std::bad_alloc();
+      }
+      madvise(ptr, size_, MADV_HUGEPAGE);
+    }
+    // 匿名映射本来就是0
+    data_ = static_cast<char *>(ptr);
+    mapped_ = true;
+    return;
+  }
+  size_ = size;
+  data_ = static_cast<char *>(std::aligned_alloc(BUSTUB_PAGE_SIZE, size_));
+  if (data_ == nullptr) {
+    throw std::bad_alloc();
+  }
+  memset(data_, 0, size_);
+}
+
+FrameMemory::~FrameMemory() { Release(); }
+
+FrameMemory::FrameMemory(FrameMemory &&other) noexcept
+    : data_(std::exchange(other.data_, nullptr)),
+      size_(std::exchange(other.size_, 0)),
+      mapped_(other.mapped_),
+      huge_pages_(other.huge_pages_) {}
+
+auto FrameMemory::operator=(FrameMemory &&other) noexcept -> FrameMemory & {
+  if (this != &other) {
+    Release();
+    data_ = std::exchange(other.data_, nullptr);
+    size_ = std::exchange(other.size_, 0);
+    mapped_ = other.mapped_;
+    huge_pages_ = other.huge_pages_;
+  }
+  return *this;
+}
+
+void FrameMemory::Release() {
+  if (data_ == nullptr) {
+    return;
+  }
+  if (mapped_) {
+    munmap(data_, size_);
+  } else {
+    std::free(data_);  // NOLINT
+  }
+  data_ = nullptr;
+}
+
+}  // namespace bustub
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.cpp
+//
+// Identification: src/buffer/free_page_map.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/free_page_map.h"
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "storage/page/free_page_map_page.h"
+
+namespace bustub {
+
+void FreePageMap::Free(page_id_t page_id) { free_pages_.insert(page_id); }
+
+auto FreePageMap::Allocate(page_id_t *page_id) -> bool {
+  if (free_pages_.empty()) {
+    return false;
+  }
+  *page_id = *free_pages_.begin();
+  free_pages_.erase(free_pages_.begin());
+  return true;
+}
+
+auto FreePageMap::Save(DiskManager *disk_manager) const -> page_id_t {
+  if (free_pages_.empty()) {
+    return INVALID_PAGE_ID;
+  }
+  // 链表页用最大的那几个空闲页，按顺序写，最后一页最先写
+  const size_t chain_len = (free_pages_.size() + FreePageMapPage::CAPACITY - 1) / FreePageMapPage::CAPACITY;
+  std::vector<page_id_t> chain(free_pages_.rbegin(), std::next(free_pages_.rbegin(), chain_len));
+  std::vector<page_id_t> free_pages(free_pages_.begin(), free_pages_.end());
+
+  char data[BUSTUB_PAGE_SIZE];
+  for (size_t i = chain_len; i > 0; i--) {
+    auto *map_page = reinterpret_cast<FreePageMapPage *>(data);
+    std::fill(data, data + BUSTUB_PAGE_SIZE, 0);
+    map_page->Init(chain[i - 1], i == chain_len ? INVALID_PAGE_ID : chain[i]);
+    const size_t begin = (i - 1) * FreePageMapPage::CAPACITY;
+    for (size_t j = begin; j < free_pages.size() && !map_page->IsFull(); j++) {
+      map_page->Append(free_pages[j]);
+    }
+    if (!disk_manager->WritePage(chain[i - 1], data)) {
+      return INVALID_PAGE_ID;
+    }
+  }
+  return chain[0];
+}
+
+auto FreePageMap::Load(DiskManager *disk_manager, page_id_t first_page_id, page_id_t end_page_id) -> FreePageMap {
+  FreePageMap map;
+  std::set<page_id_t> chain;
+  char data[BUSTUB_PAGE_SIZE]{};
+  for (page_id_t page_id = first_page_id; page_id != INVALID_PAGE_ID;) {
+    // 链表页要在文件里，不能绕回读过的页，页头记的页号要对得上，否则就不是一份完整的空闲页表
+    if (page_id < 0 || page_id >= end_page_id || !chain.insert(page_id).second) {
+      return {};
+    }
+    if (!disk_manager->ReadPage(page_id, data)) {
+      return {};
+    }
+    const auto *map_page = reinterpret_cast<const FreePageMapPage *>(data);
+    if (map_page->GetPageId() != page_id || map_page->GetSize() > FreePageMapPage::CAPACITY) {
+      return {};
+    }
+    for (size_t i = 0; i < map_page->GetSize(); i++) {
+      const page_id_t free_page_id = map_page->FreePageIdAt(i);
+      if (free_page_id < 0 || free_page_id >= end_page_id) {
+        return {};
+      }
+      map.Free(free_page_id);
+    }
+    page_id = map_page->GetNextPageId();
+  }
+  return map;
+}
+
+}  // namespace bustub
@@ -10,270 +10,244 @@
 //
 //===----------------------------------------------------------------------===//
 #include "buffer/lru_k_replacer.h"
+
+#include <algorithm>
+#include <functional>
+
 namespace bustub {
 
+namespace {
+
+/** @return the access buffer the calling thread records into; threads are spread round robin over the buffers */
+auto AccessBufferIndex(size_t buffer_cnt) -> size_t {
+  static std::atomic<size_t> next_thread{0};
+  thread_local size_t thread_index = next_thread.fetch_add(1);
+  return thread_index % buffer_cnt;
+}
+
+}  // namespace
+
 LRUKReplacer::LRUKReplacer(size_t num_frames, size_t k)
-    : replacer_size_(num_frames), k_(k), lru_k_(num_frames, k), evict_able_size_(0), evict_disable_size_(0) {}
+    : replacer_size_(num_frames), k_(k), frames_(num_frames), history_(num_frames * k) {
+  BUSTUB_ASSERT(k > 0, "k must be positive");
+  heap_.reserve(num_frames);
+  drained_accesses_.reserve(ACCESS_BUFFER_CNT * ACCESS_BUFFER_SIZE);
+}
 
 auto LRUKReplacer::Evict(frame_id_t *frame_id) -> bool {
-  std::scoped_lock sl(this->latch_);
-  bool ret = lru_k_.Evict(frame_id);
-  if (ret) {
-    this->evict_able_size_--;
+  std::scoped_lock sl(latch_);
+  DrainAccessBuffers();
+  if (!FixHeapTop()) {
+    return false;
   }
-  return ret;
+  *frame_id = HeapPop().second;
+  frames_[*frame_id] = FrameEntry{};
+  curr_size_--;
+  return true;
 }
 
-void LRUKReplacer::RecordAccess(frame_id_t frame_id) {
-  std::scoped_lock sl(this->latch_);
-  if (!lru_k_.Contained(frame_id)) {
-    this->evict_able_size_++;
+void LRUKReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "invalid frame id");
+  auto &buffer = access_buffers_[AccessBufferIndex(ACCESS_BUFFER_CNT)];
+  while (true) {
+    {
+      std::scoped_lock bl(buffer.latch_);
+      const size_t size = buffer.size_.load(std::memory_order_relaxed);
+      if (size < ACCESS_BUFFER_SIZE) {
+        buffer.accesses_[size] = {current_timestamp_++, frame_id};
+        buffer.size_.store(size + 1, std::memory_order_release);
+        return;
+      }
+    }
+    // 缓冲区满了，把所有缓冲区里的访问一起应用到replacer上，然后重试
+    std::scoped_lock sl(latch_);
+    DrainAccessBuffers();
   }
-  lru_k_.Access(frame_id);
-  BUSTUB_ASSERT(evict_able_size_ + evict_disable_size_ <= static_cast<int>(replacer_size_), "LRK out of specific size");
 }
 
 void LRUKReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
-  // 后面几乎每一行都要读写数据，所以对其加上锁
-  std::scoped_lock sl(this->latch_);
-  if (!lru_k_.SetEvictable(frame_id, set_evictable)) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "invalid frame id");
+  std::scoped_lock sl(latch_);
+  DrainAccessBuffers();
+  auto &entry = frames_[frame_id];
+  if (entry.access_cnt_ == 0 || entry.evictable_ == set_evictable) {
     return;
   }
+  entry.evictable_ = set_evictable;
   if (!set_evictable) {
-    this->evict_disable_size_++;
-    this->evict_able_size_--;
-  } else {
-    this->evict_disable_size_--;
-    this->evict_able_size_++;
+    // 堆里的条目留着，等它浮到堆顶时再丢掉
+    curr_size_--;
+    return;
   }
-}
-void LRUKReplacer::Remove(frame_id_t frame_id) {
-  // BUSTUB_ASSERT(no_evictable_set_.count(frame_id),0);
-  // 这个函数里面已经考虑线程安全的问题
-  this->SetEvictable(frame_id, true);
-  // remove需要访问临界资源，所以对其加上锁
-  std::scoped_lock sl(this->latch_);
-  if (lru_k_.Remove(frame_id)) {
-    this->evict_able_size_--;
+  curr_size_++;
+  if (!entry.in_heap_) {
+    HeapPush(EvictionKey(frame_id), frame_id);
   }
 }
 
-auto LRUKReplacer::Size() -> size_t { return this->evict_able_size_; }
-
-template <class Key>
-DoubleLinkedList<Key>::Node::Node(Key frame_id) : pre_(nullptr), next_(nullptr), value_(frame_id) {}
-template <class Key>
-DoubleLinkedList<Key>::Node::Node(Key frame_id, int vc)
-    : pre_(nullptr), next_(nullptr), value_(frame_id), visite_count_(vc) {}
-template <class Key>
-bustub::DoubleLinkedList<Key>::DoubleLinkedList() {
-  head_ = new Node({});
-  head_->pre_ = head_;
-  head_->next_ = head_;
-}
-// namespace bustub
-template <class Key>
-auto bustub::DoubleLinkedList<Key>::InsertFront(Key frame_id) -> bool {
-  Node *temp = new Node(frame_id);
-  return InsertFrontNode(temp);
-}
-template <class Key>
-auto bustub::DoubleLinkedList<Key>::InsertTail(Key frame_id) -> bool {
-  Node *temp = new Node(frame_id);
-  return InsertTailNode(temp);
-}
-
-template <class Key>
-auto bustub::DoubleLinkedList<Key>::InsertFrontNode(Node *temp) -> bool {
-  temp->next_ = head_->next_;
-  head_->next_->pre_ = temp;
-  head_->next_ = temp;
-  temp->pre_ = head_;
-  size_++;
-  return true;
-}
-template <class Key>
-auto bustub::DoubleLinkedList<Key>::InsertTailNode(Node *temp) -> bool {
-  head_->pre_->next_ = temp;
-  temp->pre_ = head_->pre_;
-  head_->pre_ = temp;
-  temp->next_ = head_;
-  size_++;
-  return true;
-}
-template <class Key>
-auto bustub::DoubleLinkedList<Key>::RemoveTail(Key *frame_id) -> bool {
-  if (size_ == 0) {
-    return false;
+void LRUKReplacer::Remove(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "invalid frame id");
+  std::scoped_lock sl(latch_);
+  DrainAccessBuffers();
+  auto &entry = frames_[frame_id];
+  if (entry.access_cnt_ == 0) {
+    return;
   }
-  Node *tail = head_->pre_;
-  *frame_id = tail->value_;
-  tail->pre_->next_ = tail->next_;
-  tail->next_->pre_ = tail->pre_;
-  delete tail;
-  size_--;
-  return true;
-}
-
-template <class Key>
-auto DoubleLinkedList<Key>::RemoveNodeFromList(Node *node) -> bool {
-  if (node == head_) {
-    return false;
+  BUSTUB_ASSERT(entry.evictable_, "Remove is called on a non-evictable frame");
+  curr_size_--;
+  const bool in_heap = entry.in_heap_;
+  entry = FrameEntry{};
+  entry.in_heap_ = in_heap;
+}
+
+auto LRUKReplacer::Size() -> size_t {
+  std::scoped_lock sl(latch_);
+  DrainAccessBuffers();
+  return curr_size_;
+}
+
+auto LRUKReplacer::EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> {
+  std::scoped_lock sl(latch_);
+  DrainAccessBuffers();
+  // 依次把堆顶弹出来记下，最后再原样放回去，frame的访问历史不受影响
+  std::vector<std::pair<size_t, frame_id_t>> candidates;
+  while (candidates.size() < max_cnt && FixHeapTop()) {
+    candidates.push_back(HeapPop());
+  }
+  std::vector<frame_id_t> frames;
+  for (const auto &[key, frame_id] : candidates) {
+    frames.push_back(frame_id);
+    HeapPush(key, frame_id);
+  }
+  return frames;
+}
+
+void LRUKReplacer::Resize(size_t num_frames) {
+  std::scoped_lock sl(latch_);
+  DrainAccessBuffers();
+  for (size_t i = num_frames; i < replacer_size_; i++) {
+    BUSTUB_ASSERT(frames_[i].access_cnt_ == 0, "frames dropped by Resize must not be tracked");
+  }
+  // 被删掉的frame在堆里可能还留着过期的条目
+  auto dropped = [num_frames](const auto &entry) { return static_cast<size_t>(entry.second) >= num_frames; };
+  heap_.erase(std::remove_if(heap_.begin(), heap_.end(), dropped), heap_.end());
+  std::make_heap(heap_.begin(), heap_.end(), std::greater<>());
+  frames_.resize(num_frames);
+  history_.resize(num_frames * k_);
+  heap_.reserve(num_frames);
+  replacer_size_ = num_frames;
+}
+
+auto LRUKReplacer::GetAccessHistory(frame_id_t frame_id) -> std::vector<uint64_t> {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "invalid frame id");
+  std::scoped_lock sl(latch_);
+  DrainAccessBuffers();
+  const auto &entry = frames_[frame_id];
+  // 环还没绕回来时最早的访问在0号槽位，绕回来之后在history_next_
+  const size_t oldest = entry.access_cnt_ < k_ ? 0 : entry.history_next_;
+  std::vector<uint64_t> history;
+  history.reserve(entry.access_cnt_);
+  for (size_t i = 0; i < entry.access_cnt_; i++) {
+    history.push_back(history_[frame_id * k_ + (oldest + i) % k_]);
+  }
+  return history;
+}
+
+void LRUKReplacer::RestoreAccessHistory(frame_id_t frame_id, page_id_t page_id, const std::vector<uint64_t> &history) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < replacer_size_, "invalid frame id");
+  if (history.empty()) {
+    RecordAccess(frame_id, page_id);
+    return;
+  }
+  std::scoped_lock sl(latch_);
+  DrainAccessBuffers();
+  for (auto ts : history) {
+    ApplyAccess(frame_id, ts);
+  }
+  // 之后记录的访问要比恢复出来的都新
+  size_t next = current_timestamp_.load();
+  while (next <= history.back() && !current_timestamp_.compare_exchange_weak(next, history.back() + 1)) {
   }
-  node->pre_->next_ = node->next_;
-  node->next_->pre_ = node->pre_;
-  node->pre_ = nullptr;
-  node->next_ = nullptr;
-  size_--;
-  return true;
 }
 
-template <class Key>
-auto DoubleLinkedList<Key>::FindFirstEvictableNode() -> Node * {
-  // `history_list(fifo_list)`和 `lru_list`都有一个特点，
-  // 就是即将淘汰的放在首位，对于前者我们根据visite_count_进
-  // 行排序，对于后者我们将最近访问的元素放在链表尾处。
-  auto temp = this->head_->next_;
-  while (temp != this->head_) {
-    if (temp->evictable_) {
-      return temp;
+void LRUKReplacer::DrainAccessBuffers() {
+  drained_accesses_.clear();
+  for (auto &buffer : access_buffers_) {
+    if (buffer.size_.load(std::memory_order_acquire) == 0) {
+      continue;
     }
-    temp = temp->next_;
+    std::scoped_lock bl(buffer.latch_);
+    const size_t size = buffer.size_.load(std::memory_order_relaxed);
+    drained_accesses_.insert(drained_accesses_.end(), buffer.accesses_.begin(), buffer.accesses_.begin() + size);
+    buffer.size_.store(0, std::memory_order_release);
+  }
+  std::sort(drained_accesses_.begin(), drained_accesses_.end());
+  for (const auto &[ts, frame_id] : drained_accesses_) {
+    ApplyAccess(frame_id, ts);
   }
-  return nullptr;
 }
 
-template <class Key>
-auto DoubleLinkedList<Key>::InsertOrdered(Node *node) -> bool {
-  // 先找到第一个节点
-  auto *temp = head_->next_;
-  // 如果当前没有任何数据，直接头插就行了
-  if (temp == head_) {
-    InsertFrontNode(node);
-    return true;
+void LRUKReplacer::ApplyAccess(frame_id_t frame_id, size_t ts) {
+  auto &entry = frames_[frame_id];
+  size_t *history = &history_[frame_id * k_];
+  if (entry.access_cnt_ > 0) {
+    // 并发的RecordAccess可能在更晚的访问已经应用之后才被取出，把它当作与最近一次访问同时发生
+    ts = std::max(ts, history[(entry.history_next_ + k_ - 1) % k_]);
   }
-  // 如果有别的数据，那么就开始遍历链表，找到第一个visite_count大于node->visite_count的节点
-  while (temp != head_ && temp->visite_count_ <= node->visite_count_) {
-    temp = temp->next_;
+  history[entry.history_next_] = ts;
+  entry.history_next_ = (entry.history_next_ + 1) % k_;
+  // 已经在堆里的frame不用动：新的访问只会让它的key变大，堆里的旧key仍然是下界
+  if (entry.access_cnt_++ > 0) {
+    entry.access_cnt_ = std::min(entry.access_cnt_, k_);
+    return;
   }
-  // 然后将其插入到该节点后面即可
-  temp->pre_->next_ = node;
-  node->next_ = temp;
-  node->pre_ = temp->pre_;
-  temp->pre_ = node;
-  size_++;
-  return true;
-}
-template <class Key>
-bustub::DoubleLinkedList<Key>::~DoubleLinkedList() {
-  Node *delted_node = head_->next_;
-  Node *temp = delted_node->next_;
-  while (delted_node != head_) {
-    temp = delted_node->next_;
-    delete delted_node;
-    delted_node = temp;
+  entry.evictable_ = true;
+  curr_size_++;
+  if (!entry.in_heap_) {
+    HeapPush(EvictionKey(frame_id), frame_id);
   }
-  delete head_;
 }
-}  // namespace bustub
-
-bustub::LruK::LruK(int size, int K) : capacity_(size), k_(K) {}
 
-void bustub::LruK::Access(frame_id_t id) {
-  // 先访问第一层cache
-  if (lru_map_.count(id) != 0) {
-    // 如果命中
-    Node *node = lru_map_[id];
-    lru_cache_.RemoveNodeFromList(node);
-    lru_cache_.InsertTailNode(node);
-  } else if (history_map_.count(id) != 0) {
-    // 如果没有命中，再访问第二层cache
-    // 如果命中
-    Node *node = history_map_[id];
-    node->visite_count_++;
-    // 如果访问次数满k次了
-    if (node->visite_count_ == k_) {
-      history_cache_.RemoveNodeFromList(node);  // 将其从第一层cache移掉
-      lru_cache_.InsertTailNode(node);          // 将其插入到第二层cache中
-      lru_map_[id] = node;
-      history_map_.erase(id);
-    }
-  } else {
-    // 如果两层cache都没有命中，那么就执行插入操作
-    // 先判断cache是否满
-    if (IsFull()) {
-      // 如果满了，则需要逐出元素
-      return;
-    }
-    // 如果没有满，则插入
-    Node *new_node = new Node(id, 1);
-    history_cache_.InsertTailNode(new_node);
-    history_map_[id] = new_node;
+auto LRUKReplacer::EvictionKey(frame_id_t frame_id) const -> size_t {
+  const auto &entry = frames_[frame_id];
+  // 不满k次的frame按最早一次访问排序（环还没绕回来，最早的在0号槽位）；满k次的按倒数第k次访问排序
+  if (entry.access_cnt_ < k_) {
+    return history_[frame_id * k_];
   }
-  // 如果两层
+  return K_ACCESSES_KEY_BIT | history_[frame_id * k_ + entry.history_next_];
 }
 
-auto bustub::LruK::Evict(frame_id_t *id) -> bool {
-  // 先从历史链表中寻找
-  if (history_cache_.Size() > 0) {
-    Node *ret = history_cache_.FindFirstEvictableNode();  // 从头开始找，找到第一个可以驱逐的结点，然后驱逐
-    if (ret != nullptr) {
-      *id = ret->value_;
-      history_cache_.RemoveNodeFromList(ret);
-      history_map_.erase(ret->value_);
-      delete ret;
-      return true;
+auto LRUKReplacer::FixHeapTop() -> bool {
+  while (!heap_.empty()) {
+    const auto [key, frame_id] = heap_.front();
+    const auto &entry = frames_[frame_id];
+    if (entry.access_cnt_ == 0 || !entry.evictable_) {
+      HeapPop();
+      continue;
     }
-  }
-  // 没有的话，再从lru_cache中寻找
-  if (lru_cache_.Size() > 0) {
-    Node *ret = lru_cache_.FindFirstEvictableNode();
-    if (ret != nullptr) {
-      *id = ret->value_;
-      lru_cache_.RemoveNodeFromList(ret);
-      lru_map_.erase(ret->value_);
-      delete ret;
+    const size_t current_key = EvictionKey(frame_id);
+    if (current_key == key) {
+      // 其它条目的真实key都不小于它们在堆里的key，也就不小于堆顶
       return true;
     }
+    HeapPop();
+    HeapPush(current_key, frame_id);
   }
   return false;
 }
-auto bustub::LruK::Contained(frame_id_t id) -> bool { return lru_map_.count(id) > 0 || history_map_.count(id) > 0; }
-auto bustub::LruK::SetEvictable(frame_id_t id, bool evictable) -> bool {
-  // 如果 直接在历史缓存区里找到
-  bool flag = false;
-  if (history_map_.count(id) > 0) {
-    Node *temp = history_map_[id];
-    flag = (temp->evictable_ != evictable);
-    temp->evictable_ = evictable;
-  } else if (lru_map_.count(id) > 0) {
-    Node *temp = lru_map_[id];
-    flag = (temp->evictable_ != evictable);
-    temp->evictable_ = evictable;
-  }
-  return flag;
-}
 
-auto bustub::LruK::Remove(frame_id_t id) -> bool {
-  if (history_map_.count(id) > 0) {
-    Node *temp = history_map_[id];
-    history_map_.erase(id);
-    history_cache_.RemoveNodeFromList(temp);
-    delete temp;
-    return true;
-  }
-  if (lru_map_.count(id) > 0) {
-    Node *temp = lru_map_[id];
-    lru_map_.erase(id);
-    lru_cache_.RemoveNodeFromList(temp);
-    delete temp;
-    return true;
-  }
-  return false;
+void LRUKReplacer::HeapPush(size_t key, frame_id_t frame_id) {
+  frames_[frame_id].in_heap_ = true;
+  heap_.emplace_back(key, frame_id);
+  std::push_heap(heap_.begin(), heap_.end(), std::greater<>());
 }
 
-auto bustub::LruK::Size() -> int { return lru_cache_.Size() + history_cache_.Size(); }
-
-auto bustub::LruK::IsFull() -> bool { return Size() >= capacity_; }
+auto LRUKReplacer::HeapPop() -> std::pair<size_t, frame_id_t> {
+  std::pop_heap(heap_.begin(), heap_.end(), std::greater<>());
+  auto top = heap_.back();
+  heap_.pop_back();
+  frames_[top.second].in_heap_ = false;
+  return top;
+}
 
-template class bustub::DoubleLinkedList<int>;
+}  // namespace bustub
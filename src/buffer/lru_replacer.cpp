@@ -12,18 +12,93 @@
 
 #include "buffer/lru_replacer.h"
 
+#include "common/macros.h"
+
 namespace bustub {
 
-LRUReplacer::LRUReplacer(size_t num_pages) {}
+LRUReplacer::LRUReplacer(size_t num_pages) : frames_(num_pages) {}
 
 LRUReplacer::~LRUReplacer() = default;
 
-auto LRUReplacer::Victim(frame_id_t *frame_id) -> bool { return false; }
+auto LRUReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock sl(latch_);
+  for (auto it = lru_list_.begin(); it != lru_list_.end(); ++it) {
+    if (frames_[*it].evictable_) {
+      *frame_id = *it;
+      frames_[*it] = FrameEntry{};
+      lru_list_.erase(it);
+      curr_size_--;
+      return true;
+    }
+  }
+  return false;
+}
+
+void LRUReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (entry.tracked_) {
+    lru_list_.erase(entry.pos_);
+  } else {
+    entry.tracked_ = true;
+    entry.evictable_ = true;
+    curr_size_++;
+  }
+  entry.pos_ = lru_list_.insert(lru_list_.end(), frame_id);
+}
+
+void LRUReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (!entry.tracked_ || entry.evictable_ == set_evictable) {
+    return;
+  }
+  entry.evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void LRUReplacer::Remove(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (!entry.tracked_) {
+    return;
+  }
+  if (entry.evictable_) {
+    curr_size_--;
+  }
+  lru_list_.erase(entry.pos_);
+  entry = FrameEntry{};
+}
 
-void LRUReplacer::Pin(frame_id_t frame_id) {}
+auto LRUReplacer::Size() -> size_t {
+  std::scoped_lock sl(latch_);
+  return curr_size_;
+}
 
-void LRUReplacer::Unpin(frame_id_t frame_id) {}
+auto LRUReplacer::EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> {
+  std::scoped_lock sl(latch_);
+  std::vector<frame_id_t> frames;
+  for (auto it = lru_list_.begin(); it != lru_list_.end() && frames.size() < max_cnt; ++it) {
+    if (frames_[*it].evictable_) {
+      frames.push_back(*it);
+    }
+  }
+  return frames;
+}
 
-auto LRUReplacer::Size() -> size_t { return 0; }
+void LRUReplacer::Resize(size_t num_frames) {
+  std::scoped_lock sl(latch_);
+  for (size_t i = num_frames; i < frames_.size(); i++) {
+    BUSTUB_ASSERT(!frames_[i].tracked_, "frames dropped by Resize must not be tracked");
+  }
+  frames_.resize(num_frames);
+}
 
 }  // namespace bustub
@@ -0,0 +1,286 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.cpp
+//
+// Identification: src/buffer/parallel_buffer_pool_manager.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+ParallelBufferPoolManager::ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                                                     size_t replacer_k, LogManager *log_manager,
+                                                     ReplacerType replacer_type)
+    : disk_manager_(disk_manager) {
+  BUSTUB_ASSERT(num_instances > 0, "parallel BPM needs at least one instance");
+  instances_.reserve(num_instances);
+  for (size_t i = 0; i < num_instances; i++) {
+    instances_.emplace_back(new BufferPoolManagerInstance(pool_size, static_cast<uint32_t>(num_instances),
+                                                          static_cast<uint32_t>(i), disk_manager, replacer_k,
+                                                          log_manager, replacer_type));
+  }
+}
+
+ParallelBufferPoolManager::~ParallelBufferPoolManager() {
+  for (auto *instance : instances_) {
+    delete instance;
+  }
+}
+
+auto ParallelBufferPoolManager::GetPoolSize() -> size_t {
+  size_t pool_size = 0;
+  for (auto *instance : instances_) {
+    pool_size += instance->GetPoolSize();
+  }
+  return pool_size;
+}
+
+void ParallelBufferPoolManager::Resize(size_t pool_size) {
+  for (auto *instance : instances_) {
+    instance->Resize(pool_size);
+  }
+}
+
+void ParallelBufferPoolManager::SetCompressedTierSize(size_t bytes) {
+  for (auto *instance : instances_) {
+    instance->SetCompressedTierSize(bytes);
+  }
+}
+
+auto ParallelBufferPoolManager::SnapshotResidentPages() -> PoolSnapshot {
+  PoolSnapshot snapshot;
+  for (auto *instance : instances_) {
+    auto entries = instance->SnapshotResidentPages().entries_;
+    snapshot.entries_.insert(snapshot.entries_.end(), std::make_move_iterator(entries.begin()),
+                             std::make_move_iterator(entries.end()));
+  }
+  return snapshot;
+}
+
+auto ParallelBufferPoolManager::GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> {
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages;
+  for (auto *instance : instances_) {
+    auto instance_pages = instance->GetDirtyPageTable();
+    dirty_pages.insert(dirty_pages.end(), instance_pages.begin(), instance_pages.end());
+  }
+  return dirty_pages;
+}
+
+auto ParallelBufferPoolManager::WarmUp(const PoolSnapshot &snapshot, size_t thread_cnt) -> size_t {
+  const size_t instance_thread_cnt = std::max<size_t>(1, thread_cnt / instances_.size());
+  std::atomic<size_t> loaded{0};
+  std::vector<std::thread> threads;
+  for (auto *instance : instances_) {
+    threads.emplace_back([&, instance] { loaded += instance->WarmUp(snapshot, instance_thread_cnt); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  return loaded;
+}
+
+auto ParallelBufferPoolManager::GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance * {
+  BUSTUB_ASSERT(page_id >= 0, "cannot route an invalid page id");
+  return instances_[static_cast<size_t>(page_id) % instances_.size()];
+}
+
+void ParallelBufferPoolManager::Prefetch(page_id_t first_page_id, size_t page_cnt) {
+  for (size_t i = 0; i < page_cnt; i++) {
+    const auto page_id = first_page_id + static_cast<page_id_t>(i);
+    GetBufferPoolManager(page_id)->Prefetch(page_id, 1);
+  }
+}
+
+auto ParallelBufferPoolManager::FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPageWithStrategy(page_id, strategy);
+}
+
+auto ParallelBufferPoolManager::GetTagCounters() -> std::vector<BufferPoolCounters> {
+  std::vector<BufferPoolCounters> counters;
+  for (auto *instance : instances_) {
+    auto instance_counters = instance->GetTagCounters();
+    counters.resize(std::max(counters.size(), instance_counters.size()));
+    for (size_t id = 0; id < instance_counters.size(); id++) {
+      counters[id] += instance_counters[id];
+    }
+  }
+  return counters;
+}
+
+auto ParallelBufferPoolManager::FetchPagesImp(const std::vector<page_id_t> &page_ids, BufferPoolTag tag)
+    -> std::vector<Page *> {
+  if (instances_.size() == 1) {
+    return instances_[0]->FetchPages(page_ids, tag);
+  }
+  // 按分片拆开，记下每一页在原来列表里的位置
+  std::vector<std::vector<page_id_t>> per_instance(instances_.size());
+  std::vector<std::vector<size_t>> positions(instances_.size());
+  for (size_t i = 0; i < page_ids.size(); i++) {
+    const size_t index = static_cast<size_t>(page_ids[i]) % instances_.size();
+    per_instance[index].push_back(page_ids[i]);
+    positions[index].push_back(i);
+  }
+  std::vector<Page *> pages(page_ids.size(), nullptr);
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (per_instance[i].empty()) {
+      continue;
+    }
+    auto instance_pages = instances_[i]->FetchPages(per_instance[i], tag);
+    for (size_t j = 0; j < instance_pages.size(); j++) {
+      pages[positions[i][j]] = instance_pages[j];
+    }
+  }
+  return pages;
+}
+
+void ParallelBufferPoolManager::UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) {
+  if (instances_.size() == 1) {
+    instances_[0]->UnpinPages(pages);
+    return;
+  }
+  std::vector<std::vector<std::pair<page_id_t, bool>>> per_instance(instances_.size());
+  for (const auto &page : pages) {
+    per_instance[static_cast<size_t>(page.first) % instances_.size()].push_back(page);
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    if (!per_instance[i].empty()) {
+      instances_[i]->UnpinPages(per_instance[i]);
+    }
+  }
+}
+
+void ParallelBufferPoolManager::ReleaseStrategy(BufferAccessStrategy *strategy) {
+  for (auto *instance : instances_) {
+    instance->ReleaseStrategy(strategy);
+  }
+}
+
+void ParallelBufferPoolManager::StartBackgroundWriter(const BackgroundWriterOptions &options) {
+  for (auto *instance : instances_) {
+    instance->StartBackgroundWriter(options);
+  }
+}
+
+void ParallelBufferPoolManager::StopBackgroundWriter() {
+  for (auto *instance : instances_) {
+    instance->StopBackgroundWriter();
+  }
+}
+
+auto ParallelBufferPoolManager::GetBackgroundWriteCount() const -> uint64_t {
+  uint64_t cnt = 0;
+  for (auto *instance : instances_) {
+    cnt += instance->GetBackgroundWriteCount();
+  }
+  return cnt;
+}
+
+auto ParallelBufferPoolManager::GetForegroundWriteCount() const -> uint64_t {
+  uint64_t cnt = 0;
+  for (auto *instance : instances_) {
+    cnt += instance->GetForegroundWriteCount();
+  }
+  return cnt;
+}
+
+auto ParallelBufferPoolManager::FetchPgImp(page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPage(page_id);
+}
+
+auto ParallelBufferPoolManager::FetchPgTaggedImp(page_id_t page_id, BufferAccessStrategy *strategy, BufferPoolTag tag)
+    -> Page * {
+  return GetBufferPoolManager(page_id)->FetchPgTaggedImp(page_id, strategy, tag);
+}
+
+auto ParallelBufferPoolManager::UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool {
+  return GetBufferPoolManager(page_id)->UnpinPage(page_id, is_dirty);
+}
+
+auto ParallelBufferPoolManager::FlushPgImp(page_id_t page_id) -> bool {
+  return GetBufferPoolManager(page_id)->FlushPage(page_id);
+}
+
+auto ParallelBufferPoolManager::NewPgImp(page_id_t *page_id) -> Page * {
+  // 只在选起点时持有latch_，真正分配页时不持有，避免所有NewPage又串行化到一把锁上
+  size_t start;
+  {
+    std::scoped_lock sl(latch_);
+    start = next_instance_;
+    next_instance_ = (next_instance_ + 1) % instances_.size();
+  }
+  for (size_t i = 0; i < instances_.size(); i++) {
+    auto *page = instances_[(start + i) % instances_.size()]->NewPage(page_id);
+    if (page != nullptr) {
+      return page;
+    }
+  }
+  return nullptr;
+}
+
+auto ParallelBufferPoolManager::NewPgInExtentImp(page_id_t page_id) -> Page * {
+  return GetBufferPoolManager(page_id)->NewPageInExtent(page_id);
+}
+
+auto ParallelBufferPoolManager::AllocateExtent(size_t page_cnt) -> page_id_t {
+  while (true) {
+    page_id_t first_page_id = 0;
+    for (auto *instance : instances_) {
+      first_page_id = std::max(first_page_id, instance->GetNextPageId());
+    }
+    const page_id_t end_page_id = first_page_id + static_cast<page_id_t>(page_cnt);
+    // 总是从第一个分片开始预留，两个同时预留的区段重叠时后来的那个在第一个分片就会失败
+    size_t reserved = 0;
+    while (reserved < instances_.size() && instances_[reserved]->ReservePageIds(first_page_id, end_page_id)) {
+      reserved++;
+    }
+    if (reserved == instances_.size()) {
+      return first_page_id;
+    }
+    for (size_t i = 0; i < reserved; i++) {
+      instances_[i]->FreePageIds(first_page_id, end_page_id);
+    }
+  }
+}
+
+auto ParallelBufferPoolManager::DeletePgImp(page_id_t page_id) -> bool {
+  return GetBufferPoolManager(page_id)->DeletePage(page_id);
+}
+
+void ParallelBufferPoolManager::FlushAllPgsImp() {
+  // 相邻的页分在不同的分片里，先收齐所有分片的脏页再一起合并写
+  std::vector<std::vector<BufferPoolManagerInstance::DirtyPage>> dirty_pages;
+  dirty_pages.reserve(instances_.size());
+  std::vector<std::pair<page_id_t, const char *>> writes;
+  for (auto *instance : instances_) {
+    dirty_pages.push_back(instance->PinDirtyPages());
+    for (const auto &page : dirty_pages.back()) {
+      writes.emplace_back(page.page_id_, page.data_);
+    }
+  }
+  disk_manager_->WritePages(std::move(writes));
+  for (size_t i = 0; i < instances_.size(); i++) {
+    instances_[i]->UnpinFlushedPages(dirty_pages[i]);
+  }
+  // 所有分片的页一次落盘
+  disk_manager_->Sync();
+  for (size_t i = 0; i < instances_.size(); i++) {
+    instances_[i]->SaveFreePageMap();
+  }
+}
+
+}  // namespace bustub
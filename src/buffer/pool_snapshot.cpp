@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pool_snapshot.cpp
+//
+// Identification: src/buffer/pool_snapshot.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/pool_snapshot.h"
+
+#include <fstream>
+#include <utility>
+
+namespace bustub {
+
+namespace {
+
+template <typename T>
+void WriteValue(std::ofstream *out, T value) {
+  out->write(reinterpret_cast<const char *>(&value), sizeof(T));
+}
+
+template <typename T>
+auto ReadValue(std::ifstream *in, T *value) -> bool {
+  return static_cast<bool>(in->read(reinterpret_cast<char *>(value), sizeof(T)));
+}
+
+}  // namespace
+
+auto PoolSnapshot::Save(const std::string &path) const -> bool {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  if (!out.is_open()) {
+    return false;
+  }
+  WriteValue(&out, MAGIC);
+  WriteValue(&out, static_cast<uint32_t>(entries_.size()));
+  for (const auto &entry : entries_) {
+    WriteValue(&out, entry.page_id_);
+    WriteValue(&out, static_cast<uint32_t>(entry.history_.size()));
+    for (auto ts : entry.history_) {
+      WriteValue(&out, ts);
+    }
+  }
+  out.flush();
+  return static_cast<bool>(out);
+}
+
+auto PoolSnapshot::Load(const std::string &path) -> PoolSnapshot {
+  std::ifstream in(path, std::ios::binary);
+  uint32_t magic;
+  uint32_t entry_cnt;
+  if (!in.is_open() || !ReadValue(&in, &magic) || magic != MAGIC || !ReadValue(&in, &entry_cnt)) {
+    return {};
+  }
+  PoolSnapshot snapshot;
+  for (uint32_t i = 0; i < entry_cnt; i++) {
+    Entry entry;
+    uint32_t history_len;
+    if (!ReadValue(&in, &entry.page_id_) || !ReadValue(&in, &history_len)) {
+      return {};
+    }
+    entry.history_.resize(history_len);
+    for (auto &ts : entry.history_) {
+      if (!ReadValue(&in, &ts)) {
+        return {};
+      }
+    }
+    snapshot.entries_.push_back(std::move(entry));
+  }
+  return snapshot;
+}
+
+}  // namespace bustub
@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer.cpp
+//
+// Identification: src/buffer/replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/replacer.h"
+
+#include "buffer/arc_replacer.h"
+#include "buffer/clock_pro_replacer.h"
+#include "buffer/clock_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/lru_replacer.h"
+#include "buffer/two_queue_replacer.h"
+#include "common/exception.h"
+#include "common/util/string_util.h"
+
+namespace bustub {
+
+auto MakeReplacer(ReplacerType type, size_t num_frames, size_t k) -> std::unique_ptr<Replacer> {
+  switch (type) {
+    case ReplacerType::LRU_K:
+      return std::make_unique<LRUKReplacer>(num_frames, k);
+    case ReplacerType::LRU:
+      return std::make_unique<LRUReplacer>(num_frames);
+    case ReplacerType::CLOCK:
+      return std::make_unique<ClockReplacer>(num_frames);
+    case ReplacerType::ARC:
+      return std::make_unique<ARCReplacer>(num_frames);
+    case ReplacerType::TWO_QUEUE:
+      return std::make_unique<TwoQueueReplacer>(num_frames);
+    case ReplacerType::CLOCK_PRO:
+      return std::make_unique<ClockProReplacer>(num_frames);
+  }
+  throw Exception(ExceptionType::INVALID, "unknown replacer type");
+}
+
+auto ReplacerTypeFromString(const std::string &name) -> std::optional<ReplacerType> {
+  const std::string lower = StringUtil::Lower(name);
+  if (lower == "lru-k" || lower == "lru_k" || lower == "lruk") {
+    return ReplacerType::LRU_K;
+  }
+  if (lower == "lru") {
+    return ReplacerType::LRU;
+  }
+  if (lower == "clock") {
+    return ReplacerType::CLOCK;
+  }
+  if (lower == "arc") {
+    return ReplacerType::ARC;
+  }
+  if (lower == "2q" || lower == "two_queue" || lower == "two-queue") {
+    return ReplacerType::TWO_QUEUE;
+  }
+  if (lower == "clock-pro" || lower == "clock_pro" || lower == "clockpro") {
+    return ReplacerType::CLOCK_PRO;
+  }
+  return std::nullopt;
+}
+
+auto ReplacerTypeToString(ReplacerType type) -> std::string {
+  switch (type) {
+    case ReplacerType::LRU_K:
+      return "lru-k";
+    case ReplacerType::LRU:
+      return "lru";
+    case ReplacerType::CLOCK:
+      return "clock";
+    case ReplacerType::ARC:
+      return "arc";
+    case ReplacerType::TWO_QUEUE:
+      return "2q";
+    case ReplacerType::CLOCK_PRO:
+      return "clock-pro";
+  }
+  return "unknown";
+}
+
+}  // namespace bustub
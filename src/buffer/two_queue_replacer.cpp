@@ -0,0 +1,144 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.cpp
+//
+// Identification: src/buffer/two_queue_replacer.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/two_queue_replacer.h"
+
+#include <algorithm>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+TwoQueueReplacer::TwoQueueReplacer(size_t num_frames)
+    : a1in_target_(std::max<size_t>(1, num_frames / 4)),
+      a1out_capacity_(std::max<size_t>(1, num_frames / 2)),
+      frames_(num_frames) {}
+
+auto TwoQueueReplacer::Evict(frame_id_t *frame_id) -> bool {
+  std::scoped_lock sl(latch_);
+  if (curr_size_ == 0) {
+    return false;
+  }
+  // A1in超过Kin时从A1in驱逐，否则从Am驱逐；首选的队列里没有可驱逐的frame时退回到另一个
+  const QueueType preferred = a1in_.size() > a1in_target_ ? QueueType::A1IN : QueueType::AM;
+  const QueueType other = preferred == QueueType::A1IN ? QueueType::AM : QueueType::A1IN;
+  const bool evicted = EvictFrom(preferred, frame_id) || EvictFrom(other, frame_id);
+  BUSTUB_ASSERT(evicted, "curr_size_ > 0 but no evictable frame");
+  curr_size_--;
+  return true;
+}
+
+auto TwoQueueReplacer::EvictFrom(QueueType queue, frame_id_t *frame_id) -> bool {
+  auto &frames = QueueOf(queue);
+  for (auto it = frames.begin(); it != frames.end(); ++it) {
+    auto &entry = frames_[*it];
+    if (!entry.evictable_) {
+      continue;
+    }
+    if (queue == QueueType::A1IN && entry.page_id_ != INVALID_PAGE_ID) {
+      a1out_.Push(entry.page_id_);
+      if (a1out_.Size() > a1out_capacity_) {
+        a1out_.PopOldest();
+      }
+    }
+    *frame_id = *it;
+    entry = FrameEntry{};
+    frames.erase(it);
+    return true;
+  }
+  return false;
+}
+
+void TwoQueueReplacer::RecordAccess(frame_id_t frame_id, page_id_t page_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (entry.queue_ == QueueType::AM) {
+    am_.splice(am_.end(), am_, entry.pos_);
+    return;
+  }
+  if (entry.queue_ == QueueType::A1IN) {
+    // A1in是FIFO，命中时不动（短时间内的相关访问不算热）
+    return;
+  }
+
+  entry.page_id_ = page_id;
+  entry.evictable_ = true;
+  curr_size_++;
+  entry.queue_ = page_id != INVALID_PAGE_ID && a1out_.Erase(page_id) ? QueueType::AM : QueueType::A1IN;
+  auto &frames = QueueOf(entry.queue_);
+  entry.pos_ = frames.insert(frames.end(), frame_id);
+}
+
+void TwoQueueReplacer::SetEvictable(frame_id_t frame_id, bool set_evictable) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (entry.queue_ == QueueType::NONE || entry.evictable_ == set_evictable) {
+    return;
+  }
+  entry.evictable_ = set_evictable;
+  if (set_evictable) {
+    curr_size_++;
+  } else {
+    curr_size_--;
+  }
+}
+
+void TwoQueueReplacer::Remove(frame_id_t frame_id) {
+  BUSTUB_ASSERT(frame_id >= 0 && static_cast<size_t>(frame_id) < frames_.size(), "invalid frame id");
+  std::scoped_lock sl(latch_);
+  auto &entry = frames_[frame_id];
+  if (entry.queue_ == QueueType::NONE) {
+    return;
+  }
+  if (entry.evictable_) {
+    curr_size_--;
+  }
+  QueueOf(entry.queue_).erase(entry.pos_);
+  entry = FrameEntry{};
+}
+
+auto TwoQueueReplacer::Size() -> size_t {
+  std::scoped_lock sl(latch_);
+  return curr_size_;
+}
+
+auto TwoQueueReplacer::EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> {
+  std::scoped_lock sl(latch_);
+  const QueueType preferred = a1in_.size() > a1in_target_ ? QueueType::A1IN : QueueType::AM;
+  const QueueType other = preferred == QueueType::A1IN ? QueueType::AM : QueueType::A1IN;
+  std::vector<frame_id_t> frames;
+  for (QueueType queue : {preferred, other}) {
+    for (auto it = QueueOf(queue).begin(); it != QueueOf(queue).end() && frames.size() < max_cnt; ++it) {
+      if (frames_[*it].evictable_) {
+        frames.push_back(*it);
+      }
+    }
+  }
+  return frames;
+}
+
+void TwoQueueReplacer::Resize(size_t num_frames) {
+  std::scoped_lock sl(latch_);
+  for (size_t i = num_frames; i < frames_.size(); i++) {
+    BUSTUB_ASSERT(frames_[i].queue_ == QueueType::NONE, "frames dropped by Resize must not be tracked");
+  }
+  frames_.resize(num_frames);
+  a1in_target_ = std::max<size_t>(1, num_frames / 4);
+  a1out_capacity_ = std::max<size_t>(1, num_frames / 2);
+  while (a1out_.Size() > a1out_capacity_) {
+    a1out_.PopOldest();
+  }
+}
+
+}  // namespace bustub
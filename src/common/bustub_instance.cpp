@@ -12,6 +12,8 @@
 #include "binder/statement/select_statement.h"
 #include "binder/statement/set_show_statement.h"
 #include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "buffer/pool_snapshot.h"
 #include "catalog/schema.h"
 #include "catalog/table_generator.h"
 #include "common/bustub_instance.h"
@@ -41,7 +43,21 @@ auto BustubInstance::MakeExecutorContext(Transaction *txn) -> std::unique_ptr<Ex
   return std::make_unique<ExecutorContext>(txn, catalog_, buffer_pool_manager_, txn_manager_, lock_manager_);
 }
 
-BustubInstance::BustubInstance(const std::string &db_file_name) {
+auto BustubInstance::MakeBufferPoolManager(size_t bpm_instances) -> BufferPoolManager * {
+  // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
+  // buffer pool size specified in `config.h`.
+  try {
+    if (bpm_instances > 1) {
+      return new ParallelBufferPoolManager(bpm_instances, 128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+    }
+    return new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
+  } catch (NotImplementedException &e) {
+    std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
+    return nullptr;
+  }
+}
+
+BustubInstance::BustubInstance(const std::string &db_file_name, size_t bpm_instances) {
   enable_logging = false;
 
   // Storage related.
@@ -50,13 +66,12 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
 
-  // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
-  // buffer pool size specified in `config.h`.
-  try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
-  } catch (NotImplementedException &e) {
-    std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
-    buffer_pool_manager_ = nullptr;
+  buffer_pool_manager_ = MakeBufferPoolManager(bpm_instances);
+
+  // Read back the pages that were resident at the last shutdown, before serving any query.
+  pool_snapshot_file_ = db_file_name + ".pool";
+  if (buffer_pool_manager_ != nullptr) {
+    buffer_pool_manager_->WarmUp(PoolSnapshot::Load(pool_snapshot_file_), WARM_UP_THREAD_CNT);
   }
 
   // Transaction (txn) related.
@@ -64,7 +79,7 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   txn_manager_ = new TransactionManager(lock_manager_, log_manager_);
 
   // Checkpoint related.
-  checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_);
+  checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_, disk_manager_);
 
   // Catalog.
   catalog_ = new Catalog(buffer_pool_manager_, lock_manager_, log_manager_);
@@ -73,7 +88,7 @@ BustubInstance::BustubInstance(const std::string &db_file_name) {
   execution_engine_ = new ExecutionEngine(buffer_pool_manager_, txn_manager_, catalog_);
 }
 
-BustubInstance::BustubInstance() {
+BustubInstance::BustubInstance(size_t bpm_instances) {
   enable_logging = false;
 
   // Storage related.
@@ -82,21 +97,14 @@ BustubInstance::BustubInstance() {
   // Log related.
   log_manager_ = new LogManager(disk_manager_);
 
-  // We need more frames for GenerateTestTable to work. Therefore, we use 128 instead of the default
-  // buffer pool size specified in `config.h`.
-  try {
-    buffer_pool_manager_ = new BufferPoolManagerInstance(128, disk_manager_, LRUK_REPLACER_K, log_manager_);
-  } catch (NotImplementedException &e) {
-    std::cerr << "BufferPoolManager is not implemented, only mock tables are supported." << std::endl;
-    buffer_pool_manager_ = nullptr;
-  }
+  buffer_pool_manager_ = MakeBufferPoolManager(bpm_instances);
 
   // Transaction (txn) related.
   lock_manager_ = new LockManager();
   txn_manager_ = new TransactionManager(lock_manager_, log_manager_);
 
   // Checkpoint related.
-  checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_);
+  checkpoint_manager_ = new CheckpointManager(txn_manager_, log_manager_, buffer_pool_manager_, disk_manager_);
 
   // Catalog.
   catalog_ = new Catalog(buffer_pool_manager_, lock_manager_, log_manager_);
@@ -146,6 +154,33 @@ void BustubInstance::CmdDisplayIndices(ResultWriter &writer) {
   writer.EndTable();
 }
 
+void BustubInstance::CmdDisplayBufferPoolStats(ResultWriter &writer) {
+  auto stats = buffer_pool_manager_->GetStats();
+  writer.BeginTable(false);
+  writer.BeginHeader();
+  for (const auto *name : {"tag", "hits", "misses", "hit_ratio", "evictions", "dirty_writes", "pin_waits"}) {
+    writer.WriteHeaderCell(name);
+  }
+  writer.EndHeader();
+  auto write_row = [&writer](const std::string &tag, const BufferPoolCounters &counters) {
+    writer.BeginRow();
+    writer.WriteCell(tag);
+    writer.WriteCell(fmt::format("{}", counters.hits_));
+    writer.WriteCell(fmt::format("{}", counters.misses_));
+    writer.WriteCell(fmt::format("{:.3f}", counters.HitRatio()));
+    writer.WriteCell(fmt::format("{}", counters.evictions_));
+    writer.WriteCell(fmt::format("{}", counters.dirty_writes_));
+    writer.WriteCell(fmt::format("{}", counters.pin_waits_));
+    writer.EndRow();
+  };
+  write_row("total", stats.total_);
+  write_row("untagged", stats.untagged_);
+  for (const auto &[tag, counters] : stats.tags_) {
+    write_row(tag, counters);
+  }
+  writer.EndTable();
+}
+
 void BustubInstance::WriteOneCell(const std::string &cell, ResultWriter &writer) {
   writer.BeginTable(true);
   writer.BeginRow();
@@ -160,6 +195,8 @@ void BustubInstance::CmdDisplayHelp(ResultWriter &writer) {
 \dt: show all tables
 \di: show all indices
 \help: show this message again
+SHOW buffer_pool_stats: show buffer pool hits, misses, evictions, dirty writes
+                        and pin waits, per table and index
 
 BusTub shell currently only supports a small set of Postgres queries. We'll set
 up a doc describing the current status later. It will silently ignore some parts
@@ -199,6 +236,8 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
   }
 
   bool is_successful = true;
+  // 会话或事务自己都可以关掉同步提交
+  txn->SetSynchronousCommit(txn->IsSynchronousCommit() && IsSynchronousCommit());
 
   std::shared_lock<std::shared_mutex> l(catalog_lock_);
   bustub::Binder binder(*catalog_);
@@ -251,6 +290,10 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       }
       case StatementType::VARIABLE_SHOW_STATEMENT: {
         const auto &show_stmt = dynamic_cast<const VariableShowStatement &>(*statement);
+        if (show_stmt.variable_ == "buffer_pool_stats") {
+          CmdDisplayBufferPoolStats(writer);
+          continue;
+        }
         auto content = GetSessionVariable(show_stmt.variable_);
         WriteOneCell(fmt::format("{}={}", show_stmt.variable_, content), writer);
         continue;
@@ -258,6 +301,10 @@ auto BustubInstance::ExecuteSqlTxn(const std::string &sql, ResultWriter &writer,
       case StatementType::VARIABLE_SET_STATEMENT: {
         const auto &set_stmt = dynamic_cast<const VariableSetStatement &>(*statement);
         session_variables_[set_stmt.variable_] = set_stmt.value_;
+        if (set_stmt.variable_ == "synchronous_commit") {
+          // 对当前事务的提交也生效
+          txn->SetSynchronousCommit(IsSynchronousCommit());
+        }
         continue;
       }
       case StatementType::EXPLAIN_STATEMENT: {
@@ -395,6 +442,9 @@ BustubInstance::~BustubInstance() {
   delete catalog_;
   delete checkpoint_manager_;
   delete log_manager_;
+  if (buffer_pool_manager_ != nullptr && !pool_snapshot_file_.empty()) {
+    buffer_pool_manager_->SnapshotResidentPages().Save(pool_snapshot_file_);
+  }
   delete buffer_pool_manager_;
   delete lock_manager_;
   delete txn_manager_;
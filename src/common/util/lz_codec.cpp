@@ -0,0 +1,153 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_codec.cpp
+//
+// Identification: src/common/util/lz_codec.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz_codec.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#include "common/macros.h"
+
+namespace bustub {
+
+namespace {
+
+constexpr size_t HASH_BITS = 12;
+constexpr size_t MAX_OFFSET = 0xFFFF;
+constexpr uint8_t NIBBLE_MAX = 15;
+
+auto Load32(const char *p) -> uint32_t {
+  uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+auto Hash(uint32_t sequence) -> size_t { return (sequence * 2654435761U) >> (32 - HASH_BITS); }
+
+/** Append the extension bytes of a length whose nibble is NIBBLE_MAX. */
+void PutLength(size_t length, std::vector<char> *dst) {
+  for (length -= NIBBLE_MAX; length >= 255; length -= 255) {
+    dst->push_back(static_cast<char>(255));
+  }
+  dst->push_back(static_cast<char>(length));
+}
+
+/** Read the extension bytes of a length whose nibble is NIBBLE_MAX. */
+auto GetLength(const uint8_t **ip, const uint8_t *end, size_t *length) -> bool {
+  while (true) {
+    if (*ip == end) {
+      return false;
+    }
+    const uint8_t byte = *(*ip)++;
+    *length += byte;
+    if (byte != 255) {
+      return true;
+    }
+  }
+}
+
+/** Append one sequence: the literals [literal, literal + literal_len) and a match, none if match_len is 0. */
+void PutSequence(const char *literal, size_t literal_len, size_t offset, size_t match_len, std::vector<char> *dst) {
+  const size_t match_code = match_len == 0 ? 0 : match_len - LZCodec::MIN_MATCH;
+  const auto literal_nibble = static_cast<uint8_t>(std::min<size_t>(literal_len, NIBBLE_MAX));
+  const auto match_nibble = static_cast<uint8_t>(std::min<size_t>(match_code, NIBBLE_MAX));
+  dst->push_back(static_cast<char>(literal_nibble << 4 | match_nibble));
+  if (literal_nibble == NIBBLE_MAX) {
+    PutLength(literal_len, dst);
+  }
+  dst->insert(dst->end(), literal, literal + literal_len);
+  if (match_len == 0) {
+    return;
+  }
+  dst->push_back(static_cast<char>(offset & 0xFF));
+  dst->push_back(static_cast<char>(offset >> 8));
+  if (match_nibble == NIBBLE_MAX) {
+    PutLength(match_code, dst);
+  }
+}
+
+}  // namespace
+
+void LZCodec::Compress(const char *src, size_t size, std::vector<char> *dst) {
+  BUSTUB_ASSERT(size <= MAX_OFFSET + 1, "LZCodec compresses at most 64 KB at a time");
+  dst->clear();
+  // 每个4字节序列的哈希 -> 上一次出现的位置，-1表示没有
+  std::array<int32_t, 1 << HASH_BITS> last_pos;
+  last_pos.fill(-1);
+  size_t anchor = 0;
+  size_t pos = 0;
+  while (pos + MIN_MATCH <= size) {
+    const uint32_t sequence = Load32(src + pos);
+    const size_t hash = Hash(sequence);
+    const int32_t candidate = last_pos[hash];
+    last_pos[hash] = static_cast<int32_t>(pos);
+    if (candidate < 0 || Load32(src + candidate) != sequence) {
+      pos++;
+      continue;
+    }
+    size_t match_len = MIN_MATCH;
+    while (pos + match_len < size && src[candidate + match_len] == src[pos + match_len]) {
+      match_len++;
+    }
+    PutSequence(src + anchor, pos - anchor, pos - candidate, match_len, dst);
+    pos += match_len;
+    anchor = pos;
+  }
+  if (anchor < size) {
+    PutSequence(src + anchor, size - anchor, 0, 0, dst);
+  }
+}
+
+auto LZCodec::Decompress(const char *src, size_t size, char *dst, size_t dst_size) -> bool {
+  const auto *ip = reinterpret_cast<const uint8_t *>(src);
+  const auto *end = ip + size;
+  size_t op = 0;
+  while (ip < end) {
+    const uint8_t token = *ip++;
+    size_t literal_len = token >> 4;
+    if (literal_len == NIBBLE_MAX && !GetLength(&ip, end, &literal_len)) {
+      return false;
+    }
+    if (literal_len > static_cast<size_t>(end - ip) || literal_len > dst_size - op) {
+      return false;
+    }
+    std::memcpy(dst + op, ip, literal_len);
+    ip += literal_len;
+    op += literal_len;
+    if (ip == end) {
+      break;
+    }
+
+    if (end - ip < 2) {
+      return false;
+    }
+    const size_t offset = ip[0] | static_cast<size_t>(ip[1]) << 8;
+    ip += 2;
+    size_t match_len = token & NIBBLE_MAX;
+    if (match_len == NIBBLE_MAX && !GetLength(&ip, end, &match_len)) {
+      return false;
+    }
+    match_len += MIN_MATCH;
+    if (offset == 0 || offset > op || match_len > dst_size - op) {
+      return false;
+    }
+    // 匹配可能和自己重叠（比如连续重复的字节），只能逐字节复制
+    for (size_t i = 0; i < match_len; i++, op++) {
+      dst[op] = dst[op - offset];
+    }
+  }
+  return op == dst_size;
+}
+
+}  // namespace bustub
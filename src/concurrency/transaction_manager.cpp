@@ -39,6 +39,10 @@ auto TransactionManager::Begin(Transaction *txn, IsolationLevel isolation_level)
     txn->SetPrevLSN(lsn);
   }
 
+  {
+    std::scoped_lock running_lock(running_txns_latch_);
+    running_txns_[txn->GetTransactionId()] = txn;
+  }
   std::unique_lock<std::shared_mutex> l(txn_map_mutex);
   txn_map[txn->GetTransactionId()] = txn;
   return txn;
@@ -60,8 +64,25 @@ void TransactionManager::Commit(Transaction *txn) {
   }
   write_set->clear();
 
+  if (enable_logging) {
+    LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::COMMIT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&record);
+    txn->SetPrevLSN(lsn);
+    if (txn->IsSynchronousCommit()) {
+      // 提交记录落盘之后才算提交成功；同时在等的提交由刷盘线程的同一次写盘一起完成（group commit）
+      log_manager_->Flush(lsn);
+    } else {
+      // 异步提交：提交记录进了日志缓冲区就返回，刷盘线程保证最迟async_commit_max_lag之后落盘
+      log_manager_->FlushAsync(lsn);
+    }
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
+  {
+    std::scoped_lock running_lock(running_txns_latch_);
+    running_txns_.erase(txn->GetTransactionId());
+  }
   // Release the global transaction latch.
   global_txn_latch_.RUnlock();
 }
@@ -110,8 +131,19 @@ void TransactionManager::Abort(Transaction *txn) {
   table_write_set->clear();
   index_write_set->clear();
 
+  // 回滚产生的日志之后写ABORT记录，不需要等它落盘
+  if (enable_logging) {
+    LogRecord record = LogRecord(txn->GetTransactionId(), txn->GetPrevLSN(), LogRecordType::ABORT);
+    lsn_t lsn = log_manager_->AppendLogRecord(&record);
+    txn->SetPrevLSN(lsn);
+  }
+
   // Release all the locks.
   ReleaseLocks(txn);
+  {
+    std::scoped_lock running_lock(running_txns_latch_);
+    running_txns_.erase(txn->GetTransactionId());
+  }
   // Release the global transaction latch.
   global_txn_latch_.RUnlock();
 }
@@ -120,4 +152,16 @@ void TransactionManager::BlockAllTransactions() { global_txn_latch_.WLock(); }
 
 void TransactionManager::ResumeTransactions() { global_txn_latch_.WUnlock(); }
 
+auto TransactionManager::GetActiveTransactionTable() -> std::vector<std::pair<txn_id_t, lsn_t>> {
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns;
+  std::scoped_lock running_lock(running_txns_latch_);
+  for (const auto &[txn_id, txn] : running_txns_) {
+    // 还没写过日志的事务恢复时不需要回滚
+    if (txn->GetPrevLSN() != INVALID_LSN) {
+      active_txns.emplace_back(txn_id, txn->GetPrevLSN());
+    }
+  }
+  return active_txns;
+}
+
 }  // namespace bustub
@@ -25,19 +25,30 @@ void IndexScanExecutor::Init() {
     BPlusTreeIndexForOneIntegerColumn* b_plus_tree_index= dynamic_cast<BPlusTreeIndexForOneIntegerColumn*>(indexinfo_->index_.get());    
     cursor_ = b_plus_tree_index->GetBeginIterator();
     end_ = b_plus_tree_index->GetEndIterator();
+    rids_.clear();
+    tuples_.clear();
+    next_ = 0;
 
 }
 
 auto IndexScanExecutor::Next(Tuple *tuple, RID *rid) -> bool { 
-    if ( cursor_==end_ ) {
-        return false;
+    // 一次从索引里取一批rid，再一起到表里读tuple，同一页上的tuple只需fetch一次
+    if (next_ == rids_.size()) {
+        rids_.clear();
+        for (; cursor_ != end_ && rids_.size() < static_cast<size_t>(INDEX_SCAN_BATCH_SIZE); ++cursor_) {
+            IntegerValueType value = (*cursor_).second;
+            rids_.push_back(value);
+        }
+        if (rids_.empty()) {
+            return false;
+        }
+        tableinfo_->table_->GetTuples(rids_, &tuples_, GetExecutorContext()->GetTransaction());
+        next_ = 0;
     }
 
-    auto kv_map = *cursor_;
-    IntegerValueType value = kv_map.second;
-    *rid = value;
-    tableinfo_->table_->GetTuple(value, tuple, GetExecutorContext()->GetTransaction());
-    ++cursor_;
+    *rid = rids_[next_];
+    *tuple = tuples_[next_];
+    next_++;
     return true;
 }
     
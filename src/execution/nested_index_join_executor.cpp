@@ -37,9 +37,10 @@ auto NestIndexJoinExecutor::FetchTupleByIndex(Tuple key, std::vector<Tuple> *res
   std::vector<RID> result_rids;
   b_plus_tree_index_->ScanKey(key, &result_rids, GetExecutorContext()->GetTransaction());
   int count = 0;
-  for (RID rid : result_rids) {
-	Tuple fetch_tuple;
-	tableinfo_->table_->GetTuple(rid, &fetch_tuple, GetExecutorContext()->GetTransaction());
+  // 同一个key的所有rid一起到表里读，每页只fetch一次
+  std::vector<Tuple> fetch_tuples;
+  tableinfo_->table_->GetTuples(result_rids, &fetch_tuples, GetExecutorContext()->GetTransaction());
+  for (Tuple &fetch_tuple : fetch_tuples) {
     result->push_back(std::move(fetch_tuple));
     count++;
   }
@@ -30,7 +30,11 @@ void SeqScanExecutor::Init() {
 
     table_info = catalog->GetTable(table_oid);
     
-    cursor_ = std::make_shared<TableIterator>(table_info->table_->Begin(ec->GetTransaction()));
+    // 估算会扫过大半个缓存池的表，通过私有的环形缓冲读，避免把其它查询的热页挤出去
+    if (plan_->use_ring_buffer_ && strategy_ == nullptr) {
+        strategy_ = std::make_unique<BufferAccessStrategy>(ec->GetBufferPoolManager(), SCAN_RING_BUFFER_SIZE);
+    }
+    cursor_ = std::make_shared<TableIterator>(table_info->table_->Begin(ec->GetTransaction(), strategy_.get()));
     end_ = std::make_shared<TableIterator>(table_info->table_->End());
     // 1. 如果是READ_COMMITTED事务的隔离级别，需要对表加上IS锁
     // 2. 对于REPEATABLE_READ隔离级别，我们也许对表加上IS锁，与1唯一的区别在与锁的释放时机
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// arc_replacer.h
+//
+// Identification: src/include/buffer/arc_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/ghost_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * ARCReplacer implements the Adaptive Replacement Cache policy (Megiddo and Modha, FAST '03).
+ *
+ * Resident pages live in T1 (seen once recently) or T2 (seen at least twice recently), both in LRU order. Pages
+ * evicted from T1 / T2 are remembered in the ghost lists B1 / B2. A miss that hits B1 means T1 was too small, a miss
+ * that hits B2 means T2 was too small; the target size of T1 adapts accordingly, which makes the policy resistant to
+ * scans without a tuning knob like the k of LRU-K.
+ */
+class ARCReplacer : public Replacer {
+ public:
+  /**
+   * @brief a new ARCReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit ARCReplacer(size_t num_frames);
+
+  ~ARCReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id = INVALID_PAGE_ID) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> override;
+
+  void Resize(size_t num_frames) override;
+
+ private:
+  enum class ListType { NONE, T1, T2 };
+
+  struct FrameEntry {
+    ListType list_{ListType::NONE};
+    bool evictable_{true};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** @brief Evict the least recently used evictable frame of a list into its ghost list. */
+  auto EvictFrom(ListType list, frame_id_t *frame_id) -> bool;
+
+  /** @brief Forget the oldest ghosts until |T1| + |B1| <= c and |T1| + |T2| + |B1| + |B2| <= 2c. */
+  void TrimGhosts();
+
+  auto ListOf(ListType list) -> std::list<frame_id_t> & { return list == ListType::T1 ? t1_ : t2_; }
+
+  std::mutex latch_;
+  size_t capacity_;
+  /** Target size of T1, "p" in the paper. */
+  size_t target_t1_{0};
+  /** Resident lists, least recently used first. */
+  std::list<frame_id_t> t1_;
+  std::list<frame_id_t> t2_;
+  GhostList b1_;
+  GhostList b2_;
+  std::vector<FrameEntry> frames_;
+  size_t curr_size_{0};
+};
+
+}  // namespace bustub
@@ -0,0 +1,71 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_access_strategy.h
+//
+// Identification: src/include/buffer/buffer_access_strategy.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <vector>
+
+#include "common/config.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * BufferAccessStrategy lets a bulk operation, such as a sequential scan over a table that is larger than the buffer
+ * pool, read its pages through a small private ring of frames instead of the main replacer.
+ *
+ * Pages fetched with BufferPoolManager::FetchPageWithStrategy() that are not already resident are loaded into the ring.
+ * Once the ring is full, its frames are recycled round robin. Ring frames never enter the replacer's access history,
+ * so a large scan cannot push the hot pages of other queries out of the pool. Pages that are already resident are
+ * pinned as usual, but the access is not recorded either.
+ *
+ * Destroying the strategy hands its frames back to the buffer pool. A strategy must not be used by more than one thread
+ * at a time.
+ */
+class BufferAccessStrategy {
+  friend class BufferPoolManagerInstance;
+
+ public:
+  /**
+   * @brief Create a ring strategy.
+   * @param bpm the buffer pool the strategy borrows its frames from
+   * @param ring_size the number of frames in the ring (per buffer pool instance)
+   */
+  BufferAccessStrategy(BufferPoolManager *bpm, size_t ring_size);
+
+  /** @brief Return the frames of the ring to the buffer pool. */
+  ~BufferAccessStrategy();
+
+  DISALLOW_COPY_AND_MOVE(BufferAccessStrategy);
+
+  /** @return the number of frames in the ring */
+  auto GetRingSize() const -> size_t { return ring_size_; }
+
+ private:
+  /** The frames one buffer pool instance lent to this strategy. */
+  struct Ring {
+    std::vector<frame_id_t> frames_;
+    /** The slot to recycle next once the ring is full. */
+    size_t next_{0};
+  };
+
+  /** @return the ring of the given buffer pool instance, only accessed under that instance's latch */
+  auto GetRing(uint32_t instance_index) -> Ring &;
+
+  BufferPoolManager *bpm_;
+  const size_t ring_size_;
+  std::vector<Ring> rings_;
+};
+
+}  // namespace bustub
@@ -14,12 +14,19 @@
 
 #include <list>
 #include <mutex>  // NOLINT
+#include <string>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_metrics.h"
 #include "buffer/lru_replacer.h"
+#include "buffer/pool_snapshot.h"
 #include "recovery/log_manager.h"
 #include "storage/disk/disk_manager.h"
 #include "storage/page/page.h"
+#include "storage/page/page_guard.h"
 
 namespace bustub {
 
@@ -45,6 +52,14 @@ class BufferPoolManager {
     return result;
   }
 
+  /**
+   * Fetch and pin a page on behalf of a table or index, whose buffer pool metrics count the access.
+   * @param page_id id of page to be fetched
+   * @param tag the tag of the table or index, see RegisterTag()
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPage(page_id_t page_id, BufferPoolTag tag) -> Page * { return FetchPgTaggedImp(page_id, nullptr, tag); }
+
   /** Grading function. Do not modify! */
   auto UnpinPage(page_id_t page_id, bool is_dirty, bufferpool_callback_fn callback = nullptr) -> bool {
     GradingCallback(callback, CallbackType::BEFORE, page_id);
@@ -84,9 +99,185 @@ class BufferPoolManager {
     GradingCallback(callback, CallbackType::AFTER, INVALID_PAGE_ID);
   }
 
+  /**
+   * Fetch and pin a page; the returned guard unpins it.
+   * @param page_id id of page to be fetched
+   * @return a guard holding the page, empty (!IsValid()) if the page cannot be fetched
+   */
+  auto FetchPageBasic(page_id_t page_id, BufferPoolTag tag = {}) -> BasicPageGuard {
+    return {this, FetchPgTaggedImp(page_id, nullptr, tag)};
+  }
+
+  /**
+   * Fetch, pin and read latch a page; the returned guard unlatches and unpins it.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring to read through for bulk reads, see FetchPageWithStrategy(); nullptr for a plain fetch
+   * @param tag the table or index the page belongs to, for the metrics
+   * @return a guard holding the page, empty (!IsValid()) if the page cannot be fetched
+   */
+  auto FetchPageRead(page_id_t page_id, BufferAccessStrategy *strategy = nullptr, BufferPoolTag tag = {})
+      -> ReadPageGuard {
+    Page *page = FetchPgTaggedImp(page_id, strategy, tag);
+    if (page == nullptr) {
+      return {};
+    }
+    page->RLatch();
+    return {this, page};
+  }
+
+  /**
+   * Fetch, pin and write latch a page; the returned guard unlatches and unpins it.
+   * @param page_id id of page to be fetched
+   * @param tag the table or index the page belongs to, for the metrics
+   * @return a guard holding the page, empty (!IsValid()) if the page cannot be fetched
+   */
+  auto FetchPageWrite(page_id_t page_id, BufferPoolTag tag = {}) -> WritePageGuard {
+    Page *page = FetchPgTaggedImp(page_id, nullptr, tag);
+    if (page == nullptr) {
+      return {};
+    }
+    page->WLatch();
+    return {this, page};
+  }
+
+  /**
+   * Fetch and pin a page for an optimistic read, without latching it; the returned guard unpins it. Reads through the
+   * guard must be validated, see OptimisticPageGuard.
+   * @param page_id id of page to be fetched
+   * @param tag the table or index the page belongs to, for the metrics
+   * @return a guard holding the page, empty (!IsValid()) if the page cannot be fetched
+   */
+  auto FetchPageOptimistic(page_id_t page_id, BufferPoolTag tag = {}) -> OptimisticPageGuard {
+    return {this, FetchPgTaggedImp(page_id, nullptr, tag)};
+  }
+
+  /**
+   * Create a new page, pinned and write latched; the returned guard unlatches and unpins it.
+   * @param[out] page_id id of created page
+   * @return a guard holding the page, empty (!IsValid()) if no new page could be created
+   */
+  auto NewPageWrite(page_id_t *page_id) -> WritePageGuard {
+    Page *page = NewPage(page_id);
+    if (page == nullptr) {
+      return {};
+    }
+    page->WLatch();
+    return {this, page};
+  }
+
+  /**
+   * Fetch and pin several pages, as if calling FetchPage() for each. Implementations take their latch once for the
+   * whole batch and read the missing pages one after the other once the latch is released, instead of one round trip
+   * per page. The pages are unpinned as usual, e.g. with UnpinPages().
+   * @param page_ids pages to fetch; a page listed twice is pinned twice
+   * @param tag the table or index the pages belong to, for the metrics
+   * @return pages[i] is the page page_ids[i], nullptr if it could not be fetched because every frame is pinned
+   */
+  auto FetchPages(const std::vector<page_id_t> &page_ids, BufferPoolTag tag = {}) -> std::vector<Page *> {
+    return FetchPagesImp(page_ids, tag);
+  }
+
+  /**
+   * Unpin several pages, as if calling UnpinPage() for each. Implementations take their latch once for the whole
+   * batch instead of once per page. Used by UnpinBatch.
+   * @param pages (page id, is dirty) pairs; a page may appear more than once if it was pinned more than once
+   */
+  virtual void UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) {
+    for (const auto &[page_id, is_dirty] : pages) {
+      UnpinPage(page_id, is_dirty);
+    }
+  }
+
   /** @return size of the buffer pool */
   virtual auto GetPoolSize() -> size_t = 0;
 
+  /**
+   * Read-ahead hint: the pages [first_page_id, first_page_id + page_cnt) are likely to be fetched soon. An
+   * implementation may start loading them asynchronously, without pinning them. The default ignores the hint.
+   * @param first_page_id first page of the range
+   * @param page_cnt number of pages in the range
+   */
+  virtual void Prefetch(__attribute__((unused)) page_id_t first_page_id, __attribute__((unused)) size_t page_cnt) {}
+
+  /**
+   * Reserve `page_cnt` consecutive page ids for NewPageInExtent(); NewPage() never hands them out. Used by
+   * ExtentAllocator to keep the pages of a table or index together on disk. The default does not support extents.
+   * @param page_cnt number of pages in the extent
+   * @return the first page id of the extent, INVALID_PAGE_ID if extents are not supported
+   */
+  virtual auto AllocateExtent(__attribute__((unused)) size_t page_cnt) -> page_id_t { return INVALID_PAGE_ID; }
+
+  /**
+   * Create a page of an extent, pinned and zeroed like a page from NewPage().
+   * @param page_id a page of an extent reserved with AllocateExtent() that was not created yet
+   * @return nullptr if no new page could be created, otherwise pointer to the new page
+   */
+  auto NewPageInExtent(page_id_t page_id) -> Page * { return NewPgInExtentImp(page_id); }
+
+  /**
+   * Fetch a page on behalf of a bulk operation. Pages that have to be read from disk go into the strategy's private
+   * ring of frames, see BufferAccessStrategy. The page is unpinned with UnpinPage() as usual. The default ignores the
+   * strategy.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring to read through, nullptr for a plain FetchPage()
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  virtual auto FetchPageWithStrategy(page_id_t page_id, __attribute__((unused)) BufferAccessStrategy *strategy)
+      -> Page * {
+    return FetchPage(page_id);
+  }
+
+  /**
+   * Give the frames of a strategy's ring back to the buffer pool. Called when the strategy is destroyed.
+   * @param strategy the strategy being destroyed
+   */
+  virtual void ReleaseStrategy(__attribute__((unused)) BufferAccessStrategy *strategy) {}
+
+  /**
+   * Hand out a tag for a table or index, to be passed along with its page fetches. Once BUFFER_POOL_MAX_TAGS - 1 tags
+   * are out, further ones are counted as untagged.
+   * @param name how GetStats() reports the tag, e.g. "table orders"
+   */
+  auto RegisterTag(const std::string &name) -> BufferPoolTag;
+
+  /**
+   * Take a snapshot of the metrics: hits, misses, evictions, dirty writes and pin waits, in total and per tag. The
+   * counters are summed when this is called, so they keep moving while the snapshot is taken.
+   */
+  auto GetStats() -> BufferPoolStats;
+
+  /**
+   * Sum the metrics counters of the pool. The default counts nothing.
+   * @return the counters indexed by tag id, empty if the pool keeps no metrics
+   */
+  virtual auto GetTagCounters() -> std::vector<BufferPoolCounters> { return {}; }
+
+  /**
+   * List the resident pages and their access history, to be saved at shutdown and handed to WarmUp() after a restart.
+   * The default returns an empty snapshot.
+   * @return the resident pages, coldest first
+   */
+  virtual auto SnapshotResidentPages() -> PoolSnapshot { return {}; }
+
+  /**
+   * Read the pages of a snapshot back into free frames and restore their access history, before the pool serves
+   * queries. The pages are read in page id order by several threads. The default loads nothing.
+   * @param snapshot pages saved by SnapshotResidentPages(), possibly by an earlier process
+   * @param thread_cnt number of reading threads, usually WARM_UP_THREAD_CNT
+   * @return the number of pages loaded
+   */
+  virtual auto WarmUp(__attribute__((unused)) const PoolSnapshot &snapshot, __attribute__((unused)) size_t thread_cnt)
+      -> size_t {
+    return 0;
+  }
+
+  /**
+   * Build the dirty page table for a checkpoint: every resident page whose page LSN is newer than its copy on disk,
+   * with its recLSN, the oldest LSN that may not be on disk yet. The default has no pages.
+   * @return page ids and their recLSN
+   */
+  virtual auto GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> { return {}; }
+
  protected:
   /**
    * Grading function. Do not modify!
@@ -108,6 +299,30 @@ class BufferPoolManager {
    */
   virtual auto FetchPgImp(page_id_t page_id) -> Page * = 0;
 
+  /**
+   * Fetch a page for a tagged access, through a strategy's ring if one is given. The default ignores the tag.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring to read through, nullptr for a plain fetch
+   * @param tag the table or index the page belongs to
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  virtual auto FetchPgTaggedImp(page_id_t page_id, BufferAccessStrategy *strategy,
+                                __attribute__((unused)) BufferPoolTag tag) -> Page * {
+    return strategy == nullptr ? FetchPgImp(page_id) : FetchPageWithStrategy(page_id, strategy);
+  }
+
+  /**
+   * Fetch several pages, see FetchPages(). The default fetches them one by one.
+   */
+  virtual auto FetchPagesImp(const std::vector<page_id_t> &page_ids, BufferPoolTag tag) -> std::vector<Page *> {
+    std::vector<Page *> pages;
+    pages.reserve(page_ids.size());
+    for (auto page_id : page_ids) {
+      pages.push_back(FetchPgTaggedImp(page_id, nullptr, tag));
+    }
+    return pages;
+  }
+
   /**
    * Unpin the target page from the buffer pool.
    * @param page_id id of page to be unpinned
@@ -130,6 +345,13 @@ class BufferPoolManager {
    */
   virtual auto NewPgImp(page_id_t *page_id) -> Page * = 0;
 
+  /**
+   * Creates a page of an extent in the buffer pool. The default does not support extents.
+   * @param page_id id of the page to create
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  virtual auto NewPgInExtentImp(__attribute__((unused)) page_id_t page_id) -> Page * { return nullptr; }
+
   /**
    * Deletes a page from the buffer pool.
    * @param page_id id of page to be deleted
@@ -141,5 +363,11 @@ class BufferPoolManager {
    * Flushes all the pages in the buffer pool to disk.
    */
   virtual void FlushAllPgsImp() = 0;
+
+ private:
+  /** Protects tag_names_. */
+  std::mutex tag_latch_;
+  /** tag_names_[id] is the name of tag id; tag 0 is the untagged one. */
+  std::vector<std::string> tag_names_{""};
 };
 }  // namespace bustub
@@ -12,12 +12,24 @@
 
 #pragma once
 
+#include <atomic>
+#include <chrono>              // NOLINT
+#include <condition_variable>  // NOLINT
+#include <deque>
 #include <list>
-#include <mutex>  // NOLINT
+#include <memory>
+#include <mutex>   // NOLINT
+#include <thread>  // NOLINT
 #include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
-#include "buffer/lru_k_replacer.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/frame_memory.h"
+#include "buffer/free_page_map.h"
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "container/hash/extendible_hash_table.h"
 #include "recovery/log_manager.h"
@@ -26,6 +38,18 @@
 
 namespace bustub {
 
+/**
+ * Tuning knobs of the buffer pool's background writer.
+ */
+struct BackgroundWriterOptions {
+  /** The writer tries to keep this many of the coldest evictable frames clean. */
+  size_t clean_frame_target_{16};
+  /** Rate limit: at most this many pages are written per round. */
+  size_t max_writes_per_round_{8};
+  /** Pause between two rounds. */
+  std::chrono::milliseconds interval_{10};
+};
+
 /**
  * BufferPoolManager reads disk pages to and from its internal buffer pool.
  */
@@ -37,9 +61,24 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    * @param disk_manager the disk manager
    * @param replacer_k the lookback constant k for the LRU-K replacer
    * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_type the page replacement policy
    */
   BufferPoolManagerInstance(size_t pool_size, DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
-                            LogManager *log_manager = nullptr);
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = BUFFER_POOL_REPLACER);
+
+  /**
+   * @brief Creates a new BufferPoolManagerInstance that is one shard of a ParallelBufferPoolManager.
+   * @param pool_size the size of the buffer pool
+   * @param num_instances total number of BPIs in the parallel BPM
+   * @param instance_index index of this BPI in the parallel BPM
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer
+   * @param log_manager the log manager (for testing only: nullptr = disable logging). Please ignore this for P1.
+   * @param replacer_type the page replacement policy
+   */
+  BufferPoolManagerInstance(size_t pool_size, uint32_t num_instances, uint32_t instance_index,
+                            DiskManager *disk_manager, size_t replacer_k = LRUK_REPLACER_K,
+                            LogManager *log_manager = nullptr, ReplacerType replacer_type = BUFFER_POOL_REPLACER);
 
   /**
    * @brief Destroy an existing BufferPoolManagerInstance.
@@ -49,8 +88,178 @@ class BufferPoolManagerInstance : public BufferPoolManager {
   /** @brief Return the size (number of frames) of the buffer pool. */
   auto GetPoolSize() -> size_t override { return pool_size_; }
 
-  /** @brief Return the pointer to all the pages in the buffer pool. */
-  auto GetPages() -> Page * { return pages_; }
+  /** @brief Return the page in a frame of the buffer pool. */
+  auto GetFrame(frame_id_t frame_id) -> Page *;
+
+  /**
+   * @brief Change the number of frames while the pool is in use.
+   *
+   * Growing allocates a new chunk of frames (or reactivates frames left over by an earlier shrink) and hands them to
+   * the free list. Shrinking retires the frames with an id >= new_size: resident pages there are written back if
+   * dirty and dropped, and frames that are still pinned are retired once their last pin goes away, so the call blocks
+   * until the pages of the retired frames are unpinned. Chunks that end up wholly unused are freed. Concurrent
+   * fetches keep running; the replacer is resized to match, the page table grows and shrinks on its own.
+   *
+   * @param new_size the new number of frames, must be positive
+   */
+  void Resize(size_t new_size);
+
+  /**
+   * @brief Queue the pages for asynchronous loading by the prefetch thread, which is started on first use. The pages
+   * are not pinned; pages that are already resident, that were never allocated or deleted, or that belong to another
+   * shard are skipped.
+   *
+   * @param first_page_id first page of the range
+   * @param page_cnt number of pages to load
+   */
+  void Prefetch(page_id_t first_page_id, size_t page_cnt) override;
+
+  /**
+   * @brief Fetch a page through a strategy's ring. A miss loads the page into the next frame of the ring, which is
+   * taken from the pool while the ring is still filling up; ring frames are never tracked by the replacer. A hit pins
+   * the page without recording an access.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring to read through, nullptr for a plain FetchPage()
+   * @return nullptr if page_id cannot be fetched, otherwise pointer to the requested page
+   */
+  auto FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * @brief FetchPgImp or FetchPageWithStrategy, counting the access under tag. Public so that a parallel BPM can route
+   * tagged fetches to its instances.
+   */
+  auto FetchPgTaggedImp(page_id_t page_id, BufferAccessStrategy *strategy, BufferPoolTag tag) -> Page * override;
+
+  /**
+   * @brief Hand the ring frames of a strategy back to the replacer (as its coldest entries) or, if they no longer hold
+   * a page, to the free list.
+   * @param strategy the strategy being destroyed
+   */
+  void ReleaseStrategy(BufferAccessStrategy *strategy) override;
+
+  /**
+   * @brief Unpin a batch of pages under one acquisition of the latch.
+   * @param pages (page id, is dirty) pairs
+   */
+  void UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) override;
+
+  /**
+   * @brief List the resident pages, coldest first in the replacer's eviction order, followed by the pinned ones. Pages
+   * read through a strategy's ring are left out.
+   */
+  auto SnapshotResidentPages() -> PoolSnapshot override;
+
+  /**
+   * @brief Load the pages of a snapshot that belong to this instance into free frames. If there are more pages than
+   * free frames, the hottest ones are loaded. Pages that are already resident or deleted are skipped. Fetches of a page
+   * that is still being read wait for the read, like for any miss.
+   * @param snapshot pages saved by SnapshotResidentPages()
+   * @param thread_cnt number of reading threads, each reads a run of consecutive page ids
+   * @return the number of pages loaded
+   */
+  auto WarmUp(const PoolSnapshot &snapshot, size_t thread_cnt) -> size_t override;
+
+  /**
+   * @brief The recLSN of a page is the LSN after the page LSN it had when last read or written, so it never misses a
+   * change that is not on disk; it may be older than the first change since then. Pages being written count as dirty.
+   */
+  auto GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> override;
+
+  /** @brief Sum the per-thread metrics counters, indexed by tag id. */
+  auto GetTagCounters() -> std::vector<BufferPoolCounters> override { return metrics_.Collect(); }
+
+  /** @brief Return the number of pages loaded by the prefetch thread. */
+  auto GetPrefetchCount() const -> uint64_t { return prefetch_reads_; }
+
+  /**
+   * @brief Start a thread that writes dirty pages back before they are chosen for eviction, so that foreground misses
+   * find clean victims. Does nothing if the writer is already running.
+   * @param options clean-frame target, rate limit and interval of the writer
+   */
+  void StartBackgroundWriter(const BackgroundWriterOptions &options = BackgroundWriterOptions{});
+
+  /** @brief Stop and join the background writer, if running. */
+  void StopBackgroundWriter();
+
+  /**
+   * @brief Run one round of the background writer on the calling thread: look at the coldest
+   * options.clean_frame_target_ evictable frames and write back up to options.max_writes_per_round_ dirty ones.
+   * @return the number of pages written, 0 if the write failed and the pages were marked dirty again
+   */
+  auto BackgroundWriteRound(const BackgroundWriterOptions &options) -> size_t;
+
+  /** @brief Return the number of pages written by the background writer. */
+  auto GetBackgroundWriteCount() const -> uint64_t { return background_writes_; }
+
+  /** @brief Return the number of dirty victims written back synchronously by NewPage/FetchPage. */
+  auto GetForegroundWriteCount() const -> uint64_t { return foreground_writes_; }
+
+  /**
+   * @brief Size the compressed tier. Evicted pages that match the disk (clean ones, and dirty ones once written back)
+   * are kept there compressed, and misses look there before reading the disk. Pages evicted from a strategy's ring are
+   * not kept. 0 disables the tier.
+   * @param bytes capacity of the tier in compressed bytes
+   */
+  void SetCompressedTierSize(size_t bytes) { compressed_tier_.SetCapacity(bytes); }
+
+  /** @brief Return the compressed tier, for its hit counters and compression ratio. */
+  auto GetCompressedTier() -> CompressedPageCache & { return compressed_tier_; }
+
+  /** A dirty page pinned by PinDirtyPages() to be written out. */
+  struct DirtyPage {
+    frame_id_t frame_id_;
+    page_id_t page_id_;
+    const char *data_;
+    /** The page LSN when it was pinned, on disk once the page is written. */
+    lsn_t lsn_;
+  };
+
+  /**
+   * @brief First step of FlushAllPages(): pin every dirty page and clear its dirty flag; changes made while the page is
+   * written set it again. ParallelBufferPoolManager gathers the pages of all instances, so that adjacent pages of
+   * different instances are written together.
+   * @return the pinned pages, to be written and then handed to UnpinFlushedPages()
+   */
+  auto PinDirtyPages() -> std::vector<DirtyPage>;
+
+  /** @brief Unpin the pages returned by PinDirtyPages() once they are written. */
+  void UnpinFlushedPages(const std::vector<DirtyPage> &pages);
+
+  /** @brief Last step of FlushAllPages(): write the free page map into free pages and remember its root. */
+  void SaveFreePageMap();
+
+  /**
+   * @brief Reserve page_cnt consecutive page ids for NewPageInExtent(). Only a standalone instance owns consecutive
+   * page ids; a shard returns INVALID_PAGE_ID and ParallelBufferPoolManager reserves the extent across its shards.
+   * @return the first page id of the extent, or INVALID_PAGE_ID
+   */
+  auto AllocateExtent(size_t page_cnt) -> page_id_t override;
+
+  /** @brief Return the page id NewPage hands out next once the free page map is empty. */
+  auto GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+  /**
+   * @brief Take the page ids of this instance in [first_page_id, end_page_id) away from NewPage, for an extent. The
+   * page ids this instance skips to get there go to the free page map.
+   * @return false, reserving nothing, if NewPage already handed out a page id at or after first_page_id
+   */
+  auto ReservePageIds(page_id_t first_page_id, page_id_t end_page_id) -> bool;
+
+  /**
+   * @brief Give the page ids of this instance in [first_page_id, end_page_id), reserved but unused, back to NewPage:
+   * the next page id moves back to the start of the range if nothing was allocated after it, otherwise the page ids go
+   * to the free page map.
+   */
+  void FreePageIds(page_id_t first_page_id, page_id_t end_page_id);
+
+  /** @brief Return the number of deleted pages waiting to be reused by NewPage. */
+  auto GetFreePageCount() -> size_t;
+
+  /**
+   * @brief Return the first page of the free page map as FlushAllPages() last wrote it, see FreePageMap::Load().
+   * INVALID_PAGE_ID if the map was empty, or if NewPage reused a free page since, which may have overwritten it.
+   */
+  auto GetFreePageMapRoot() -> page_id_t;
 
  protected:
   /**
@@ -72,6 +281,12 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto NewPgImp(page_id_t *page_id) -> Page * override;
 
+  /**
+   * @brief Create page page_id of an extent like NewPgImp(). If the page is already resident, because a read-ahead of
+   * the pages before it loaded it, that frame is pinned and zeroed instead.
+   */
+  auto NewPgInExtentImp(page_id_t page_id) -> Page * override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -90,6 +305,16 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto FetchPgImp(page_id_t page_id) -> Page * override;
 
+  /**
+   * @brief Fetch a batch of pages. Hits are pinned and frames for the misses are acquired under one acquisition of the
+   * latch; the misses are then read in page id order without the latch. A page whose eviction is still being written
+   * back is fetched on its own afterwards. Once every frame is pinned, the remaining misses come back as nullptr.
+   * @param page_ids pages to fetch; a page listed twice is pinned twice
+   * @param tag the table or index the pages belong to
+   * @return pages[i] is the page page_ids[i], nullptr if it could not be fetched
+   */
+  auto FetchPagesImp(const std::vector<page_id_t> &page_ids, BufferPoolTag tag) -> std::vector<Page *> override;
+
   /**
    * TODO(P1): Add implementation
    *
@@ -140,40 +365,229 @@ class BufferPoolManagerInstance : public BufferPoolManager {
    */
   auto DeletePgImp(page_id_t page_id) -> bool override;
 
-  /** Number of pages in the buffer pool. */
-  const size_t pool_size_;
+  /** Number of frames in the buffer pool. Frames with an id >= pool_size_ are being retired by Resize() or unused. */
+  std::atomic<size_t> pool_size_;
+  /** How many instances are in the parallel BPM (if present, otherwise just 1 BPI) */
+  const uint32_t num_instances_ = 1;
+  /** Index of this BPI in the parallel BPM (if present, otherwise just 0) */
+  const uint32_t instance_index_ = 0;
   /** The next page id to be allocated  */
   std::atomic<page_id_t> next_page_id_ = 0;
   /** Bucket size for the extendible hash table */
   const size_t bucket_size_ = 4;
 
-  /** Array of buffer pool pages. */
-  Page *pages_;
+  /** A block of frames allocated by the constructor or by Resize(), holding frames [first_frame_, first_frame_ + n). */
+  struct FrameChunk {
+    size_t first_frame_;
+    /** The page data of the chunk's frames, BUSTUB_PAGE_SIZE aligned for direct I/O. */
+    FrameMemory memory_;
+    /** The chunk's frames, pointing into memory_. A deque constructs them in place and never moves them. */
+    std::deque<Page> pages_;
+  };
+  /** @brief Allocate the frames [first_frame, first_frame + frame_cnt), on huge pages if BUFFER_POOL_HUGE_PAGES. */
+  static auto MakeFrameChunk(size_t first_frame, size_t frame_cnt) -> FrameChunk;
+  /** The frame memory, in frame order. A frame never moves while its chunk exists. */
+  std::vector<FrameChunk> frame_chunks_;
+  /** pages_[frame_id] is the page of a frame, over all chunks. Guarded by latch_, which Resize() holds to extend it. */
+  std::vector<Page *> pages_;
+  /** Serializes Resize() calls. */
+  std::mutex resize_latch_;
   /** Pointer to the disk manager. */
   DiskManager *disk_manager_ __attribute__((__unused__));
   /** Pointer to the log manager. Please ignore this for P1. */
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
   /** Page table for keeping track of buffer pool pages. */
   ExtendibleHashTable<page_id_t, frame_id_t> *page_table_;
   /** Replacer to find unpinned pages for replacement. */
-  LRUKReplacer *replacer_;
+  std::unique_ptr<Replacer> replacer_;
   /** List of free frames that don't have any pages on them. */
   std::list<frame_id_t> free_list_;
-  /** This latch protects shared data structures. We recommend updating this comment to describe what it protects. */
-  std::recursive_mutex latch_;
+  /**
+   * Protects the page table, the replacer, the free list, the frame metadata (page id, pin count, dirty flag) and the
+   * I/O state below. It is never held across a disk read or write.
+   */
+  std::mutex latch_;
+  /** Signalled whenever a frame finishes its I/O or a write-back completes. */
+  std::condition_variable io_cv_;
+  /**
+   * io_in_progress_[frame_id] is true while the frame is being filled from disk or its previous dirty page is being
+   * written back. The frame is already mapped and pinned, so concurrent fetchers of the same page wait on io_cv_
+   * instead of issuing a second read.
+   */
+  std::vector<bool> io_in_progress_;
+  /** frame_owner_[frame_id] is the strategy whose ring holds the frame, nullptr for frames managed by the replacer. */
+  std::vector<BufferAccessStrategy *> frame_owner_;
+  /** Pages that were evicted dirty and whose write-back has not finished yet. They must not be read back until then. */
+  std::unordered_set<page_id_t> writing_back_;
+
+  /** The background writer thread, nullptr when it is not running. */
+  std::thread *bg_writer_thread_{nullptr};
+  /** Protects the writer's thread handle, options and stop flag. */
+  std::mutex bg_writer_latch_;
+  std::condition_variable bg_writer_cv_;
+  bool bg_writer_stop_{false};
+  BackgroundWriterOptions bg_writer_options_;
+  /** The prefetch thread, started by the first Prefetch() call. */
+  std::thread *prefetch_thread_{nullptr};
+  /** Protects the prefetch queue, thread handle and stop flag. */
+  std::mutex prefetch_latch_;
+  std::condition_variable prefetch_cv_;
+  bool prefetch_stop_{false};
+  /** Pages waiting to be loaded, bounded by pool_size_. */
+  std::deque<page_id_t> prefetch_queue_;
+  /** Pages loaded by the prefetch thread. */
+  std::atomic<uint64_t> prefetch_reads_{0};
+
+  /** Pages written by the background writer. */
+  std::atomic<uint64_t> background_writes_{0};
+  /** Dirty victims written back on the foreground path. */
+  std::atomic<uint64_t> foreground_writes_{0};
+
+  /** Deleted pages of this instance, reused by AllocatePage() before it extends the file. */
+  FreePageMap free_page_map_;
+  /** Number of FlushAllPages() calls writing the free page map right now; its pages must not be reused meanwhile. */
+  size_t free_page_map_savers_{0};
+  /** Where the map was last saved, INVALID_PAGE_ID if that copy may have been overwritten since. */
+  page_id_t free_page_map_root_{INVALID_PAGE_ID};
+
+  /** Hit, miss, eviction, dirty write and pin wait counters, per thread and tag. */
+  BufferPoolMetrics metrics_;
+
+  /** Evicted pages kept in memory compressed. A page in the tier is never resident, and matches the disk. */
+  CompressedPageCache compressed_tier_{COMPRESSED_TIER_SIZE};
 
   /**
-   * @brief Allocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief Allocate a page on disk, reusing the lowest deleted page if there is one and extending the file otherwise.
+   * Caller should acquire the latch before calling this function.
    * @return the id of the allocated page
    */
   auto AllocatePage() -> page_id_t;
 
   /**
-   * @brief Deallocate a page on disk. Caller should acquire the latch before calling this function.
+   * @brief NewPgImp and NewPgInExtentImp: acquire a frame and map a new, zeroed page to it, releasing the latch to
+   * write back a dirty victim. Caller must hold the latch through *lock.
+   * @param page_id the page to create, INVALID_PAGE_ID to allocate one with AllocatePage()
+   * @param[out] new_page_id the created page
+   * @return nullptr if every frame is pinned
+   */
+  auto CreatePage(std::unique_lock<std::mutex> *lock, page_id_t page_id, page_id_t *new_page_id) -> Page *;
+
+  /**
+   * @brief Take a frame from the free list, or evict one. The evicted page is unmapped; if it was dirty, or if it is
+   * clean and the compressed tier is enabled, its id is returned through victim_page_id and recorded in writing_back_,
+   * and the caller must call EvictVictim() before reusing the frame. Caller must hold the latch.
+   * @param[out] frame_id the acquired frame
+   * @param[out] victim_page_id the page that still has to be written back or put in the tier, or INVALID_PAGE_ID
+   * @param[out] victim_dirty whether the victim has to be written back
+   * @param tag the access an eviction is counted for
+   * @return false if every frame is pinned
+   */
+  auto AcquireFrame(frame_id_t *frame_id, page_id_t *victim_page_id, bool *victim_dirty, BufferPoolTag tag) -> bool;
+
+  /**
+   * @brief Write back a victim returned by AcquireFrame() if it is dirty, and keep a copy in the compressed tier.
+   * Called without the latch, before the frame is overwritten.
+   * @param page the frame still holding the victim
+   * @param keep_in_tier false for victims of a strategy's ring
+   * @param tag the access a dirty write is counted for
+   */
+  void EvictVictim(Page *page, page_id_t victim_page_id, bool victim_dirty, bool keep_in_tier, BufferPoolTag tag);
+
+  /**
+   * @brief Write-ahead rule: make the log durable up to the LSN of a page about to be written, forcing a log flush
+   * if needed. Also applies while logging is disabled, when recovery logs the rollback of the losers; LogManager::Flush
+   * clamps the LSNs of pages that are not logged. No-op without a log manager. Called without the latch.
+   * @param lsn the largest page LSN among the pages about to be written
+   */
+  void ForceLogUpTo(lsn_t lsn);
+
+  /** @brief The disk LSN of a page created now: all records so far, and none of the new page's own, are older. */
+  auto NewPageDiskLsn() -> lsn_t;
+
+  /**
+   * @brief Drop one pin of a frame. Once the frame is unpinned it becomes evictable, or, if Resize() is retiring it,
+   * the resizing thread is woken up instead. Caller must hold the latch.
+   */
+  void ReleasePin(frame_id_t frame_id);
+
+  /**
+   * @brief Empty the frames with an id >= new_size, writing dirty pages back and waiting for pinned ones. Caller must
+   * hold the latch through *lock and must have set pool_size_ to new_size.
+   */
+  void RetireFrames(std::unique_lock<std::mutex> *lock, size_t new_size);
+
+  /** @brief UnpinPgImp and UnpinPages. Caller must hold the latch. */
+  auto UnpinPageLocked(page_id_t page_id, bool is_dirty) -> bool;
+
+  /** @brief FetchPgImp, FetchPageWithStrategy and FetchPgTaggedImp. */
+  auto FetchPageImpl(page_id_t page_id, BufferAccessStrategy *strategy, BufferPoolTag tag) -> Page *;
+
+  /**
+   * @brief Miss path shared by FetchPgImp and the prefetcher: acquire a frame, map page_id to it and read the page,
+   * releasing the latch for the I/O. Caller must hold the latch through *lock, and page_id must not be resident.
+   * @param lock the caller's lock on latch_, unlocked and relocked around the I/O
+   * @param page_id the page to load
+   * @param[out] frame_id the frame the page was loaded into, pinned once
+   * @param strategy take the frame from this strategy's ring if possible, may be nullptr
+   * @param tag the access evictions and dirty writes are counted for
+   * @return false if every frame is pinned
+   */
+  auto LoadPage(std::unique_lock<std::mutex> *lock, page_id_t page_id, frame_id_t *frame_id,
+                BufferAccessStrategy *strategy, BufferPoolTag tag) -> bool;
+
+  /** A miss of a batch: its frame was taken by AcquireFrame(), mapped by InstallPage() and marked as doing I/O. */
+  struct PendingLoad {
+    page_id_t page_id_;
+    frame_id_t frame_id_;
+    Page *page_;
+    page_id_t victim_page_id_;
+    bool victim_dirty_;
+  };
+
+  /**
+   * @brief Batch miss path shared by FetchPages and the prefetcher: write back the dirty victims, put the victims in
+   * the compressed tier and read the pages, handing all writes and then all reads to the disk manager at once so they
+   * are in flight together. Caller must hold the latch through *lock; it is released for the I/O.
+   */
+  void LoadPages(std::unique_lock<std::mutex> *lock, const std::vector<PendingLoad> &loads, BufferPoolTag tag);
+
+  /**
+   * @brief Take the next frame of a strategy's ring: a new frame from the pool while the ring is not full, otherwise
+   * the next ring slot, whose page is unmapped like an evicted one. Caller must hold the latch.
+   * @return false if the ring slot is pinned, the caller then falls back to AcquireFrame()
+   */
+  auto AcquireRingFrame(BufferAccessStrategy *strategy, frame_id_t *frame_id, page_id_t *victim_page_id,
+                        bool *victim_dirty, BufferPoolTag tag) -> bool;
+
+  /** @brief Load a batch of queued pages on the prefetch thread and leave them unpinned. */
+  void PrefetchPages(const std::vector<page_id_t> &page_ids);
+
+  /** @brief Stop and join the prefetch thread, dropping queued pages. */
+  void StopPrefetcher();
+
+  /**
+   * @brief Map page_id to frame_id and pin it once. Caller must hold the latch.
+   * @param track_in_replacer record the access in the replacer; false for ring frames
+   */
+  void InstallPage(frame_id_t frame_id, page_id_t page_id, bool track_in_replacer);
+
+  /**
+   * @brief Clear the I/O state of a frame once its write-back / read is done and wake up the waiters. Caller must hold
+   * the latch.
+   */
+  void FinishFrameIo(frame_id_t frame_id, page_id_t victim_page_id);
+
+  /**
+   * @brief Check that the page id routes to this instance. Only meaningful when this BPI is a shard.
+   * @param page_id the page id to validate
+   */
+  void ValidatePageId(page_id_t page_id) const;
+
+  /**
+   * @brief Deallocate a page on disk: record it in the free page map so AllocatePage() can reuse it. Caller should
+   * acquire the latch before calling this function.
    * @param page_id id of the page to deallocate
    */
-  void DeallocatePage(__attribute__((unused)) page_id_t page_id) {
-    // This is a no-nop right now without a more complex data structure to track deallocated pages
-  }
+  void DeallocatePage(page_id_t page_id);
 };
 }  // namespace bustub
@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// buffer_pool_metrics.h
+//
+// Identification: src/include/buffer/buffer_pool_metrics.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * BufferPoolTag names the table or index a page access is made for, so that the buffer pool metrics can be broken
+ * down per table and index. Tags are handed out by BufferPoolManager::RegisterTag(); the default tag 0 stands for
+ * accesses nobody claimed.
+ */
+class BufferPoolTag {
+ public:
+  BufferPoolTag() = default;
+  explicit BufferPoolTag(uint32_t id) : id_(id) {}
+
+  auto GetId() const -> uint32_t { return id_; }
+
+ private:
+  uint32_t id_{0};
+};
+
+/** The buffer pool counters of one tag, or of the whole pool. */
+struct BufferPoolCounters {
+  /** Fetches that found their page resident. */
+  uint64_t hits_{0};
+  /** Fetches that had to load their page. */
+  uint64_t misses_{0};
+  /** Pages evicted to make room. */
+  uint64_t evictions_{0};
+  /** Dirty pages written back, by a fetch evicting them or by the background writer. */
+  uint64_t dirty_writes_{0};
+  /** Fetches that had to wait for another thread's read or write-back of their page. */
+  uint64_t pin_waits_{0};
+
+  auto operator+=(const BufferPoolCounters &that) -> BufferPoolCounters &;
+
+  /** @return hits / (hits + misses), 0 if there was no fetch */
+  auto HitRatio() const -> double;
+};
+
+/** A snapshot of the buffer pool counters, see BufferPoolManager::GetStats(). */
+struct BufferPoolStats {
+  /** Every access, tagged or not. */
+  BufferPoolCounters total_;
+  /** Accesses without a tag. */
+  BufferPoolCounters untagged_;
+  /** (tag name, counters) for every registered tag, in registration order. */
+  std::vector<std::pair<std::string, BufferPoolCounters>> tags_;
+};
+
+/**
+ * BufferPoolMetrics counts the events of one buffer pool instance without taking a latch. Each thread adds to its own
+ * stripe of relaxed atomic counters (threads are spread over the stripes round robin, so a stripe is shared only when
+ * there are more threads than stripes), and Collect() sums the stripes when somebody asks.
+ */
+class BufferPoolMetrics {
+ public:
+  enum class Counter { HIT = 0, MISS, EVICTION, DIRTY_WRITE, PIN_WAIT };
+
+  /** @brief Add n to a counter of a tag. Tags beyond BUFFER_POOL_MAX_TAGS are counted as untagged. */
+  void Add(BufferPoolTag tag, Counter counter, uint64_t n = 1) {
+    const uint32_t id = tag.GetId() < BUFFER_POOL_MAX_TAGS ? tag.GetId() : 0;
+    stripes_[StripeIndex()].counters_[id][static_cast<size_t>(counter)].fetch_add(n, std::memory_order_relaxed);
+  }
+
+  /** @return the counters summed over all stripes, indexed by tag id */
+  auto Collect() const -> std::vector<BufferPoolCounters>;
+
+ private:
+  static constexpr size_t STRIPE_CNT = 16;
+  static constexpr size_t COUNTER_CNT = 5;
+
+  struct alignas(64) Stripe {
+    std::array<std::array<std::atomic<uint64_t>, COUNTER_CNT>, BUFFER_POOL_MAX_TAGS> counters_{};
+  };
+
+  /** @return the stripe of the calling thread */
+  static auto StripeIndex() -> size_t;
+
+  std::array<Stripe, STRIPE_CNT> stripes_;
+};
+
+}  // namespace bustub
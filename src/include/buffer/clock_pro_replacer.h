@@ -0,0 +1,114 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// clock_pro_replacer.h
+//
+// Identification: src/include/buffer/clock_pro_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * ClockProReplacer implements the CLOCK-Pro policy (Jiang, Chen and Zhang, USENIX ATC '05), a clock approximation of
+ * LIRS.
+ *
+ * All pages sit on one circular list. Resident pages are hot or cold; a cold page that is read again during its test
+ * period (while it or its non-resident ghost is still on the clock) becomes hot. Three hands sweep the clock:
+ * - the cold hand evicts unreferenced cold pages and gives referenced ones another test period,
+ * - the hot hand demotes unreferenced hot pages and ends the test periods it passes,
+ * - the test hand bounds the number of non-resident pages to the number of frames.
+ * The share of frames given to cold pages adapts: it grows when a non-resident page is read back and shrinks when a
+ * test period expires.
+ */
+class ClockProReplacer : public Replacer {
+ public:
+  /**
+   * @brief a new ClockProReplacer.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit ClockProReplacer(size_t num_frames);
+
+  ~ClockProReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id = INVALID_PAGE_ID) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> override;
+
+  void Resize(size_t num_frames) override;
+
+ private:
+  static constexpr frame_id_t NON_RESIDENT = -1;
+
+  struct Entry {
+    page_id_t page_id_;
+    /** NON_RESIDENT for non-resident pages, which only remember that a test period is running. */
+    frame_id_t frame_id_;
+    bool hot_{false};
+    bool referenced_{false};
+    bool test_{false};
+  };
+  using EntryIter = std::list<Entry>::iterator;
+
+  struct FrameEntry {
+    bool tracked_{false};
+    bool evictable_{true};
+    EntryIter pos_;
+  };
+
+  /** @brief The entry after it on the clock, wrapping around. */
+  auto Next(EntryIter it) -> EntryIter;
+
+  /** @brief Insert an entry at the head of the clock, i.e. the position the hot hand reaches last. */
+  auto InsertAtHead(const Entry &entry) -> EntryIter;
+
+  /** @brief Remove an entry from the clock, moving any hand that points at it to the next entry. */
+  void EraseEntry(EntryIter it);
+
+  /** @brief Run the hot hand until it demotes one hot page. */
+  void HandHot();
+
+  /** @brief Run the test hand until it ends one test period. */
+  void HandTest();
+
+  void GrowColdTarget();
+  void ShrinkColdTarget();
+
+  std::mutex latch_;
+  size_t capacity_;
+  std::list<Entry> clock_;
+  EntryIter hand_hot_;
+  EntryIter hand_cold_;
+  EntryIter hand_test_;
+  std::vector<FrameEntry> frames_;
+  /** Non-resident pages on the clock. */
+  std::unordered_map<page_id_t, EntryIter> non_resident_;
+  size_t hot_cnt_{0};
+  size_t cold_cnt_{0};
+  /** Number of frames the policy tries to keep for cold pages, "mc" in the paper. */
+  size_t cold_target_;
+  size_t curr_size_{0};
+};
+
+}  // namespace bustub
@@ -6,7 +6,7 @@
 //
 // Identification: src/include/buffer/clock_replacer.h
 //
-// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
 //
 //===----------------------------------------------------------------------===//
 
@@ -37,16 +37,32 @@ class ClockReplacer : public Replacer {
    */
   ~ClockReplacer() override;
 
-  auto Victim(frame_id_t *frame_id) -> bool override;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
-  void Pin(frame_id_t frame_id) override;
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id = INVALID_PAGE_ID) override;
 
-  void Unpin(frame_id_t frame_id) override;
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
 
   auto Size() -> size_t override;
 
+  auto EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> override;
+
+  void Resize(size_t num_frames) override;
+
  private:
-  // TODO(student): implement me!
+  struct FrameEntry {
+    bool tracked_{false};
+    bool evictable_{true};
+    bool referenced_{false};
+  };
+
+  std::mutex latch_;
+  /** The clock: frames in frame id order, the hand sweeps over the tracked, evictable ones. */
+  std::vector<FrameEntry> frames_;
+  size_t hand_{0};
+  size_t curr_size_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,106 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// compressed_page_cache.h
+//
+// Identification: src/include/buffer/compressed_page_cache.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <atomic>
+#include <list>
+#include <mutex>  // NOLINT
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * CompressedPageCache is an in-memory tier between a buffer pool instance and the disk. Pages evicted from the pool
+ * are kept here compressed with LZCodec, and a miss in the pool looks here before reading the disk. A page that
+ * does not compress is kept as is.
+ *
+ * The tier only ever holds copies of what is on disk, and only of pages that are not in the pool: Get() takes the
+ * page out of the tier. When the entries no longer fit in the capacity, the least recently put ones are dropped.
+ *
+ * Thread safe. Compression and decompression run outside the internal latch.
+ */
+class CompressedPageCache {
+ public:
+  /** @param capacity bytes of compressed pages the tier may hold, 0 disables it */
+  explicit CompressedPageCache(size_t capacity) : capacity_(capacity) {}
+
+  /**
+   * @brief Store a copy of a page, replacing an older copy. Does nothing if the tier is disabled.
+   * @param page_id the page
+   * @param data BUSTUB_PAGE_SIZE bytes, the page as it is on disk
+   */
+  void Put(page_id_t page_id, const char *data);
+
+  /**
+   * @brief Take a page out of the tier.
+   * @param page_id the page
+   * @param[out] data where to write the BUSTUB_PAGE_SIZE bytes of the page
+   * @return false if the page is not in the tier
+   */
+  auto Get(page_id_t page_id, char *data) -> bool;
+
+  /** @brief Drop the copy of a page, if any. */
+  void Erase(page_id_t page_id);
+
+  /** @brief Change the capacity in bytes, dropping the oldest entries that no longer fit. 0 empties the tier. */
+  void SetCapacity(size_t capacity);
+
+  auto GetCapacity() const -> size_t { return capacity_; }
+
+  auto IsEnabled() const -> bool { return capacity_ > 0; }
+
+  /** @brief Return the number of pages in the tier. */
+  auto Size() -> size_t;
+
+  /** @brief Return the bytes used by the pages in the tier. */
+  auto GetUsedBytes() -> size_t;
+
+  /** @brief Return the number of Get() calls that found their page. */
+  auto GetHitCount() const -> uint64_t { return hits_; }
+
+  /** @brief Return the number of Get() calls that did not find their page. */
+  auto GetMissCount() const -> uint64_t { return misses_; }
+
+  /** @brief Return the uncompressed size of the pages in the tier divided by the bytes they use, 0 when empty. */
+  auto GetCompressionRatio() -> double;
+
+ private:
+  struct Entry {
+    std::vector<char> data_;
+    /** False if data_ holds the page as is. */
+    bool compressed_;
+    /** Position in lru_. */
+    std::list<page_id_t>::iterator lru_pos_;
+  };
+
+  /** @brief Drop the oldest entries until used_bytes_ <= capacity. Caller must hold the latch. */
+  void EvictUntil(size_t capacity);
+
+  /** @brief Drop one entry. Caller must hold the latch. */
+  void RemoveEntry(std::unordered_map<page_id_t, Entry>::iterator it);
+
+  std::atomic<size_t> capacity_;
+  /** Protects everything below. */
+  std::mutex latch_;
+  std::unordered_map<page_id_t, Entry> entries_;
+  /** Page ids, most recently put first. */
+  std::list<page_id_t> lru_;
+  size_t used_bytes_{0};
+  std::atomic<uint64_t> hits_{0};
+  std::atomic<uint64_t> misses_{0};
+};
+
+}  // namespace bustub
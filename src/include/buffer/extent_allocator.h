@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// extent_allocator.h
+//
+// Identification: src/include/buffer/extent_allocator.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+
+#include "common/config.h"
+#include "storage/page/page.h"
+#include "storage/page/page_guard.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+
+/**
+ * ExtentAllocator creates the pages of one table heap or index. Instead of taking the next page id of the whole
+ * database for every page, it reserves extents of consecutive page ids with BufferPoolManager::AllocateExtent() and
+ * hands them out in order. Tables and indexes that grow at the same time then do not interleave on disk, so a scan
+ * reads runs of adjacent pages that OS read-ahead, Prefetch() and DiskManager::WritePages() can make use of.
+ *
+ * If the buffer pool does not support extents, pages come from NewPage() as before. The unused rest of the last
+ * extent is never written; it stays a hole in the database file. Thread safe.
+ */
+class ExtentAllocator {
+ public:
+  /**
+   * @param bpm the buffer pool to create the pages in
+   * @param extent_page_cnt pages reserved at a time
+   */
+  explicit ExtentAllocator(BufferPoolManager *bpm, size_t extent_page_cnt = EXTENT_PAGE_CNT);
+
+  /**
+   * Create the next page of the current extent, reserving a new extent when it is used up.
+   * @param[out] page_id id of the created page
+   * @return the page, pinned and zeroed like one from NewPage(); nullptr if every frame is pinned
+   */
+  auto NewPage(page_id_t *page_id) -> Page *;
+
+  /** NewPage(), returning the page write latched in a guard, like BufferPoolManager::NewPageWrite(). */
+  auto NewPageWrite(page_id_t *page_id) -> WritePageGuard;
+
+ private:
+  BufferPoolManager *bpm_;
+  const size_t extent_page_cnt_;
+  /** Protects next_page_id_ and end_page_id_. */
+  std::mutex latch_;
+  /** The next page to create and the end of the current extent; equal when a new extent is needed. */
+  page_id_t next_page_id_{INVALID_PAGE_ID};
+  page_id_t end_page_id_{INVALID_PAGE_ID};
+};
+
+}  // namespace bustub
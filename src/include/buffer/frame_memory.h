@@ -0,0 +1,62 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// frame_memory.h
+//
+// Identification: src/include/buffer/frame_memory.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * FrameMemory is the page data of a block of buffer pool frames, one BUSTUB_PAGE_SIZE slot per frame. Every slot is
+ * BUSTUB_PAGE_SIZE aligned, so a DiskManager opened with O_DIRECT reads and writes frames in place, without a bounce
+ * buffer.
+ *
+ * With huge pages requested the block is mapped with MAP_HUGETLB, which needs huge pages reserved by the system; if
+ * that fails it is mapped normally and marked for transparent huge pages instead.
+ */
+class FrameMemory {
+ public:
+  /**
+   * @brief Allocate the data of frame_cnt frames, zeroed.
+   * @param frame_cnt number of frames
+   * @param huge_pages try to back the memory with huge pages
+   */
+  explicit FrameMemory(size_t frame_cnt, bool huge_pages = false);
+
+  ~FrameMemory();
+
+  FrameMemory(const FrameMemory &) = delete;
+  auto operator=(const FrameMemory &) -> FrameMemory & = delete;
+  FrameMemory(FrameMemory &&other) noexcept;
+  auto operator=(FrameMemory &&other) noexcept -> FrameMemory &;
+
+  /** @return the data of frame i of the block */
+  auto GetFrame(size_t i) -> char * { return data_ + i * BUSTUB_PAGE_SIZE; }
+
+  /** @return true if the block is mapped on reserved (MAP_HUGETLB) huge pages */
+  auto IsOnHugePages() const -> bool { return huge_pages_; }
+
+ private:
+  void Release();
+
+  char *data_{nullptr};
+  /** bytes allocated, rounded up to the huge page size when mapped */
+  size_t size_{0};
+  /** true if data_ came from mmap rather than aligned_alloc */
+  bool mapped_{false};
+  bool huge_pages_{false};
+};
+
+}  // namespace bustub
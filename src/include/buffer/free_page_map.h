@@ -0,0 +1,79 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map.h
+//
+// Identification: src/include/buffer/free_page_map.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <iterator>
+#include <limits>
+#include <set>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * FreePageMap keeps track of the deleted pages of one buffer pool instance, so that AllocatePage() can hand them out
+ * again before it extends the database file. Allocate() returns the lowest free page id, which keeps the file dense
+ * and places new pages next to their neighbours.
+ *
+ * The map lives in memory as an ordered set. Save() writes it out as a chain of FreePageMapPage pages, and Load() reads
+ * such a chain back. The chain is stored in pages that are free themselves, so saving the map never grows the file.
+ * The buffer pool keeps the first page of the chain in the disk manager's master record and loads it at startup.
+ *
+ * Not thread safe; the buffer pool instance calls it under its latch.
+ */
+class FreePageMap {
+ public:
+  /** @brief Record that a page was deleted. Freeing a page twice is a no-op. */
+  void Free(page_id_t page_id);
+
+  /**
+   * @brief Take the lowest free page id out of the map.
+   * @param[out] page_id the page to reuse
+   * @return false if there is no free page
+   */
+  auto Allocate(page_id_t *page_id) -> bool;
+
+  auto IsFree(page_id_t page_id) const -> bool { return free_pages_.count(page_id) > 0; }
+
+  auto Size() const -> size_t { return free_pages_.size(); }
+
+  /** @brief Drop the free pages for which keep returns false. */
+  template <typename Predicate>
+  void Retain(Predicate keep) {
+    for (auto it = free_pages_.begin(); it != free_pages_.end();) {
+      it = keep(*it) ? std::next(it) : free_pages_.erase(it);
+    }
+  }
+
+  /**
+   * @brief Write the map to disk. Each page of the chain lists as many free pages as fit; the chain itself occupies
+   * the highest free pages, which stay in the map. The caller must make sure none of them is written concurrently.
+   * @return the first page of the chain, INVALID_PAGE_ID if the map is empty or a page of the chain failed to write
+   */
+  auto Save(DiskManager *disk_manager) const -> page_id_t;
+
+  /**
+   * @brief Read a map written by Save(). A chain that does not look like one Save() wrote, e.g. because one of its
+   * pages was reused since, gives an empty map: the pages it listed are lost, but none of them is handed out twice.
+   * @param first_page_id the page Save() returned; INVALID_PAGE_ID gives an empty map
+   * @param end_page_id every page of the chain and every page it lists must be below it, e.g. the end of the file
+   */
+  static auto Load(DiskManager *disk_manager, page_id_t first_page_id,
+                   page_id_t end_page_id = std::numeric_limits<page_id_t>::max()) -> FreePageMap;
+
+ private:
+  std::set<page_id_t> free_pages_;
+};
+
+}  // namespace bustub
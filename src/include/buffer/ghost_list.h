@@ -0,0 +1,63 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// ghost_list.h
+//
+// Identification: src/include/buffer/ghost_list.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <iterator>
+#include <list>
+#include <unordered_map>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * GhostList remembers the ids of recently evicted pages, oldest first, so that replacers such as ARC and 2Q can tell
+ * when an evicted page is read back. It holds page ids only, no page data.
+ */
+class GhostList {
+ public:
+  /** @return the number of remembered pages */
+  auto Size() const -> size_t { return pages_.size(); }
+
+  /** @brief Remember page_id as the most recently evicted page. */
+  void Push(page_id_t page_id) {
+    pages_.push_back(page_id);
+    index_[page_id] = std::prev(pages_.end());
+  }
+
+  /** @brief Forget page_id. @return true if it was remembered */
+  auto Erase(page_id_t page_id) -> bool {
+    auto it = index_.find(page_id);
+    if (it == index_.end()) {
+      return false;
+    }
+    pages_.erase(it->second);
+    index_.erase(it);
+    return true;
+  }
+
+  /** @brief Forget the oldest page, if any. */
+  void PopOldest() {
+    if (pages_.empty()) {
+      return;
+    }
+    index_.erase(pages_.front());
+    pages_.pop_front();
+  }
+
+ private:
+  std::list<page_id_t> pages_;
+  std::unordered_map<page_id_t, std::list<page_id_t>::iterator> index_;
+};
+
+}  // namespace bustub
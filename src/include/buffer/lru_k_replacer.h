@@ -12,81 +12,18 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <limits>
-#include <list>
 #include <memory>
 #include <mutex>  // NOLINT
-#include <set>
-#include <unordered_map>
+#include <utility>
 #include <vector>
 
+#include "buffer/replacer.h"
 #include "common/config.h"
 #include "common/macros.h"
 namespace bustub {
-/**
- *
- *
- */
-template <class Key>
-class DoubleLinkedList {
- public:
-  class Node {
-   public:
-    Node *pre_;
-    Node *next_;
-    Key value_;
-    bool evictable_{true};
-    int visite_count_{0};
-    explicit Node(Key frame_id);
-    Node(Key frame_id, int vc);
-  };
-
- public:
-  DoubleLinkedList();
-
- public:
-  Node *head_;
-  int size_{0};
-  auto InsertFront(Key frame_id) -> bool;
-  auto InsertTail(Key frame_id) -> bool;
-
-  auto InsertTailNode(Node *temp) -> bool;
-  auto InsertFrontNode(Node *temp) -> bool;
-  auto RemoveTail(Key *frame_id) -> bool;
-  auto RemoveNodeFromList(Node *node) -> bool;
-  auto FindFirstEvictableNode() -> Node *;
-  inline auto Size() -> int { return size_; }
-  auto InsertOrdered(Node *node) -> bool;
-
-  ~DoubleLinkedList();
-};
-
-class LruK {
-  using Node = DoubleLinkedList<frame_id_t>::Node;
-  using LRU_List = DoubleLinkedList<frame_id_t>;
-  using History_List = DoubleLinkedList<frame_id_t>;
-  using Map = std::unordered_map<frame_id_t, Node *>;
-
-  int capacity_;
-  int k_;
-
-  LRU_List lru_cache_;
-  History_List history_cache_;
-  Map history_map_;
-  Map lru_map_;
-
- public:
-  LruK(int size, int K);
-  void Access(frame_id_t id);
-  auto Evict(frame_id_t *id) -> bool;
-  auto Contained(frame_id_t id) -> bool;
-  auto SetEvictable(frame_id_t id, bool evictable) -> bool;
-  auto Remove(frame_id_t id) -> bool;
-
-  auto Size() -> int;
-  auto IsFull() -> bool;
-};
-
 /**
  * LRUKReplacer implements the LRU-k replacement policy.
  *
@@ -97,13 +34,17 @@ class LruK {
  * A frame with less than k historical references is given
  * +inf as its backward k-distance. When multiple frames have +inf backward
  * k-distance, classical LRU algorithm is used to choose victim.
+ *
+ * All state is preallocated and indexed by frame id: each frame keeps its last k access timestamps in a fixed ring,
+ * and the evictable frames form a binary heap ordered by backward k-distance that is updated lazily. RecordAccess,
+ * SetEvictable and Remove are O(1), Evict is amortized O(log n), and nothing is allocated after construction.
+ * RecordAccess only appends to one of ACCESS_BUFFER_CNT small per-thread buffers; the buffered accesses are applied
+ * in timestamp order under latch_ when a buffer fills up and before any other operation, so every other call sees the
+ * same state as if the accesses had been applied at once.
  */
-class LRUKReplacer {
+class LRUKReplacer : public Replacer {
  public:
   /**
-   *
-   * TODO(P1): Add implementation
-   *
    * @brief a new LRUKReplacer.
    * @param num_frames the maximum number of frames the LRUReplacer will be
    * required to store
@@ -113,15 +54,11 @@ class LRUKReplacer {
   DISALLOW_COPY_AND_MOVE(LRUKReplacer);
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Destroys the LRUReplacer.
    */
-  ~LRUKReplacer() = default;
+  ~LRUKReplacer() override = default;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Find the frame with largest backward k-distance and evict that
    * frame. Only frames that are marked as 'evictable' are candidates for
    * eviction.
@@ -137,11 +74,9 @@ class LRUKReplacer {
    * @return true if a frame is evicted successfully, false if no frames can be
    * evicted.
    */
-  auto Evict(frame_id_t *frame_id) -> bool;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Record the event that the given frame id is accessed at current
    * timestamp. Create a new entry for access history if frame id has not been
    * seen before.
@@ -150,13 +85,14 @@ class LRUKReplacer {
    * exception. You can also use BUSTUB_ASSERT to abort the process if frame id
    * is invalid.
    *
+   * The access is timestamped immediately but only buffered; it does not take latch_ unless the buffer is full.
+   *
    * @param frame_id id of frame that received a new access.
+   * @param page_id unused, LRU-K forgets evicted pages
    */
-  void RecordAccess(frame_id_t frame_id);
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id = INVALID_PAGE_ID) override;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Toggle whether a frame is evictable or non-evictable. This function
    * also controls replacer's size. Note that size is equal to number of
    * evictable entries.
@@ -173,11 +109,9 @@ class LRUKReplacer {
    * @param frame_id id of frame whose 'evictable' status will be modified
    * @param set_evictable whether the given frame is evictable or not
    */
-  void SetEvictable(frame_id_t frame_id, bool set_evictable);
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Remove an evictable frame from replacer, along with its access
    * history. This function should also decrement replacer's size if removal is
    * successful.
@@ -193,28 +127,109 @@ class LRUKReplacer {
    *
    * @param frame_id id of frame to be removed
    */
-  void Remove(frame_id_t frame_id);
+  void Remove(frame_id_t frame_id) override;
 
   /**
-   * TODO(P1): Add implementation
-   *
    * @brief Return replacer's size, which tracks the number of evictable frames.
    *
    * @return size_t
    */
-  auto Size() -> size_t;
+  auto Size() -> size_t override;
+
+  /**
+   * @brief Peek at the next frames that Evict() would pick, coldest first, without evicting them or touching their
+   * access history. Used by the buffer pool's background writer to clean frames ahead of demand.
+   *
+   * @param max_cnt return at most this many frames
+   * @return evictable frame ids in eviction order
+   */
+  auto EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> override;
+
+  /**
+   * @brief Change the number of frames. Frames with an id >= num_frames must not be tracked any more when shrinking.
+   * @param num_frames the new number of frames
+   */
+  void Resize(size_t num_frames) override;
+
+  /**
+   * @brief Return the last (up to k) access timestamps of a frame, oldest first.
+   * @param frame_id id of the frame
+   */
+  auto GetAccessHistory(frame_id_t frame_id) -> std::vector<uint64_t> override;
+
+  /**
+   * @brief Apply saved accesses to a frame as if they had been recorded at their original timestamps. The timestamp
+   * counter is moved past them, so that accesses recorded afterwards are more recent.
+   * @param frame_id id of the frame
+   * @param page_id unused
+   * @param history access timestamps, oldest first
+   */
+  void RestoreAccessHistory(frame_id_t frame_id, page_id_t page_id, const std::vector<uint64_t> &history) override;
 
  private:
-  // TODO(student): implement me! You can replace these member variables as you
-  // like. Remove maybe_unused if you start using them.
-  [[maybe_unused]] size_t current_timestamp_{0};
-  [[maybe_unused]] size_t curr_size_{0};
-  [[maybe_unused]] size_t replacer_size_;
-  [[maybe_unused]] size_t k_;
+  /** Number of access buffers RecordAccess() spreads the threads over. */
+  static constexpr size_t ACCESS_BUFFER_CNT = 16;
+  /** Accesses one buffer holds before the recording thread applies all buffers to the replacer. */
+  static constexpr size_t ACCESS_BUFFER_SIZE = 64;
+  /** Set in the eviction key of frames with k accesses, so that all frames with +inf k-distance sort first. */
+  static constexpr size_t K_ACCESSES_KEY_BIT = size_t{1} << (std::numeric_limits<size_t>::digits - 1);
+
+  /** Replacer state of one frame. Its last k access timestamps live in history_[frame_id * k_, (frame_id + 1) * k_). */
+  struct FrameEntry {
+    /** Number of recorded accesses, saturating at k. 0 means the frame is not tracked. */
+    size_t access_cnt_{0};
+    /** Ring slot the next access is written to; once the ring is full this is also the oldest (k-th) access. */
+    size_t history_next_{0};
+    bool evictable_{true};
+    /** Whether heap_ holds an entry for the frame, which may be stale. */
+    bool in_heap_{false};
+  };
+
+  /** Accesses recorded by RecordAccess() but not applied yet, as (timestamp, frame id). */
+  struct alignas(64) AccessBuffer {
+    std::mutex latch_;
+    std::array<std::pair<size_t, frame_id_t>, ACCESS_BUFFER_SIZE> accesses_;
+    /** Written under latch_, read without it so that draining can skip empty buffers. */
+    std::atomic<size_t> size_{0};
+  };
+
+  /** @brief Apply every buffered access in timestamp order. Caller must hold latch_. */
+  void DrainAccessBuffers();
+
+  /** @brief Add one access at timestamp ts to the history of frame_id. Caller must hold latch_. */
+  void ApplyAccess(frame_id_t frame_id, size_t ts);
+
+  /**
+   * @return the eviction key of a tracked frame, smaller keys are evicted first: the first access for frames with less
+   * than k accesses, the k-th most recent access with K_ACCESSES_KEY_BIT set otherwise
+   */
+  auto EvictionKey(frame_id_t frame_id) const -> size_t;
+
+  /**
+   * @brief Bring the top of heap_ up to date: drop entries of frames that are no longer evictable and re-insert entries
+   * whose key has grown, until the top entry is the next victim. Caller must hold latch_.
+   * @return false if no frame is evictable
+   */
+  auto FixHeapTop() -> bool;
+
+  void HeapPush(size_t key, frame_id_t frame_id);
+  auto HeapPop() -> std::pair<size_t, frame_id_t>;
+
+  std::atomic<size_t> current_timestamp_{0};
+  size_t curr_size_{0};
+  size_t replacer_size_;
+  size_t k_;
   std::mutex latch_;
-  LruK lru_k_;
-  int evict_able_size_;
-  int evict_disable_size_;
+  std::vector<FrameEntry> frames_;
+  std::vector<size_t> history_;
+  /**
+   * Min-heap of (eviction key, frame id), at most one entry per frame. Keys only grow, so an entry's key is a lower
+   * bound of the frame's real key and entries are only brought up to date lazily, when they reach the top.
+   */
+  std::vector<std::pair<size_t, frame_id_t>> heap_;
+  std::array<AccessBuffer, ACCESS_BUFFER_CNT> access_buffers_;
+  /** Scratch space DrainAccessBuffers() sorts the buffered accesses in, preallocated to hold all of them. */
+  std::vector<std::pair<size_t, frame_id_t>> drained_accesses_;
 };
 
 }  // namespace bustub
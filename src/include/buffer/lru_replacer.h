@@ -37,16 +37,32 @@ class LRUReplacer : public Replacer {
    */
   ~LRUReplacer() override;
 
-  auto Victim(frame_id_t *frame_id) -> bool override;
+  auto Evict(frame_id_t *frame_id) -> bool override;
 
-  void Pin(frame_id_t frame_id) override;
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id = INVALID_PAGE_ID) override;
 
-  void Unpin(frame_id_t frame_id) override;
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
 
   auto Size() -> size_t override;
 
+  auto EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> override;
+
+  void Resize(size_t num_frames) override;
+
  private:
-  // TODO(student): implement me!
+  struct FrameEntry {
+    bool tracked_{false};
+    bool evictable_{true};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  std::mutex latch_;
+  /** Tracked frames, least recently used first. */
+  std::list<frame_id_t> lru_list_;
+  std::vector<FrameEntry> frames_;
+  size_t curr_size_{0};
 };
 
 }  // namespace bustub
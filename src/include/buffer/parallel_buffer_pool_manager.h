@@ -0,0 +1,198 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager.h
+//
+// Identification: src/include/buffer/parallel_buffer_pool_manager.h
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <mutex>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+/**
+ * ParallelBufferPoolManager shards the buffer pool over several BufferPoolManagerInstances. Every page id is owned by
+ * exactly one instance (page_id % num_instances), so threads touching pages of different shards never contend on the
+ * same buffer pool latch.
+ */
+class ParallelBufferPoolManager : public BufferPoolManager {
+ public:
+  /**
+   * Creates a new ParallelBufferPoolManager.
+   * @param num_instances the number of individual BufferPoolManagerInstances to store
+   * @param pool_size the pool size of each BufferPoolManagerInstance
+   * @param disk_manager the disk manager
+   * @param replacer_k the lookback constant k for the LRU-K replacer of each instance
+   * @param log_manager the log manager (for testing only: nullptr = disable logging)
+   * @param replacer_type the page replacement policy of each instance
+   */
+  ParallelBufferPoolManager(size_t num_instances, size_t pool_size, DiskManager *disk_manager,
+                            size_t replacer_k = LRUK_REPLACER_K, LogManager *log_manager = nullptr,
+                            ReplacerType replacer_type = BUFFER_POOL_REPLACER);
+
+  /**
+   * Destroys an existing ParallelBufferPoolManager.
+   */
+  ~ParallelBufferPoolManager() override;
+
+  /** @return size of the buffer pool, summed over all instances */
+  auto GetPoolSize() -> size_t override;
+
+  /**
+   * Resize every instance to pool_size frames, one instance after the other, see BufferPoolManagerInstance::Resize().
+   * @param pool_size the new number of frames per instance
+   */
+  void Resize(size_t pool_size);
+
+  /**
+   * Size the compressed tier of every instance, see BufferPoolManagerInstance::SetCompressedTierSize().
+   * @param bytes capacity of each instance's tier in compressed bytes, 0 disables the tiers
+   */
+  void SetCompressedTierSize(size_t bytes);
+
+  /** List the resident pages of every instance; each instance's pages are ordered coldest first. */
+  auto SnapshotResidentPages() -> PoolSnapshot override;
+
+  /**
+   * Warm up all instances at the same time, each one loading its own pages of the snapshot.
+   * @param snapshot pages saved by SnapshotResidentPages()
+   * @param thread_cnt reading threads in total, spread over the instances
+   * @return the number of pages loaded
+   */
+  auto WarmUp(const PoolSnapshot &snapshot, size_t thread_cnt) -> size_t override;
+
+  /** The dirty page tables of all instances. */
+  auto GetDirtyPageTable() -> std::vector<std::pair<page_id_t, lsn_t>> override;
+
+  /** @return the number of instances in this parallel BPM */
+  auto GetNumInstances() const -> size_t { return instances_.size(); }
+
+  /**
+   * @param page_id id of page
+   * @return pointer to the BufferPoolManagerInstance responsible for handling given page id
+   */
+  auto GetBufferPoolManager(page_id_t page_id) -> BufferPoolManagerInstance *;
+
+  /**
+   * Read-ahead hint, every page of the range is handed to the instance that owns it.
+   * @param first_page_id first page of the range
+   * @param page_cnt number of pages in the range
+   */
+  void Prefetch(page_id_t first_page_id, size_t page_cnt) override;
+
+  /**
+   * Fetch a page through a strategy's ring, from the instance that owns the page. Each instance keeps its own ring.
+   * @param page_id id of page to be fetched
+   * @param strategy the ring to read through, nullptr for a plain FetchPage()
+   * @return the requested page, or nullptr
+   */
+  auto FetchPageWithStrategy(page_id_t page_id, BufferAccessStrategy *strategy) -> Page * override;
+
+  /**
+   * Reserve consecutive page ids across all instances. The extent starts after the next page id of every instance;
+   * if one of them hands out a page id of the extent through NewPage meanwhile, the instances that already reserved
+   * their share give it back and the reservation starts over.
+   * @param page_cnt number of pages in the extent
+   * @return the first page id of the extent
+   */
+  auto AllocateExtent(size_t page_cnt) -> page_id_t override;
+
+  /** @return the metrics counters summed over all instances, indexed by tag id */
+  auto GetTagCounters() -> std::vector<BufferPoolCounters> override;
+
+  /** Unpin a batch of pages, taking the latch of each instance involved once. */
+  void UnpinPages(const std::vector<std::pair<page_id_t, bool>> &pages) override;
+
+  /** Give the ring frames of the strategy back to every instance. */
+  void ReleaseStrategy(BufferAccessStrategy *strategy) override;
+
+  /** Start the background writer of every instance. */
+  void StartBackgroundWriter(const BackgroundWriterOptions &options = BackgroundWriterOptions{});
+
+  /** Stop the background writer of every instance. */
+  void StopBackgroundWriter();
+
+  /** @return pages written by the background writers, summed over all instances */
+  auto GetBackgroundWriteCount() const -> uint64_t;
+
+  /** @return dirty victims written back on the foreground path, summed over all instances */
+  auto GetForegroundWriteCount() const -> uint64_t;
+
+ protected:
+  /**
+   * Fetch the requested page from the buffer pool.
+   * @param page_id id of page to be fetched
+   * @return the requested page
+   */
+  auto FetchPgImp(page_id_t page_id) -> Page * override;
+
+  /** Fetch a page for a tagged access from the instance that owns it. */
+  auto FetchPgTaggedImp(page_id_t page_id, BufferAccessStrategy *strategy, BufferPoolTag tag) -> Page * override;
+
+  /** Fetch a batch of pages, taking the latch of each instance involved once. */
+  auto FetchPagesImp(const std::vector<page_id_t> &page_ids, BufferPoolTag tag) -> std::vector<Page *> override;
+
+  /**
+   * Unpin the target page from the buffer pool.
+   * @param page_id id of page to be unpinned
+   * @param is_dirty true if the page should be marked as dirty, false otherwise
+   * @return false if the page pin count is <= 0 before this call, true otherwise
+   */
+  auto UnpinPgImp(page_id_t page_id, bool is_dirty) -> bool override;
+
+  /**
+   * Flushes the target page to disk.
+   * @param page_id id of page to be flushed, cannot be INVALID_PAGE_ID
+   * @return false if the page could not be found in the page table, true otherwise
+   */
+  auto FlushPgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * Creates a new page in the buffer pool. Instances are tried round robin, starting from the instance after the one
+   * that served the previous request, until one of them has a free or evictable frame.
+   * @param[out] page_id id of created page
+   * @return nullptr if no new pages could be created, otherwise pointer to new page
+   */
+  auto NewPgImp(page_id_t *page_id) -> Page * override;
+
+  /** Creates a page of an extent in the instance that owns it. */
+  auto NewPgInExtentImp(page_id_t page_id) -> Page * override;
+
+  /**
+   * Deletes a page from the buffer pool.
+   * @param page_id id of page to be deleted
+   * @return false if the page exists but could not be deleted, true if the page didn't exist or deletion succeeded
+   */
+  auto DeletePgImp(page_id_t page_id) -> bool override;
+
+  /**
+   * Flushes all the dirty pages in the buffer pool to disk. The dirty pages of all instances are written together, so
+   * that runs of adjacent pages, which always span instances, go out in one vectored write.
+   */
+  void FlushAllPgsImp() override;
+
+ private:
+  DiskManager *disk_manager_;
+  /** The shards, instance i owns every page id with page_id % instances_.size() == i. */
+  std::vector<BufferPoolManagerInstance *> instances_;
+  /** The instance NewPgImp starts probing from. */
+  size_t next_instance_{0};
+  /** Protects next_instance_. */
+  std::mutex latch_;
+};
+
+}  // namespace bustub
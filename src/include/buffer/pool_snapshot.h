@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// pool_snapshot.h
+//
+// Identification: src/include/buffer/pool_snapshot.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * PoolSnapshot lists the pages a buffer pool holds, together with the replacer's access history of each page. It is
+ * written when the database shuts down, and after a restart BufferPoolManager::WarmUp() reads the listed pages back
+ * before queries are served, instead of faulting them in one miss at a time.
+ *
+ * Pages are listed coldest first. Only page ids and access timestamps are saved, never page contents, so a snapshot
+ * that is out of date only costs some useless reads.
+ *
+ * File format (host byte order):
+ * ------------------------------------------------------------------------------------------------
+ * | Magic (4) | PageCount (4) | PageId (4) | HistoryLength (4) | Timestamp_1 (8) | ... | PageId (4) | ...
+ * ------------------------------------------------------------------------------------------------
+ */
+class PoolSnapshot {
+ public:
+  /** One resident page. */
+  struct Entry {
+    page_id_t page_id_;
+    /** Access timestamps, oldest first, see Replacer::GetAccessHistory(). May be empty. */
+    std::vector<uint64_t> history_;
+  };
+
+  /**
+   * @brief Write the snapshot to a file, replacing it.
+   * @return false if the file cannot be written
+   */
+  auto Save(const std::string &path) const -> bool;
+
+  /**
+   * @brief Read a snapshot written by Save().
+   * @return the snapshot, empty if the file does not exist or is damaged
+   */
+  static auto Load(const std::string &path) -> PoolSnapshot;
+
+  /** The resident pages, coldest first. */
+  std::vector<Entry> entries_;
+
+ private:
+  static constexpr uint32_t MAGIC = 0x42505353;  // "BPSS"
+};
+
+}  // namespace bustub
@@ -12,12 +12,20 @@
 
 #pragma once
 
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
 #include "common/config.h"
 
 namespace bustub {
 
 /**
- * Replacer is an abstract class that tracks page usage.
+ * Replacer is an abstract class that tracks page usage and picks the frame to evict when the buffer pool is full.
+ *
+ * A frame is tracked from its first RecordAccess() until it is evicted or removed. Newly tracked frames are evictable;
+ * the buffer pool marks a frame non-evictable while its page is pinned.
  */
 class Replacer {
  public:
@@ -25,26 +33,86 @@ class Replacer {
   virtual ~Replacer() = default;
 
   /**
-   * Remove the victim frame as defined by the replacement policy.
-   * @param[out] frame_id id of frame that was removed, nullptr if no victim was found
-   * @return true if a victim frame was found, false otherwise
+   * Pick a victim frame among the evictable frames and stop tracking it.
+   * @param[out] frame_id id of the evicted frame
+   * @return true if a frame was evicted, false if no frame is evictable
+   */
+  virtual auto Evict(frame_id_t *frame_id) -> bool = 0;
+
+  /**
+   * Record an access to a frame, starting to track it if it is not tracked yet.
+   * @param frame_id id of the accessed frame
+   * @param page_id the page the frame holds. Policies that remember recently evicted pages (ARC, 2Q, CLOCK-Pro) use it
+   * to recognize a page that comes back; INVALID_PAGE_ID if unknown, then the page is treated as never seen before.
    */
-  virtual auto Victim(frame_id_t *frame_id) -> bool = 0;
+  virtual void RecordAccess(frame_id_t frame_id, page_id_t page_id = INVALID_PAGE_ID) = 0;
 
   /**
-   * Pins a frame, indicating that it should not be victimized until it is unpinned.
-   * @param frame_id the id of the frame to pin
+   * Mark a tracked frame as evictable or not; does nothing for frames that are not tracked.
+   * @param frame_id id of the frame
+   * @param set_evictable whether the frame may be evicted
    */
-  virtual void Pin(frame_id_t frame_id) = 0;
+  virtual void SetEvictable(frame_id_t frame_id, bool set_evictable) = 0;
 
   /**
-   * Unpins a frame, indicating that it can now be victimized.
-   * @param frame_id the id of the frame to unpin
+   * Stop tracking a frame without evicting it, e.g. because its page was deleted. Unlike an evicted page, the page is
+   * not remembered. Does nothing for frames that are not tracked.
+   * @param frame_id id of the frame
    */
-  virtual void Unpin(frame_id_t frame_id) = 0;
+  virtual void Remove(frame_id_t frame_id) = 0;
 
-  /** @return the number of elements in the replacer that can be victimized */
+  /** @return the number of evictable frames */
   virtual auto Size() -> size_t = 0;
+
+  /**
+   * Peek at the frames Evict() is going to pick next, without evicting them or changing their access history. Clock
+   * based policies return the frames their hand would consider first, which may differ from the actual victims once
+   * reference bits are cleared.
+   * @param max_cnt return at most this many frames
+   * @return evictable frame ids, first victim first
+   */
+  virtual auto EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> = 0;
+
+  /**
+   * Change the number of frames, when the buffer pool grows or shrinks. Before shrinking, the caller removes or evicts
+   * every frame with an id >= num_frames. Size-dependent targets of the policy are scaled to the new size.
+   * @param num_frames the new number of frames
+   */
+  virtual void Resize(size_t num_frames) = 0;
+
+  /**
+   * Return the access history of a tracked frame so that it can be saved across a restart, see PoolSnapshot. Policies
+   * that keep no access timestamps return an empty history.
+   * @param frame_id id of the frame
+   * @return access timestamps, oldest first; empty if the frame is not tracked
+   */
+  virtual auto GetAccessHistory(__attribute__((unused)) frame_id_t frame_id) -> std::vector<uint64_t> { return {}; }
+
+  /**
+   * Start tracking a frame with a history returned by GetAccessHistory(), possibly by an earlier process. The default
+   * records one access, so restoring frames coldest first rebuilds their recency order.
+   * @param frame_id id of the frame
+   * @param page_id the page the frame holds
+   * @param history access timestamps, oldest first
+   */
+  virtual void RestoreAccessHistory(frame_id_t frame_id, page_id_t page_id,
+                                    __attribute__((unused)) const std::vector<uint64_t> &history) {
+    RecordAccess(frame_id, page_id);
+  }
 };
 
+/**
+ * Create a replacer.
+ * @param type the replacement policy
+ * @param num_frames the number of frames the replacer tracks at most
+ * @param k the lookback constant, only used by ReplacerType::LRU_K
+ */
+auto MakeReplacer(ReplacerType type, size_t num_frames, size_t k = LRUK_REPLACER_K) -> std::unique_ptr<Replacer>;
+
+/** @return the policy named by a string such as "lru-k", "2q" or "clock-pro" (case insensitive), if any */
+auto ReplacerTypeFromString(const std::string &name) -> std::optional<ReplacerType>;
+
+/** @return the name of a policy, as accepted by ReplacerTypeFromString() */
+auto ReplacerTypeToString(ReplacerType type) -> std::string;
+
 }  // namespace bustub
@@ -0,0 +1,84 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// two_queue_replacer.h
+//
+// Identification: src/include/buffer/two_queue_replacer.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <list>
+#include <mutex>  // NOLINT
+#include <vector>
+
+#include "buffer/ghost_list.h"
+#include "buffer/replacer.h"
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * TwoQueueReplacer implements the full version of the 2Q policy (Johnson and Shasha, VLDB '94).
+ *
+ * A page read for the first time enters the FIFO queue A1in. When it is evicted from there its id is remembered in
+ * the ghost queue A1out; only a page that is read again while remembered there is admitted to the LRU queue Am. Pages
+ * touched by a single scan therefore never push the hot pages out of Am.
+ */
+class TwoQueueReplacer : public Replacer {
+ public:
+  /**
+   * @brief a new TwoQueueReplacer. A1in holds a quarter and A1out half of the frames, as suggested by the paper.
+   * @param num_frames the maximum number of frames the replacer will be required to store
+   */
+  explicit TwoQueueReplacer(size_t num_frames);
+
+  ~TwoQueueReplacer() override = default;
+
+  auto Evict(frame_id_t *frame_id) -> bool override;
+
+  void RecordAccess(frame_id_t frame_id, page_id_t page_id = INVALID_PAGE_ID) override;
+
+  void SetEvictable(frame_id_t frame_id, bool set_evictable) override;
+
+  void Remove(frame_id_t frame_id) override;
+
+  auto Size() -> size_t override;
+
+  auto EvictionCandidates(size_t max_cnt) -> std::vector<frame_id_t> override;
+
+  void Resize(size_t num_frames) override;
+
+ private:
+  enum class QueueType { NONE, A1IN, AM };
+
+  struct FrameEntry {
+    QueueType queue_{QueueType::NONE};
+    bool evictable_{true};
+    page_id_t page_id_{INVALID_PAGE_ID};
+    std::list<frame_id_t>::iterator pos_;
+  };
+
+  /** @brief Evict the oldest evictable frame of a queue; pages leaving A1in are remembered in A1out. */
+  auto EvictFrom(QueueType queue, frame_id_t *frame_id) -> bool;
+
+  auto QueueOf(QueueType queue) -> std::list<frame_id_t> & { return queue == QueueType::A1IN ? a1in_ : am_; }
+
+  std::mutex latch_;
+  /** Kin and Kout in the paper. */
+  size_t a1in_target_;
+  size_t a1out_capacity_;
+  /** FIFO queue of pages read once, oldest first. */
+  std::list<frame_id_t> a1in_;
+  /** LRU queue of hot pages, least recently used first. */
+  std::list<frame_id_t> am_;
+  GhostList a1out_;
+  std::vector<FrameEntry> frames_;
+  size_t curr_size_{0};
+};
+
+}  // namespace bustub
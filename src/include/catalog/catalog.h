@@ -138,6 +138,7 @@ class Catalog {
     // we are running shell without buffer pool. We don't need to create TableHeap in this case.
     if (create_table_heap) {
       table = std::make_unique<TableHeap>(bpm_, lock_manager_, log_manager_, txn);
+      table->SetBufferPoolTag(bpm_->RegisterTag("table " + table_name));
     }
 
     // Fetch the table OID for the new table
@@ -228,6 +229,7 @@ class Catalog {
 
     // TODO(chi): support both hash index and btree index
     auto index = std::make_unique<BPlusTreeIndex<KeyType, ValueType, KeyComparator>>(std::move(meta), bpm_);
+    index->SetBufferPoolTag(bpm_->RegisterTag("index " + index_name));
 
     // Populate the index with all tuples in table heap
     auto *table_meta = GetTable(table_name);
@@ -342,6 +344,9 @@ class Catalog {
     return result;
   }
 
+  /** @return the buffer pool the tables and indexes of this catalog live in */
+  auto GetBufferPoolManager() const -> BufferPoolManager * { return bpm_; }
+
  private:
   [[maybe_unused]] BufferPoolManager *bpm_;
   [[maybe_unused]] LockManager *lock_manager_;
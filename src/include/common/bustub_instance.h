@@ -211,9 +211,18 @@ class BustubInstance {
   auto MakeExecutorContext(Transaction *txn) -> std::unique_ptr<ExecutorContext>;
 
  public:
-  explicit BustubInstance(const std::string &db_file_name);
+  /**
+   * Create a BusTub instance backed by a database file.
+   * @param db_file_name the database file
+   * @param bpm_instances number of buffer pool shards; more than 1 selects a ParallelBufferPoolManager
+   */
+  explicit BustubInstance(const std::string &db_file_name, size_t bpm_instances = 1);
 
-  BustubInstance();
+  /**
+   * Create an in-memory BusTub instance.
+   * @param bpm_instances number of buffer pool shards; more than 1 selects a ParallelBufferPoolManager
+   */
+  explicit BustubInstance(size_t bpm_instances = 1);
 
   ~BustubInstance();
 
@@ -266,12 +275,26 @@ class BustubInstance {
     return variable == "1" || variable == "true" || variable == "yes";
   }
 
+  /**
+   * `SET synchronous_commit = off` lets the transactions of this session return from Commit before their commit
+   * record is durable, see Transaction::SetSynchronousCommit.
+   */
+  auto IsSynchronousCommit() -> bool {
+    auto variable = StringUtil::Lower(GetSessionVariable("synchronous_commit"));
+    return !(variable == "0" || variable == "false" || variable == "no" || variable == "off");
+  }
+
  private:
+  auto MakeBufferPoolManager(size_t bpm_instances) -> BufferPoolManager *;
   void CmdDisplayTables(ResultWriter &writer);
   void CmdDisplayIndices(ResultWriter &writer);
   void CmdDisplayHelp(ResultWriter &writer);
+  /** `SHOW buffer_pool_stats`: the buffer pool metrics, in total and per table / index. */
+  void CmdDisplayBufferPoolStats(ResultWriter &writer);
   void WriteOneCell(const std::string &cell, ResultWriter &writer);
   std::unordered_map<std::string, std::string> session_variables_;
+  /** Where the resident pages are saved at shutdown, empty for an in-memory instance. See PoolSnapshot. */
+  std::string pool_snapshot_file_;
 };
 
 }  // namespace bustub
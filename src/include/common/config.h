@@ -27,6 +27,9 @@ extern std::atomic<bool> enable_logging;
 /** If ENABLE_LOGGING is true, the log should be flushed to disk every LOG_TIMEOUT. */
 extern std::chrono::duration<int64_t> log_timeout;
 
+/** A transaction committed with synchronous_commit off is durable at most ASYNC_COMMIT_MAX_LAG after its commit. */
+extern std::chrono::milliseconds async_commit_max_lag;
+
 static constexpr int INVALID_PAGE_ID = -1;                                           // invalid page id
 static constexpr int INVALID_TXN_ID = -1;                                            // invalid transaction id
 static constexpr int INVALID_LSN = -1;                                               // invalid log sequence number
@@ -35,7 +38,22 @@ static constexpr int BUSTUB_PAGE_SIZE = 4096;
 static constexpr int BUFFER_POOL_SIZE = 10;                                          // size of buffer pool
 static constexpr int LOG_BUFFER_SIZE = ((BUFFER_POOL_SIZE + 1) * BUSTUB_PAGE_SIZE);  // size of a log buffer in byte
 static constexpr int BUCKET_SIZE = 50;                                               // size of extendible hash bucket
-static constexpr int LRUK_REPLACER_K = 10;  // lookback window for lru-k replacer
+static constexpr int LRUK_REPLACER_K = 10;         // lookback window for lru-k replacer
+static constexpr int SCAN_PREFETCH_PAGE_CNT = 4;   // pages read ahead by table / index iterators
+static constexpr int SCAN_RING_BUFFER_SIZE = 16;   // frames in the private ring of a large sequential scan
+static constexpr int SCAN_RING_POOL_DIVISOR = 4;   // scans estimated larger than 1/n of the pool use the ring
+static constexpr int UNPIN_BATCH_SIZE = 16;        // unpins an UnpinBatch collects before handing them to the pool
+static constexpr int OPTIMISTIC_READ_RETRIES = 3;  // optimistic B+ tree descents tried before read latching
+static constexpr int WARM_UP_THREAD_CNT = 4;       // threads reading back the pages of a pool snapshot at startup
+static constexpr int COMPRESSED_TIER_SIZE = 0;     // bytes of compressed evicted pages kept per pool, 0 = off
+static constexpr int INDEX_SCAN_BATCH_SIZE = 64;   // rids an index scan reads from the table heap in one batch
+static constexpr size_t BUFFER_POOL_MAX_TAGS = 64;  // tables and indexes the buffer pool metrics break down
+static constexpr size_t ASYNC_IO_QUEUE_DEPTH = 64;  // page I/Os an AsyncDiskManager keeps in flight
+static constexpr size_t ASYNC_IO_THREAD_CNT = 4;    // threads of the AsyncDiskManager pread / pwrite fallback
+static constexpr bool BUFFER_POOL_HUGE_PAGES = false;  // back buffer pool frames with huge pages
+static constexpr bool DISK_MANAGER_DIRECT_IO = false;  // open the database file with O_DIRECT, bypassing the OS cache
+static constexpr size_t EXTENT_PAGE_CNT = 64;  // consecutive pages a table heap or index reserves at a time
+static constexpr size_t REDO_WORKER_CNT = 4;  // threads replaying the log at restart, each owning some of the pages
 
 using frame_id_t = int32_t;    // frame id type
 using page_id_t = int32_t;     // page id type
@@ -44,6 +62,11 @@ using lsn_t = int32_t;         // log sequence number type
 using slot_offset_t = size_t;  // slot offset type
 using oid_t = uint16_t;
 
+/** Page replacement policies a buffer pool instance can be built with, see MakeReplacer(). */
+enum class ReplacerType { LRU_K, LRU, CLOCK, ARC, TWO_QUEUE, CLOCK_PRO };
+
+static constexpr ReplacerType BUFFER_POOL_REPLACER = ReplacerType::LRU_K;  // default replacement policy
+
 static constexpr int VARCHAR_DEFAULT_LENGTH = 128;  // default length for varchar when constructing the column
 
 }  // namespace bustub
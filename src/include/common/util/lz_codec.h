@@ -0,0 +1,56 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_codec.h
+//
+// Identification: src/include/common/util/lz_codec.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace bustub {
+
+/**
+ * LZCodec is a small, fast LZ77 codec in the spirit of LZ4, for compressing pages in memory. It favours speed over
+ * ratio: one greedy pass with a hash table of the last position of every 4-byte sequence, no entropy coding.
+ *
+ * The output is a series of sequences, each made of a token, its literals and a match:
+ * ---------------------------------------------------------------------------------------------------
+ * | Token (1) | LiteralLength ext (0+) | Literals | Offset (2) | MatchLength ext (0+) | Token (1) | ...
+ * ---------------------------------------------------------------------------------------------------
+ * The high nibble of the token is the number of literals, the low nibble the match length minus MIN_MATCH. A nibble
+ * of 15 is continued by extension bytes that are added to it, up to and including the first byte that is not 255.
+ * The offset points back into the output, little endian. The last sequence only has literals.
+ */
+class LZCodec {
+ public:
+  /** Shortest match worth encoding. */
+  static constexpr size_t MIN_MATCH = 4;
+
+  /**
+   * @brief Compress a buffer.
+   * @param src the data to compress, at most 64 KB
+   * @param size size of src
+   * @param[out] dst the compressed data, replaces its content
+   */
+  static void Compress(const char *src, size_t size, std::vector<char> *dst);
+
+  /**
+   * @brief Decompress the output of Compress().
+   * @param src the compressed data
+   * @param size size of src
+   * @param[out] dst where to write the original data
+   * @param dst_size size of the original data
+   * @return false if src is damaged or does not decompress to exactly dst_size bytes
+   */
+  static auto Decompress(const char *src, size_t size, char *dst, size_t dst_size) -> bool;
+};
+
+}  // namespace bustub
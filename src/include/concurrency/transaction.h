@@ -325,6 +325,16 @@ class Transaction {
    */
   inline void SetPrevLSN(lsn_t prev_lsn) { prev_lsn_ = prev_lsn; }
 
+  /** @return true if Commit waits until the commit record is durable (the default) */
+  inline auto IsSynchronousCommit() const -> bool { return synchronous_commit_; }
+
+  /**
+   * Set whether Commit waits until the commit record is durable. Without waiting, a crash loses the transaction if it
+   * committed less than async_commit_max_lag before.
+   * @param synchronous_commit false to return from Commit once the commit record is in the log buffer
+   */
+  inline void SetSynchronousCommit(bool synchronous_commit) { synchronous_commit_ = synchronous_commit; }
+
  private:
   /** The current transaction state. */
   TransactionState state_{TransactionState::GROWING};
@@ -341,6 +351,8 @@ class Transaction {
   std::shared_ptr<std::deque<IndexWriteRecord>> index_write_set_;
   /** The LSN of the last record written by the transaction. */
   lsn_t prev_lsn_;
+  /** Commit waits until the commit record is durable. */
+  bool synchronous_commit_{true};
 
   std::mutex latch_;
 
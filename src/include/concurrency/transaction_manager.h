@@ -13,9 +13,12 @@
 #pragma once
 
 #include <atomic>
+#include <mutex>  // NOLINT
 #include <shared_mutex>
 #include <unordered_map>
 #include <unordered_set>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "concurrency/lock_manager.h"
@@ -45,7 +48,8 @@ class TransactionManager {
       -> Transaction *;
 
   /**
-   * Commits a transaction.
+   * Commits a transaction. With logging enabled, returns once the commit record is durable, or once it is in the log
+   * buffer if the transaction has synchronous commit off.
    * @param txn the transaction to commit
    */
   void Commit(Transaction *txn);
@@ -83,6 +87,12 @@ class TransactionManager {
   /** Resumes all transactions, used for checkpointing. */
   void ResumeTransactions();
 
+  /**
+   * Build the active transaction table for a checkpoint.
+   * @return the transactions that began and did not commit or abort yet, with the LSN of their last log record
+   */
+  auto GetActiveTransactionTable() -> std::vector<std::pair<txn_id_t, lsn_t>>;
+
  private:
   /**
    * Releases all the locks held by the given transaction.
@@ -136,10 +146,14 @@ class TransactionManager {
 
   std::atomic<txn_id_t> next_txn_id_{0};
   LockManager *lock_manager_ __attribute__((__unused__));
-  LogManager *log_manager_ __attribute__((__unused__));
+  LogManager *log_manager_;
 
   /** The global transaction latch is used for checkpointing. */
   ReaderWriterLatch global_txn_latch_;
+
+  /** The transactions between Begin and the end of Commit / Abort; txn_map keeps them after that. */
+  std::unordered_map<txn_id_t, Transaction *> running_txns_;
+  std::mutex running_txns_latch_;
 };
 
 }  // namespace bustub
@@ -48,5 +48,9 @@ class IndexScanExecutor : public AbstractExecutor {
   TableInfo * tableinfo_;
   BPlusTreeIndexIteratorForOneIntegerColumn cursor_;
   BPlusTreeIndexIteratorForOneIntegerColumn end_;
+  /** 从索引里取出的一批rid和它们对应的tuple，next_是下一个要返回的位置 */
+  std::vector<RID> rids_;
+  std::vector<Tuple> tuples_;
+  size_t next_{0};
 };
 }  // namespace bustub
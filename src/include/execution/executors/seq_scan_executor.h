@@ -51,6 +51,8 @@ class SeqScanExecutor : public AbstractExecutor {
   /** The sequential scan plan node to be executed */
   const SeqScanPlanNode *plan_;
   ExecutorContext *exec_ctx_;
+  /** The ring the scan reads through when plan_->use_ring_buffer_ is set; declared before the cursors that use it. */
+  std::unique_ptr<BufferAccessStrategy> strategy_;
   std::shared_ptr<TableIterator> cursor_;
   std::shared_ptr<TableIterator> end_;
   LockManager * lock_manager_;
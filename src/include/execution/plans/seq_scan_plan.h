@@ -62,6 +62,11 @@ class SeqScanPlanNode : public AbstractPlanNode {
   */
   AbstractExpressionRef filter_predicate_;
 
+  /** Read the table through a private ring of frames (see BufferAccessStrategy). Set by the optimizer for scans that
+   * are expected to be larger than a fraction of the buffer pool, so they don't flush the pool.
+   */
+  bool use_ring_buffer_{false};
+
  protected:
   auto PlanNodeToString() const -> std::string override {
     if (filter_predicate_) {
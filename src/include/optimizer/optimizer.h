@@ -94,6 +94,12 @@ class Optimizer {
    */
   auto OptimizeSortLimitAsTopN(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
 
+  /**
+   * @brief let sequential scans that are estimated to touch more than 1/SCAN_RING_POOL_DIVISOR of the buffer pool read
+   * through a ring buffer
+   */
+  auto OptimizeSeqScanRingBuffer(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef;
+
   /**
    * @brief get the estimated cardinality for a table based on the table name. Useful when join reordering. BusTub
    * doesn't support statistics for now, so it's the only way for you to get the table size :(
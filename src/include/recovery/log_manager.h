@@ -13,9 +13,12 @@
 #pragma once
 
 #include <algorithm>
+#include <chrono>              // NOLINT
 #include <condition_variable>  // NOLINT
 #include <future>              // NOLINT
+#include <map>
 #include <mutex>               // NOLINT
+#include <thread>              // NOLINT
 
 #include "recovery/log_record.h"
 #include "storage/disk/disk_manager.h"
@@ -25,16 +28,28 @@ namespace bustub {
 /**
  * LogManager maintains a separate thread that is awakened whenever the log buffer is full or whenever a timeout
  * happens. When the thread is awakened, the log buffer's content is written into the disk log file.
+ *
+ * Records are appended to one of the two buffers while the flush thread writes the other one, so appends never wait
+ * for the disk unless the buffer fills up. Appending does not take the latch: a record reserves its LSN and its slice
+ * of the active buffer with one compare-and-swap on reserve_state_, serializes itself in parallel with the other
+ * appenders and then adds its size to the buffer's completion watermark. The flush thread switches appends to the
+ * other buffer with the same compare-and-swap, and writes the old one once its watermark reached the reserved size.
+ *
+ * A caller that needs its records on disk
+ * (a committing transaction, or the buffer pool about to write a page) calls Flush and waits. Every waiter that
+ * arrives while a write is in progress is covered by the next write, so one sync serves many commits.
  */
 class LogManager {
  public:
   explicit LogManager(DiskManager *disk_manager)
-      : next_lsn_(0), persistent_lsn_(INVALID_LSN), disk_manager_(disk_manager) {
+      : persistent_lsn_(INVALID_LSN), log_offset_(disk_manager->GetLogSize()), disk_manager_(disk_manager) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
     flush_buffer_ = new char[LOG_BUFFER_SIZE];
+    RestoreLSN();
   }
 
   ~LogManager() {
+    StopFlushThread();
     delete[] log_buffer_;
     delete[] flush_buffer_;
     log_buffer_ = nullptr;
@@ -46,29 +61,114 @@ class LogManager {
 
   auto AppendLogRecord(LogRecord *log_record) -> lsn_t;
 
-  inline auto GetNextLSN() -> lsn_t { return next_lsn_; }
+  /**
+   * Force the log to disk up to and including lsn and wait until it is durable. LSNs that were never assigned
+   * (e.g. garbage read from a page that is not logged) are clamped to the last assigned LSN.
+   * Without a flush thread the caller writes the log buffer itself.
+   * @param lsn the log sequence number that must be persistent when this returns
+   * @throws std::logic_error if a write of the log failed, the records after it never become persistent
+   */
+  void Flush(lsn_t lsn);
+
+  /**
+   * Ask for the log up to and including lsn to be durable within async_commit_max_lag, without waiting for it.
+   * Without a flush thread the caller writes the log buffer itself.
+   * @param lsn the commit record of a transaction committed with synchronous_commit off
+   */
+  void FlushAsync(lsn_t lsn);
+
+  /**
+   * Append a checkpoint record and make it the one recovery starts from: the record is forced to disk together with
+   * everything before it, then the master record is pointed at it. Called while transactions are blocked, so no other
+   * record is appended between the flush and the checkpoint record.
+   * @param log_record the checkpoint record, its redo offset is filled in here
+   * @param redo_lsn the oldest LSN redo has to start from, the smallest recLSN of the dirty page table
+   * @return the LSN of the checkpoint record
+   */
+  auto WriteCheckpoint(LogRecord *log_record, lsn_t redo_lsn) -> lsn_t;
+
+  inline auto GetNextLSN() -> lsn_t { return static_cast<lsn_t>(reserve_state_ >> LSN_SHIFT); }
   inline auto GetPersistentLSN() -> lsn_t { return persistent_lsn_; }
   inline void SetPersistentLSN(lsn_t lsn) { persistent_lsn_ = lsn; }
-  inline auto GetLogBuffer() -> char * { return log_buffer_; }
+  /** @return the buffer records are appended to */
+  inline auto GetLogBuffer() -> char * { return Buffer(reserve_state_); }
 
  private:
-  // TODO(students): you may add your own member variables
-
-  /** The atomic counter which records the next log sequence number. */
-  std::atomic<lsn_t> next_lsn_;
+  // reserve_state_: | next LSN (31 bits) | index of the buffer appends go to (1 bit) | bytes reserved in it (32 bits) |
+  static constexpr uint64_t OFFSET_MASK = 0xffffffff;
+  static constexpr uint64_t BUFFER_BIT = 1ULL << 32;
+  static constexpr int LSN_SHIFT = 33;
+  /** Entries of buffer_offsets_ kept between checkpoints, past that every other one is dropped. */
+  static constexpr size_t MAX_BUFFER_OFFSETS = 1024;
+
+  static auto BufferIndex(uint64_t state) -> size_t { return (state & BUFFER_BIT) != 0 ? 1 : 0; }
+  auto Buffer(uint64_t state) -> char * { return BufferIndex(state) == 0 ? log_buffer_ : flush_buffer_; }
+
+  /**
+   * Continue the LSNs of the log already on disk: the next LSN follows the last complete record, which is also the
+   * persistent LSN. Otherwise a restarted process would hand out LSNs lower than the page LSNs on disk. A record
+   * torn by a crash at the end of the log is cut off, so that the records written from now on can be scanned.
+   */
+  void RestoreLSN();
+  /** Slow path of AppendLogRecord: wait until the active buffer has room for size bytes, flushing if needed. */
+  void WaitForRoom(size_t size);
+  /** Body of the flush thread. */
+  void FlushLoop();
+  /**
+   * Switch appends to the other buffer and write what was appended to the log file. Waits for a write in progress
+   * first; the latch is released during the write. @return false if there was nothing to write or the write failed
+   */
+  auto FlushBuffer(std::unique_lock<std::mutex> *lock) -> bool;
+  /**
+   * @return the offset in the log file of the buffer holding lsn, or of an earlier buffer if its entry was dropped to
+   * bound the table, 0 if that buffer is older than the ones still known. Forgets the buffers before it; a later
+   * checkpoint with an older redo LSN replays from the start of the log.
+   * Called with the latch held.
+   */
+  auto GetLogOffset(lsn_t lsn) -> int64_t;
+  /** Serialize log_record into dst, which has room for log_record->size_ bytes. */
+  static void SerializeLogRecord(const LogRecord &log_record, char *dst);
+
+  /** The next log sequence number, the active buffer and the bytes reserved in it, changed together by CAS. */
+  std::atomic<uint64_t> reserve_state_{0};
   /** The log records before and including the persistent lsn have been written to disk. */
   std::atomic<lsn_t> persistent_lsn_;
 
+  /** Buffer 0 and buffer 1 of reserve_state_, they take turns being appended to and being written. */
   char *log_buffer_;
   char *flush_buffer_;
+  /** Completion watermark of each buffer: the bytes of it that appenders finished serializing. */
+  std::atomic<size_t> completed_[2]{0, 0};
 
+  /** Protects the flags below; appenders only take it to wait for room. */
   std::mutex latch_;
-
-  std::thread *flush_thread_ __attribute__((__unused__));
-
+  /** The flush thread was asked to write now (buffer full or a Flush waiter) instead of at the next timeout. */
+  bool flush_requested_{false};
+  /** A write of the inactive buffer is in progress. */
+  bool flushing_{false};
+  /** A write of the log failed. Nothing is written after it, so the log has no gap; Flush and appenders throw. */
+  bool failed_{false};
+  bool stop_{false};
+  /** The time by which the earliest pending FlushAsync wants its records durable, max() if none is pending. */
+  std::chrono::steady_clock::time_point async_deadline_{std::chrono::steady_clock::time_point::max()};
+  /** The largest LSN passed to FlushAsync. */
+  lsn_t async_lsn_{INVALID_LSN};
+  /** The size of the log file, i.e. the offset the next write of a buffer goes to. */
+  int64_t log_offset_;
+  /**
+   * The first LSN of the buffers written since the last checkpoint and the offset of the buffer in the log file. At
+   * most MAX_BUFFER_OFFSETS of them, thinned out evenly when there are more.
+   */
+  std::map<lsn_t, int64_t> buffer_offsets_;
+
+  std::thread *flush_thread_{nullptr};
+
+  /** Wakes up the flush thread. */
+  std::condition_variable flush_cv_;
+  /** Wakes up appenders waiting for room and Flush callers once a write completed. */
   std::condition_variable cv_;
 
-  DiskManager *disk_manager_ __attribute__((__unused__));
+  DiskManager *disk_manager_;
 };
 
 }  // namespace bustub
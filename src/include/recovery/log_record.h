@@ -14,6 +14,8 @@
 
 #include <cassert>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 #include "storage/table/tuple.h"
@@ -32,6 +34,8 @@ enum class LogRecordType {
   ABORT,
   /** Creating a new page in the table heap. */
   NEWPAGE,
+  /** A checkpoint, with the active transaction table and the dirty page table at the time. */
+  CHECKPOINT,
 };
 
 /**
@@ -54,9 +58,13 @@ enum class LogRecordType {
  * | HEADER | tuple_rid | tuple_size | old_tuple_data | tuple_size | new_tuple_data |
  *-----------------------------------------------------------------------------------
  * For new page type log record
- *--------------------------
- * | HEADER | prev_page_id |
- *--------------------------
+ *------------------------------------
+ * | HEADER | prev_page_id | page_id |
+ *------------------------------------
+ * For checkpoint type log record (ATT: transaction id and last LSN, DPT: page id and recLSN)
+ *-------------------------------------------------------------------------------
+ * | HEADER | redo_offset | att_size | ATT entries | dpt_size | DPT entries |
+ *-------------------------------------------------------------------------------
  */
 class LogRecord {
   friend class LogManager;
@@ -110,6 +118,16 @@ class LogRecord {
     size_ = HEADER_SIZE + sizeof(page_id_t) * 2;
   }
 
+  // constructor for CHECKPOINT type
+  LogRecord(std::vector<std::pair<txn_id_t, lsn_t>> active_txns, std::vector<std::pair<page_id_t, lsn_t>> dirty_pages)
+      : log_record_type_(LogRecordType::CHECKPOINT),
+        active_txns_(std::move(active_txns)),
+        dirty_pages_(std::move(dirty_pages)) {
+    // header size + redo offset + both tables, each prefixed with its number of entries
+    size_ = HEADER_SIZE + sizeof(int64_t) + 2 * sizeof(int32_t) +
+            (active_txns_.size() + dirty_pages_.size()) * (sizeof(int32_t) + sizeof(lsn_t));
+  }
+
   ~LogRecord() = default;
 
   inline auto GetDeleteTuple() -> Tuple & { return delete_tuple_; }
@@ -128,6 +146,12 @@ class LogRecord {
 
   inline auto GetNewPageRecord() -> page_id_t { return prev_page_id_; }
 
+  inline auto GetActiveTxns() -> std::vector<std::pair<txn_id_t, lsn_t>> & { return active_txns_; }
+
+  inline auto GetDirtyPages() -> std::vector<std::pair<page_id_t, lsn_t>> & { return dirty_pages_; }
+
+  inline auto GetRedoOffset() -> int64_t { return redo_offset_; }
+
   inline auto GetSize() -> int32_t { return size_; }
 
   inline auto GetLSN() -> lsn_t { return lsn_; }
@@ -176,6 +200,11 @@ class LogRecord {
   // case4: for new page operation
   page_id_t prev_page_id_{INVALID_PAGE_ID};
   page_id_t page_id_{INVALID_PAGE_ID};
+
+  // case5: for checkpoint, the offset in the log file redo starts from, and the ATT and DPT
+  int64_t redo_offset_{0};
+  std::vector<std::pair<txn_id_t, lsn_t>> active_txns_;
+  std::vector<std::pair<page_id_t, lsn_t>> dirty_pages_;
   static const int HEADER_SIZE = 20;
 };  // namespace bustub
 
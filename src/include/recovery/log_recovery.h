@@ -13,22 +13,53 @@
 #pragma once
 
 #include <algorithm>
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <functional>
 #include <mutex>  // NOLINT
 #include <unordered_map>
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
 #include "concurrency/lock_manager.h"
+#include "recovery/log_manager.h"
 #include "recovery/log_record.h"
 
 namespace bustub {
 
 /**
  * Read log file from disk, redo and undo.
+ *
+ * Recovery follows ARIES. Analysis starts at the last checkpoint the master record points to, seeds the active
+ * transaction table and the dirty page table from the checkpoint record and brings them up to the end of the log.
+ * Redo then starts at the smallest recLSN, which the checkpoint recorded as a log offset, and only replays a record if
+ * its page is in the dirty page table and the record is not older than the page's recLSN; the pages that were written
+ * back before the crash are not even read.
+ *
+ * Redo is partitioned by page: the thread calling Redo reads and deserializes the log, and hands every record that
+ * changes a table page to the worker owning that page (page_id % redo_workers). A page is only ever touched by its
+ * own worker, which applies its records in LSN order, so the pages are replayed in parallel without changing the
+ * outcome of a serial replay.
+ *
+ * Undo rolls the losers back the way TransactionManager::Abort does: every step is logged as an ordinary record of the
+ * loser and stamped on the page as its LSN, and an ABORT record closes each loser. If the system crashes again during
+ * undo, the next recovery redoes the logged steps and rolls them back together with the rest of the loser.
  */
 class LogRecovery {
  public:
-  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager)
-      : disk_manager_(disk_manager), buffer_pool_manager_(buffer_pool_manager), offset_(0) {
+  /**
+   * @param disk_manager the disk manager holding the log
+   * @param buffer_pool_manager the buffer pool the pages are replayed into
+   * @param log_manager the log the rollback of the losers is appended to, only needed by Undo
+   * @param redo_workers the threads applying redo records
+   */
+  LogRecovery(DiskManager *disk_manager, BufferPoolManager *buffer_pool_manager, LogManager *log_manager,
+              size_t redo_workers = REDO_WORKER_CNT)
+      : disk_manager_(disk_manager),
+        buffer_pool_manager_(buffer_pool_manager),
+        log_manager_(log_manager),
+        redo_workers_(std::max<size_t>(redo_workers, 1)),
+        offset_(0) {
     log_buffer_ = new char[LOG_BUFFER_SIZE];
   }
 
@@ -37,20 +68,86 @@ class LogRecovery {
     log_buffer_ = nullptr;
   }
 
+  /**
+   * Run the analysis pass, then replay the log from the redo start. Records whose LSN is not newer than the page LSN
+   * are already in the page and skipped. Also builds lsn_mapping_ for Undo.
+   */
   void Redo();
+
+  /**
+   * Roll back the transactions that neither committed nor aborted before the end of the log, and append an ABORT record
+   * for each of them. Returns once the ABORT records are durable.
+   */
   void Undo();
-  auto DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool;
+
+  /**
+   * Deserialize a log record.
+   * @param data the start of the record
+   * @param size the bytes readable at data
+   * @param[out] log_record the record
+   * @return false if no complete record starts at data, i.e. the end of the log or a torn tail
+   */
+  auto DeserializeLogRecord(const char *data, int size, LogRecord *log_record) -> bool;
 
  private:
-  DiskManager *disk_manager_ __attribute__((__unused__));
-  BufferPoolManager *buffer_pool_manager_ __attribute__((__unused__));
+  /** A record for a redo worker, and the page of the record the worker should apply it to. */
+  struct RedoTask {
+    page_id_t page_id_;
+    LogRecord log_record_;
+  };
+
+  /** The tasks of one redo worker. The reader hands them over in batches so the latch is taken once per batch. */
+  struct RedoQueue {
+    std::mutex latch_;
+    std::condition_variable cv_;
+    std::deque<std::vector<RedoTask>> batches_;
+    bool done_{false};
+  };
+
+  /** Tasks collected before a batch is handed to a worker. */
+  static constexpr size_t REDO_BATCH_SIZE = 256;
+  /** Batches queued per worker before the reader waits, to bound the memory used on a long log. */
+  static constexpr size_t REDO_QUEUE_DEPTH = 64;
+
+  /**
+   * Analysis pass: build active_txn_ and dirty_pages_ from the last checkpoint and the log after it, and set
+   * redo_offset_. Without a checkpoint the whole log is analyzed and redone.
+   */
+  void Analyze();
+  /** Deserialize the records from offset to the end of the log and hand each one to visit with its offset. */
+  void ScanLog(int64_t offset, const std::function<void(LogRecord *, int64_t)> &visit);
+  /** @return true if the page may miss the change of the record with this LSN, by the dirty page table */
+  auto NeedsRedo(page_id_t page_id, lsn_t lsn) -> bool;
+  /** Queue `log_record` for the worker owning page_id. */
+  void Dispatch(page_id_t page_id, const LogRecord &log_record, std::vector<std::vector<RedoTask>> *pending,
+                std::vector<RedoQueue> *queues);
+  void Submit(std::vector<RedoTask> *batch, RedoQueue *queue);
+  /** Worker: apply the batches of `queue` until the reader is done. */
+  void RunRedoWorker(RedoQueue *queue);
+  /** Redo one record on page_id unless the page LSN shows it is already there. */
+  void RedoRecord(page_id_t page_id, LogRecord *log_record);
+  /**
+   * Apply the inverse of a record and log it as the next record of its transaction.
+   * @param[in,out] prev_lsn the last LSN of the transaction, updated to the LSN of the logged inverse
+   */
+  void UndoRecord(LogRecord *log_record, lsn_t *prev_lsn);
+
+  DiskManager *disk_manager_;
+  BufferPoolManager *buffer_pool_manager_;
+  LogManager *log_manager_;
+  const size_t redo_workers_;
 
   /** Maintain active transactions and its corresponding latest lsn. */
   std::unordered_map<txn_id_t, lsn_t> active_txn_;
+  /** The pages that may not be up to date on disk and their recLSN, the oldest LSN the disk may be missing. */
+  std::unordered_map<page_id_t, lsn_t> dirty_pages_;
+  /** Offset in the log file redo starts from. */
+  int64_t redo_offset_{0};
   /** Mapping the log sequence number to log file offset for undos. */
-  std::unordered_map<lsn_t, int> lsn_mapping_;
+  std::unordered_map<lsn_t, int64_t> lsn_mapping_;
 
-  int offset_ __attribute__((__unused__));  // NOLINT
+  /** Offset in the log file of the first byte in log_buffer_ */
+  int64_t offset_;
   char *log_buffer_;
 };
 
@@ -0,0 +1,136 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.h
+//
+// Identification: src/include/storage/disk/async_disk_manager.h
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <condition_variable>  // NOLINT
+#include <deque>
+#include <mutex>  // NOLINT
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "common/config.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+/**
+ * AsyncDiskManager keeps many page reads and writes of the database file in flight at once. Requests handed to
+ * Schedule are submitted to an io_uring in one system call and completed by a reaper thread; where io_uring is not
+ * available (old kernel, seccomp) a pool of threads issues them with pread / pwrite instead.
+ *
+ * ReadPage and WritePage go through the same queue and wait for their request, so callers written for DiskManager
+ * work unchanged and no longer serialize on a latch. WritePages is inherited, its runs of adjacent pages already go out
+ * in one system call each. The log file is still handled by DiskManager. The database file is always opened for
+ * buffered I/O, since requests are handed to the kernel as is, without bounce buffers.
+ */
+class AsyncDiskManager : public DiskManager {
+ public:
+  enum class Backend { IO_URING, THREAD_POOL };
+
+  /**
+   * Creates a new asynchronous disk manager that writes to the specified database file.
+   * @param db_file the file name of the database file to write to
+   * @param queue_depth the most requests in flight at a time
+   * @param backend the backend to use; IO_URING falls back to THREAD_POOL if the ring cannot be set up
+   */
+  explicit AsyncDiskManager(const std::string &db_file, size_t queue_depth = ASYNC_IO_QUEUE_DEPTH,
+                            Backend backend = Backend::IO_URING);
+
+  ~AsyncDiskManager() override;
+
+  /** Wait for the requests in flight, then sync and close the file like DiskManager. */
+  void ShutDown() override;
+
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override;
+
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override;
+
+  /**
+   * Queue the requests and return without waiting. Blocks only while queue_depth requests are already in flight.
+   * Reads past the end of the file complete with a zero-filled page.
+   */
+  void Schedule(std::vector<DiskRequest> requests) override;
+
+  /** @return the backend in use */
+  auto GetBackend() const -> Backend { return backend_; }
+
+ private:
+  /** A request in flight, indexed by the user data of its io_uring submission. */
+  struct Slot {
+    DiskRequest request_;
+    iovec iov_;
+  };
+
+  /** The mmaped submission and completion queues of the io_uring, see io_uring_setup(2). */
+  struct Ring {
+    int fd_{-1};
+    void *sq_ptr_{nullptr};
+    size_t sq_size_{0};
+    void *cq_ptr_{nullptr};
+    size_t cq_size_{0};
+    void *sqes_ptr_{nullptr};
+    size_t sqes_size_{0};
+    unsigned *sq_head_{nullptr};
+    unsigned *sq_tail_{nullptr};
+    unsigned *sq_mask_{nullptr};
+    unsigned *sq_array_{nullptr};
+    unsigned *cq_head_{nullptr};
+    unsigned *cq_tail_{nullptr};
+    unsigned *cq_mask_{nullptr};
+    void *cqes_{nullptr};
+  };
+
+  auto SetUpRing() -> bool;
+  void TearDownRing();
+  /** Reaper thread: wait for io_uring completions and fire their callbacks. */
+  void ReapCompletions();
+  /** Thread pool worker: pop requests from pending_ and perform them. */
+  void ServeRequests();
+  /**
+   * Perform a request with pread / pwrite, retrying until the whole page is transferred or a read hits the end of file.
+   * @param done the bytes transferred already
+   * @return the bytes transferred, or -errno
+   */
+  auto PerformRequest(const DiskRequest &request, int done = 0) -> int;
+  /** Fire the callback of a request that transferred `result` bytes, or failed with -errno. */
+  void CompleteRequest(DiskRequest *request, int result);
+  /** Account for a finished request and wake up Schedule / Stop callers waiting for room in the queue. */
+  void ReleaseRequest();
+  /** Stop the reaper / workers after the requests in flight completed. */
+  void Stop();
+
+  Backend backend_;
+  const size_t queue_depth_;
+  bool stopped_{false};
+
+  /** Protects the submission queue, pending_, free_slots_, in_flight_ and stopped_ */
+  std::mutex latch_;
+  std::condition_variable room_cv_;
+  size_t in_flight_{0};
+
+  // io_uring
+  Ring ring_;
+  std::vector<Slot> slots_;
+  std::vector<unsigned> free_slots_;
+  std::thread reaper_;
+
+  // thread pool
+  std::deque<DiskRequest> pending_;
+  std::condition_variable pending_cv_;
+  std::vector<std::thread> workers_;
+};
+
+}  // namespace bustub
@@ -17,53 +17,104 @@
 #include <future>  // NOLINT
 #include <mutex>   // NOLINT
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "common/config.h"
 
 namespace bustub {
 
+/**
+ * One page read or write handed to DiskManager::Schedule. The caller keeps the future of callback_, which is set to
+ * true once the I/O completed and to false if it failed.
+ */
+struct DiskRequest {
+  /** true to write data_ to the page, false to read the page into data_ */
+  bool is_write_;
+  /** page to read or write */
+  page_id_t page_id_;
+  /** BUSTUB_PAGE_SIZE bytes, must stay valid until the callback fires */
+  char *data_;
+  std::promise<bool> callback_;
+};
+
 /**
  * DiskManager takes care of the allocation and deallocation of pages within a database. It performs the reading and
  * writing of pages to and from disk, providing a logical file layer within the context of a database management system.
+ *
+ * Pages are read and written with pread / pwrite at their own offset, so page I/O from many threads runs in parallel
+ * without a shared file position. Writes reach the OS page cache; Sync() and ShutDown() sync the file to disk.
  */
 class DiskManager {
  public:
   /**
    * Creates a new disk manager that writes to the specified database file.
    * @param db_file the file name of the database file to write to
+   * @param direct_io open the database file with O_DIRECT, so pages are not cached a second time by the OS. Falls back
+   * to buffered I/O if the file system does not support it. Page buffers should be BUSTUB_PAGE_SIZE aligned, like the
+   * frames of the buffer pool; other buffers are copied through a bounce buffer.
    */
-  explicit DiskManager(const std::string &db_file);
+  explicit DiskManager(const std::string &db_file, bool direct_io = DISK_MANAGER_DIRECT_IO);
 
   /** FOR TEST / LEADERBOARD ONLY, used by DiskManagerMemory */
   DiskManager() = default;
 
-  virtual ~DiskManager() = default;
+  virtual ~DiskManager();
 
   /**
-   * Shut down the disk manager and close all the file resources.
+   * Shut down the disk manager: sync the database file and close all the file resources.
    */
-  void ShutDown();
+  virtual void ShutDown();
 
   /**
    * Write a page to the database file.
    * @param page_id id of the page
    * @param page_data raw page data
+   * @return false on an I/O error
    */
-  virtual void WritePage(page_id_t page_id, const char *page_data);
+  virtual auto WritePage(page_id_t page_id, const char *page_data) -> bool;
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
-   * @param[out] page_data output buffer
+   * @param[out] page_data output buffer, zero filled past the end of the file
+   * @return false on an I/O error
    */
-  virtual void ReadPage(page_id_t page_id, char *page_data);
+  virtual auto ReadPage(page_id_t page_id, char *page_data) -> bool;
 
   /**
-   * Flush the entire log buffer into disk.
+   * Write many pages at once. The pages are sorted by page id and every run of adjacent page ids goes out in one
+   * vectored write (pwritev). Disk managers without a database file write them one by one through WritePage.
+   * @param pages page ids and their raw page data, each page id at most once
+   */
+  virtual void WritePages(std::vector<std::pair<page_id_t, const char *>> pages);
+
+  /**
+   * Start a batch of page reads and writes. The requests may complete in any order and concurrently with each other;
+   * the caller must not put two requests for the same page into one batch if one of them is a write.
+   * The base implementation performs them one by one through ReadPage / WritePage before returning.
+   * @param requests the requests, the futures of their callbacks must have been taken already
+   */
+  virtual void Schedule(std::vector<DiskRequest> requests);
+
+  /**
+   * Schedule the requests and wait until all of them completed.
+   * @return true if all of them succeeded
+   */
+  auto ScheduleAndWait(std::vector<DiskRequest> requests) -> bool;
+
+  /**
+   * Sync the pages written so far to disk (fdatasync). Returns once they are durable.
+   */
+  void Sync();
+
+  /**
+   * Flush the entire log buffer into disk. Returns once the log is durable (fdatasync).
    * @param log_data raw log data
    * @param size size of log entry
+   * @return false on an I/O error, the log may then end in a partly written record
    */
-  void WriteLog(char *log_data, int size);
+  virtual auto WriteLog(char *log_data, int size) -> bool;
 
   /**
    * Read a log entry from the log file.
@@ -72,7 +123,44 @@ class DiskManager {
    * @param offset offset of the log entry in the file
    * @return true if the read was successful, false otherwise
    */
-  auto ReadLog(char *log_data, int size, int offset) -> bool;
+  auto ReadLog(char *log_data, int size, int64_t offset) -> bool;
+
+  /** @return the bytes in the log file, 0 if there is no log file */
+  auto GetLogSize() -> int64_t;
+
+  /**
+   * Cut the log file down to size bytes. Returns once the new size is durable.
+   * @return false on an I/O error
+   */
+  auto TruncateLog(int64_t size) -> bool;
+
+  /**
+   * Record where the last complete checkpoint record starts, in the master record file next to the log. Returns once
+   * the master record is durable.
+   * @param checkpoint_offset offset of the checkpoint record in the log file
+   */
+  void WriteMasterRecord(int64_t checkpoint_offset);
+
+  /** @return the offset of the last checkpoint record in the log file, -1 if no checkpoint was taken */
+  auto ReadMasterRecord() -> int64_t;
+
+  /**
+   * Record the first page of a buffer pool instance's free page map in the master record file, see FreePageMap::Save.
+   * Returns once it is durable.
+   * @param instance_index the buffer pool instance the map belongs to
+   * @param root the first page of the map, INVALID_PAGE_ID if the instance has no saved map
+   */
+  void WriteFreePageMapRoot(uint32_t instance_index, page_id_t root);
+
+  /**
+   * Read what WriteFreePageMapRoot() recorded for a buffer pool instance.
+   * @param[out] root the first page of the map, INVALID_PAGE_ID if the instance has no saved map
+   * @return false if nothing was ever recorded for the instance
+   */
+  auto ReadFreePageMapRoot(uint32_t instance_index, page_id_t *root) -> bool;
+
+  /** @return the number of pages the database file holds, 0 without a database file */
+  virtual auto GetNumPages() -> page_id_t;
 
   /** @return the number of disk flushes */
   auto GetNumFlushes() const -> int;
@@ -83,6 +171,15 @@ class DiskManager {
   /** @return the number of disk writes */
   auto GetNumWrites() const -> int;
 
+  /** @return the number of pwrite / pwritev system calls that wrote pages, one page or a run of pages each */
+  auto GetNumWriteCalls() const -> int { return num_write_calls_; }
+
+  /** @return true if the database file is open with O_DIRECT */
+  auto IsDirectIo() const -> bool { return direct_io_; }
+
+  /** @return the number of direct page I/Os that went through a bounce buffer because the buffer was not aligned */
+  auto GetNumBouncedIos() const -> int { return num_bounced_ios_; }
+
   /**
    * Sets the future which is used to check for non-blocking flushes.
    * @param f the non-blocking flush check
@@ -93,19 +190,27 @@ class DiskManager {
   inline auto HasFlushLogFuture() -> bool { return flush_log_f_ != nullptr; }
 
  protected:
-  auto GetFileSize(const std::string &file_name) -> int;
-  // stream to write log file
-  std::fstream log_io_;
+  auto GetFileSize(const std::string &file_name) -> int64_t;
+  /** Write size bytes at offset of the master record file and sync it. */
+  void WriteMaster(int64_t offset, const void *data, size_t size);
+  /** @return false if the master record file does not hold size bytes at offset */
+  auto ReadMaster(int64_t offset, void *data, size_t size) -> bool;
+  // 日志文件的fd，追加写，每次WriteLog之后fdatasync
+  int log_fd_{-1};
   std::string log_name_;
-  // stream to write db file
-  std::fstream db_io_;     // 文件流，主要用于向db文件中写文件用的
+  // 主记录文件：| 最后一个检查点记录在日志里的偏移量 (8) | 0号分片的空闲页表根 (4) | 它的按位取反 (4) | 1号分片... |
+  // 取反的那一份用来识别没写过的槽位，没写过的地方读出来是0
+  std::string master_name_;
+  // db文件的fd，页的读写都用pread/pwrite按偏移量进行，不需要共享文件位置，也就不需要锁
+  int db_fd_{-1};
   std::string file_name_;  // db 文件名
   int num_flushes_{0};
-  int num_writes_{0};
+  std::atomic<int> num_writes_{0};
+  std::atomic<int> num_write_calls_{0};
+  bool direct_io_{false};
+  std::atomic<int> num_bounced_ios_{0};
   bool flush_log_{false};
   std::future<void> *flush_log_f_{nullptr};
-  // With multiple buffer pool instances, need to protect file access
-  std::mutex db_io_latch_;
 };
 
 }  // namespace bustub
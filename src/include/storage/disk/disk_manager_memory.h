@@ -43,16 +43,20 @@ class DiskManagerMemory : public DiskManager {
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data) override;
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override;
 
   /**
    * Read a page from the database file.
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
-  void ReadPage(page_id_t page_id, char *page_data) override;
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override;
+
+  /** @return the number of pages the memory holds */
+  auto GetNumPages() -> page_id_t override { return static_cast<page_id_t>(pages_); }
 
  private:
+  size_t pages_;
   char *memory_;
 };
 
@@ -69,7 +73,7 @@ class DiskManagerUnlimitedMemory : public DiskManager {
    * @param page_id id of the page
    * @param page_data raw page data
    */
-  void WritePage(page_id_t page_id, const char *page_data) override {
+  auto WritePage(page_id_t page_id, const char *page_data) -> bool override {
     std::unique_lock<std::mutex> l(mutex_);
     if (page_id >= static_cast<int>(data_.size())) {
       data_.resize(page_id + 1);
@@ -82,6 +86,7 @@ class DiskManagerUnlimitedMemory : public DiskManager {
     l.unlock();
 
     memcpy(ptr->first.data(), page_data, BUSTUB_PAGE_SIZE);
+    return true;
   }
 
   /**
@@ -89,21 +94,26 @@ class DiskManagerUnlimitedMemory : public DiskManager {
    * @param page_id id of the page
    * @param[out] page_data output buffer
    */
-  void ReadPage(page_id_t page_id, char *page_data) override {
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override {
     std::unique_lock<std::mutex> l(mutex_);
-    if (page_id >= static_cast<int>(data_.size()) || page_id < 0) {
-      LOG_WARN("page not exist");
-      return;
-    }
-    if (data_[page_id] == nullptr) {
+    // 和DiskManager读到文件末尾之后一样，没写过的页读出来是0
+    if (page_id >= static_cast<int>(data_.size()) || page_id < 0 || data_[page_id] == nullptr) {
       LOG_WARN("page not exist");
-      return;
+      memset(page_data, 0, BUSTUB_PAGE_SIZE);
+      return true;
     }
     std::shared_ptr<ProtectedPage> ptr = data_[page_id];
     std::shared_lock<std::shared_mutex> l_page(ptr->second);
     l.unlock();
 
     memcpy(page_data, ptr->first.data(), BUSTUB_PAGE_SIZE);
+    return true;
+  }
+
+  /** @return one past the highest page written so far */
+  auto GetNumPages() -> page_id_t override {
+    std::scoped_lock l(mutex_);
+    return static_cast<page_id_t>(data_.size());
   }
 
  private:
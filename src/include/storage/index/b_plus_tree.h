@@ -10,10 +10,13 @@
 //===----------------------------------------------------------------------===//
 #pragma once
 
+#include <atomic>
+#include <mutex>  // NOLINT
 #include <queue>
 #include <string>
 #include <vector>
 
+#include "buffer/extent_allocator.h"
 #include "concurrency/transaction.h"
 #include "storage/index/index_iterator.h"
 #include "storage/page/b_plus_tree_internal_page.h"
@@ -69,20 +72,22 @@ class BPlusTree {
   // return the page id of the root node
   auto GetRootPageId() -> page_id_t;
 
-  // 辅助函数，给定key，找出该key所在的leafpage和idx
-  auto LocatePage(const KeyType &key, int *idx) -> LeafPage*;
+  // 之后这棵树的页访问都记在这个tag下，见BufferPoolManager::RegisterTag()
+  void SetBufferPoolTag(BufferPoolTag tag) { tag_ = tag; }
 
+  // 融合node和它的兄弟，做完之后放掉两个锁，返回true则说明父亲节点也需要修复
   template<class PageNode>
-  auto Merge(PageNode * mergein, const KeyType & deleted_key) -> InternalPage*;
+  auto Merge(WritePageGuard *parent_guard, WritePageGuard *node_guard, const KeyType & deleted_key) -> bool;
 
   template<class PageNode>
   auto Merge(PageNode * merge_b, PageNode * merge_s) -> void;
-  // 如果返回不为空，则说明返回的这个节点也需要修复
+
+  // path是从根到要修复的那个结点一路经过的页
   template<class PageNode>
-  auto FixInternalNode(PageNode *pn, const KeyType & deleted_key) -> void;
+  auto FixInternalNode(std::vector<page_id_t> *path, const KeyType & deleted_key) -> void;
 
   template<class PageNode>
-  auto BorrowBrother(PageNode * node, bool left) -> bool;
+  auto BorrowBrother(WritePageGuard *parent_guard, WritePageGuard *node_guard, bool left) -> bool;
 
 
   // index iterator
@@ -103,44 +108,33 @@ class BPlusTree {
   void RemoveFromFile(const std::string &file_name, Transaction *transaction = nullptr);
 
   auto Search(const KeyType &key, std::vector<ValueType> *result) -> void;
+
+  // lock-free descent of Search(), false if it has to be retried
+  auto SearchOptimistic(const KeyType &key, std::vector<ValueType> *result) -> bool;
   
-  template<class PageNode>
-  void UpdateNode(PageNode *node);
-  
-  int fetch_count{0};
-  int unpin_count{0};
+  // 把page_id这个孩子的最大key往上更新，调用的时候不能拿着任何结点的锁
+  void UpdateNode(page_id_t parent_page_id, page_id_t page_id, KeyType max_key);
 
  private:
   // search
   // split
   template<class T>
   auto SplitNode(T * origin, T * splited) -> void;
-  auto SplitLeafPageNode(LeafPage *leaf) -> InternalPage *;
-
-  auto SplitInternalPageNode(InternalPage * spliting_node) -> InternalPage *;
 
   auto UpdateChildrenParent(InternalPage * parent) -> void;
 
-  template<class T>
-  auto UnpinPageNode(T * node, bool is_dirty) -> void;
-
-  template<class T>
-  auto FetchPageNode(page_id_t page_id) -> T*;
-
-  template<class T>
-  auto NewPageNode(page_id_t parent_page_id, int max_size) -> T*;
-
+  // 分裂path的最后一个结点，做完之后出栈，返回true则说明父亲节点也满了
   template<class PageNode>
-  auto SplitPageNode(PageNode *leaf_node) -> InternalPage *;
+  auto SplitPageNode(std::vector<page_id_t> *path) -> bool;
+
+  // 给当前的根加读锁，树为空时返回空的guard
+  auto LatchRootRead() -> ReadPageGuard;
 
   void UpdateRootPageId(int insert_record = 0);
 
   template <class T>
   auto ToInternalPage(T *page_data) -> InternalPage *;
 
-  template <class T>
-  auto ToGeneralPage(T *page_data) -> BPlusTreePage *;
-
   template <class T>
   auto ToLeafPage(T *page_data) -> LeafPage *;
 
@@ -151,11 +145,17 @@ class BPlusTree {
 
   // member variable
   std::string index_name_;
-  page_id_t root_page_id_;
+  // 根换掉的时候旧的根还被写锁锁着，拿到根的锁之后再对一次，就知道拿到的是不是根
+  std::atomic<page_id_t> root_page_id_;
+  // 插入和删除之间串行，结点只有拿着它的写者会改
+  std::mutex writer_latch_;
   BufferPoolManager *buffer_pool_manager_;
   KeyComparator comparator_;
   int leaf_max_size_;
   int internal_max_size_;
+  BufferPoolTag tag_;
+  // 索引的页按区段分配，叶子页在磁盘上挨在一起
+  ExtentAllocator extent_allocator_;
 };
 
 }  // namespace bustub
@@ -41,6 +41,9 @@ class BPlusTreeIndex : public Index {
 
   auto GetEndIterator() -> INDEXITERATOR_TYPE;
 
+  /** Count the page accesses of this index under a buffer pool tag, see BufferPoolManager::RegisterTag(). */
+  void SetBufferPoolTag(BufferPoolTag tag) { container_.SetBufferPoolTag(tag); }
+
  protected:
   // comparator for key
   KeyComparator comparator_;
@@ -13,6 +13,7 @@
  * For range scan of b+ tree
  */
 #pragma once
+#include "buffer/buffer_pool_metrics.h"
 #include "storage/page/b_plus_tree_leaf_page.h"
 
 namespace bustub {
@@ -25,7 +26,7 @@ class IndexIterator {
   // you may define your own constructor based on your member variables
   using LeafPage = BPlusTreeLeafPage<KeyType, ValueType, KeyComparator>;
   IndexIterator();
-  IndexIterator(BufferPoolManager *bpm, page_id_t page_id, int start_index);
+  IndexIterator(BufferPoolManager *bpm, page_id_t page_id, int start_index, BufferPoolTag tag = {});
   ~IndexIterator();  // NOLINT
 
   auto IsEnd() const -> bool;
@@ -45,6 +46,8 @@ class IndexIterator {
   BufferPoolManager *bpm_;
   LeafPage * page_;
   int cursor_;
+  // 叶子页的访问记在所属索引的tag下
+  BufferPoolTag tag_;
   
 };
 
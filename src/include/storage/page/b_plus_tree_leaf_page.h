@@ -64,7 +64,7 @@ class BPlusTreeLeafPage : public BPlusTreePage {
 
 
   auto SetValue(int index, const ValueType & value) -> void;
-  auto Get(const KeyType & key, KeyComparator & cmp, std::vector<ValueType> *result) -> void;
+  auto Get(const KeyType & key, KeyComparator & cmp, std::vector<ValueType> *result) const -> void;
   // helper，搜索函数  
   auto BinarySearch(const KeyType & key, int *idx, KeyComparator cmp) const -> bool;
   // helper，插入帮助函数，一定可以插入成功，但是插入之后如果满了，则返回true
@@ -0,0 +1,64 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map_page.h
+//
+// Identification: src/include/storage/page/free_page_map_page.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+
+#include "common/config.h"
+
+namespace bustub {
+
+/**
+ * One page of the on-disk free page map (see FreePageMap). The map is a singly linked chain of these pages, each
+ * listing up to CAPACITY free page ids.
+ *
+ * Format (size in byte, 16 bytes of header):
+ * ----------------------------------------------------------------------------
+ * | PageId (4) | LSN (4) | NextPageId (4) | Size (4) | FreePageId_1 (4) | ...
+ * ----------------------------------------------------------------------------
+ */
+class FreePageMapPage {
+ public:
+  static constexpr size_t HEADER_SIZE = 16;
+  static constexpr size_t CAPACITY = (BUSTUB_PAGE_SIZE - HEADER_SIZE) / sizeof(page_id_t);
+
+  /** @brief Initialize an empty map page. */
+  void Init(page_id_t page_id, page_id_t next_page_id);
+
+  auto GetPageId() const -> page_id_t;
+
+  /** @return the next page of the chain, INVALID_PAGE_ID on the last one */
+  auto GetNextPageId() const -> page_id_t;
+
+  /** @return the number of free page ids on this page */
+  auto GetSize() const -> size_t;
+
+  auto IsFull() const -> bool;
+
+  auto FreePageIdAt(size_t index) const -> page_id_t;
+
+  /** @brief Append a free page id. The page must not be full. */
+  void Append(page_id_t page_id);
+
+ private:
+  page_id_t page_id_;
+  __attribute__((unused)) lsn_t lsn_;
+  page_id_t next_page_id_;
+  uint32_t size_;
+  // Flexible array member for page data.
+  page_id_t free_page_ids_[1];
+};
+
+static_assert(sizeof(FreePageMapPage) == FreePageMapPage::HEADER_SIZE + sizeof(page_id_t));
+
+}  // namespace bustub
@@ -12,8 +12,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "common/config.h"
 #include "common/rwlatch.h"
@@ -30,8 +33,14 @@ class Page {
   friend class BufferPoolManagerInstance;
 
  public:
-  /** Constructor. Zeros out the page data. */
-  Page() { ResetMemory(); }
+  /** Constructor. Allocates the page data and zeros it out. */
+  Page() : owned_data_(new char[BUSTUB_PAGE_SIZE]), data_(owned_data_.get()) { ResetMemory(); }
+
+  /**
+   * Constructor for a buffer pool frame. Zeros out the page data.
+   * @param data BUSTUB_PAGE_SIZE bytes of page data, owned by the caller and outliving the page
+   */
+  explicit Page(char *data) : data_(data) { ResetMemory(); }
 
   /** Default destructor. */
   ~Page() = default;
@@ -48,11 +57,18 @@ class Page {
   /** @return true if the page in memory has been modified from the page on disk, false otherwise */
   inline auto IsDirty() -> bool { return is_dirty_; }
 
-  /** Acquire the page write latch. */
-  inline void WLatch() { rwlatch_.WLock(); }
+  /** Acquire the page write latch. The page version is odd while the latch is held, see OptimisticLatch(). */
+  inline void WLatch() {
+    rwlatch_.WLock();
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+  }
 
   /** Release the page write latch. */
-  inline void WUnlatch() { rwlatch_.WUnlock(); }
+  inline void WUnlatch() {
+    version_.store(version_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    rwlatch_.WUnlock();
+  }
 
   /** Acquire the page read latch. */
   inline void RLatch() { rwlatch_.RLock(); }
@@ -60,6 +76,20 @@ class Page {
   /** Release the page read latch. */
   inline void RUnlatch() { rwlatch_.RUnlock(); }
 
+  /**
+   * Start an optimistic read. Nothing is locked and no shared cache line is written: the caller reads the page and then
+   * calls ValidateOptimistic() with the returned version, which fails if a writer latched the page in between, in which
+   * case whatever was read must be thrown away. The caller must keep the page pinned.
+   * @return the page version; an odd version means a writer holds the latch right now and will never validate
+   */
+  inline auto OptimisticLatch() -> uint64_t { return version_.load(std::memory_order_acquire); }
+
+  /** @return true if the page has not been write latched since OptimisticLatch() returned version */
+  inline auto ValidateOptimistic(uint64_t version) -> bool {
+    std::atomic_thread_fence(std::memory_order_acquire);
+    return (version & 1) == 0 && version_.load(std::memory_order_relaxed) == version;
+  }
+
   /** @return the page LSN. */
   inline auto GetLSN() -> lsn_t { return *reinterpret_cast<lsn_t *>(GetData() + OFFSET_LSN); }
 
@@ -78,16 +108,22 @@ class Page {
   /** Zeroes out the data that is held within the page. */
   inline void ResetMemory() { memset(data_, OFFSET_PAGE_START, BUSTUB_PAGE_SIZE); }
 
-  /** The actual data that is stored within a page. */
-  char data_[BUSTUB_PAGE_SIZE]{};
+  /** The page data when the page allocated it itself, nullptr for a buffer pool frame. */
+  std::unique_ptr<char[]> owned_data_;
+  /** The actual data that is stored within a page. Frames point into the pool's aligned FrameMemory. */
+  char *data_;
   /** The ID of this page. */
   page_id_t page_id_ = INVALID_PAGE_ID;
   /** The pin count of this page. */
   int pin_count_ = 0;
   /** True if the page is dirty, i.e. it is different from its corresponding page on disk. */
   bool is_dirty_ = false;
+  /** The page LSN of the version last read from or written to disk, the recLSN of the page is the LSN after it. */
+  lsn_t disk_lsn_ = INVALID_LSN;
   /** Page latch. */
   ReaderWriterLatch rwlatch_;
+  /** Bumped when the write latch is taken and again when it is released, so it is odd while a writer is active. */
+  std::atomic<uint64_t> version_{0};
 };
 
 }  // namespace bustub
@@ -0,0 +1,289 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.h
+//
+// Identification: src/include/storage/page/page_guard.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "common/config.h"
+#include "storage/page/page.h"
+
+namespace bustub {
+
+class BufferPoolManager;
+class UnpinBatch;
+
+/**
+ * BasicPageGuard owns one pin on a page and unpins it when it goes out of scope, so that a page fetched from the
+ * buffer pool can no longer leak its frame on an early return. It does not latch the page; see ReadPageGuard and
+ * WritePageGuard for that.
+ *
+ * Guards can be moved but not copied. A default-constructed or moved-from guard holds no page; so does the guard
+ * returned by a fetch that failed because every frame is pinned, check IsValid() before using it.
+ */
+class BasicPageGuard {
+ public:
+  BasicPageGuard() = default;
+
+  BasicPageGuard(BufferPoolManager *bpm, Page *page) : bpm_(bpm), page_(page) {}
+
+  BasicPageGuard(const BasicPageGuard &) = delete;
+  auto operator=(const BasicPageGuard &) -> BasicPageGuard & = delete;
+
+  /** @brief Take over the pin of that guard, which becomes empty. */
+  BasicPageGuard(BasicPageGuard &&that) noexcept;
+
+  /** @brief Unpin the page this guard holds, if any, then take over the pin of that guard. */
+  auto operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard &;
+
+  /** @brief Unpin the page now and leave the guard empty. Does nothing on an empty guard. */
+  void Drop();
+
+  /**
+   * @brief Leave the guard empty, but hand the unpin to a batch instead of doing it now. The page stays pinned until
+   * the batch is released.
+   */
+  void Drop(UnpinBatch *batch);
+
+  ~BasicPageGuard();
+
+  /** @return true if the guard holds a page */
+  auto IsValid() const -> bool { return page_ != nullptr; }
+
+  auto PageId() const -> page_id_t { return page_->GetPageId(); }
+
+  /** @return the page itself, for page types that derive from Page such as TablePage */
+  auto GetPage() const -> Page * { return page_; }
+
+  auto GetData() const -> const char * { return page_->GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return reinterpret_cast<const T *>(GetData());
+  }
+
+  /** @brief The page data for writing; marks the page dirty. */
+  auto GetDataMut() -> char * {
+    is_dirty_ = true;
+    return page_->GetData();
+  }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return reinterpret_cast<T *>(GetDataMut());
+  }
+
+  /** @brief Unpin the page as dirty, for writes made through GetPage(). */
+  void SetDirty() { is_dirty_ = true; }
+
+ private:
+  friend class ReadPageGuard;
+  friend class WritePageGuard;
+  friend class OptimisticPageGuard;
+
+  BufferPoolManager *bpm_{nullptr};
+  Page *page_{nullptr};
+  bool is_dirty_{false};
+};
+
+/**
+ * ReadPageGuard owns one pin and the read latch on a page, and releases both when it goes out of scope. Get one from
+ * BufferPoolManager::FetchPageRead().
+ */
+class ReadPageGuard {
+ public:
+  ReadPageGuard() = default;
+
+  /** @brief Guard a page that is already pinned and read latched. */
+  ReadPageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  ReadPageGuard(const ReadPageGuard &) = delete;
+  auto operator=(const ReadPageGuard &) -> ReadPageGuard & = delete;
+
+  ReadPageGuard(ReadPageGuard &&that) noexcept = default;
+
+  /** @brief Release the page this guard holds, if any, then take over the page of that guard. */
+  auto operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard &;
+
+  /** @brief Unlatch and unpin the page now and leave the guard empty. Does nothing on an empty guard. */
+  void Drop();
+
+  /** @brief Unlatch the page now and hand the unpin to a batch. */
+  void Drop(UnpinBatch *batch);
+
+  ~ReadPageGuard();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  /** @return the page itself, for page types that derive from Page; TablePage's read accessors are not const */
+  auto GetPage() const -> Page * { return guard_.GetPage(); }
+
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+ private:
+  friend class OptimisticPageGuard;
+
+  BasicPageGuard guard_;
+};
+
+/**
+ * WritePageGuard owns one pin and the write latch on a page, and releases both when it goes out of scope. The page is
+ * unpinned dirty if it was written through GetDataMut() / AsMut() or SetDirty() was called. Get one from
+ * BufferPoolManager::FetchPageWrite() or NewPageWrite().
+ */
+class WritePageGuard {
+ public:
+  WritePageGuard() = default;
+
+  /** @brief Guard a page that is already pinned and write latched. */
+  WritePageGuard(BufferPoolManager *bpm, Page *page) : guard_(bpm, page) {}
+
+  WritePageGuard(const WritePageGuard &) = delete;
+  auto operator=(const WritePageGuard &) -> WritePageGuard & = delete;
+
+  WritePageGuard(WritePageGuard &&that) noexcept = default;
+
+  /** @brief Release the page this guard holds, if any, then take over the page of that guard. */
+  auto operator=(WritePageGuard &&that) noexcept -> WritePageGuard &;
+
+  /** @brief Unlatch and unpin the page now and leave the guard empty. Does nothing on an empty guard. */
+  void Drop();
+
+  /** @brief Unlatch the page now and hand the unpin to a batch. */
+  void Drop(UnpinBatch *batch);
+
+  ~WritePageGuard();
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  /** @return the page itself, for page types that derive from Page such as TablePage */
+  auto GetPage() const -> Page * { return guard_.GetPage(); }
+
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+  auto GetDataMut() -> char * { return guard_.GetDataMut(); }
+
+  template <class T>
+  auto AsMut() -> T * {
+    return guard_.AsMut<T>();
+  }
+
+  void SetDirty() { guard_.SetDirty(); }
+
+ private:
+  BasicPageGuard guard_;
+};
+
+/**
+ * OptimisticPageGuard owns one pin on a page and the page version it saw when the guard was made, instead of a latch.
+ * Readers take no latch and write no shared cache line, which is what makes it cheap on hot pages such as the upper
+ * levels of a B+ tree; in exchange, anything read through the guard may be torn by a concurrent writer and is only
+ * good once Validate() returned true after the read. On failure the caller restarts. Get one from
+ * BufferPoolManager::FetchPageOptimistic().
+ *
+ * Only writers that take the page write latch (WritePageGuard, Page::WLatch) invalidate an optimistic read.
+ */
+class OptimisticPageGuard {
+ public:
+  OptimisticPageGuard() = default;
+
+  /** @brief Guard a pinned page, remembering its current version. */
+  OptimisticPageGuard(BufferPoolManager *bpm, Page *page)
+      : guard_(bpm, page), version_(page == nullptr ? 0 : page->OptimisticLatch()) {}
+
+  OptimisticPageGuard(const OptimisticPageGuard &) = delete;
+  auto operator=(const OptimisticPageGuard &) -> OptimisticPageGuard & = delete;
+
+  OptimisticPageGuard(OptimisticPageGuard &&that) noexcept = default;
+  auto operator=(OptimisticPageGuard &&that) noexcept -> OptimisticPageGuard & = default;
+
+  /** @brief Unpin the page now and leave the guard empty. Does nothing on an empty guard. */
+  void Drop() { guard_.Drop(); }
+
+  /** @brief Leave the guard empty and hand the unpin to a batch. */
+  void Drop(UnpinBatch *batch) { guard_.Drop(batch); }
+
+  auto IsValid() const -> bool { return guard_.IsValid(); }
+
+  auto PageId() const -> page_id_t { return guard_.PageId(); }
+
+  /** @return true if no writer latched the page since the guard was made, i.e. everything read so far is consistent */
+  auto Validate() const -> bool { return guard_.page_->ValidateOptimistic(version_); }
+
+  auto GetData() const -> const char * { return guard_.GetData(); }
+
+  template <class T>
+  auto As() const -> const T * {
+    return guard_.As<T>();
+  }
+
+  /**
+   * @brief Read latch the page and check that it did not change since the guard was made. On success the pin moves to
+   * the returned guard and this guard becomes empty; otherwise the returned guard is empty and this one is unchanged.
+   */
+  auto UpgradeRead() -> ReadPageGuard;
+
+ private:
+  BasicPageGuard guard_;
+  uint64_t version_{0};
+};
+
+/**
+ * UnpinBatch collects the unpins of pages a thread is done with and hands them to the buffer pool together, which
+ * takes the pool latch once per batch instead of once per page. It is meant for code that walks over many pages, such
+ * as a table heap or B+ tree traversal: each page is unlatched as soon as the walk moves on, but stays pinned until
+ * the batch is released. The batch releases itself when it holds `capacity` pages and when it is destroyed.
+ *
+ * An UnpinBatch belongs to one thread and one buffer pool.
+ */
+class UnpinBatch {
+ public:
+  explicit UnpinBatch(BufferPoolManager *bpm, size_t capacity = UNPIN_BATCH_SIZE);
+
+  UnpinBatch(const UnpinBatch &) = delete;
+  auto operator=(const UnpinBatch &) -> UnpinBatch & = delete;
+
+  ~UnpinBatch();
+
+  /** @brief Queue the unpin of a page, releasing the batch if it is full. */
+  void Add(page_id_t page_id, bool is_dirty);
+
+  /** @brief Unpin every queued page now. */
+  void Release();
+
+  auto Size() const -> size_t { return pages_.size(); }
+
+  auto GetBufferPoolManager() const -> BufferPoolManager * { return bpm_; }
+
+ private:
+  BufferPoolManager *bpm_;
+  size_t capacity_;
+  std::vector<std::pair<page_id_t, bool>> pages_;
+};
+
+}  // namespace bustub
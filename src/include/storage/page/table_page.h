@@ -84,6 +84,15 @@ class TablePage : public Page {
   auto InsertTuple(const Tuple &tuple, RID *rid, Transaction *txn, LockManager *lock_manager, LogManager *log_manager)
       -> bool;
 
+  /**
+   * Insert a tuple into the given slot, which must be empty. Used by recovery, which has to put a tuple back under the
+   * RID the log recorded for it. Not logged.
+   * @param tuple tuple to insert
+   * @param rid rid of the tuple, on this page
+   * @return true if the slot is empty and there is enough space
+   */
+  auto InsertTupleAt(const Tuple &tuple, const RID &rid) -> bool;
+
   /**
    * Mark a tuple as deleted. This does not actually delete the tuple.
    * @param rid rid of the tuple to mark as deleted
@@ -12,7 +12,10 @@
 
 #pragma once
 
+#include <vector>
+
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/extent_allocator.h"
 #include "recovery/log_manager.h"
 #include "storage/page/table_page.h"
 #include "storage/table/table_iterator.h"
@@ -99,8 +102,22 @@ class TableHeap {
    */
   auto GetTuple(const RID &rid, Tuple *tuple, Transaction *txn, bool acquire_read_lock = true) -> bool;
 
-  /** @return the begin iterator of this table */
-  auto Begin(Transaction *txn) -> TableIterator;
+  /**
+   * Read several tuples. Their pages are pinned with one BufferPoolManager::FetchPages() call and unpinned in one
+   * batch, and each page is read latched once for all of its tuples.
+   * @param rids rids of the tuples to read, in any order
+   * @param[out] tuples tuples[i] is the tuple of rids[i]
+   * @param txn transaction performing the read
+   * @return found[i] is true if rids[i] was read; all false, and the transaction is aborted, if a page could not be
+   * fetched
+   */
+  auto GetTuples(const std::vector<RID> &rids, std::vector<Tuple> *tuples, Transaction *txn) -> std::vector<bool>;
+
+  /**
+   * @param strategy read the pages of the scan through this ring instead of the main replacer, may be nullptr
+   * @return the begin iterator of this table
+   */
+  auto Begin(Transaction *txn, BufferAccessStrategy *strategy = nullptr) -> TableIterator;
 
   /** @return the end iterator of this table */
   auto End() -> TableIterator;
@@ -108,11 +125,17 @@ class TableHeap {
   /** @return the id of the first page of this table */
   inline auto GetFirstPageId() const -> page_id_t { return first_page_id_; }
 
+  /** Count the page accesses of this table under a buffer pool tag, see BufferPoolManager::RegisterTag(). */
+  void SetBufferPoolTag(BufferPoolTag tag) { tag_ = tag; }
+
  private:
   BufferPoolManager *buffer_pool_manager_;
   LockManager *lock_manager_;
   LogManager *log_manager_;
   page_id_t first_page_id_{};
+  BufferPoolTag tag_;
+  /** Creates the pages of this table in extents, so that they are adjacent on disk. */
+  ExtentAllocator extent_allocator_;
 };
 
 }  // namespace bustub
@@ -0,0 +1,38 @@
+#include <algorithm>
+
+#include "buffer/buffer_pool_manager.h"
+#include "execution/plans/seq_scan_plan.h"
+#include "optimizer/optimizer.h"
+
+namespace bustub {
+
+auto Optimizer::OptimizeSeqScanRingBuffer(const AbstractPlanNodeRef &plan) -> AbstractPlanNodeRef {
+  std::vector<AbstractPlanNodeRef> children;
+  for (const auto &child : plan->GetChildren()) {
+    children.emplace_back(OptimizeSeqScanRingBuffer(child));
+  }
+  auto optimized_plan = plan->CloneWithChildren(std::move(children));
+
+  auto *bpm = catalog_.GetBufferPoolManager();
+  if (optimized_plan->GetType() != PlanType::SeqScan || bpm == nullptr) {
+    return optimized_plan;
+  }
+  const auto &seq_scan_plan = dynamic_cast<const SeqScanPlanNode &>(*optimized_plan);
+  const auto cardinality = EstimatedCardinality(seq_scan_plan.table_name_);
+  const auto *table_info = catalog_.GetTable(seq_scan_plan.table_name_);
+  if (!cardinality.has_value() || table_info == nullptr) {
+    return optimized_plan;
+  }
+  // 估算表的页数：每个tuple除了数据本身，在TablePage里还占一个slot（offset + size）
+  const size_t tuple_size = table_info->schema_.GetLength() + 2 * sizeof(uint32_t);
+  const size_t tuples_per_page = std::max<size_t>(1, BUSTUB_PAGE_SIZE / tuple_size);
+  const size_t estimated_pages = (*cardinality + tuples_per_page - 1) / tuples_per_page;
+  if (estimated_pages <= bpm->GetPoolSize() / SCAN_RING_POOL_DIVISOR) {
+    return optimized_plan;
+  }
+  auto ring_plan = std::make_shared<SeqScanPlanNode>(seq_scan_plan);
+  ring_plan->use_ring_buffer_ = true;
+  return ring_plan;
+}
+
+}  // namespace bustub
@@ -12,7 +12,48 @@
 
 #include "recovery/log_manager.h"
 
+#include <cstring>
+#include <iterator>
+
+#include "common/macros.h"
+
 namespace bustub {
+
+void LogManager::RestoreLSN() {
+  // LSN随日志的偏移量递增，从最后一个检查点（没有就从头）往后只看记录头，最后一条完整记录的LSN就是最大的
+  int64_t offset = std::max<int64_t>(disk_manager_->ReadMasterRecord(), 0);
+  if (offset >= log_offset_) {
+    offset = 0;
+  }
+  lsn_t last_lsn = INVALID_LSN;
+  while (offset < log_offset_ && disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset)) {
+    int pos = 0;
+    while (pos + LogRecord::HEADER_SIZE <= LOG_BUFFER_SIZE) {
+      int32_t size;
+      memcpy(&size, log_buffer_ + pos, sizeof(int32_t));
+      // 读到了文件末尾，或者这条记录跨过了这次读的末尾；没写完的最后一条不算
+      if (size < LogRecord::HEADER_SIZE || size > LOG_BUFFER_SIZE - pos || offset + pos + size > log_offset_) {
+        break;
+      }
+      memcpy(&last_lsn, log_buffer_ + pos + sizeof(int32_t), sizeof(lsn_t));
+      pos += size;
+    }
+    if (pos == 0) {
+      break;
+    }
+    offset += pos;
+  }
+  // 日志文件是追加写的，崩溃时写了一半的最后一条要截掉，否则新的记录会接在它后面，恢复扫到它就停了，看不到新记录
+  if (offset < log_offset_) {
+    BUSTUB_ENSURE(disk_manager_->TruncateLog(offset), "failed to truncate the torn end of the log");
+    log_offset_ = offset;
+  }
+  if (last_lsn != INVALID_LSN) {
+    reserve_state_ = static_cast<uint64_t>(last_lsn + 1) << LSN_SHIFT;
+    persistent_lsn_ = last_lsn;
+  }
+}
+
 /*
  * set enable_logging = true
  * Start a separate thread to execute flush to disk operation periodically
@@ -22,33 +63,275 @@ namespace bustub {
  *
  * This thread runs forever until system shutdown/StopFlushThread
  */
-void LogManager::RunFlushThread() {}
+void LogManager::RunFlushThread() {
+  std::scoped_lock lock(latch_);
+  if (flush_thread_ != nullptr) {
+    return;
+  }
+  enable_logging = true;
+  stop_ = false;
+  flush_thread_ = new std::thread(&LogManager::FlushLoop, this);
+}
 
 /*
  * Stop and join the flush thread, set enable_logging = false
  */
-void LogManager::StopFlushThread() {}
+void LogManager::StopFlushThread() {
+  std::thread *thread;
+  {
+    std::scoped_lock lock(latch_);
+    thread = flush_thread_;
+    if (thread == nullptr) {
+      return;
+    }
+    enable_logging = false;
+    // stop_之后追加的线程不再等刷盘线程，自己写日志
+    stop_ = true;
+  }
+  flush_cv_.notify_one();
+  thread->join();
+  delete thread;
+  std::scoped_lock lock(latch_);
+  flush_thread_ = nullptr;
+}
+
+void LogManager::FlushLoop() {
+  std::unique_lock lock(latch_);
+  while (!stop_) {
+    // 有异步提交在等时最晚在它的截止时间醒来
+    const auto timeout = std::min(async_deadline_, std::chrono::steady_clock::now() + log_timeout);
+    const bool woken = flush_cv_.wait_until(
+        lock, timeout, [&] { return flush_requested_ || stop_ || async_deadline_ < timeout; });
+    if (woken && !flush_requested_ && !stop_) {
+      // 来了一个更早的截止时间，重新算要等多久
+      continue;
+    }
+    flush_requested_ = false;
+    // 写盘期间新来的提交继续往另一个缓冲区里追加，下一轮一次写出去
+    FlushBuffer(&lock);
+    if (persistent_lsn_ >= async_lsn_ || failed_) {
+      async_deadline_ = std::chrono::steady_clock::time_point::max();
+    }
+  }
+  // 退出前把剩下的日志写完
+  while (FlushBuffer(&lock)) {
+  }
+}
+
+auto LogManager::FlushBuffer(std::unique_lock<std::mutex> *lock) -> bool {
+  // 另一个缓冲区还在写的时候不能切换过去
+  cv_.wait(*lock, [&] { return !flushing_; });
+  if (failed_) {
+    return false;
+  }
+  // 把追加切换到另一个缓冲区，同时拿到旧缓冲区里分配出去的字节数和最后一个LSN
+  uint64_t state = reserve_state_;
+  do {
+    if ((state & OFFSET_MASK) == 0) {
+      return false;
+    }
+  } while (!reserve_state_.compare_exchange_weak(state, (state & ~OFFSET_MASK) ^ BUFFER_BIT));
+  const size_t index = BufferIndex(state);
+  const auto size = static_cast<size_t>(state & OFFSET_MASK);
+  const auto last_lsn = static_cast<lsn_t>(state >> LSN_SHIFT) - 1;
+  flushing_ = true;
+  // 等着空间的追加者可以往新缓冲区里写了
+  cv_.notify_all();
+  lock->unlock();
+  // 分配到位置的追加者可能还在序列化，等完成水位追上分配出去的字节数
+  while (completed_[index].load(std::memory_order_acquire) < size) {
+    std::this_thread::yield();
+  }
+  completed_[index].store(0, std::memory_order_relaxed);
+  const bool written = disk_manager_->WriteLog(Buffer(state), static_cast<int>(size));
+  lock->lock();
+  flushing_ = false;
+  if (!written) {
+    // 这一批没有落盘，persistent_lsn_不能前进；之后的缓冲区也不再写，否则日志中间缺一段。等着的提交都会失败
+    failed_ = true;
+    cv_.notify_all();
+    return false;
+  }
+  // 缓冲区按顺序写盘，这个缓冲区的第一个LSN紧跟在上一次写盘的最后一个LSN后面
+  buffer_offsets_.emplace(persistent_lsn_ + 1, log_offset_);
+  if (buffer_offsets_.size() > MAX_BUFFER_OFFSETS) {
+    // 很久没有检查点时表会一直变长。隔一个删一个：查到的是更早一个缓冲区的位置，重做多读一段日志，但不会漏；
+    // 最新的一项留着，检查点要找它自己的缓冲区
+    auto it = std::next(buffer_offsets_.begin());
+    while (it != buffer_offsets_.end() && std::next(it) != buffer_offsets_.end()) {
+      it = std::next(buffer_offsets_.erase(it));
+    }
+  }
+  log_offset_ += static_cast<int64_t>(size);
+  persistent_lsn_ = last_lsn;
+  cv_.notify_all();
+  return true;
+}
+
+void LogManager::Flush(lsn_t lsn) {
+  std::unique_lock lock(latch_);
+  // 页上的LSN不一定是日志分配的（例如不记日志的页），按已分配的最大LSN算
+  lsn = std::min(lsn, GetNextLSN() - 1);
+  while (persistent_lsn_ < lsn) {
+    BUSTUB_ENSURE(!failed_, "failed to write the log");
+    if (flush_thread_ == nullptr || stop_) {
+      FlushBuffer(&lock);
+      continue;
+    }
+    // 在写盘期间到达的等待者都由下一次写盘覆盖
+    flush_requested_ = true;
+    flush_cv_.notify_one();
+    cv_.wait(lock);
+  }
+}
+
+void LogManager::FlushAsync(lsn_t lsn) {
+  std::unique_lock lock(latch_);
+  if (persistent_lsn_ >= lsn) {
+    return;
+  }
+  if (flush_thread_ == nullptr || stop_) {
+    lock.unlock();
+    Flush(lsn);
+    return;
+  }
+  async_lsn_ = std::max(async_lsn_, lsn);
+  // 只记最早的截止时间，之后的异步提交搭同一次刷盘
+  if (async_deadline_ == std::chrono::steady_clock::time_point::max()) {
+    async_deadline_ = std::chrono::steady_clock::now() + async_commit_max_lag;
+    flush_cv_.notify_one();
+  }
+}
 
 /*
  * append a log record into log buffer
  * you MUST set the log record's lsn within this method
  * @return: lsn that is assigned to this log record
- *
- *
- * example below
- * // First, serialize the must have fields(20 bytes in total)
- * log_record.lsn_ = next_lsn_++;
- * memcpy(log_buffer_ + offset_, &log_record, 20);
- * int pos = offset_ + 20;
- *
- * if (log_record.log_record_type_ == LogRecordType::INSERT) {
- *    memcpy(log_buffer_ + pos, &log_record.insert_rid_, sizeof(RID));
- *    pos += sizeof(RID);
- *    // we have provided serialize function for tuple class
- *    log_record.insert_tuple_.SerializeTo(log_buffer_ + pos);
- *  }
- *
  */
-auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t { return INVALID_LSN; }
+auto LogManager::AppendLogRecord(LogRecord *log_record) -> lsn_t {
+  const auto size = static_cast<size_t>(log_record->size_);
+  BUSTUB_ASSERT(size <= LOG_BUFFER_SIZE, "A log record must fit in the log buffer.");
+  // 一次CAS同时分配LSN和缓冲区里的位置，不持锁，LSN的顺序和在日志里的顺序一致
+  uint64_t state = reserve_state_;
+  while (true) {
+    if ((state & OFFSET_MASK) + size > LOG_BUFFER_SIZE) {
+      WaitForRoom(size);
+      state = reserve_state_;
+      continue;
+    }
+    if (reserve_state_.compare_exchange_weak(state, state + (1ULL << LSN_SHIFT) + size)) {
+      break;
+    }
+  }
+  log_record->lsn_ = static_cast<lsn_t>(state >> LSN_SHIFT);
+  SerializeLogRecord(*log_record, Buffer(state) + (state & OFFSET_MASK));
+  // 序列化完了才计入完成水位，刷盘线程不会写出半条记录
+  completed_[BufferIndex(state)].fetch_add(size, std::memory_order_release);
+  return log_record->lsn_;
+}
+
+auto LogManager::WriteCheckpoint(LogRecord *log_record, lsn_t redo_lsn) -> lsn_t {
+  BUSTUB_ENSURE(static_cast<size_t>(log_record->GetSize()) <= LOG_BUFFER_SIZE, "checkpoint record too large");
+  // 先把检查点之前的日志都写盘，检查点记录就是下一个缓冲区的第一条记录
+  Flush(GetNextLSN() - 1);
+  {
+    std::scoped_lock lock(latch_);
+    log_record->redo_offset_ = GetLogOffset(redo_lsn);
+  }
+  lsn_t lsn = AppendLogRecord(log_record);
+  Flush(lsn);
+  int64_t checkpoint_offset;
+  {
+    std::scoped_lock lock(latch_);
+    auto it = buffer_offsets_.find(lsn);
+    BUSTUB_ENSURE(it != buffer_offsets_.end(), "a record was appended between the flush and the checkpoint");
+    checkpoint_offset = it->second;
+  }
+  // 检查点记录落盘之后才能让主记录指向它
+  disk_manager_->WriteMasterRecord(checkpoint_offset);
+  return lsn;
+}
+
+auto LogManager::GetLogOffset(lsn_t lsn) -> int64_t {
+  if (lsn > persistent_lsn_) {
+    return log_offset_;
+  }
+  auto it = buffer_offsets_.upper_bound(lsn);
+  if (it == buffer_offsets_.begin()) {
+    return 0;
+  }
+  --it;
+  buffer_offsets_.erase(buffer_offsets_.begin(), it);
+  return it->second;
+}
+
+void LogManager::WaitForRoom(size_t size) {
+  std::unique_lock lock(latch_);
+  // 切换缓冲区在持锁时进行，这里持锁检查不会错过唤醒
+  while ((reserve_state_ & OFFSET_MASK) + size > LOG_BUFFER_SIZE) {
+    BUSTUB_ENSURE(!failed_, "failed to write the log");
+    if (flush_thread_ == nullptr || stop_) {
+      FlushBuffer(&lock);
+      continue;
+    }
+    flush_requested_ = true;
+    flush_cv_.notify_one();
+    cv_.wait(lock);
+  }
+}
+
+void LogManager::SerializeLogRecord(const LogRecord &log_record, char *dst) {
+  // HEADER: | size | LSN | transID | prevLSN | LogType |
+  memcpy(dst, &log_record.size_, sizeof(int32_t));
+  memcpy(dst + 4, &log_record.lsn_, sizeof(lsn_t));
+  memcpy(dst + 8, &log_record.txn_id_, sizeof(txn_id_t));
+  memcpy(dst + 12, &log_record.prev_lsn_, sizeof(lsn_t));
+  memcpy(dst + 16, &log_record.log_record_type_, sizeof(LogRecordType));
+  char *pos = dst + LogRecord::HEADER_SIZE;
+
+  switch (log_record.log_record_type_) {
+    case LogRecordType::INSERT:
+      memcpy(pos, &log_record.insert_rid_, sizeof(RID));
+      log_record.insert_tuple_.SerializeTo(pos + sizeof(RID));
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      memcpy(pos, &log_record.delete_rid_, sizeof(RID));
+      log_record.delete_tuple_.SerializeTo(pos + sizeof(RID));
+      break;
+    case LogRecordType::UPDATE:
+      memcpy(pos, &log_record.update_rid_, sizeof(RID));
+      pos += sizeof(RID);
+      log_record.old_tuple_.SerializeTo(pos);
+      pos += sizeof(int32_t) + log_record.old_tuple_.GetLength();
+      log_record.new_tuple_.SerializeTo(pos);
+      break;
+    case LogRecordType::NEWPAGE:
+      memcpy(pos, &log_record.prev_page_id_, sizeof(page_id_t));
+      memcpy(pos + sizeof(page_id_t), &log_record.page_id_, sizeof(page_id_t));
+      break;
+    case LogRecordType::CHECKPOINT: {
+      memcpy(pos, &log_record.redo_offset_, sizeof(int64_t));
+      pos += sizeof(int64_t);
+      auto serialize_table = [&pos](const auto &table) {
+        auto count = static_cast<int32_t>(table.size());
+        memcpy(pos, &count, sizeof(int32_t));
+        pos += sizeof(int32_t);
+        for (const auto &[id, lsn] : table) {
+          memcpy(pos, &id, sizeof(int32_t));
+          memcpy(pos + sizeof(int32_t), &lsn, sizeof(lsn_t));
+          pos += sizeof(int32_t) + sizeof(lsn_t);
+        }
+      };
+      serialize_table(log_record.active_txns_);
+      serialize_table(log_record.dirty_pages_);
+      break;
+    }
+    default:
+      // BEGIN / COMMIT / ABORT只有HEADER
+      break;
+  }
+}
 
 }  // namespace bustub
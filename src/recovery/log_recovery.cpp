@@ -12,6 +12,10 @@
 
 #include "recovery/log_recovery.h"
 
+#include <cstring>
+#include <queue>
+#include <thread>  // NOLINT
+
 #include "storage/page/table_page.h"
 
 namespace bustub {
@@ -20,21 +24,464 @@ namespace bustub {
  * @return: true means deserialize succeed, otherwise can't deserialize cause
  * incomplete log record
  */
-auto LogRecovery::DeserializeLogRecord(const char *data, LogRecord *log_record) -> bool { return false; }
+auto LogRecovery::DeserializeLogRecord(const char *data, int size, LogRecord *log_record) -> bool {
+  if (size < LogRecord::HEADER_SIZE) {
+    return false;
+  }
+  int32_t record_size;
+  memcpy(&record_size, data, sizeof(int32_t));
+  // 读到文件末尾补的0，或者这条记录的后半截还没读进来
+  if (record_size < LogRecord::HEADER_SIZE || record_size > size) {
+    return false;
+  }
+  log_record->size_ = record_size;
+  memcpy(&log_record->lsn_, data + 4, sizeof(lsn_t));
+  memcpy(&log_record->txn_id_, data + 8, sizeof(txn_id_t));
+  memcpy(&log_record->prev_lsn_, data + 12, sizeof(lsn_t));
+  memcpy(&log_record->log_record_type_, data + 16, sizeof(LogRecordType));
+
+  const char *pos = data + LogRecord::HEADER_SIZE;
+  const char *end = data + record_size;
+  auto read_rid = [&](RID *rid) {
+    if (end - pos < static_cast<int>(sizeof(RID))) {
+      return false;
+    }
+    memcpy(rid, pos, sizeof(RID));
+    pos += sizeof(RID);
+    return true;
+  };
+  // 元组长度来自日志本身，先确认没有越过这条记录的末尾再读
+  auto read_tuple = [&](Tuple *tuple) {
+    int32_t tuple_size;
+    if (end - pos < static_cast<int>(sizeof(int32_t))) {
+      return false;
+    }
+    memcpy(&tuple_size, pos, sizeof(int32_t));
+    if (tuple_size < 0 || tuple_size > end - pos - static_cast<int>(sizeof(int32_t))) {
+      return false;
+    }
+    tuple->DeserializeFrom(pos);
+    pos += sizeof(int32_t) + tuple_size;
+    return true;
+  };
+
+  bool valid;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      valid = read_rid(&log_record->insert_rid_) && read_tuple(&log_record->insert_tuple_);
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      valid = read_rid(&log_record->delete_rid_) && read_tuple(&log_record->delete_tuple_);
+      break;
+    case LogRecordType::UPDATE:
+      valid = read_rid(&log_record->update_rid_) && read_tuple(&log_record->old_tuple_) &&
+              read_tuple(&log_record->new_tuple_);
+      break;
+    case LogRecordType::NEWPAGE:
+      valid = end - pos >= static_cast<int>(2 * sizeof(page_id_t));
+      if (valid) {
+        memcpy(&log_record->prev_page_id_, pos, sizeof(page_id_t));
+        memcpy(&log_record->page_id_, pos + sizeof(page_id_t), sizeof(page_id_t));
+        pos += 2 * sizeof(page_id_t);
+      }
+      break;
+    case LogRecordType::CHECKPOINT: {
+      // 两张表的条目数同样来自日志，读之前确认放得下
+      auto read_table = [&](auto *table) {
+        int32_t count;
+        if (end - pos < static_cast<int>(sizeof(int32_t))) {
+          return false;
+        }
+        memcpy(&count, pos, sizeof(int32_t));
+        pos += sizeof(int32_t);
+        constexpr int entry_size = sizeof(int32_t) + sizeof(lsn_t);
+        if (count < 0 || count > (end - pos) / entry_size) {
+          return false;
+        }
+        table->resize(count);
+        for (auto &[id, lsn] : *table) {
+          memcpy(&id, pos, sizeof(int32_t));
+          memcpy(&lsn, pos + sizeof(int32_t), sizeof(lsn_t));
+          pos += entry_size;
+        }
+        return true;
+      };
+      valid = end - pos >= static_cast<int>(sizeof(int64_t));
+      if (valid) {
+        memcpy(&log_record->redo_offset_, pos, sizeof(int64_t));
+        pos += sizeof(int64_t);
+        valid = read_table(&log_record->active_txns_) && read_table(&log_record->dirty_pages_);
+      }
+      break;
+    }
+    case LogRecordType::BEGIN:
+    case LogRecordType::COMMIT:
+    case LogRecordType::ABORT:
+      valid = true;
+      break;
+    default:
+      valid = false;
+      break;
+  }
+  return valid && pos == end;
+}
+
+void LogRecovery::ScanLog(int64_t offset, const std::function<void(LogRecord *, int64_t)> &visit) {
+  offset_ = offset;
+  LogRecord log_record;
+  while (disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, offset_)) {
+    int pos = 0;
+    while (DeserializeLogRecord(log_buffer_ + pos, LOG_BUFFER_SIZE - pos, &log_record)) {
+      visit(&log_record, offset_ + pos);
+      pos += log_record.size_;
+    }
+    // 日志读完了（读到的是补的0），或者剩下的是一条没写完的记录
+    if (pos == 0) {
+      break;
+    }
+    offset_ += pos;
+  }
+}
+
+/*
+ * analysis phase: rebuild the active transaction table and the dirty page table as of the end of the log, starting
+ * from the last checkpoint
+ */
+void LogRecovery::Analyze() {
+  active_txn_.clear();
+  dirty_pages_.clear();
+  lsn_mapping_.clear();
+  redo_offset_ = 0;
+
+  // 主记录指向的必须是一条完整的检查点记录，否则当作没有检查点，从头分析
+  int64_t start = 0;
+  const int64_t checkpoint_offset = disk_manager_->ReadMasterRecord();
+  LogRecord checkpoint;
+  if (checkpoint_offset >= 0 && disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, checkpoint_offset) &&
+      DeserializeLogRecord(log_buffer_, LOG_BUFFER_SIZE, &checkpoint) &&
+      checkpoint.log_record_type_ == LogRecordType::CHECKPOINT) {
+    active_txn_.insert(checkpoint.active_txns_.begin(), checkpoint.active_txns_.end());
+    dirty_pages_.insert(checkpoint.dirty_pages_.begin(), checkpoint.dirty_pages_.end());
+    redo_offset_ = checkpoint.redo_offset_;
+    start = checkpoint_offset;
+  }
+
+  ScanLog(start, [&](LogRecord *log_record, int64_t offset) {
+    lsn_mapping_[log_record->lsn_] = offset;
+    switch (log_record->log_record_type_) {
+      case LogRecordType::CHECKPOINT:
+        return;
+      case LogRecordType::COMMIT:
+      case LogRecordType::ABORT:
+        active_txn_.erase(log_record->txn_id_);
+        return;
+      case LogRecordType::INSERT:
+        dirty_pages_.emplace(log_record->insert_rid_.GetPageId(), log_record->lsn_);
+        break;
+      case LogRecordType::MARKDELETE:
+      case LogRecordType::APPLYDELETE:
+      case LogRecordType::ROLLBACKDELETE:
+        dirty_pages_.emplace(log_record->delete_rid_.GetPageId(), log_record->lsn_);
+        break;
+      case LogRecordType::UPDATE:
+        dirty_pages_.emplace(log_record->update_rid_.GetPageId(), log_record->lsn_);
+        break;
+      case LogRecordType::NEWPAGE:
+        // 已经在表里的页保留更早的recLSN
+        dirty_pages_.emplace(log_record->page_id_, log_record->lsn_);
+        if (log_record->prev_page_id_ != INVALID_PAGE_ID) {
+          dirty_pages_.emplace(log_record->prev_page_id_, log_record->lsn_);
+        }
+        break;
+      default:
+        break;
+    }
+    active_txn_[log_record->txn_id_] = log_record->lsn_;
+  });
+}
+
+auto LogRecovery::NeedsRedo(page_id_t page_id, lsn_t lsn) -> bool {
+  auto it = dirty_pages_.find(page_id);
+  return it != dirty_pages_.end() && lsn >= it->second;
+}
 
 /*
  *redo phase on TABLE PAGE level(table/table_page.h)
- *read log file from the beginning to end (you must prefetch log records into
- *log buffer to reduce unnecessary I/O operations), remember to compare page's
- *LSN with log_record's sequence number, and also build active_txn_ table &
- *lsn_mapping_ table
+ *read log file from the redo start to end, skip the records of pages the dirty page table shows to be on disk, and
+ *compare the page's LSN with log_record's sequence number for the others
  */
-void LogRecovery::Redo() {}
+void LogRecovery::Redo() {
+  Analyze();
+
+  std::vector<RedoQueue> queues(redo_workers_);
+  std::vector<std::vector<RedoTask>> pending(redo_workers_);
+  std::vector<std::thread> workers;
+  workers.reserve(redo_workers_);
+  for (auto &queue : queues) {
+    workers.emplace_back(&LogRecovery::RunRedoWorker, this, &queue);
+  }
+
+  // 本线程只负责读日志，改页的记录按页号分给各个worker；脏页表说明已经在盘上的改动连页都不用读
+  auto dispatch = [&](page_id_t page_id, const LogRecord &log_record) {
+    if (NeedsRedo(page_id, log_record.lsn_)) {
+      Dispatch(page_id, log_record, &pending, &queues);
+    }
+  };
+  ScanLog(redo_offset_, [&](LogRecord *log_record, int64_t offset) {
+    lsn_mapping_[log_record->lsn_] = offset;
+    switch (log_record->log_record_type_) {
+      case LogRecordType::INSERT:
+        dispatch(log_record->insert_rid_.GetPageId(), *log_record);
+        break;
+      case LogRecordType::MARKDELETE:
+      case LogRecordType::APPLYDELETE:
+      case LogRecordType::ROLLBACKDELETE:
+        dispatch(log_record->delete_rid_.GetPageId(), *log_record);
+        break;
+      case LogRecordType::UPDATE:
+        dispatch(log_record->update_rid_.GetPageId(), *log_record);
+        break;
+      case LogRecordType::NEWPAGE:
+        // 新页由它自己的worker初始化，上一页指向它的next指针由上一页的worker补上
+        dispatch(log_record->page_id_, *log_record);
+        if (log_record->prev_page_id_ != INVALID_PAGE_ID) {
+          dispatch(log_record->prev_page_id_, *log_record);
+        }
+        break;
+      default:
+        break;
+    }
+  });
+
+  for (size_t i = 0; i < redo_workers_; i++) {
+    if (!pending[i].empty()) {
+      Submit(&pending[i], &queues[i]);
+    }
+    {
+      std::scoped_lock lock(queues[i].latch_);
+      queues[i].done_ = true;
+    }
+    queues[i].cv_.notify_all();
+  }
+  for (auto &worker : workers) {
+    worker.join();
+  }
+}
+
+void LogRecovery::Dispatch(page_id_t page_id, const LogRecord &log_record,
+                           std::vector<std::vector<RedoTask>> *pending, std::vector<RedoQueue> *queues) {
+  const size_t worker = static_cast<size_t>(page_id) % redo_workers_;
+  auto &batch = (*pending)[worker];
+  batch.push_back(RedoTask{page_id, log_record});
+  if (batch.size() >= REDO_BATCH_SIZE) {
+    Submit(&batch, &(*queues)[worker]);
+  }
+}
+
+void LogRecovery::Submit(std::vector<RedoTask> *batch, RedoQueue *queue) {
+  {
+    std::unique_lock lock(queue->latch_);
+    queue->cv_.wait(lock, [&] { return queue->batches_.size() < REDO_QUEUE_DEPTH; });
+    queue->batches_.push_back(std::move(*batch));
+  }
+  queue->cv_.notify_all();
+  batch->clear();
+  batch->reserve(REDO_BATCH_SIZE);
+}
+
+void LogRecovery::RunRedoWorker(RedoQueue *queue) {
+  while (true) {
+    std::vector<RedoTask> batch;
+    {
+      std::unique_lock lock(queue->latch_);
+      queue->cv_.wait(lock, [&] { return !queue->batches_.empty() || queue->done_; });
+      if (queue->batches_.empty()) {
+        return;
+      }
+      batch = std::move(queue->batches_.front());
+      queue->batches_.pop_front();
+    }
+    // 读线程可能在等队列空出位置
+    queue->cv_.notify_all();
+    for (auto &task : batch) {
+      RedoRecord(task.page_id_, &task.log_record_);
+    }
+  }
+}
+
+void LogRecovery::RedoRecord(page_id_t page_id, LogRecord *log_record) {
+  auto guard = buffer_pool_manager_->FetchPageWrite(page_id);
+  BUSTUB_ENSURE(guard.IsValid(), "BPM full");
+  auto *page = static_cast<TablePage *>(guard.GetPage());
+  const lsn_t lsn = log_record->lsn_;
+
+  if (log_record->log_record_type_ == LogRecordType::NEWPAGE) {
+    if (page_id != log_record->page_id_) {
+      // 建新页时上一页的LSN没有变，只能看next指针是不是已经设置过
+      if (page->GetNextPageId() == INVALID_PAGE_ID) {
+        page->SetNextPageId(log_record->page_id_);
+        guard.SetDirty();
+      }
+      return;
+    }
+    // 新页可能从来没有写回过磁盘，读出来全是0，页号对不上
+    if (page->GetTablePageId() != page_id || page->GetLSN() < lsn) {
+      page->Init(page_id, BUSTUB_PAGE_SIZE, log_record->prev_page_id_, nullptr, nullptr);
+      page->SetLSN(lsn);
+      guard.SetDirty();
+    }
+    return;
+  }
+
+  // 页上的LSN不比这条记录旧，说明改动已经随着页写回了磁盘
+  if (page->GetLSN() >= lsn) {
+    return;
+  }
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      // Undo把ApplyDelete删掉的元组放回原来的槽位时也记成INSERT，那个槽位不一定是第一个空槽
+      BUSTUB_ENSURE(page->InsertTupleAt(log_record->insert_tuple_, log_record->insert_rid_),
+                    "Redo must place the tuple in its original slot.");
+      break;
+    case LogRecordType::MARKDELETE:
+      page->MarkDelete(log_record->delete_rid_, nullptr, nullptr, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE:
+      page->ApplyDelete(log_record->delete_rid_, nullptr, nullptr);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->RollbackDelete(log_record->delete_rid_, nullptr, nullptr);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple old_tuple;
+      page->UpdateTuple(log_record->new_tuple_, &old_tuple, log_record->update_rid_, nullptr, nullptr, nullptr);
+      break;
+    }
+    default:
+      break;
+  }
+  page->SetLSN(lsn);
+  guard.SetDirty();
+}
 
 /*
  *undo phase on TABLE PAGE level(table/table_page.h)
  *iterate through active txn map and undo each operation
  */
-void LogRecovery::Undo() {}
+void LogRecovery::Undo() {
+  BUSTUB_ENSURE(log_manager_ != nullptr, "Undo logs the rollback and needs a log manager.");
+  // 所有未结束事务的记录按LSN从新到旧回滚，每个事务顺着prevLSN往前找；回滚的每一步接在事务最后一条记录后面
+  std::priority_queue<lsn_t> to_undo;
+  std::unordered_map<txn_id_t, lsn_t> last_lsn = active_txn_;
+  for (const auto &[txn_id, lsn] : active_txn_) {
+    to_undo.push(lsn);
+  }
+  LogRecord log_record;
+  while (!to_undo.empty()) {
+    const lsn_t lsn = to_undo.top();
+    to_undo.pop();
+    auto it = lsn_mapping_.find(lsn);
+    if (it == lsn_mapping_.end()) {
+      // 检查点时还在运行的事务，它较早的记录可能在重做起点之前，把整个日志的位置补上
+      ScanLog(0, [&](LogRecord *record, int64_t offset) { lsn_mapping_.emplace(record->lsn_, offset); });
+      it = lsn_mapping_.find(lsn);
+    }
+    BUSTUB_ASSERT(it != lsn_mapping_.end(), "Undo needs a record that is not in the log.");
+    disk_manager_->ReadLog(log_buffer_, LOG_BUFFER_SIZE, it->second);
+    BUSTUB_ENSURE(DeserializeLogRecord(log_buffer_, LOG_BUFFER_SIZE, &log_record) && log_record.lsn_ == lsn,
+                  "Log record to undo is corrupted.");
+    UndoRecord(&log_record, &last_lsn[log_record.txn_id_]);
+    if (log_record.prev_lsn_ != INVALID_LSN) {
+      to_undo.push(log_record.prev_lsn_);
+    }
+  }
+  // ABORT落盘之后这些事务就结束了，下一次恢复不会再回滚它们
+  lsn_t abort_lsn = INVALID_LSN;
+  for (const auto &[txn_id, lsn] : last_lsn) {
+    LogRecord abort(txn_id, lsn, LogRecordType::ABORT);
+    abort_lsn = log_manager_->AppendLogRecord(&abort);
+  }
+  if (abort_lsn != INVALID_LSN) {
+    log_manager_->Flush(abort_lsn);
+  }
+  active_txn_.clear();
+  dirty_pages_.clear();
+  lsn_mapping_.clear();
+}
+
+void LogRecovery::UndoRecord(LogRecord *log_record, lsn_t *prev_lsn) {
+  RID rid;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      rid = log_record->insert_rid_;
+      break;
+    case LogRecordType::UPDATE:
+      rid = log_record->update_rid_;
+      break;
+    case LogRecordType::MARKDELETE:
+    case LogRecordType::APPLYDELETE:
+    case LogRecordType::ROLLBACKDELETE:
+      rid = log_record->delete_rid_;
+      break;
+    default:
+      // BEGIN / NEWPAGE不需要回滚，新页留着也不影响表的内容
+      return;
+  }
+
+  auto guard = buffer_pool_manager_->FetchPageWrite(rid.GetPageId());
+  BUSTUB_ENSURE(guard.IsValid(), "BPM full");
+  auto *page = static_cast<TablePage *>(guard.GetPage());
+  // 先写日志再改页，和TransactionManager::Abort回滚时记的记录一样；页的LSN说明这一步回滚已经在页上了
+  LogRecord inverse;
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      inverse = LogRecord(log_record->txn_id_, *prev_lsn, LogRecordType::APPLYDELETE, rid, log_record->insert_tuple_);
+      break;
+    case LogRecordType::MARKDELETE:
+      inverse =
+          LogRecord(log_record->txn_id_, *prev_lsn, LogRecordType::ROLLBACKDELETE, rid, log_record->delete_tuple_);
+      break;
+    case LogRecordType::APPLYDELETE:
+      inverse = LogRecord(log_record->txn_id_, *prev_lsn, LogRecordType::INSERT, rid, log_record->delete_tuple_);
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      inverse = LogRecord(log_record->txn_id_, *prev_lsn, LogRecordType::MARKDELETE, rid, log_record->delete_tuple_);
+      break;
+    case LogRecordType::UPDATE:
+      inverse = LogRecord(log_record->txn_id_, *prev_lsn, LogRecordType::UPDATE, rid, log_record->new_tuple_,
+                          log_record->old_tuple_);
+      break;
+    default:
+      break;
+  }
+  *prev_lsn = log_manager_->AppendLogRecord(&inverse);
+
+  switch (log_record->log_record_type_) {
+    case LogRecordType::INSERT:
+      page->ApplyDelete(rid, nullptr, nullptr);
+      break;
+    case LogRecordType::MARKDELETE:
+      page->RollbackDelete(rid, nullptr, nullptr);
+      break;
+    case LogRecordType::APPLYDELETE:
+      // 放回原来的RID，不能随便找个空槽，否则回滚更早的记录时按原来的RID找不到它
+      BUSTUB_ENSURE(page->InsertTupleAt(log_record->delete_tuple_, rid), "Undo must restore the tuple in its slot.");
+      break;
+    case LogRecordType::ROLLBACKDELETE:
+      page->MarkDelete(rid, nullptr, nullptr, nullptr);
+      break;
+    case LogRecordType::UPDATE: {
+      Tuple new_tuple;
+      page->UpdateTuple(log_record->old_tuple_, &new_tuple, rid, nullptr, nullptr, nullptr);
+      break;
+    }
+    default:
+      break;
+  }
+  page->SetLSN(*prev_lsn);
+  guard.SetDirty();
+}
 
 }  // namespace bustub
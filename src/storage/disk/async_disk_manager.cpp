@@ -0,0 +1,343 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// async_disk_manager.cpp
+//
+// Identification: src/storage/disk/async_disk_manager.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/disk/async_disk_manager.h"
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define BUSTUB_HAS_IO_URING
+#endif
+
+#include "common/exception.h"
+#include "common/logger.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+#ifdef BUSTUB_HAS_IO_URING
+/** user_data of the no-op that tells the reaper thread to exit */
+static constexpr uint64_t STOP_USER_DATA = UINT64_MAX;
+#endif
+
+AsyncDiskManager::AsyncDiskManager(const std::string &db_file, size_t queue_depth, Backend backend)
+    : DiskManager(db_file, false), backend_(backend), queue_depth_(queue_depth) {
+  BUSTUB_ASSERT(queue_depth_ > 0, "queue depth must be positive");
+  if (backend_ == Backend::IO_URING && SetUpRing()) {
+    slots_.resize(queue_depth_);
+    for (size_t i = queue_depth_; i > 0; i--) {
+      free_slots_.push_back(static_cast<unsigned>(i - 1));
+    }
+    reaper_ = std::thread([this] { ReapCompletions(); });
+    return;
+  }
+  backend_ = Backend::THREAD_POOL;
+  for (size_t i = 0; i < ASYNC_IO_THREAD_CNT; i++) {
+    workers_.emplace_back([this] { ServeRequests(); });
+  }
+}
+
+AsyncDiskManager::~AsyncDiskManager() { Stop(); }
+
+void AsyncDiskManager::ShutDown() {
+  Stop();
+  DiskManager::ShutDown();
+}
+
+auto AsyncDiskManager::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  std::vector<DiskRequest> requests(1);
+  // 写请求只读data_
+  requests[0] = {true, page_id, const_cast<char *>(page_data), {}};  // NOLINT
+  auto future = requests[0].callback_.get_future();
+  Schedule(std::move(requests));
+  return future.get();
+}
+
+auto AsyncDiskManager::ReadPage(page_id_t page_id, char *page_data) -> bool {
+  std::vector<DiskRequest> requests(1);
+  requests[0] = {false, page_id, page_data, {}};
+  auto future = requests[0].callback_.get_future();
+  Schedule(std::move(requests));
+  return future.get();
+}
+
+void AsyncDiskManager::Schedule(std::vector<DiskRequest> requests) {
+  std::unique_lock lock(latch_);
+  BUSTUB_ASSERT(!stopped_, "disk manager is shut down");
+  size_t next = 0;
+  while (next < requests.size()) {
+    // 队列满了就等一部分请求完成，有空位就尽量多放一些，一次系统调用提交
+    room_cv_.wait(lock, [this] { return in_flight_ < queue_depth_; });
+    size_t batch = 0;
+#ifdef BUSTUB_HAS_IO_URING
+    unsigned tail = backend_ == Backend::IO_URING ? *ring_.sq_tail_ : 0;
+#endif
+    while (next < requests.size() && in_flight_ < queue_depth_) {
+      DiskRequest &request = requests[next++];
+      if (request.is_write_) {
+        num_writes_ += 1;
+      }
+      in_flight_++;
+      batch++;
+      if (backend_ == Backend::THREAD_POOL) {
+        pending_.push_back(std::move(request));
+        continue;
+      }
+#ifdef BUSTUB_HAS_IO_URING
+      const unsigned slot_index = free_slots_.back();
+      free_slots_.pop_back();
+      Slot &slot = slots_[slot_index];
+      slot.request_ = std::move(request);
+      slot.iov_ = {slot.request_.data_, BUSTUB_PAGE_SIZE};
+      const unsigned index = tail & *ring_.sq_mask_;
+      auto *sqe = static_cast<io_uring_sqe *>(ring_.sqes_ptr_) + index;
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = slot.request_.is_write_ ? IORING_OP_WRITEV : IORING_OP_READV;
+      sqe->fd = db_fd_;
+      sqe->off = static_cast<uint64_t>(slot.request_.page_id_) * BUSTUB_PAGE_SIZE;
+      sqe->addr = reinterpret_cast<uint64_t>(&slot.iov_);
+      sqe->len = 1;
+      sqe->user_data = slot_index;
+      ring_.sq_array_[index] = index;
+      tail++;
+#endif
+    }
+    if (backend_ == Backend::THREAD_POOL) {
+      pending_cv_.notify_all();
+      continue;
+    }
+#ifdef BUSTUB_HAS_IO_URING
+    __atomic_store_n(ring_.sq_tail_, tail, __ATOMIC_RELEASE);
+    while (batch > 0) {
+      const long submitted = syscall(__NR_io_uring_enter, ring_.fd_, batch, 0, 0, nullptr, 0);  // NOLINT
+      if (submitted < 0) {
+        // 完成队列满了时内核会拒绝提交，收割线程不需要latch_就能腾出位置
+        if (errno == EINTR || errno == EAGAIN || errno == EBUSY) {
+          continue;
+        }
+        throw Exception("io_uring_enter failed");
+      }
+      batch -= static_cast<size_t>(submitted);
+    }
+#endif
+  }
+}
+
+auto AsyncDiskManager::SetUpRing() -> bool {
+#ifdef BUSTUB_HAS_IO_URING
+  io_uring_params params;
+  memset(&params, 0, sizeof(params));
+  const long fd = syscall(__NR_io_uring_setup, queue_depth_, &params);  // NOLINT
+  if (fd < 0) {
+    LOG_DEBUG("io_uring is not available, falling back to a thread pool");
+    return false;
+  }
+  ring_.fd_ = static_cast<int>(fd);
+  ring_.sq_size_ = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+  ring_.cq_size_ = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+  const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+  if (single_mmap) {
+    ring_.sq_size_ = ring_.cq_size_ = std::max(ring_.sq_size_, ring_.cq_size_);
+  }
+  auto map = [this](size_t size, off_t offset) -> void * {
+    void *ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_.fd_, offset);
+    return ptr == MAP_FAILED ? nullptr : ptr;
+  };
+  ring_.sq_ptr_ = map(ring_.sq_size_, IORING_OFF_SQ_RING);
+  ring_.cq_ptr_ = single_mmap ? ring_.sq_ptr_ : map(ring_.cq_size_, IORING_OFF_CQ_RING);
+  ring_.sqes_size_ = params.sq_entries * sizeof(io_uring_sqe);
+  ring_.sqes_ptr_ = map(ring_.sqes_size_, IORING_OFF_SQES);
+  if (ring_.sq_ptr_ == nullptr || ring_.cq_ptr_ == nullptr || ring_.sqes_ptr_ == nullptr) {
+    LOG_DEBUG("can't map the io_uring queues, falling back to a thread pool");
+    TearDownRing();
+    return false;
+  }
+  auto *sq = static_cast<char *>(ring_.sq_ptr_);
+  auto *cq = static_cast<char *>(ring_.cq_ptr_);
+  ring_.sq_head_ = reinterpret_cast<unsigned *>(sq + params.sq_off.head);
+  ring_.sq_tail_ = reinterpret_cast<unsigned *>(sq + params.sq_off.tail);
+  ring_.sq_mask_ = reinterpret_cast<unsigned *>(sq + params.sq_off.ring_mask);
+  ring_.sq_array_ = reinterpret_cast<unsigned *>(sq + params.sq_off.array);
+  ring_.cq_head_ = reinterpret_cast<unsigned *>(cq + params.cq_off.head);
+  ring_.cq_tail_ = reinterpret_cast<unsigned *>(cq + params.cq_off.tail);
+  ring_.cq_mask_ = reinterpret_cast<unsigned *>(cq + params.cq_off.ring_mask);
+  ring_.cqes_ = cq + params.cq_off.cqes;
+  return true;
+#else
+  return false;
+#endif
+}
+
+void AsyncDiskManager::TearDownRing() {
+  if (ring_.sqes_ptr_ != nullptr) {
+    munmap(ring_.sqes_ptr_, ring_.sqes_size_);
+  }
+  if (ring_.cq_ptr_ != nullptr && ring_.cq_ptr_ != ring_.sq_ptr_) {
+    munmap(ring_.cq_ptr_, ring_.cq_size_);
+  }
+  if (ring_.sq_ptr_ != nullptr) {
+    munmap(ring_.sq_ptr_, ring_.sq_size_);
+  }
+  if (ring_.fd_ >= 0) {
+    close(ring_.fd_);
+  }
+  ring_ = Ring{};
+}
+
+void AsyncDiskManager::ReapCompletions() {
+#ifdef BUSTUB_HAS_IO_URING
+  std::vector<std::pair<uint64_t, int>> completions;
+  while (true) {
+    unsigned head = *ring_.cq_head_;
+    const unsigned tail = __atomic_load_n(ring_.cq_tail_, __ATOMIC_ACQUIRE);
+    if (head == tail) {
+      syscall(__NR_io_uring_enter, ring_.fd_, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0);
+      continue;
+    }
+    // 先把完成事件拷出来归还给内核，再逐个回调
+    completions.clear();
+    for (; head != tail; head++) {
+      const io_uring_cqe &cqe = static_cast<io_uring_cqe *>(ring_.cqes_)[head & *ring_.cq_mask_];
+      completions.emplace_back(cqe.user_data, cqe.res);
+    }
+    __atomic_store_n(ring_.cq_head_, head, __ATOMIC_RELEASE);
+
+    bool stop = false;
+    for (auto [user_data, result] : completions) {
+      if (user_data == STOP_USER_DATA) {
+        stop = true;
+        continue;
+      }
+      DiskRequest request = std::move(slots_[user_data].request_);
+      // 被打断或者只传了一部分的请求，剩下的部分在这里同步做完
+      if (result == -EINTR || result == -EAGAIN || (result >= 0 && result < BUSTUB_PAGE_SIZE)) {
+        result = PerformRequest(request, std::max(result, 0));
+      }
+      CompleteRequest(&request, result);
+      {
+        std::scoped_lock sl(latch_);
+        free_slots_.push_back(static_cast<unsigned>(user_data));
+      }
+      ReleaseRequest();
+    }
+    if (stop) {
+      return;
+    }
+  }
+#endif
+}
+
+void AsyncDiskManager::ServeRequests() {
+  std::unique_lock lock(latch_);
+  while (true) {
+    pending_cv_.wait(lock, [this] { return stopped_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      return;
+    }
+    DiskRequest request = std::move(pending_.front());
+    pending_.pop_front();
+    lock.unlock();
+    CompleteRequest(&request, PerformRequest(request));
+    ReleaseRequest();
+    lock.lock();
+  }
+}
+
+auto AsyncDiskManager::PerformRequest(const DiskRequest &request, int done) -> int {
+  const off_t offset = static_cast<off_t>(request.page_id_) * BUSTUB_PAGE_SIZE;
+  // 和DiskManager一样，只传了一部分或者被信号打断时接着传，直到整页传完、读到文件末尾或者出错
+  while (done < BUSTUB_PAGE_SIZE) {
+    const ssize_t result =
+        request.is_write_ ? pwrite(db_fd_, request.data_ + done, BUSTUB_PAGE_SIZE - done, offset + done)
+                          : pread(db_fd_, request.data_ + done, BUSTUB_PAGE_SIZE - done, offset + done);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result < 0) {
+      return -errno;
+    }
+    if (result == 0) {
+      break;
+    }
+    done += static_cast<int>(result);
+  }
+  return done;
+}
+
+void AsyncDiskManager::CompleteRequest(DiskRequest *request, int result) {
+  if (result < 0) {
+    LOG_DEBUG("I/O error on page %d: %s", request->page_id_, strerror(-result));
+    request->callback_.set_value(false);
+    return;
+  }
+  if (request->is_write_) {
+    if (result < BUSTUB_PAGE_SIZE) {
+      LOG_DEBUG("short write on page %d", request->page_id_);
+    }
+    request->callback_.set_value(result == BUSTUB_PAGE_SIZE);
+    return;
+  }
+  // 和DiskManager一样，读到文件末尾之后的部分补0
+  if (result < BUSTUB_PAGE_SIZE) {
+    memset(request->data_ + result, 0, BUSTUB_PAGE_SIZE - result);
+  }
+  request->callback_.set_value(true);
+}
+
+void AsyncDiskManager::ReleaseRequest() {
+  std::scoped_lock sl(latch_);
+  in_flight_--;
+  room_cv_.notify_all();
+}
+
+void AsyncDiskManager::Stop() {
+  {
+    std::unique_lock lock(latch_);
+    if (stopped_) {
+      return;
+    }
+    room_cv_.wait(lock, [this] { return in_flight_ == 0; });
+    stopped_ = true;
+#ifdef BUSTUB_HAS_IO_URING
+    if (backend_ == Backend::IO_URING) {
+      // 提交一个no-op，收割线程看到它就退出
+      const unsigned tail = *ring_.sq_tail_;
+      const unsigned index = tail & *ring_.sq_mask_;
+      auto *sqe = static_cast<io_uring_sqe *>(ring_.sqes_ptr_) + index;
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = IORING_OP_NOP;
+      sqe->user_data = STOP_USER_DATA;
+      ring_.sq_array_[index] = index;
+      __atomic_store_n(ring_.sq_tail_, tail + 1, __ATOMIC_RELEASE);
+      while (syscall(__NR_io_uring_enter, ring_.fd_, 1, 0, 0, nullptr, 0) < 0 && errno == EINTR) {
+      }
+    }
+#endif
+  }
+  pending_cv_.notify_all();
+  if (reaper_.joinable()) {
+    reaper_.join();
+  }
+  for (auto &worker : workers_) {
+    worker.join();
+  }
+  workers_.clear();
+  TearDownRing();
+}
+
+}  // namespace bustub
@@ -10,10 +10,18 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <fcntl.h>
 #include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <memory>
 #include <mutex>  // NOLINT
 #include <string>
 #include <thread>  // NOLINT
@@ -26,99 +34,241 @@ namespace bustub {
 
 static char *buffer_used;
 
+/** @return true if a page buffer can be used for O_DIRECT I/O as is */
+static auto IsAligned(const char *data) -> bool { return reinterpret_cast<uintptr_t>(data) % BUSTUB_PAGE_SIZE == 0; }
+
+/** @return this thread's aligned buffer for direct I/O from or into a page buffer that is not aligned */
+static auto BounceBuffer() -> char * {
+  thread_local std::unique_ptr<char, decltype(&std::free)> buffer(
+      static_cast<char *>(std::aligned_alloc(BUSTUB_PAGE_SIZE, BUSTUB_PAGE_SIZE)), &std::free);
+  return buffer.get();
+}
+
 /**
  * Constructor: open/create a single database file & log file
  * @input db_file: database file name
  */
-DiskManager::DiskManager(const std::string &db_file) : file_name_(db_file) {
+DiskManager::DiskManager(const std::string &db_file, bool direct_io) : file_name_(db_file) {
   std::string::size_type n = file_name_.rfind('.');
   if (n == std::string::npos) {
     LOG_DEBUG("wrong file format");
     return;
   }
   log_name_ = file_name_.substr(0, n) + ".log";
+  master_name_ = file_name_.substr(0, n) + ".master";
 
-  log_io_.open(log_name_, std::ios::binary | std::ios::in | std::ios::app | std::ios::out);
-  // directory or file does not exist
-  if (!log_io_.is_open()) {
-    log_io_.clear();
-    // create a new file
-    log_io_.open(log_name_, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!log_io_.is_open()) {
-      throw Exception("can't open dblog file");
-    }
+  // 日志只追加写，读的时候用pread按偏移量读
+  log_fd_ = open(log_name_.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+  if (log_fd_ < 0) {
+    throw Exception("can't open dblog file");
   }
 
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
-  // directory or file does not exist
-  if (!db_io_.is_open()) {
-    db_io_.clear();
-    // create a new file
-    db_io_.open(db_file, std::ios::binary | std::ios::trunc | std::ios::out | std::ios::in);
-    if (!db_io_.is_open()) {
-      throw Exception("can't open db file");
-    }
+#ifdef O_DIRECT
+  if (direct_io) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT | O_DIRECT, 0644);
+    // tmpfs等文件系统不支持O_DIRECT，退回普通的读写
+    direct_io_ = db_fd_ >= 0;
+  }
+#endif
+  if (direct_io && !direct_io_) {
+    LOG_DEBUG("O_DIRECT is not supported for %s, using buffered I/O", db_file.c_str());
+  }
+  if (db_fd_ < 0) {
+    db_fd_ = open(db_file.c_str(), O_RDWR | O_CREAT, 0644);
+  }
+  if (db_fd_ < 0) {
+    throw Exception("can't open db file");
   }
   buffer_used = nullptr;
 }
 
+DiskManager::~DiskManager() {
+  if (db_fd_ >= 0) {
+    close(db_fd_);
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+  }
+}
+
 /**
  * Close all file streams
  */
 void DiskManager::ShutDown() {
-  {
-    std::scoped_lock scoped_db_io_latch(db_io_latch_);
-    db_io_.close();
+  if (db_fd_ >= 0) {
+    // 写页只写到了操作系统的page cache里，关闭之前落盘一次
+    if (fsync(db_fd_) != 0) {
+      LOG_DEBUG("I/O error while syncing db file");
+    }
+    close(db_fd_);
+    db_fd_ = -1;
+  }
+  if (log_fd_ >= 0) {
+    close(log_fd_);
+    log_fd_ = -1;
   }
-  log_io_.close();
 }
 
 /**
  * Write the contents of the specified page into disk file
  */
-void DiskManager::WritePage(page_id_t page_id, const char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);                // 一个scope锁
-  size_t offset = static_cast<size_t>(page_id) * BUSTUB_PAGE_SIZE;  // 根据page_id 算出page在db文件中的偏移量
-  // set write cursor to offset
-  num_writes_ += 1;  //
-  db_io_.seekp(offset);
-  db_io_.write(page_data, BUSTUB_PAGE_SIZE);  // 直接刷入磁盘中
-  // check for I/O error
-  if (db_io_.bad()) {  // 检查fstream流是否有故障
-    LOG_DEBUG("I/O error while writing");
+auto DiskManager::WritePage(page_id_t page_id, const char *page_data) -> bool {
+  const off_t offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;  // 根据page_id 算出page在db文件中的偏移量
+  num_writes_ += 1;
+  // O_DIRECT要求缓冲区按页对齐，缓冲池的frame都是对齐的，其他调用方的缓冲区先拷到对齐的缓冲区里
+  if (direct_io_ && !IsAligned(page_data)) {
+    char *bounce = BounceBuffer();
+    memcpy(bounce, page_data, BUSTUB_PAGE_SIZE);
+    page_data = bounce;
+    num_bounced_ios_++;
+  }
+  // pwrite可能只写了一部分或者被信号打断，写完整个页为止
+  size_t written = 0;
+  while (written < BUSTUB_PAGE_SIZE) {
+    const ssize_t result = pwrite(db_fd_, page_data + written, BUSTUB_PAGE_SIZE - written, offset + written);
+    num_write_calls_++;
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result <= 0) {
+      LOG_DEBUG("I/O error while writing");
+      return false;
+    }
+    written += result;
+  }
+  return true;
+}
+
+/**
+ * Write the pages sorted by page id, one pwritev per run of adjacent pages
+ */
+void DiskManager::WritePages(std::vector<std::pair<page_id_t, const char *>> pages) {
+  // 没有db文件的子类（内存里的DiskManager）只能逐页写
+  if (db_fd_ < 0) {
+    for (const auto &[page_id, page_data] : pages) {
+      WritePage(page_id, page_data);
+    }
     return;
   }
-  // needs to flush to keep disk file in sync
-  db_io_.flush();  // 刷新缓存
+  std::sort(pages.begin(), pages.end(), [](const auto &a, const auto &b) { return a.first < b.first; });
+  std::vector<iovec> iov;
+  size_t begin = 0;
+  while (begin < pages.size()) {
+    // 找出一段page id连续的页，一次系统调用最多带IOV_MAX个缓冲区
+    size_t end = begin + 1;
+    while (end < pages.size() && end - begin < static_cast<size_t>(IOV_MAX) &&
+           pages[end].first == pages[end - 1].first + 1) {
+      end++;
+    }
+    const bool aligned = !direct_io_ || std::all_of(pages.begin() + begin, pages.begin() + end,
+                                                    [](const auto &page) { return IsAligned(page.second); });
+    if (!aligned) {
+      // O_DIRECT下有没对齐的缓冲区，这一段逐页经过WritePage的中转缓冲区
+      for (size_t i = begin; i < end; i++) {
+        WritePage(pages[i].first, pages[i].second);
+      }
+      begin = end;
+      continue;
+    }
+    iov.clear();
+    for (size_t i = begin; i < end; i++) {
+      iov.push_back({const_cast<char *>(pages[i].second), BUSTUB_PAGE_SIZE});  // NOLINT
+    }
+    num_writes_ += static_cast<int>(end - begin);
+    off_t offset = static_cast<off_t>(pages[begin].first) * BUSTUB_PAGE_SIZE;
+    size_t next = 0;
+    while (next < iov.size()) {
+      const ssize_t result = pwritev(db_fd_, iov.data() + next, static_cast<int>(iov.size() - next), offset);
+      num_write_calls_++;
+      if (result < 0 && errno == EINTR) {
+        continue;
+      }
+      if (result <= 0) {
+        LOG_DEBUG("I/O error while writing");
+        break;
+      }
+      // 和WritePage一样可能只写了一部分：跳过写完的缓冲区，写了一半的那个从没写的地方接着写
+      offset += result;
+      auto left = static_cast<size_t>(result);
+      while (next < iov.size() && left >= iov[next].iov_len) {
+        left -= iov[next].iov_len;
+        next++;
+      }
+      if (left > 0) {
+        iov[next].iov_base = static_cast<char *>(iov[next].iov_base) + left;
+        iov[next].iov_len -= left;
+      }
+    }
+    begin = end;
+  }
 }
 
 /**
  * Read the contents of the specified page into the given memory area
  */
-void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
-  std::scoped_lock scoped_db_io_latch(db_io_latch_);
-  int offset = page_id * BUSTUB_PAGE_SIZE;
-  // check if read beyond file length
-  if (offset > GetFileSize(file_name_)) {  // 查看偏移量是否超出了db文件的大小
-    LOG_DEBUG("I/O error reading past end of file");
-    // std::cerr << "I/O error while reading" << std::endl;
-  } else {
-    // set read cursor to offset
-    db_io_.seekp(offset);                      // 跳到开始读的地方
-    db_io_.read(page_data, BUSTUB_PAGE_SIZE);  // 读入到缓冲区中
-    if (db_io_.bad()) {
+auto DiskManager::ReadPage(page_id_t page_id, char *page_data) -> bool {
+  const off_t offset = static_cast<off_t>(page_id) * BUSTUB_PAGE_SIZE;
+  // 和WritePage一样，没对齐的缓冲区经过对齐的缓冲区中转
+  char *target = page_data;
+  if (direct_io_ && !IsAligned(page_data)) {
+    page_data = BounceBuffer();
+    num_bounced_ios_++;
+  }
+  size_t read_count = 0;
+  while (read_count < BUSTUB_PAGE_SIZE) {
+    const ssize_t result = pread(db_fd_, page_data + read_count, BUSTUB_PAGE_SIZE - read_count, offset + read_count);
+    if (result < 0 && errno == EINTR) {
+      continue;
+    }
+    if (result < 0) {
       LOG_DEBUG("I/O error while reading");
-      return;
+      return false;
     }
-    // if file ends before reading BUSTUB_PAGE_SIZE
-    int read_count = db_io_.gcount();
-    if (read_count < BUSTUB_PAGE_SIZE) {  // 如果读的数据少于一个页面的数据，那么就将返回的数据后面填补0
-      LOG_DEBUG("Read less than a page");
-      db_io_.clear();
-      // std::cerr << "Read less than a page" << std::endl;
-      memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+    // 读到文件末尾了
+    if (result == 0) {
+      break;
     }
+    read_count += result;
+  }
+  // if file ends before reading BUSTUB_PAGE_SIZE
+  if (read_count < BUSTUB_PAGE_SIZE) {  // 如果读的数据少于一个页面的数据，那么就将返回的数据后面填补0
+    LOG_DEBUG("Read less than a page");
+    memset(page_data + read_count, 0, BUSTUB_PAGE_SIZE - read_count);
+  }
+  if (page_data != target) {
+    memcpy(target, page_data, BUSTUB_PAGE_SIZE);
+  }
+  return true;
+}
+
+void DiskManager::Schedule(std::vector<DiskRequest> requests) {
+  for (auto &request : requests) {
+    const bool ok =
+        request.is_write_ ? WritePage(request.page_id_, request.data_) : ReadPage(request.page_id_, request.data_);
+    request.callback_.set_value(ok);
+  }
+}
+
+auto DiskManager::ScheduleAndWait(std::vector<DiskRequest> requests) -> bool {
+  std::vector<std::future<bool>> futures;
+  futures.reserve(requests.size());
+  for (auto &request : requests) {
+    futures.push_back(request.callback_.get_future());
+  }
+  Schedule(std::move(requests));
+  bool ok = true;
+  for (auto &future : futures) {
+    ok = future.get() && ok;
+  }
+  return ok;
+}
+
+void DiskManager::Sync() {
+  if (db_fd_ < 0) {
+    return;
+  }
+  if (fdatasync(db_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing db file");
   }
 }
 
@@ -126,7 +276,7 @@ void DiskManager::ReadPage(page_id_t page_id, char *page_data) {
  * Write the contents of the log into disk file
  * Only return when sync is done, and only perform sequence write
  */
-void DiskManager::WriteLog(char *log_data, int size) {
+auto DiskManager::WriteLog(char *log_data, int size) -> bool {
   /**
    * 向日志文件中写日志信息
    */
@@ -135,7 +285,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
   buffer_used = log_data;
 
   if (size == 0) {  // no effect on num_flushes_ if log buffer is empty
-    return;
+    return true;
   }
 
   flush_log_ = true;
@@ -146,17 +296,30 @@ void DiskManager::WriteLog(char *log_data, int size) {
   }
 
   num_flushes_ += 1;
+  if (log_fd_ < 0) {  // in-memory disk managers have no log file
+    flush_log_ = false;
+    return true;
+  }
   // sequence write
-  log_io_.write(log_data, size);
-
-  // check for I/O error
-  if (log_io_.bad()) {
-    LOG_DEBUG("I/O error while writing log");
-    return;
+  for (int written = 0; written < size;) {
+    const ssize_t ret = write(log_fd_, log_data + written, size - written);
+    if (ret < 0 && errno == EINTR) {
+      continue;
+    }
+    // check for I/O error
+    if (ret < 0) {
+      LOG_DEBUG("I/O error while writing log");
+      return false;
+    }
+    written += static_cast<int>(ret);
+  }
+  // 提交要等日志真正落盘，只flush到page cache是不够的；一次fdatasync覆盖这一批的所有提交
+  if (fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while syncing log");
+    return false;
   }
-  // needs to flush to keep disk file in sync
-  log_io_.flush();
   flush_log_ = false;
+  return true;
 }
 
 /**
@@ -164,7 +327,7 @@ void DiskManager::WriteLog(char *log_data, int size) {
  * Always read from the beginning and perform sequence read
  * @return: false means already reach the end
  */
-auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
+auto DiskManager::ReadLog(char *log_data, int size, int64_t offset) -> bool {
   /**
    * 从log文件中读取日志信息，放到指定的log_data指向的内存区域中，大小为size
    */
@@ -173,23 +336,109 @@ auto DiskManager::ReadLog(char *log_data, int size, int offset) -> bool {
     // LOG_DEBUG("file size is %d", GetFileSize(log_name_));
     return false;
   }
-  log_io_.seekp(offset);
-  log_io_.read(log_data, size);
-
-  if (log_io_.bad()) {
+  const ssize_t read_count = pread(log_fd_, log_data, size, offset);
+  if (read_count < 0) {
     LOG_DEBUG("I/O error while reading log");
     return false;
   }
   // if log file ends before reading "size"
-  int read_count = log_io_.gcount();
   if (read_count < size) {
-    log_io_.clear();
     memset(log_data + read_count, 0, size - read_count);
   }
 
   return true;
 }
 
+auto DiskManager::GetLogSize() -> int64_t {
+  if (log_fd_ < 0) {
+    return 0;
+  }
+  return std::max<int64_t>(GetFileSize(log_name_), 0);
+}
+
+auto DiskManager::TruncateLog(int64_t size) -> bool {
+  if (log_fd_ < 0) {
+    return true;
+  }
+  // 日志是O_APPEND打开的，截短之后的写接在新的末尾
+  if (ftruncate(log_fd_, size) != 0 || fdatasync(log_fd_) != 0) {
+    LOG_DEBUG("I/O error while truncating log");
+    return false;
+  }
+  return true;
+}
+
+void DiskManager::WriteMasterRecord(int64_t checkpoint_offset) {
+  WriteMaster(0, &checkpoint_offset, sizeof(checkpoint_offset));
+}
+
+auto DiskManager::ReadMasterRecord() -> int64_t {
+  int64_t checkpoint_offset;
+  if (!ReadMaster(0, &checkpoint_offset, sizeof(checkpoint_offset))) {
+    return -1;
+  }
+  return checkpoint_offset;
+}
+
+void DiskManager::WriteFreePageMapRoot(uint32_t instance_index, page_id_t root) {
+  const page_id_t slot[2] = {root, ~root};
+  WriteMaster(sizeof(int64_t) + instance_index * sizeof(slot), slot, sizeof(slot));
+}
+
+auto DiskManager::ReadFreePageMapRoot(uint32_t instance_index, page_id_t *root) -> bool {
+  page_id_t slot[2];
+  *root = INVALID_PAGE_ID;
+  if (!ReadMaster(sizeof(int64_t) + instance_index * sizeof(slot), slot, sizeof(slot)) || slot[1] != ~slot[0]) {
+    return false;
+  }
+  *root = slot[0];
+  return true;
+}
+
+auto DiskManager::GetNumPages() -> page_id_t {
+  if (db_fd_ < 0) {
+    return 0;
+  }
+  return static_cast<page_id_t>(std::max<int64_t>(GetFileSize(file_name_), 0) / BUSTUB_PAGE_SIZE);
+}
+
+void DiskManager::WriteMaster(int64_t offset, const void *data, size_t size) {
+  if (master_name_.empty()) {
+    return;
+  }
+  // 每个槽位一次pwrite写完，不会出现写了一半的槽位
+  int fd = open(master_name_.c_str(), O_WRONLY | O_CREAT, 0644);
+  if (fd < 0) {
+    LOG_DEBUG("can't open master record file");
+    return;
+  }
+  bool ok = true;
+  struct stat stat_buf;
+  if (offset > 0 && fstat(fd, &stat_buf) == 0 && stat_buf.st_size < static_cast<off_t>(sizeof(int64_t))) {
+    // 新建的文件先标记还没有检查点，否则检查点的位置读出来是0
+    const int64_t no_checkpoint = -1;
+    ok = pwrite(fd, &no_checkpoint, sizeof(no_checkpoint), 0) == sizeof(no_checkpoint);
+  }
+  ok = ok && pwrite(fd, data, size, offset) == static_cast<ssize_t>(size) && fdatasync(fd) == 0;
+  if (!ok) {
+    LOG_DEBUG("I/O error while writing master record");
+  }
+  close(fd);
+}
+
+auto DiskManager::ReadMaster(int64_t offset, void *data, size_t size) -> bool {
+  if (master_name_.empty()) {
+    return false;
+  }
+  int fd = open(master_name_.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+  const bool ok = pread(fd, data, size, offset) == static_cast<ssize_t>(size);
+  close(fd);
+  return ok;
+}
+
 /**
  * Returns number of flushes made so far
  */
@@ -208,10 +457,10 @@ auto DiskManager::GetFlushState() const -> bool { return flush_log_; }
 /**
  * Private helper function to get disk file size
  */
-auto DiskManager::GetFileSize(const std::string &file_name) -> int {
+auto DiskManager::GetFileSize(const std::string &file_name) -> int64_t {
   struct stat stat_buf;
   int rc = stat(file_name.c_str(), &stat_buf);
-  return rc == 0 ? static_cast<int>(stat_buf.st_size) : -1;
+  return rc == 0 ? static_cast<int64_t>(stat_buf.st_size) : -1;
 }
 
 }  // namespace bustub
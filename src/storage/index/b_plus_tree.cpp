@@ -1,4 +1,5 @@
 #include <string>
+#include <utility>
 
 #include "common/exception.h"
 #include "common/logger.h"
@@ -19,7 +20,8 @@ BPLUSTREE_TYPE::BPlusTree(std::string name, BufferPoolManager *buffer_pool_manag
       buffer_pool_manager_(buffer_pool_manager),
       comparator_(comparator),
       leaf_max_size_(leaf_max_size),
-      internal_max_size_(internal_max_size) {
+      internal_max_size_(internal_max_size),
+      extent_allocator_(buffer_pool_manager) {
         // 先判断是否有根页面
 
 
@@ -48,27 +50,89 @@ auto BPLUSTREE_TYPE::GetValue(const KeyType &key, std::vector<ValueType> *result
 }
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Search(const KeyType &key, std::vector<ValueType> *result){
-  // page_node不会为空
-  Page * root_page = buffer_pool_manager_->FetchPage(root_page_id_);
-  BPlusTreePage * node = ToGeneralPage(root_page);
-  while (!node->IsLeafPage()) {
+  if (IsEmpty()) {
+    return;
+  }
+  // 先乐观地往下走，内部结点不加锁；一直冲突的话再老老实实加读锁
+  for (int attempt = 0; attempt < OPTIMISTIC_READ_RETRIES; attempt++) {
+    if (SearchOptimistic(key, result)) {
+      return;
+    }
+  }
+  // 路径上的页先拿到孩子的读锁再释放，unpin攒到最后一次做完
+  UnpinBatch path(buffer_pool_manager_);
+  ReadPageGuard guard = LatchRootRead();
+  if (!guard.IsValid()) {
+    return;
+  }
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
     // page_node不是叶子节点，所以page_node可以转化为中间结点
-    InternalPage *page_internal_node = ToInternalPage(node);
+    const auto *page_internal_node = guard.As<InternalPage>();
     // 通过中间节点找到合适的叶子结点，然后循环再次判断
     int idx;
     page_internal_node->BinarySearch(key, &idx, comparator_);
-    
-    page_id_t page_id = page_internal_node->ValueAt(idx);
-    UnpinPageNode(page_internal_node,false);
-    node = FetchPageNode<InternalPage>(page_id);
+    if (idx >= page_internal_node->GetSize()) {
+      return;
+    }
+    ReadPageGuard child = buffer_pool_manager_->FetchPageRead(page_internal_node->ValueAt(idx), nullptr, tag_);
+    guard.Drop(&path);
+    guard = std::move(child);
   }
   // 如果是叶子结点，那我们就可以搜索值了
-  if (node->IsLeafPage()) {
-    LeafPage* page_leaf_node = ToLeafPage(node);
-    page_leaf_node->Get(key, comparator_,result);
-  }
-  UnpinPageNode(node,false);
+  guard.As<LeafPage>()->Get(key, comparator_, result);
+}
 
+/*
+ * Walk down to the leaf without latching internal nodes: every read of a node is checked against the node's version
+ * before it is used, and the parent is checked again once the child is pinned, so a child id read from a node that
+ * was split or merged meanwhile is never followed. Only the leaf is read latched.
+ * @return false if a writer got in the way, result is untouched then and the caller should retry
+ */
+INDEX_TEMPLATE_ARGUMENTS
+auto BPLUSTREE_TYPE::SearchOptimistic(const KeyType &key, std::vector<ValueType> *result) -> bool {
+  page_id_t root_page_id = root_page_id_;
+  if (root_page_id == INVALID_PAGE_ID) {
+    return true;
+  }
+  UnpinBatch path(buffer_pool_manager_);
+  OptimisticPageGuard guard = buffer_pool_manager_->FetchPageOptimistic(root_page_id, tag_);
+  // 换根的写者一直锁着旧根，拿到版本号之后根还是它，旧根之后再被换掉也校验得出来
+  if (!guard.IsValid() || root_page_id_ != root_page_id) {
+    return false;
+  }
+  while (true) {
+    bool is_leaf = guard.As<BPlusTreePage>()->IsLeafPage();
+    if (!guard.Validate()) {
+      return false;
+    }
+    if (is_leaf) {
+      // 叶子加读锁，并确认加锁之前没有人改过它
+      ReadPageGuard leaf = guard.UpgradeRead();
+      if (!leaf.IsValid()) {
+        return false;
+      }
+      leaf.As<LeafPage>()->Get(key, comparator_, result);
+      return true;
+    }
+    const auto *page_internal_node = guard.As<InternalPage>();
+    int idx;
+    page_internal_node->BinarySearch(key, &idx, comparator_);
+    bool out_of_range = idx >= page_internal_node->GetSize();
+    page_id_t child_page_id = out_of_range ? INVALID_PAGE_ID : page_internal_node->ValueAt(idx);
+    if (!guard.Validate()) {
+      return false;
+    }
+    if (out_of_range) {
+      return true;
+    }
+    OptimisticPageGuard child = buffer_pool_manager_->FetchPageOptimistic(child_page_id, tag_);
+    // 拿到孩子之后父亲还没变，孩子才是对的
+    if (!child.IsValid() || !guard.Validate()) {
+      return false;
+    }
+    guard.Drop(&path);
+    guard = std::move(child);
+  }
 }
 
 /*****************************************************************************
@@ -82,157 +146,115 @@ void BPLUSTREE_TYPE::Search(const KeyType &key, std::vector<ValueType> *result){
  */
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::Insert(const KeyType &key, const ValueType &value, Transaction *transaction) -> bool {
+  // 写者之间串行，读者只在写者锁着某一层的时候等一下
+  std::scoped_lock lock(writer_latch_);
   // 如果当前B+树为空，则先初始化一下
   if (IsEmpty()){
     // 初始化为数据结点
-    LeafPage* root_node = NewPageNode<LeafPage>(HEADER_PAGE_ID, leaf_max_size_);
-    root_page_id_ = root_node->GetPageId();
-    UpdateRootPageId(root_page_id_);
-    UnpinPageNode(root_node, true);
+    page_id_t root_page_id;
+    WritePageGuard root_guard = extent_allocator_.NewPageWrite(&root_page_id);
+    root_guard.AsMut<LeafPage>()->Init(root_page_id, HEADER_PAGE_ID, leaf_max_size_);
+    root_page_id_ = root_page_id;
+    UpdateRootPageId(root_page_id);
   }
-  // 1. 找到根节点
-  BPlusTreePage* node = FetchPageNode<BPlusTreePage>(root_page_id_);
-  
+  // 1. 找到根节点，一路记下经过的页，分裂的时候从下往上用
+  std::vector<page_id_t> path{root_page_id_};
+
   int idx;
-  while (!node->IsLeafPage()) {
-      InternalPage * node_interal = ToInternalPage(node);
+  while (true) {
+      ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(path.back(), nullptr, tag_);
+      if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+        break;
+      }
+      const auto *node_interal = guard.As<InternalPage>();
       // 2. 找到下一层开始的位置
       node_interal->BinarySearch(key, &idx, comparator_);
       // 如果是最后一个idx，则需要修改
       if (idx == node_interal->GetSize() && comparator_(key, node_interal->KeyAt(idx-1)) > 0) {
-        node_interal->SetKeyAt(idx-1, key);
         idx = node_interal->GetSize() - 1;
-        UnpinPageNode(node_interal, true);
-      }else {
-        UnpinPageNode(node_interal, false);
+        // 结点只有写者会改，放掉读锁再加写锁，中间不会有人改它
+        guard.Drop();
+        WritePageGuard write_guard = buffer_pool_manager_->FetchPageWrite(path.back(), tag_);
+        write_guard.AsMut<InternalPage>()->SetKeyAt(idx, key);
+        path.push_back(write_guard.As<InternalPage>()->ValueAt(idx));
+        continue;
       }
 
-      // 3. 先取出page id
-      page_id_t next_page_id = node_interal->ValueAt(idx);
-      // 然后继续寻找
-      node = FetchPageNode<BPlusTreePage>(next_page_id);
+      // 3. 先取出page id，然后继续寻找
+      path.push_back(node_interal->ValueAt(idx));
   }
-  // 跳出for循环之后，肯定就是叶子节点了
-  LeafPage * leaf_node = ToLeafPage(node);
-  // 然后插入即可
-  bool is_full = leaf_node->Insert(key, value, comparator_);
+  // 跳出循环之后，肯定就是叶子节点了，然后插入即可
+  WritePageGuard leaf_guard = buffer_pool_manager_->FetchPageWrite(path.back(), tag_);
+  bool is_full = leaf_guard.AsMut<LeafPage>()->Insert(key, value, comparator_);
+  leaf_guard.Drop();
 
   if (is_full) {
-    InternalPage * spliting_node = SplitPageNode(leaf_node);
-    while (spliting_node){
-      spliting_node = SplitPageNode(spliting_node);
+    // 从叶子开始往上分裂，父亲满了就接着分裂父亲
+    bool spliting = SplitPageNode<LeafPage>(&path);
+    while (spliting) {
+      spliting = SplitPageNode<InternalPage>(&path);
     }
-  } else {
-    UnpinPageNode(leaf_node, true);
   }
-  // std::cout <<  << std::endl;
   return true;
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-template<class T>
-auto BPLUSTREE_TYPE::FetchPageNode(page_id_t page_id) -> T* {
-  this->fetch_count++;
-  Page * page = buffer_pool_manager_->FetchPage(page_id);
-  T * node = reinterpret_cast<T*>(page->GetData());
-  return node;
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::SplitInternalPageNode(InternalPage * spliting_node) -> InternalPage * {
-  if (spliting_node->IsRootPage()) {
-    InternalPage * root_page_node = NewPageNode<InternalPage>(HEADER_PAGE_ID, internal_max_size_);
-    // 重新设置page_id
-    root_page_id_ = root_page_node->GetPageId();
-    // 然后重新设置当前leaf的父节点
-    UpdateRootPageId();
-    // 更新父亲节点
-    spliting_node->SetParentPageId(root_page_id_);
-
-    root_page_node->Insert(spliting_node->KeyAt(spliting_node->GetSize() - 1), spliting_node->GetPageId(), comparator_);
-    UnpinPageNode(root_page_node, true);
-  }
-  // 建立分割节点
-  InternalPage* temp_page = NewPageNode<InternalPage>(spliting_node->GetParentPageId(), internal_max_size_);
-  // 在对中间节点进行分裂
-  SplitNode(spliting_node, temp_page);
-  // 取出其父亲节点
-  page_id_t spliting_parent_page_id = spliting_node->GetParentPageId();
-  Page * spliting_parent_page = buffer_pool_manager_->FetchPage(spliting_parent_page_id);
-  InternalPage* spliting_parent_page_node = ToInternalPage(spliting_parent_page->GetData());
-  // 然后把新节点插入到父节点中
-  bool is_full = spliting_parent_page_node->Insert(temp_page->KeyAt(temp_page->GetSize() - 1), temp_page->GetPageId(), comparator_);
-  if (is_full) {
-    return spliting_parent_page_node;
-  }
-  return nullptr;
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::SplitLeafPageNode(LeafPage *leaf_node) -> InternalPage * {
-    // 如果本身就是根结点，需要插入一个中间节点
-    if (leaf_node->IsRootPage()){
-      InternalPage * root_page_node = NewPageNode<InternalPage>(HEADER_PAGE_ID, internal_max_size_);
-      // 重新设置page_id
-      root_page_id_ = root_page_node->GetPageId();
-      // 然后重新设置当前leaf的父节点
-      UpdateRootPageId();
-      // 设置父亲节点
-      leaf_node->SetParentPageId(root_page_id_);
-      // 把分裂节点插入到新的根节点
-      root_page_node->Insert(leaf_node->KeyAt(leaf_node->GetSize() - 1), leaf_node->GetPageId(), comparator_);
-      UnpinPageNode(root_page_node, true);
+auto BPLUSTREE_TYPE::LatchRootRead() -> ReadPageGuard {
+  while (true) {
+    page_id_t root_page_id = root_page_id_;
+    if (root_page_id == INVALID_PAGE_ID) {
+      return {};
     }
-    // 1. 新建一个分裂节点的页面
-    LeafPage* split_page_node = NewPageNode<LeafPage>(leaf_node->GetParentPageId(), leaf_max_size_);
-    // 开始分裂
-    SplitNode(leaf_node, split_page_node);
-    // 然后取出其父亲节点
-    Page * parent_page = buffer_pool_manager_->FetchPage(split_page_node->GetParentPageId());
-    // 转化为内部结点
-    InternalPage * parent_page_node = ToInternalPage(parent_page->GetData());
-    // 然后把分裂的结点插入到内部结点中
-    bool is_full = parent_page_node->Insert(split_page_node->KeyAt(split_page_node->GetSize() - 1), split_page_node->GetPageId(), comparator_);
-    
-    UnpinPageNode(split_page_node, true);
-    UnpinPageNode(leaf_node, true);
-    
-    if (is_full) {
-      return parent_page_node;
-    }
-    UnpinPageNode(parent_page_node, true);
-    return nullptr;
+    ReadPageGuard root_guard = buffer_pool_manager_->FetchPageRead(root_page_id, nullptr, tag_);
+    // 等锁的时候根可能已经分裂或者被删掉了，那就重新来
+    if (root_page_id_ == root_page_id) {
+      return root_guard;
+    }
+  }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 template<class PageNode>
-auto BPLUSTREE_TYPE::SplitPageNode(PageNode *node) -> InternalPage * {
+auto BPLUSTREE_TYPE::SplitPageNode(std::vector<page_id_t> *path) -> bool {
+    // 先锁父亲再锁自己，和读者从上往下的加锁顺序一致
+    // 多出来的那一项在锁上之前读者照样能读，写者又是串行的，路径上记下的页不会变
+    WritePageGuard parent_guard;
+    if (path->size() >= 2) {
+      parent_guard = buffer_pool_manager_->FetchPageWrite((*path)[path->size() - 2], tag_);
+    }
+    WritePageGuard node_guard = buffer_pool_manager_->FetchPageWrite(path->back(), tag_);
+    path->pop_back();
+    auto *node = node_guard.AsMut<PageNode>();
     // 如果本身就是根结点，需要插入一个中间节点
     if (node->IsRootPage()){
-      InternalPage * root_page_node = NewPageNode<InternalPage>(HEADER_PAGE_ID, internal_max_size_);
-      // 重新设置page_id
-      root_page_id_ = root_page_node->GetPageId();
-      // 然后重新设置当前leaf的父节点
-      UpdateRootPageId();
+      page_id_t root_page_id;
+      parent_guard = extent_allocator_.NewPageWrite(&root_page_id);
+      auto *root_page_node = parent_guard.AsMut<InternalPage>();
+      root_page_node->Init(root_page_id, HEADER_PAGE_ID, internal_max_size_);
       // 设置父亲节点
-      node->SetParentPageId(root_page_id_);
+      node->SetParentPageId(root_page_id);
       // 把分裂节点插入到新的根节点
       root_page_node->Insert(node->KeyAt(node->GetSize() - 1), node->GetPageId(), comparator_);
-      UnpinPageNode(root_page_node, true);
+      // 旧根还锁着的时候换根，等着旧根的读者拿到锁之后会发现根变了
+      root_page_id_ = root_page_id;
+      UpdateRootPageId();
     }
     // 1. 新建一个分裂节点
-    PageNode* split_page_node = NewPageNode<PageNode>(node->GetParentPageId(), node->GetMaxSize());
+    page_id_t split_page_id;
+    WritePageGuard split_guard = extent_allocator_.NewPageWrite(&split_page_id);
+    auto *split_page_node = split_guard.AsMut<PageNode>();
+    split_page_node->Init(split_page_id, node->GetParentPageId(), node->GetMaxSize());
     // 开始分裂
     SplitNode(node, split_page_node);
     // 然后取出其父亲节点
-    InternalPage * parent_page_node = FetchPageNode<InternalPage>(split_page_node->GetParentPageId());
+    auto *parent_page_node = parent_guard.AsMut<InternalPage>();
     // 判断节点是否为叶子节点，如果是叶子节点，则我们需要更新next_page_id
     if (node->IsLeafPage()) {
         // 1. 将分裂出来的那个结点的next_page_id设置为split_page_node
         // 2. 找到分裂节点的前一个结点修改next_pageid
         //    必须是是排在最头部的叶子，那么就不做任何操作
         LeafPage * leaf_node = ToLeafPage(node);
-        LeafPage * leaf_split_page_node = reinterpret_cast<LeafPage*>(split_page_node);
+        LeafPage * leaf_split_page_node = ToLeafPage(split_page_node);
         
         
         // 取出新分裂节点的pre
@@ -245,45 +267,12 @@ auto BPLUSTREE_TYPE::SplitPageNode(PageNode *node) -> InternalPage * {
         leaf_node->SetPrePageId(leaf_split_page_node->GetPageId());
         // 更新旧的分裂点pre的next
         if (leaf_node_pre_page_id!=INVALID_PAGE_ID)  {
-          LeafPage * leaf_node_pre_page = FetchPageNode<LeafPage>(leaf_node_pre_page_id);
-          leaf_node_pre_page->SetNextPageId(leaf_split_page_node->GetPageId());
-          UnpinPageNode(leaf_node_pre_page, true);
+          WritePageGuard pre_guard = buffer_pool_manager_->FetchPageWrite(leaf_node_pre_page_id, tag_);
+          pre_guard.AsMut<LeafPage>()->SetNextPageId(leaf_split_page_node->GetPageId());
         }
     }
     // 然后把分裂的结点插入到内部结点中
-    bool is_full = parent_page_node->Insert(split_page_node->KeyAt(split_page_node->GetSize() - 1), split_page_node->GetPageId(), comparator_);
-    
-    UnpinPageNode(split_page_node, true);
-    UnpinPageNode(node, true);
-    
-    if (is_full) {
-      return parent_page_node;
-    }
-    UnpinPageNode(parent_page_node, true);
-    return nullptr;
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-template<class T>
-auto BPLUSTREE_TYPE::NewPageNode(page_id_t parent_page_id, int max_size) -> T* {
-  int page_id;
-  Page * page = buffer_pool_manager_->NewPage(&page_id);
-  fetch_count++;
-  T* temp_page = reinterpret_cast<T*>(page->GetData());
-  temp_page->Init(page_id, parent_page_id, max_size);
-  return temp_page;
-}
-
-INDEX_TEMPLATE_ARGUMENTS
-template<class T>
-auto BPLUSTREE_TYPE::UnpinPageNode(T * node, bool is_dirty) -> void {
-  if (node==nullptr) {
-    return;
-  }
-  this->unpin_count++;
-  page_id_t page_id = node->GetPageId();
-  buffer_pool_manager_->UnpinPage(page_id, is_dirty);
-
+    return parent_page_node->Insert(split_page_node->KeyAt(split_page_node->GetSize() - 1), split_page_id, comparator_);
 }
 
 INDEX_TEMPLATE_ARGUMENTS
@@ -307,66 +296,43 @@ auto BPLUSTREE_TYPE::SplitNode(T * origin, T * new_page_node) -> void {
 }
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::UpdateChildrenParent(InternalPage * parent) -> void {
+  // 孩子们一起unpin，只拿一次缓冲池的锁
+  UnpinBatch children(buffer_pool_manager_);
   for (int i = 0 ; i < parent->GetSize(); i++) {
-    page_id_t child_page_id = parent->ValueAt(i);
-    BPlusTreePage * child_page = FetchPageNode<BPlusTreePage>(child_page_id);
-    child_page->SetParentPageId(parent->GetPageId());
-    UnpinPageNode(child_page,true);
+    WritePageGuard child_guard = buffer_pool_manager_->FetchPageWrite(parent->ValueAt(i), tag_);
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(parent->GetPageId());
+    child_guard.Drop(&children);
   }
 
 }
 
 
-INDEX_TEMPLATE_ARGUMENTS
-auto BPLUSTREE_TYPE::LocatePage(const KeyType &key, int *idx) -> LeafPage* {
-  // page_node不会为空
-  
-  BPlusTreePage * node = FetchPageNode<BPlusTreePage>(root_page_id_);
-  while (!node->IsLeafPage()) {
-    // page_node不是叶子节点，所以page_node可以转化为中间结点
-    InternalPage *page_internal_node = ToInternalPage(node);
-    // 通过中间节点找到合适的叶子结点，然后循环再次判断
-    page_internal_node->BinarySearch(key, idx, comparator_);
-    if (*idx >= page_internal_node->GetSize()) {
-      return nullptr;
-    }
-    page_id_t page_id = page_internal_node->ValueAt(*idx);
-    UnpinPageNode(page_internal_node,false);
-    node = FetchPageNode<InternalPage>(page_id);
-  }
-  LeafPage *leaf_node = ToLeafPage(node);
-  return leaf_node;
-}
-
-
 INDEX_TEMPLATE_ARGUMENTS
 template<class PageNode>
-auto BPLUSTREE_TYPE::BorrowBrother(PageNode * node, bool left) -> bool {
-  // 找到父亲节点
-  page_id_t parent_page_id = node->GetParentPageId();
-  InternalPage* parent_page = FetchPageNode<InternalPage>(parent_page_id);
+auto BPLUSTREE_TYPE::BorrowBrother(WritePageGuard *parent_guard, WritePageGuard *node_guard, bool left) -> bool {
+  // 父亲已经锁着了，兄弟在它下面，加锁顺序还是从上往下
+  const auto *parent_page = parent_guard->As<InternalPage>();
+  const auto *node_page = node_guard->As<PageNode>();
   int idx;
-  parent_page->BinarySearch(node->MaxKey(), &idx, comparator_);
-  PageNode* bro = nullptr;
-  int bro_index;
-  int borrow_index;
+  parent_page->BinarySearch(node_page->MaxKey(), &idx, comparator_);
+  WritePageGuard bro_guard;
+  int bro_index = 0;
+  int borrow_index = 0;
   if(left && idx > 0){
     bro_index = idx - 1;
-    page_id_t brother_page_id = parent_page->array_[bro_index].second;
-    bro = FetchPageNode<PageNode>(brother_page_id);
-    borrow_index = bro->GetSize() - 1;
+    bro_guard = buffer_pool_manager_->FetchPageWrite(parent_page->ValueAt(bro_index), tag_);
+    borrow_index = bro_guard.As<PageNode>()->GetSize() - 1;
   }else if(!left && idx < parent_page->GetSize() - 1) {
     bro_index = idx + 1;
-    page_id_t brother_page_id = parent_page->array_[bro_index].second;
-    bro = FetchPageNode<PageNode>(brother_page_id);
+    bro_guard = buffer_pool_manager_->FetchPageWrite(parent_page->ValueAt(bro_index), tag_);
     borrow_index = 0;
   }
 
-  if (bro==nullptr || bro->GetSize()==bro->GetMinSize()) {
-    UnpinPageNode(parent_page, true);
-    UnpinPageNode(bro, true);
+  if (!bro_guard.IsValid() || bro_guard.As<PageNode>()->GetSize()==bro_guard.As<PageNode>()->GetMinSize()) {
     return false;
   }
+  auto *node = node_guard->AsMut<PageNode>();
+  auto *bro = bro_guard.AsMut<PageNode>();
   
   // 结点借进来
   node->Insert(bro->array_[borrow_index].first, bro->array_[borrow_index].second, comparator_);
@@ -374,23 +340,20 @@ auto BPLUSTREE_TYPE::BorrowBrother(PageNode * node, bool left) -> bool {
   // 如果node不是叶子节点，还需要更新子节点的父亲指针
   if (!node->IsLeafPage()) {
     InternalPage* interal_node = ToInternalPage(bro);
-    BPlusTreePage * child = FetchPageNode<BPlusTreePage>(interal_node->array_[borrow_index].second);
-    child->SetParentPageId(node->GetPageId());
-    UnpinPageNode(child, true);
+    WritePageGuard child_guard = buffer_pool_manager_->FetchPageWrite(interal_node->array_[borrow_index].second, tag_);
+    child_guard.AsMut<BPlusTreePage>()->SetParentPageId(node->GetPageId());
   }
   // 接点借出去
   bro->Delete(bro->array_[borrow_index].first, nullptr, comparator_);
 
-  // 借出去的父亲节点更新key
+  // 借出去的父亲节点更新key，要在放锁之前改，不然读者会按旧的key去找借走的那一项
+  // 借的两个结点都不是父亲的最后一个孩子，父亲的最大key不变，上面不用改
+  auto *parent = parent_guard->AsMut<InternalPage>();
   if (left) {
-    UpdateNode(bro);
+    parent->SetKeyAt(bro_index, bro->MaxKey());
   }else {
-    UpdateNode(node);
+    parent->SetKeyAt(idx, node->MaxKey());
   }
-  // 用不上就丢弃
-  UnpinPageNode(parent_page, true);
-  UnpinPageNode(bro, true);
-
   return true;
 
 }
@@ -406,89 +369,115 @@ auto BPLUSTREE_TYPE::BorrowBrother(PageNode * node, bool left) -> bool {
  */
 INDEX_TEMPLATE_ARGUMENTS
 template<class PageNode>
-auto BPLUSTREE_TYPE::FixInternalNode(PageNode *pn, const KeyType & deleted_key) -> void {
+auto BPLUSTREE_TYPE::FixInternalNode(std::vector<page_id_t> *path, const KeyType & deleted_key) -> void {
+  // 要修复的结点不是根，先锁父亲再锁自己
+  BUSTUB_ASSERT(path->size() >= 2, "a node to fix has a parent");
+  WritePageGuard parent_guard = buffer_pool_manager_->FetchPageWrite((*path)[path->size() - 2], tag_);
+  WritePageGuard node_guard = buffer_pool_manager_->FetchPageWrite(path->back(), tag_);
+  path->pop_back();
   // 4.如果是，看看左兄弟能不能借一个结点出来，如果左边兄弟也已经是最小值了
   //   那么就在尝试向右兄弟借一个结点出来
   // 4.1 如果能借，先把借出来的结点从原结点删掉，并且要级联更新父亲的key
-  bool success = BorrowBrother(pn, true) || BorrowBrother(pn, false);
+  bool success = BorrowBrother<PageNode>(&parent_guard, &node_guard, true) ||
+                 BorrowBrother<PageNode>(&parent_guard, &node_guard, false);
   // 如果借节点成功，直接将pn给删掉就行
   if (success) {
+    auto *pn = node_guard.AsMut<PageNode>();
     if (pn->Delete(deleted_key, nullptr, comparator_)) {
       // 删完之后更新父亲节点
-      UpdateNode(pn);
+      page_id_t parent_page_id = pn->GetParentPageId();
+      page_id_t pn_page_id = pn->GetPageId();
+      KeyType max_key = pn->MaxKey();
+      node_guard.Drop();
+      parent_guard.Drop();
+      UpdateNode(parent_page_id, pn_page_id, max_key);
     }
-    UnpinPageNode(pn, true);
     return;
   }
   // 如果不能借结点，那么就将pn与其兄弟融合
-  InternalPage * need_fix_page = Merge(pn, deleted_key);
   // 融合之后会可能会出现新的需要修复的结点，即上一层
-  if (need_fix_page) {
+  if (Merge<PageNode>(&parent_guard, &node_guard, deleted_key)) {
     // 继续修复....
-    FixInternalNode(need_fix_page, deleted_key);
+    FixInternalNode<InternalPage>(path, deleted_key);
   }
 }
 
 
 INDEX_TEMPLATE_ARGUMENTS
-template<class PageNode>
-void BPLUSTREE_TYPE::UpdateNode(PageNode *update_node) {
-
-  if (update_node->IsRootPage()) {
-    return;
-  }
-
-  BPlusTreePage * node = FetchPageNode<BPlusTreePage>(update_node->GetParentPageId());
-  
-  page_id_t last_page_id = update_node->GetPageId();
-  KeyType last_max_key = update_node->MaxKey();
-  while (node->GetPageId() != HEADER_PAGE_ID) {
-    InternalPage * internal_node = ToInternalPage(node);
+void BPLUSTREE_TYPE::UpdateNode(page_id_t parent_page_id, page_id_t page_id, KeyType max_key) {
+  UnpinBatch path(buffer_pool_manager_);
+  // 从下往上走，一次只锁一层，不会和从上往下的加锁顺序冲突
+  // 还没改到的祖先的key比孩子的最大key大，读者照着它往下找不会漏掉东西
+  while (parent_page_id != INVALID_PAGE_ID && parent_page_id != HEADER_PAGE_ID) {
+    WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(parent_page_id, tag_);
+    const auto *internal_node = guard.As<InternalPage>();
+    bool changed = false;
     for (int i = 0; i < internal_node->GetSize(); i++) {
-      if (internal_node->array_[i].second == last_page_id) {
-        internal_node->array_[i].first = last_max_key;
+      if (internal_node->ValueAt(i) == page_id && comparator_(internal_node->KeyAt(i), max_key) != 0) {
+        guard.AsMut<InternalPage>()->SetKeyAt(i, max_key);
+        changed = true;
       }
     }
-    page_id_t parent_page_id = node->GetParentPageId();
-    UnpinPageNode(node, true);
-    node = FetchPageNode<BPlusTreePage>(parent_page_id);
-    last_page_id = internal_node->GetPageId();
-    last_max_key = internal_node->MaxKey();
+    // 这一层没变，再往上也不会变
+    if (!changed) {
+      break;
+    }
+    parent_page_id = internal_node->GetParentPageId();
+    page_id = internal_node->GetPageId();
+    max_key = internal_node->MaxKey();
+    guard.Drop(&path);
   }
-  UnpinPageNode(node, true);
 
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::Remove(const KeyType &key, Transaction *transaction) {
-  // 1. 找到key所在的叶子节点
-  int idx;
-  // page_node不会为空，定位key所在的那个叶子节点
-  LeafPage *leaf_node = LocatePage(key, &idx);
-
-  // 如果所在的那个叶子节点为null，则说明没有这个key，直接返回
-  if (leaf_node == nullptr) {
+  std::scoped_lock lock(writer_latch_);
+  if (IsEmpty()) {
     return;
   }
+  // 1. 找到key所在的叶子节点，一路记下经过的页，修复的时候从下往上用
+  std::vector<page_id_t> path{root_page_id_};
+  int idx;
+  while (true) {
+    ReadPageGuard guard = buffer_pool_manager_->FetchPageRead(path.back(), nullptr, tag_);
+    if (guard.As<BPlusTreePage>()->IsLeafPage()) {
+      break;
+    }
+    // page_node不是叶子节点，所以page_node可以转化为中间结点
+    const auto *page_internal_node = guard.As<InternalPage>();
+    // 通过中间节点找到合适的叶子结点，然后循环再次判断
+    page_internal_node->BinarySearch(key, &idx, comparator_);
+    // 如果找不到下一层，则说明没有这个key，直接返回
+    if (idx >= page_internal_node->GetSize()) {
+      return;
+    }
+    path.push_back(page_internal_node->ValueAt(idx));
+  }
+  WritePageGuard leaf_guard = buffer_pool_manager_->FetchPageWrite(path.back(), tag_);
+  const auto *leaf_node = leaf_guard.As<LeafPage>();
   // 定位到指定叶子节点之后，开始搜索，如果搜索不到，则直接返回
   bool findable = leaf_node->BinarySearch(key, &idx, comparator_);
   if (!findable) {
-    UnpinPageNode(leaf_node, true);
     return;
   }
 
   // 判断删除之后，是否需要修复
   if (leaf_node->GetSize() - 1 >= leaf_node->GetMinSize() || leaf_node->IsRootPage()) {
     // 如果不需要，直接删除即可
-    if (leaf_node->Delete(key, nullptr, comparator_)) {
+    auto *leaf = leaf_guard.AsMut<LeafPage>();
+    if (leaf->Delete(key, nullptr, comparator_)) {
       //删除之后要向上更新节点
-      UpdateNode(leaf_node);
+      page_id_t parent_page_id = leaf->GetParentPageId();
+      KeyType max_key = leaf->MaxKey();
+      leaf_guard.Drop();
+      UpdateNode(parent_page_id, path.back(), max_key);
     }
-    UnpinPageNode(leaf_node, true);
     return;
   }
+  leaf_guard.Drop();
   // 开始修复结点
-  FixInternalNode(leaf_node, key);
+  FixInternalNode<LeafPage>(&path, key);
 
   return;
 
@@ -506,19 +495,19 @@ void BPLUSTREE_TYPE::Merge(PageNode * merge_s, PageNode * merge_b) {
     merge_b->array_[i] = merge_s->array_[i];
     if (!merge_b->IsLeafPage()) {
       InternalPage * bp = ToInternalPage(merge_b);
-      BPlusTreePage * page = FetchPageNode<BPlusTreePage>(bp->array_[i].second);
-      page->SetParentPageId(bp->GetPageId());
-      UnpinPageNode(page, true);
+      WritePageGuard child_guard = buffer_pool_manager_->FetchPageWrite(bp->array_[i].second, tag_);
+      child_guard.AsMut<BPlusTreePage>()->SetParentPageId(bp->GetPageId());
     }
   }
 }
 
 INDEX_TEMPLATE_ARGUMENTS
 template<class PageNode>
-auto BPLUSTREE_TYPE::Merge(PageNode * mergein, const KeyType & deleted_key) -> InternalPage*{
-    // 先找到待融合节点的父亲节点
-    page_id_t page_id = mergein->GetParentPageId();
-    InternalPage * mergein_parent = FetchPageNode<InternalPage>(page_id);
+auto BPLUSTREE_TYPE::Merge(WritePageGuard *parent_guard, WritePageGuard *node_guard,
+                           const KeyType & deleted_key) -> bool {
+    // 待融合节点和它的父亲节点都已经锁着了
+    auto *mergein = node_guard->AsMut<PageNode>();
+    auto *mergein_parent = parent_guard->AsMut<InternalPage>();
 
     // 然后搜索该节点在父亲节点中的下标
     int idx;
@@ -527,53 +516,59 @@ auto BPLUSTREE_TYPE::Merge(PageNode * mergein, const KeyType & deleted_key) -> I
     // 然后判断父亲节点是不是根节点
     if (mergein_parent->IsRootPage() && mergein_parent->GetSize()==1) {
       // 如果是根节点就好办了，就删除根节点，用这个叶子节点代替根节点
-      buffer_pool_manager_->DeletePage(root_page_id_);
+      page_id_t old_root_page_id = parent_guard->PageId();
       mergein->SetParentPageId(HEADER_PAGE_ID);
       root_page_id_ = mergein->GetPageId();
       UpdateRootPageId();
+      parent_guard->Drop();
+      buffer_pool_manager_->DeletePage(old_root_page_id);
 
       //然后将key给删掉
       mergein->Delete(deleted_key, nullptr, comparator_);
       if (mergein->GetSize()==0) {
         // 如果删除之后叶子节点已经没有数据了，直接将根节点设置为NULL
-        UnpinPageNode(mergein, true);
-        buffer_pool_manager_->DeletePage(mergein->GetPageId());
+        page_id_t mergein_page_id = mergein->GetPageId();
         root_page_id_ = INVALID_PAGE_ID;
         UpdateRootPageId();
-      } else {
-        UpdateNode(mergein);
-        UnpinPageNode(mergein, true);
+        node_guard->Drop();
+        buffer_pool_manager_->DeletePage(mergein_page_id);
       }
-      
-    }else if(idx==0) {
+      node_guard->Drop();
+      return false;
+    }
+
+    // 融合之后要删掉的那张页，因为数据已经融合到另外一页去了，以及留下来的那一页
+    page_id_t merged_page_id;
+    page_id_t kept_page_id;
+    KeyType kept_max_key;
+    if(idx==0) {
       // 如果，merginin在是父亲节点中最小的，那么就只能向右融合了
-      PageNode* right_node = FetchPageNode<PageNode>(mergein_parent->ValueAt(idx+1));
+      WritePageGuard right_guard = buffer_pool_manager_->FetchPageWrite(mergein_parent->ValueAt(idx+1), tag_);
+      auto *right_node = right_guard.AsMut<PageNode>();
       // 然后将两个节点融合即可
       Merge(mergein, right_node);
       // 如果mergin是叶子节点，我们还需更新叶子节点中的指针
       if (mergein->IsLeafPage()) {
         LeafPage *next = ToLeafPage(mergein);
         if (next->GetPrePageId()!=INVALID_PAGE_ID) {
-          LeafPage *pre = FetchPageNode<LeafPage>(next->GetPrePageId());
-          pre->SetNextPageId(right_node->GetPageId());
-          UnpinPageNode(pre, true);
+          WritePageGuard pre_guard = buffer_pool_manager_->FetchPageWrite(next->GetPrePageId(), tag_);
+          pre_guard.AsMut<LeafPage>()->SetNextPageId(right_node->GetPageId());
         }
         LeafPage *mergein_right_node = ToLeafPage(right_node);
         mergein_right_node->SetPrePageId(next->GetPrePageId());
       }
       // 然后将key删除
       mergein_parent->Delete(mergein->MaxKey(), nullptr, comparator_);
-      UnpinPageNode(mergein, true);
-      // 删除融合的那张页，因为数据已经融合到另外一页去了
-      buffer_pool_manager_->DeletePage(mergein->GetPageId());
+      merged_page_id = mergein->GetPageId();
 
       // 然后将key从节点中删掉
       right_node->Delete(deleted_key, nullptr, comparator_);
-      UpdateNode(right_node);
-      UnpinPageNode(right_node, true);
+      kept_page_id = right_node->GetPageId();
+      kept_max_key = right_node->MaxKey();
     }else{
       // 向左融合，优先向左边融合
-      PageNode* left_node = FetchPageNode<PageNode>(mergein_parent->ValueAt(idx-1));
+      WritePageGuard left_guard = buffer_pool_manager_->FetchPageWrite(mergein_parent->ValueAt(idx-1), tag_);
+      auto *left_node = left_guard.AsMut<PageNode>();
       
       Merge(left_node, mergein);
 
@@ -581,9 +576,8 @@ auto BPLUSTREE_TYPE::Merge(PageNode * mergein, const KeyType & deleted_key) -> I
       if (mergein->IsLeafPage()) {
         LeafPage *next = ToLeafPage(left_node);
         if (next->GetPrePageId()!=INVALID_PAGE_ID) {
-          LeafPage *pre = FetchPageNode<LeafPage>(next->GetPrePageId());
-          pre->SetNextPageId(mergein->GetPageId());
-          UnpinPageNode(pre, true);
+          WritePageGuard pre_guard = buffer_pool_manager_->FetchPageWrite(next->GetPrePageId(), tag_);
+          pre_guard.AsMut<LeafPage>()->SetNextPageId(mergein->GetPageId());
         }
 
         LeafPage *mergein_leaf = ToLeafPage(mergein);
@@ -592,20 +586,21 @@ auto BPLUSTREE_TYPE::Merge(PageNode * mergein, const KeyType & deleted_key) -> I
 
       // 逻辑同上...
       mergein_parent->Delete(left_node->MaxKey(), nullptr, comparator_);
-      
-      UnpinPageNode(left_node, true);
-      buffer_pool_manager_->DeletePage(left_node->GetPageId());
+      merged_page_id = left_node->GetPageId();
 
       mergein->Delete(deleted_key, nullptr, comparator_);
-      UpdateNode(mergein);
-      UnpinPageNode(mergein, true);
+      kept_page_id = mergein->GetPageId();
+      kept_max_key = mergein->MaxKey();
     }
 
-    if (mergein_parent->GetSize()>= mergein_parent->GetMinSize()) {
-      UnpinPageNode(mergein_parent, true);
-      return nullptr;
-    }
-    return mergein_parent;
+    // 放掉这一层的锁再删页、往上更新key
+    page_id_t parent_page_id = parent_guard->PageId();
+    bool need_fix = mergein_parent->GetSize() < mergein_parent->GetMinSize();
+    node_guard->Drop();
+    parent_guard->Drop();
+    buffer_pool_manager_->DeletePage(merged_page_id);
+    UpdateNode(parent_page_id, kept_page_id, kept_max_key);
+    return need_fix;
 }
 
 /*****************************************************************************
@@ -622,19 +617,19 @@ auto BPLUSTREE_TYPE::Begin() -> INDEXITERATOR_TYPE {
       return End();
   }
   // page_node不会为空
-  BPlusTreePage * node = FetchPageNode<BPlusTreePage>(root_page_id_);
-  while (!node->IsLeafPage()) {
-    // page_node不是叶子节点，所以page_node可以转化为中间结点
-    InternalPage *page_internal_node = ToInternalPage(node);
-    // 通过中间节点找到合适的叶子结点，然后循环再次判断
-    page_id_t page_id = page_internal_node->ValueAt(0);
-    UnpinPageNode(page_internal_node,false);
-    node = FetchPageNode<InternalPage>(page_id);
+  UnpinBatch path(buffer_pool_manager_);
+  ReadPageGuard guard = LatchRootRead();
+  if (!guard.IsValid()) {
+    return End();
+  }
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    // 一直往最左边的孩子走
+    ReadPageGuard child = buffer_pool_manager_->FetchPageRead(guard.As<InternalPage>()->ValueAt(0), nullptr, tag_);
+    guard.Drop(&path);
+    guard = std::move(child);
   }
   // 如果是叶子结点，那我们就可以搜索值了
-  page_id_t first_leafpage_id = node->GetPageId();
-  UnpinPageNode(node,false);
-  return INDEXITERATOR_TYPE(buffer_pool_manager_, first_leafpage_id, 0);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, guard.PageId(), 0, tag_);
 }
 
 /*
@@ -649,10 +644,24 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
   }
   // page_node不会为空
   int cursor = 0;
-  LeafPage *leaf_node = LocatePage(key, &cursor);
-  leaf_node->BinarySearch(key, &cursor, comparator_);
-  UnpinPageNode(leaf_node,false);
-  return INDEXITERATOR_TYPE(buffer_pool_manager_, leaf_node->GetPageId(), cursor);
+  UnpinBatch path(buffer_pool_manager_);
+  ReadPageGuard guard = LatchRootRead();
+  if (!guard.IsValid()) {
+    return End();
+  }
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    const auto *page_internal_node = guard.As<InternalPage>();
+    page_internal_node->BinarySearch(key, &cursor, comparator_);
+    if (cursor >= page_internal_node->GetSize()) {
+      // key比树里所有的key都大
+      return End();
+    }
+    ReadPageGuard child = buffer_pool_manager_->FetchPageRead(page_internal_node->ValueAt(cursor), nullptr, tag_);
+    guard.Drop(&path);
+    guard = std::move(child);
+  }
+  guard.As<LeafPage>()->BinarySearch(key, &cursor, comparator_);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, guard.PageId(), cursor, tag_);
 }
 
 /*
@@ -663,21 +672,22 @@ auto BPLUSTREE_TYPE::Begin(const KeyType &key) -> INDEXITERATOR_TYPE {
 INDEX_TEMPLATE_ARGUMENTS
 auto BPLUSTREE_TYPE::End() -> INDEXITERATOR_TYPE { 
   if(root_page_id_==INVALID_PAGE_ID) {
-      return INDEXITERATOR_TYPE(buffer_pool_manager_, INVALID_PAGE_ID, -1);
+      return INDEXITERATOR_TYPE(buffer_pool_manager_, INVALID_PAGE_ID, -1, tag_);
   }
-  BPlusTreePage * node = FetchPageNode<BPlusTreePage>(root_page_id_);
-  while (!node->IsLeafPage()) {
-    // page_node不是叶子节点，所以page_node可以转化为中间结点
-    InternalPage *page_internal_node = ToInternalPage(node);
-    // 通过中间节点找到合适的叶子结点，然后循环再次判断
+  UnpinBatch path(buffer_pool_manager_);
+  ReadPageGuard guard = LatchRootRead();
+  if (!guard.IsValid()) {
+    return INDEXITERATOR_TYPE(buffer_pool_manager_, INVALID_PAGE_ID, -1, tag_);
+  }
+  while (!guard.As<BPlusTreePage>()->IsLeafPage()) {
+    // 一直往最右边的孩子走
+    const auto *page_internal_node = guard.As<InternalPage>();
     page_id_t page_id = page_internal_node->ValueAt(page_internal_node->GetSize()-1);
-    UnpinPageNode(page_internal_node,false);
-    node = FetchPageNode<InternalPage>(page_id);
+    ReadPageGuard child = buffer_pool_manager_->FetchPageRead(page_id, nullptr, tag_);
+    guard.Drop(&path);
+    guard = std::move(child);
   }
-  page_id_t first_leafpage_id = node->GetPageId();
-  int cursuor = node->GetSize();
-  UnpinPageNode(node,false);
-  return INDEXITERATOR_TYPE(buffer_pool_manager_, first_leafpage_id, cursuor);
+  return INDEXITERATOR_TYPE(buffer_pool_manager_, guard.PageId(), guard.As<BPlusTreePage>()->GetSize(), tag_);
 }
 
 /**
@@ -699,7 +709,8 @@ auto BPLUSTREE_TYPE::GetRootPageId() -> page_id_t { return root_page_id_; }
  */
 INDEX_TEMPLATE_ARGUMENTS
 void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
-  auto *header_page = static_cast<HeaderPage *>(buffer_pool_manager_->FetchPage(HEADER_PAGE_ID));
+  WritePageGuard guard = buffer_pool_manager_->FetchPageWrite(HEADER_PAGE_ID, tag_);
+  auto *header_page = static_cast<HeaderPage *>(guard.GetPage());
   if (insert_record != 0) {
     // create a new record<index_name + root_page_id> in header_page
     header_page->InsertRecord(index_name_, root_page_id_);
@@ -707,7 +718,7 @@ void BPLUSTREE_TYPE::UpdateRootPageId(int insert_record) {
     // update root_page_id in header_page
     header_page->UpdateRecord(index_name_, root_page_id_);
   }
-  buffer_pool_manager_->UnpinPage(HEADER_PAGE_ID, true);
+  guard.SetDirty();
 }
 
 /*
@@ -902,10 +913,6 @@ INDEX_TEMPLATE_ARGUMENTS
 template <typename T>
 auto BPLUSTREE_TYPE::ToInternalPage(T *page_data) -> InternalPage * { return reinterpret_cast<InternalPage *>(page_data); }
 
-INDEX_TEMPLATE_ARGUMENTS
-template <typename T>
-auto BPLUSTREE_TYPE::ToGeneralPage(T *page_data) -> BPlusTreePage * { return reinterpret_cast<BPlusTreePage *>(page_data); }
-
 
 INDEX_TEMPLATE_ARGUMENTS
 template <typename T>
@@ -13,12 +13,15 @@ INDEXITERATOR_TYPE::IndexIterator() {
 }
 
 INDEX_TEMPLATE_ARGUMENTS
-INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, page_id_t page_id, int start_index): bpm_(bpm), cursor_(start_index) {
+INDEXITERATOR_TYPE::IndexIterator(BufferPoolManager *bpm, page_id_t page_id, int start_index, BufferPoolTag tag)
+    : bpm_(bpm), cursor_(start_index), tag_(tag) {
     if (page_id==INVALID_PAGE_ID) {
         cursor_ = -1;
     }else{
-        Page* page_data = bpm->FetchPage(page_id);
+        Page* page_data = bpm->FetchPage(page_id, tag);
         page_ = reinterpret_cast<LeafPage*>(page_data->GetData());
+        // 预读后续的叶子页
+        bpm_->Prefetch(page_->GetNextPageId(), SCAN_PREFETCH_PAGE_CNT);
     }
 }
 
@@ -60,8 +63,9 @@ auto INDEXITERATOR_TYPE::operator++() -> INDEXITERATOR_TYPE & {
     }
     page_id_t next_page_id = page_->GetNextPageId();
     bpm_->UnpinPage(page_->GetPageId(), false);
-    Page* page_data = bpm_->FetchPage(next_page_id);
+    Page* page_data = bpm_->FetchPage(next_page_id, tag_);
     page_ = reinterpret_cast<LeafPage*>(page_data->GetData());
+    bpm_->Prefetch(page_->GetNextPageId(), SCAN_PREFETCH_PAGE_CNT);
     cursor_ = 0;
     return *this;
 }
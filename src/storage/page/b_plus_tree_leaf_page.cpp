@@ -158,7 +158,8 @@ auto B_PLUS_TREE_LEAF_PAGE_TYPE::Delete(const KeyType & key, ValueType * value,
 
 
 INDEX_TEMPLATE_ARGUMENTS
-auto B_PLUS_TREE_LEAF_PAGE_TYPE::Get(const KeyType & key, KeyComparator & cmp, std::vector<ValueType> *result) -> void{
+auto B_PLUS_TREE_LEAF_PAGE_TYPE::Get(const KeyType & key, KeyComparator & cmp,
+                                     std::vector<ValueType> *result) const -> void{
   int idx;
   bool findable = BinarySearch(key, &idx, cmp);
   if (findable) {
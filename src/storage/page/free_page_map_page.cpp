@@ -0,0 +1,44 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// free_page_map_page.cpp
+//
+// Identification: src/storage/page/free_page_map_page.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/free_page_map_page.h"
+
+#include "common/macros.h"
+
+namespace bustub {
+
+void FreePageMapPage::Init(page_id_t page_id, page_id_t next_page_id) {
+  page_id_ = page_id;
+  lsn_ = INVALID_LSN;
+  next_page_id_ = next_page_id;
+  size_ = 0;
+}
+
+auto FreePageMapPage::GetPageId() const -> page_id_t { return page_id_; }
+
+auto FreePageMapPage::GetNextPageId() const -> page_id_t { return next_page_id_; }
+
+auto FreePageMapPage::GetSize() const -> size_t { return size_; }
+
+auto FreePageMapPage::IsFull() const -> bool { return size_ >= CAPACITY; }
+
+auto FreePageMapPage::FreePageIdAt(size_t index) const -> page_id_t {
+  BUSTUB_ASSERT(index < size_, "index out of range");
+  return free_page_ids_[index];
+}
+
+void FreePageMapPage::Append(page_id_t page_id) {
+  BUSTUB_ASSERT(!IsFull(), "free page map page is full");
+  free_page_ids_[size_++] = page_id;
+}
+
+}  // namespace bustub
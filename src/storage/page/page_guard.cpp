@@ -0,0 +1,147 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard.cpp
+//
+// Identification: src/storage/page/page_guard.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/page_guard.h"
+
+#include <utility>
+
+#include "buffer/buffer_pool_manager.h"
+#include "common/macros.h"
+
+namespace bustub {
+
+BasicPageGuard::BasicPageGuard(BasicPageGuard &&that) noexcept
+    : bpm_(that.bpm_), page_(that.page_), is_dirty_(that.is_dirty_) {
+  that.bpm_ = nullptr;
+  that.page_ = nullptr;
+  that.is_dirty_ = false;
+}
+
+auto BasicPageGuard::operator=(BasicPageGuard &&that) noexcept -> BasicPageGuard & {
+  if (this != &that) {
+    Drop();
+    bpm_ = that.bpm_;
+    page_ = that.page_;
+    is_dirty_ = that.is_dirty_;
+    that.bpm_ = nullptr;
+    that.page_ = nullptr;
+    that.is_dirty_ = false;
+  }
+  return *this;
+}
+
+void BasicPageGuard::Drop() {
+  if (page_ == nullptr) {
+    return;
+  }
+  bpm_->UnpinPage(page_->GetPageId(), is_dirty_);
+  bpm_ = nullptr;
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+void BasicPageGuard::Drop(UnpinBatch *batch) {
+  if (page_ == nullptr) {
+    return;
+  }
+  BUSTUB_ASSERT(batch->GetBufferPoolManager() == bpm_, "the batch belongs to another buffer pool");
+  batch->Add(page_->GetPageId(), is_dirty_);
+  bpm_ = nullptr;
+  page_ = nullptr;
+  is_dirty_ = false;
+}
+
+BasicPageGuard::~BasicPageGuard() { Drop(); }
+
+auto ReadPageGuard::operator=(ReadPageGuard &&that) noexcept -> ReadPageGuard & {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void ReadPageGuard::Drop() {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->RUnlatch();
+  }
+  guard_.Drop();
+}
+
+void ReadPageGuard::Drop(UnpinBatch *batch) {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->RUnlatch();
+  }
+  guard_.Drop(batch);
+}
+
+ReadPageGuard::~ReadPageGuard() { Drop(); }
+
+auto WritePageGuard::operator=(WritePageGuard &&that) noexcept -> WritePageGuard & {
+  if (this != &that) {
+    Drop();
+    guard_ = std::move(that.guard_);
+  }
+  return *this;
+}
+
+void WritePageGuard::Drop() {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->WUnlatch();
+  }
+  guard_.Drop();
+}
+
+void WritePageGuard::Drop(UnpinBatch *batch) {
+  if (guard_.page_ != nullptr) {
+    guard_.page_->WUnlatch();
+  }
+  guard_.Drop(batch);
+}
+
+WritePageGuard::~WritePageGuard() { Drop(); }
+
+auto OptimisticPageGuard::UpgradeRead() -> ReadPageGuard {
+  Page *page = guard_.page_;
+  page->RLatch();
+  if (!page->ValidateOptimistic(version_)) {
+    page->RUnlatch();
+    return {};
+  }
+  ReadPageGuard read_guard;
+  read_guard.guard_ = std::move(guard_);
+  return read_guard;
+}
+
+UnpinBatch::UnpinBatch(BufferPoolManager *bpm, size_t capacity) : bpm_(bpm), capacity_(capacity) {
+  BUSTUB_ASSERT(capacity > 0, "an unpin batch must hold at least one page");
+  pages_.reserve(capacity);
+}
+
+UnpinBatch::~UnpinBatch() { Release(); }
+
+void UnpinBatch::Add(page_id_t page_id, bool is_dirty) {
+  pages_.emplace_back(page_id, is_dirty);
+  if (pages_.size() >= capacity_) {
+    Release();
+  }
+}
+
+void UnpinBatch::Release() {
+  if (pages_.empty()) {
+    return;
+  }
+  bpm_->UnpinPages(pages_);
+  pages_.clear();
+}
+
+}  // namespace bustub
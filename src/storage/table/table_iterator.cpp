@@ -11,6 +11,7 @@
 //===----------------------------------------------------------------------===//
 
 #include <cassert>
+#include <utility>
 
 #include "common/exception.h"
 #include "concurrency/transaction.h"
@@ -18,8 +19,8 @@
 
 namespace bustub {
 
-TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn)
-    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn) {
+TableIterator::TableIterator(TableHeap *table_heap, RID rid, Transaction *txn, BufferAccessStrategy *strategy)
+    : table_heap_(table_heap), tuple_(new Tuple(rid)), txn_(txn), strategy_(strategy) {
   if (rid.GetPageId() != INVALID_PAGE_ID) {
      if (!table_heap_->GetTuple(tuple_->rid_, tuple_, txn_)) {
       throw bustub::Exception("read non-existing tuple");
@@ -41,19 +42,26 @@ auto TableIterator::operator++() -> TableIterator & {
   // 首先获取bpm
   BufferPoolManager *buffer_pool_manager = table_heap_->buffer_pool_manager_;
   // 从bpm获取数据页
-  auto cur_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(tuple_->rid_.GetPageId()));
-  BUSTUB_ENSURE(cur_page != nullptr, "BPM full");  // all pages are pinned
+  auto cur_guard = buffer_pool_manager->FetchPageRead(tuple_->rid_.GetPageId(), nullptr, table_heap_->tag_);
+  BUSTUB_ENSURE(cur_guard.IsValid(), "BPM full");  // all pages are pinned
+  // 跳过的空页立即解锁，批量unpin
+  UnpinBatch empty_pages(buffer_pool_manager);
 
-  cur_page->RLatch();
+  auto cur_page = static_cast<TablePage *>(cur_guard.GetPage());
   RID next_tuple_rid;
   if (!cur_page->GetNextTupleRid(tuple_->rid_,
                                  &next_tuple_rid)) {  // end of this page
     while (cur_page->GetNextPageId() != INVALID_PAGE_ID) {
-      auto next_page = static_cast<TablePage *>(buffer_pool_manager->FetchPage(cur_page->GetNextPageId()));
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
-      cur_page = next_page;
-      cur_page->RLatch();
+      auto next_guard = buffer_pool_manager->FetchPageRead(cur_page->GetNextPageId(), strategy_, table_heap_->tag_);
+      BUSTUB_ENSURE(next_guard.IsValid(), "BPM full");
+      cur_guard.Drop(&empty_pages);
+      cur_guard = std::move(next_guard);
+      cur_page = static_cast<TablePage *>(cur_guard.GetPage());
+      // Moved on to a new page: keep the next SCAN_PREFETCH_PAGE_CNT pages of the chain loading in the background.
+      // A ring scan skips this, read-ahead would load its pages into the main pool.
+      if (strategy_ == nullptr) {
+        buffer_pool_manager->Prefetch(cur_page->GetNextPageId(), SCAN_PREFETCH_PAGE_CNT);
+      }
       if (cur_page->GetFirstTupleRid(&next_tuple_rid)) {
         break;
       }
@@ -65,14 +73,10 @@ auto TableIterator::operator++() -> TableIterator & {
     // DO NOT ACQUIRE READ LOCK twice in a single thread otherwise it may deadlock.
     // See https://users.rust-lang.org/t/how-bad-is-the-potential-deadlock-mentioned-in-rwlocks-document/67234
     if (!table_heap_->GetTuple(tuple_->rid_, tuple_, txn_, false)) {
-      cur_page->RUnlatch();
-      buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
       throw bustub::Exception("read non-existing tuple");
     }
   }
-  // release until copy the tuple
-  cur_page->RUnlatch();
-  buffer_pool_manager->UnpinPage(cur_page->GetTablePageId(), false);
+  // release until copy the tuple (cur_guard)
   return *this;
 }
 
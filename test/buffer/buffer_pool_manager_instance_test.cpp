@@ -12,15 +12,48 @@
 
 #include "buffer/buffer_pool_manager_instance.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>  // NOLINT
 #include <cstdio>
+#include <filesystem>
+#include <memory>
 #include <random>
 #include <string>
+#include <thread>  // NOLINT
+#include <vector>
 
 #include "buffer/buffer_pool_manager.h"
+#include "buffer/compressed_page_cache.h"
+#include "buffer/extent_allocator.h"
+#include "buffer/free_page_map.h"
+#include "buffer/pool_snapshot.h"
+#include "buffer/replacer.h"
+#include "fmt/core.h"
 #include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/page/free_page_map_page.h"
 
 namespace bustub {
 
+/** An in-memory disk whose reads take a while, so that tests can observe what happens while a read is in flight. */
+class SlowDiskManager : public DiskManagerUnlimitedMemory {
+ public:
+  explicit SlowDiskManager(std::chrono::milliseconds read_delay = std::chrono::milliseconds(200))
+      : read_delay_(read_delay) {}
+
+  auto ReadPage(page_id_t page_id, char *page_data) -> bool override {
+    read_cnt_++;
+    std::this_thread::sleep_for(read_delay_);
+    return DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  std::atomic<int> read_cnt_{0};
+
+ private:
+  std::chrono::milliseconds read_delay_;
+};
+
 // NOLINTNEXTLINE
 // Check whether pages containing terminal characters can be recovered
 TEST(BufferPoolManagerInstanceTest, ENABLE_BinaryDataTest) {
@@ -233,4 +266,801 @@ TEST(BufferPoolManagerInstanceTest, ENABLED_SampleTest) {
   delete disk_manager;
 }
 
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ConcurrentMissTest) {
+  const size_t buffer_pool_size = 2;
+  auto *disk_manager = new SlowDiskManager();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t cold_page;
+  page_id_t hot_page;
+  page_id_t temp_page;
+  snprintf(bpm->NewPage(&cold_page)->GetData(), BUSTUB_PAGE_SIZE, "cold");
+  bpm->UnpinPage(cold_page, true);
+  bpm->NewPage(&hot_page);
+  bpm->UnpinPage(hot_page, true);
+  // Evict the cold page, then keep the hot page resident and pinned.
+  ASSERT_NE(nullptr, bpm->NewPage(&temp_page));
+  ASSERT_NE(nullptr, bpm->FetchPage(hot_page));
+  bpm->UnpinPage(temp_page, false);
+  ASSERT_EQ(0, disk_manager->read_cnt_);
+
+  // Scenario: every thread misses on the same page, only one of them reads it from disk.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([&] {
+      auto *page = bpm->FetchPage(cold_page);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(0, strcmp(page->GetData(), "cold"));
+    });
+  }
+
+  // Scenario: a hit on a resident page does not wait for the read in flight.
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_NE(nullptr, bpm->FetchPage(hot_page));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(100));
+
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, disk_manager->read_cnt_);
+  for (int i = 0; i < 4; i++) {
+    EXPECT_TRUE(bpm->UnpinPage(cold_page, false));
+  }
+  EXPECT_FALSE(bpm->UnpinPage(cold_page, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, BackgroundWriterTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  page_id_t page_ids[buffer_pool_size];
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // Scenario: the writer cleans the 4 coldest frames, at most 2 pages per round.
+  BackgroundWriterOptions options;
+  options.clean_frame_target_ = 4;
+  options.max_writes_per_round_ = 2;
+  EXPECT_EQ(2, bpm->BackgroundWriteRound(options));
+  EXPECT_EQ(2, bpm->BackgroundWriteRound(options));
+  EXPECT_EQ(0, bpm->BackgroundWriteRound(options));
+  EXPECT_EQ(4, bpm->GetBackgroundWriteCount());
+
+  // Scenario: evicting the cleaned frames costs no foreground write, the next victim is still dirty.
+  page_id_t page_id_temp;
+  for (int i = 0; i < 4; i++) {
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+  EXPECT_EQ(0, bpm->GetForegroundWriteCount());
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  EXPECT_EQ(1, bpm->GetForegroundWriteCount());
+
+  // Scenario: the written pages can be read back (this miss evicts dirty page 5).
+  for (int i = 0; i < 5; i++) {
+    bpm->UnpinPage(page_ids[i] + 10, false);
+  }
+  auto *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(std::to_string(page_ids[0]), std::string(page->GetData()));
+  bpm->UnpinPage(page_ids[0], false);
+  EXPECT_EQ(2, bpm->GetForegroundWriteCount());
+
+  // Scenario: the writer thread cleans the remaining dirty pages {6, 7, 8, 9} in the background.
+  options.clean_frame_target_ = buffer_pool_size;
+  options.interval_ = std::chrono::milliseconds(1);
+  bpm->StartBackgroundWriter(options);
+  for (int i = 0; i < 5000 && bpm->GetBackgroundWriteCount() < 8; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  bpm->StopBackgroundWriter();
+  EXPECT_EQ(8, bpm->GetBackgroundWriteCount());
+  EXPECT_EQ(0, bpm->BackgroundWriteRound(options));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, PrefetchTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new SlowDiskManager(std::chrono::milliseconds(1));
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Pages 0-9 end up on disk only, pages 10-19 are resident.
+  for (size_t i = 0; i < buffer_pool_size * 2; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+
+  // Scenario: the hint loads pages 0-4 in the background; pages that were never allocated are ignored.
+  bpm->Prefetch(0, 5);
+  bpm->Prefetch(100, 5);
+  for (int i = 0; i < 5000 && bpm->GetPrefetchCount() < 5; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  ASSERT_EQ(5, bpm->GetPrefetchCount());
+  ASSERT_EQ(5, disk_manager->read_cnt_);
+
+  // Scenario: fetching the prefetched pages does not touch the disk again.
+  for (page_id_t page_id = 0; page_id < 5; page_id++) {
+    auto *page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+    EXPECT_EQ(1, page->GetPinCount());
+    bpm->UnpinPage(page_id, false);
+  }
+  EXPECT_EQ(5, disk_manager->read_cnt_);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, RingStrategyTest) {
+  const size_t buffer_pool_size = 10;
+  auto *disk_manager = new SlowDiskManager(std::chrono::milliseconds(1));
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // Pages 0-9 end up on disk only, pages 10-19 are resident and 10, 11 are hot.
+  for (size_t i = 0; i < buffer_pool_size * 2; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    bpm->UnpinPage(page_id, true);
+  }
+  for (int i = 0; i < 3; i++) {
+    for (page_id_t page_id : {10, 11}) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+  }
+  const int reads_before_scan = disk_manager->read_cnt_;
+
+  {
+    // Scenario: a scan over pages 0-9 through a ring of 2 frames only ever takes 2 frames from the pool.
+    BufferAccessStrategy strategy(bpm, 2);
+    for (page_id_t page_id = 0; page_id < 10; page_id++) {
+      auto *page = bpm->FetchPageWithStrategy(page_id, &strategy);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+      if (page_id == 3) {
+        snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "scan");
+      }
+      bpm->UnpinPage(page_id, page_id == 3);
+    }
+    EXPECT_EQ(reads_before_scan + 10, disk_manager->read_cnt_);
+
+    // Scenario: the ring took the two coldest frames (pages 12 and 13), the hot pages and the rest survived the scan.
+    for (page_id_t page_id : {10, 11, 14, 15, 16, 17, 18, 19}) {
+      ASSERT_NE(nullptr, bpm->FetchPage(page_id));
+      bpm->UnpinPage(page_id, false);
+    }
+    EXPECT_EQ(reads_before_scan + 10, disk_manager->read_cnt_);
+  }
+
+  // Scenario: the page dirtied through the ring was written back when its frame was recycled.
+  auto *page = bpm->FetchPage(3);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ("scan", std::string(page->GetData()));
+  bpm->UnpinPage(3, false);
+
+  // Scenario: the ring frames were handed back, so every frame can be pinned again.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    page_ids.push_back(page_id);
+  }
+  for (auto page_id : page_ids) {
+    bpm->UnpinPage(page_id, false);
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, EveryReplacerTest) {
+  const size_t buffer_pool_size = 8;
+  for (auto type : {ReplacerType::LRU_K, ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::ARC,
+                    ReplacerType::TWO_QUEUE, ReplacerType::CLOCK_PRO}) {
+    SCOPED_TRACE(ReplacerTypeToString(type));
+    auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+    auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), LRUK_REPLACER_K,
+                                                           nullptr, type);
+
+    // Write 3x more pages than fit, keeping page 0 pinned all along so it can never be evicted.
+    page_id_t page_id;
+    auto *pinned = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, pinned);
+    snprintf(pinned->GetData(), BUSTUB_PAGE_SIZE, "pinned");
+    const int page_cnt = 3 * buffer_pool_size;
+    for (int i = 1; i < page_cnt; i++) {
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      ASSERT_EQ(i, page_id);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+
+    // Read them back a few times in a skewed order; every fetch must see the data written.
+    for (int round = 0; round < 3; round++) {
+      for (int i = 1; i < page_cnt; i += 1 + round) {
+        auto *page = bpm->FetchPage(i);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(fmt::format("page {}", i), std::string(page->GetData()));
+        ASSERT_TRUE(bpm->UnpinPage(i, false));
+      }
+    }
+    EXPECT_EQ(0, strcmp(pinned->GetData(), "pinned"));
+
+    // With all other frames pinned, nothing can be evicted.
+    std::vector<page_id_t> held;
+    for (int i = 1; i < static_cast<int>(buffer_pool_size); i++) {
+      ASSERT_NE(nullptr, bpm->FetchPage(i));
+      held.push_back(i);
+    }
+    EXPECT_EQ(nullptr, bpm->FetchPage(page_cnt - 1));
+    for (auto held_page_id : held) {
+      ASSERT_TRUE(bpm->UnpinPage(held_page_id, false));
+    }
+    ASSERT_NE(nullptr, bpm->FetchPage(page_cnt - 1));
+    ASSERT_TRUE(bpm->UnpinPage(page_cnt - 1, false));
+    ASSERT_TRUE(bpm->UnpinPage(0, true));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeTest) {
+  const size_t buffer_pool_size = 8;
+  const int page_cnt = 40;
+  for (auto type : {ReplacerType::LRU_K, ReplacerType::LRU, ReplacerType::CLOCK, ReplacerType::ARC,
+                    ReplacerType::TWO_QUEUE, ReplacerType::CLOCK_PRO}) {
+    SCOPED_TRACE(ReplacerTypeToString(type));
+    auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+    auto bpm = std::make_unique<BufferPoolManagerInstance>(buffer_pool_size, disk_manager.get(), LRUK_REPLACER_K,
+                                                           nullptr, type);
+    for (int i = 0; i < page_cnt; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    }
+
+    // Readers keep fetching and dirtying pages while the pool grows and shrinks under them.
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&, t] {
+        std::mt19937 gen(t);
+        while (!stop) {
+          const page_id_t page_id = static_cast<page_id_t>(gen() % page_cnt);
+          auto *page = bpm->FetchPage(page_id);
+          if (page == nullptr) {
+            continue;
+          }
+          EXPECT_EQ(fmt::format("page {}", page_id), std::string(page->GetData()));
+          bpm->UnpinPage(page_id, t % 2 == 0);
+        }
+      });
+    }
+    for (size_t new_size : {32, 4, 16, 2, 24, 8}) {
+      bpm->Resize(new_size);
+      EXPECT_EQ(new_size, bpm->GetPoolSize());
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    stop = true;
+    for (auto &thread : threads) {
+      thread.join();
+    }
+
+    // Nothing was lost, and frames of the chunks added by Resize are page aligned like the first ones.
+    for (int i = 0; i < page_cnt; i++) {
+      auto *page = bpm->FetchPage(i);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(fmt::format("page {}", i), std::string(page->GetData()));
+      EXPECT_EQ(0U, reinterpret_cast<uintptr_t>(page->GetData()) % BUSTUB_PAGE_SIZE);
+      ASSERT_TRUE(bpm->UnpinPage(i, false));
+    }
+    // Exactly buffer_pool_size frames are in use.
+    for (int i = 0; i < static_cast<int>(buffer_pool_size); i++) {
+      ASSERT_NE(nullptr, bpm->FetchPage(i));
+    }
+    EXPECT_EQ(nullptr, bpm->FetchPage(page_cnt - 1));
+    for (int i = 0; i < static_cast<int>(buffer_pool_size); i++) {
+      ASSERT_TRUE(bpm->UnpinPage(i, false));
+    }
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ResizeWaitsForPinTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(4, disk_manager.get());
+  page_id_t page_ids[4];
+  for (auto &page_id : page_ids) {
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+  }
+  // the free list hands out the last frame first, so page 0 sits in frame 3
+  ASSERT_EQ(page_ids[0], bpm->GetFrame(3)->GetPageId());
+  for (int i = 1; i < 4; i++) {
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], true));
+  }
+
+  std::atomic<bool> resized{false};
+  std::thread resizer([&] {
+    bpm->Resize(2);
+    resized = true;
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+  EXPECT_FALSE(resized);
+  // the retiring frame still serves its page
+  auto *page = bpm->FetchPage(page_ids[0]);
+  ASSERT_NE(nullptr, page);
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[0], false));
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[0], true));
+  resizer.join();
+  EXPECT_TRUE(resized);
+  EXPECT_EQ(2, bpm->GetPoolSize());
+
+  for (auto page_id : page_ids) {
+    page = bpm->FetchPage(page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(fmt::format("page {}", page_id), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, WarmRestartTest) {
+  const std::string snapshot_file = "warm_restart_test.pool";
+  const size_t buffer_pool_size = 10;
+  SlowDiskManager disk_manager(std::chrono::milliseconds(0));
+  {
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+    for (int i = 0; i < 2 * static_cast<int>(buffer_pool_size); i++) {
+      page_id_t page_id;
+      auto *page = bpm.NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+      ASSERT_TRUE(bpm.UnpinPage(page_id, true));
+    }
+    // pages 10-19 are resident, 15-19 are hot
+    for (int round = 0; round < 3; round++) {
+      for (page_id_t page_id = round == 0 ? 10 : 15; page_id < 20; page_id++) {
+        ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+        ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+      }
+    }
+    bpm.FlushAllPages();
+    ASSERT_TRUE(bpm.SnapshotResidentPages().Save(snapshot_file));
+  }
+
+  auto snapshot = PoolSnapshot::Load(snapshot_file);
+  ASSERT_EQ(buffer_pool_size, snapshot.entries_.size());
+  EXPECT_EQ(2, snapshot.entries_.back().history_.size());
+  disk_manager.read_cnt_ = 0;
+  {
+    BufferPoolManagerInstance bpm(buffer_pool_size, &disk_manager, 2);
+    EXPECT_EQ(buffer_pool_size, bpm.WarmUp(snapshot, 4));
+    EXPECT_EQ(static_cast<int>(buffer_pool_size), disk_manager.read_cnt_);
+    for (page_id_t page_id = 10; page_id < 20; page_id++) {
+      auto *page = bpm.FetchPage(page_id);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(fmt::format("page {}", page_id), std::string(page->GetData()));
+      ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+    }
+    EXPECT_EQ(static_cast<int>(buffer_pool_size), disk_manager.read_cnt_);
+    // the restored history still tells the hot pages apart, new pages replace the cold ones
+    page_id_t page_id;
+    for (int i = 0; i < 5; i++) {
+      ASSERT_NE(nullptr, bpm.NewPage(&page_id));
+      EXPECT_GE(page_id, 20);
+      ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+    }
+    for (page_id = 15; page_id < 20; page_id++) {
+      ASSERT_NE(nullptr, bpm.FetchPage(page_id));
+      ASSERT_TRUE(bpm.UnpinPage(page_id, false));
+    }
+    EXPECT_EQ(static_cast<int>(buffer_pool_size), disk_manager.read_cnt_);
+  }
+
+  // a smaller pool loads the hottest pages only
+  disk_manager.read_cnt_ = 0;
+  BufferPoolManagerInstance small_bpm(4, &disk_manager, 2);
+  EXPECT_EQ(4, small_bpm.WarmUp(snapshot, 2));
+  for (page_id_t page_id = 16; page_id < 20; page_id++) {
+    ASSERT_NE(nullptr, small_bpm.FetchPage(page_id));
+    ASSERT_TRUE(small_bpm.UnpinPage(page_id, false));
+  }
+  EXPECT_EQ(4, disk_manager.read_cnt_);
+
+  // a snapshot left over from a bigger database does not load pages past the end of this one
+  PoolSnapshot stale;
+  stale.entries_.push_back({100, {1}});
+  BufferPoolManagerInstance stale_bpm(4, &disk_manager, 2);
+  EXPECT_EQ(0, stale_bpm.WarmUp(stale, 1));
+  EXPECT_EQ(0, stale_bpm.GetNextPageId());
+  EXPECT_EQ(4, disk_manager.read_cnt_);
+  EXPECT_TRUE(PoolSnapshot::Load("no_such_file.pool").entries_.empty());
+  remove(snapshot_file.c_str());
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FreePageReuseTest) {
+  const std::string db_name = "free_page_test.db";
+  const size_t buffer_pool_size = 10;
+  const int page_cnt = 50;
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+
+  // Create a table of pages, write it out and drop it again, over and over. Most pages are no longer in the pool when
+  // they are deleted. The deleted pages must be reused, so the file stops growing after the first round.
+  uintmax_t file_size = 0;
+  for (int round = 0; round < 10; round++) {
+    std::vector<page_id_t> page_ids;
+    for (int i = 0; i < page_cnt; i++) {
+      page_id_t page_id;
+      auto *page = bpm->NewPage(&page_id);
+      ASSERT_NE(nullptr, page);
+      snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "round %d page %d", round, i);
+      ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+      page_ids.push_back(page_id);
+    }
+    // every round gets the same, lowest, page ids back
+    EXPECT_EQ(page_cnt - 1, *std::max_element(page_ids.begin(), page_ids.end()));
+    bpm->FlushAllPages();
+    for (int i = 0; i < page_cnt; i++) {
+      auto *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(fmt::format("round {} page {}", round, i), std::string(page->GetData()));
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+    if (round == 0) {
+      file_size = std::filesystem::file_size(db_name);
+    }
+    EXPECT_EQ(file_size, std::filesystem::file_size(db_name));
+    for (auto page_id : page_ids) {
+      ASSERT_TRUE(bpm->DeletePage(page_id));
+    }
+    EXPECT_EQ(static_cast<size_t>(page_cnt), bpm->GetFreePageCount());
+  }
+  EXPECT_EQ(static_cast<uintmax_t>(page_cnt) * BUSTUB_PAGE_SIZE, file_size);
+
+  // the free page map is written into the free pages on flush
+  bpm->FlushAllPages();
+  EXPECT_EQ(file_size, std::filesystem::file_size(db_name));
+  const page_id_t root = bpm->GetFreePageMapRoot();
+  ASSERT_NE(INVALID_PAGE_ID, root);
+  auto map = FreePageMap::Load(disk_manager, root);
+  EXPECT_EQ(static_cast<size_t>(page_cnt), map.Size());
+  for (page_id_t page_id = 0; page_id < page_cnt; page_id++) {
+    EXPECT_TRUE(map.IsFree(page_id));
+  }
+
+  // after a restart the saved map is loaded again and its pages are reused
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+  EXPECT_EQ(root, bpm->GetFreePageMapRoot());
+  EXPECT_EQ(static_cast<size_t>(page_cnt), bpm->GetFreePageCount());
+
+  // reusing a free page may overwrite the saved map, so it is dropped on disk as well
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(0, page_id);
+  EXPECT_EQ(INVALID_PAGE_ID, bpm->GetFreePageMapRoot());
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  bpm->FlushPage(page_id);
+  EXPECT_EQ(file_size, std::filesystem::file_size(db_name));
+
+  // without a saved map the remaining free pages are lost, but pages in the file are never handed out again
+  delete bpm;
+  disk_manager->ShutDown();
+  delete disk_manager;
+  disk_manager = new DiskManager(db_name);
+  bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager, 2);
+  EXPECT_EQ(0U, bpm->GetFreePageCount());
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  EXPECT_EQ(page_cnt, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  disk_manager->ShutDown();
+  remove(db_name.c_str());
+  remove("free_page_test.log");
+  remove("free_page_test.master");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FreePageMapTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  FreePageMap map;
+  page_id_t page_id;
+  EXPECT_FALSE(map.Allocate(&page_id));
+  EXPECT_EQ(INVALID_PAGE_ID, map.Save(disk_manager.get()));
+
+  // enough free pages for a chain of three map pages
+  const auto free_cnt = static_cast<page_id_t>(2 * FreePageMapPage::CAPACITY + 10);
+  for (page_id_t i = free_cnt; i > 0; i--) {
+    map.Free(3 * i);
+  }
+  map.Free(3);
+  EXPECT_EQ(static_cast<size_t>(free_cnt), map.Size());
+
+  const page_id_t root = map.Save(disk_manager.get());
+  EXPECT_EQ(3 * free_cnt, root);
+  auto loaded = FreePageMap::Load(disk_manager.get(), root);
+  EXPECT_EQ(static_cast<size_t>(free_cnt), loaded.Size());
+  // a chain that lists pages past the end, or that does not start at a map page, is not loaded
+  EXPECT_EQ(0U, FreePageMap::Load(disk_manager.get(), root, 3 * free_cnt).Size());
+  EXPECT_EQ(0U, FreePageMap::Load(disk_manager.get(), 3).Size());
+
+  // both hand out the lowest page first
+  for (page_id_t i = 1; i <= free_cnt; i++) {
+    ASSERT_TRUE(loaded.Allocate(&page_id));
+    EXPECT_EQ(3 * i, page_id);
+    ASSERT_TRUE(map.Allocate(&page_id));
+    EXPECT_EQ(3 * i, page_id);
+  }
+  EXPECT_FALSE(loaded.Allocate(&page_id));
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, CompressedTierTest) {
+  const size_t buffer_pool_size = 4;
+  const int page_cnt = 16;
+  auto *disk_manager = new SlowDiskManager(std::chrono::milliseconds(0));
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  bpm->SetCompressedTierSize(page_cnt * BUSTUB_PAGE_SIZE);
+  auto &tier = bpm->GetCompressedTier();
+
+  // Mostly empty pages, written back dirty when they are evicted and then kept in the tier.
+  std::vector<page_id_t> page_ids;
+  for (int i = 0; i < page_cnt; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", i);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  EXPECT_EQ(static_cast<size_t>(page_cnt) - buffer_pool_size, tier.Size());
+  EXPECT_GT(tier.GetCompressionRatio(), 10);
+
+  // Scenario: reading every page a few times never goes to disk. Clean victims go to the tier too.
+  for (int round = 0; round < 3; round++) {
+    for (int i = 0; i < page_cnt; i++) {
+      auto *page = bpm->FetchPage(page_ids[i]);
+      ASSERT_NE(nullptr, page);
+      EXPECT_EQ(fmt::format("page {}", i), std::string(page->GetData()));
+      ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+    }
+  }
+  EXPECT_EQ(0, disk_manager->read_cnt_);
+  EXPECT_EQ(3U * page_cnt, tier.GetHitCount());
+  // a page is either resident or in the tier, never both
+  EXPECT_EQ(static_cast<size_t>(page_cnt) - buffer_pool_size, tier.Size());
+
+  // Scenario: a page deleted while in the tier is dropped from it, and its id comes back as a fresh page.
+  ASSERT_TRUE(bpm->DeletePage(page_ids[0]));
+  EXPECT_EQ(static_cast<size_t>(page_cnt) - buffer_pool_size - 1, tier.Size());
+  page_id_t page_id;
+  auto *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  EXPECT_EQ(page_ids[0], page_id);
+  EXPECT_EQ(0, page->GetData()[0]);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  // Scenario: once the tier is too small for every page, misses go to disk and still see the right data.
+  bpm->SetCompressedTierSize(tier.GetUsedBytes() / 2);
+  for (int i = 1; i < page_cnt; i++) {
+    auto *page = bpm->FetchPage(page_ids[i]);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(fmt::format("page {}", i), std::string(page->GetData()));
+    ASSERT_TRUE(bpm->UnpinPage(page_ids[i], false));
+  }
+  EXPECT_GT(disk_manager->read_cnt_, 0);
+  EXPECT_GT(tier.GetMissCount(), 0U);
+
+  // Scenario: a disabled tier is emptied and no longer consulted.
+  bpm->SetCompressedTierSize(0);
+  EXPECT_EQ(0U, tier.Size());
+  const int reads = disk_manager->read_cnt_;
+  auto *last = bpm->FetchPage(page_ids[1]);
+  ASSERT_NE(nullptr, last);
+  EXPECT_EQ("page 1", std::string(last->GetData()));
+  ASSERT_TRUE(bpm->UnpinPage(page_ids[1], false));
+  EXPECT_EQ(reads + 1, disk_manager->read_cnt_);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, FetchPagesTest) {
+  const size_t buffer_pool_size = 8;
+  auto *disk_manager = new SlowDiskManager(std::chrono::milliseconds(0));
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+
+  // Pages 0-3 end up on disk only, pages 4-11 are resident.
+  for (int i = 0; i < 12; i++) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "page %d", page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: hits, misses and a page listed twice. Only the misses are read, and every entry is pinned.
+  const std::vector<page_id_t> batch = {11, 0, 1, 11, 2};
+  auto pages = bpm->FetchPages(batch);
+  ASSERT_EQ(batch.size(), pages.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(batch[i], pages[i]->GetPageId());
+    EXPECT_EQ(fmt::format("page {}", batch[i]), std::string(pages[i]->GetData()));
+  }
+  EXPECT_EQ(3, disk_manager->read_cnt_);
+  EXPECT_EQ(2, pages[0]->GetPinCount());
+  std::vector<std::pair<page_id_t, bool>> unpins;
+  for (auto page_id : batch) {
+    unpins.emplace_back(page_id, false);
+  }
+  bpm->UnpinPages(unpins);
+  EXPECT_EQ(0, pages[0]->GetPinCount());
+
+  // Scenario: once every frame is pinned, the remaining misses come back as nullptr and nothing stays pinned for them.
+  auto pinned = bpm->FetchPages({4, 5, 6, 7, 8, 9});
+  auto partial = bpm->FetchPages({0, 1, 2, 3});
+  EXPECT_NE(nullptr, partial[0]);
+  EXPECT_NE(nullptr, partial[1]);
+  EXPECT_EQ(nullptr, partial[2]);
+  EXPECT_EQ(nullptr, partial[3]);
+  bpm->UnpinPages({{0, false}, {1, false}});
+  for (page_id_t page_id = 4; page_id < 10; page_id++) {
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+  auto rest = bpm->FetchPages({2, 3});
+  ASSERT_NE(nullptr, rest[0]);
+  ASSERT_NE(nullptr, rest[1]);
+  EXPECT_EQ("page 3", std::string(rest[1]->GetData()));
+  bpm->UnpinPages({{2, false}, {3, false}});
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, MetricsTest) {
+  const size_t buffer_pool_size = 4;
+  auto *disk_manager = new SlowDiskManager(std::chrono::milliseconds(50));
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  const BufferPoolTag table = bpm->RegisterTag("table t");
+  const BufferPoolTag index = bpm->RegisterTag("index i");
+
+  // Six dirty pages: the first two are evicted and written back by untagged NewPage calls.
+  for (int i = 0; i < 6; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  // Scenario: the table hits page 5 and misses page 0, the index misses page 1 and hits it through a guard.
+  ASSERT_NE(nullptr, bpm->FetchPage(5, table));
+  ASSERT_TRUE(bpm->UnpinPage(5, false));
+  ASSERT_NE(nullptr, bpm->FetchPage(0, table));
+  ASSERT_TRUE(bpm->UnpinPage(0, false));
+  ASSERT_TRUE(bpm->FetchPageRead(1, nullptr, index).IsValid());
+  ASSERT_TRUE(bpm->FetchPageRead(1, nullptr, index).IsValid());
+
+  auto stats = bpm->GetStats();
+  ASSERT_EQ(2U, stats.tags_.size());
+  EXPECT_EQ("table t", stats.tags_[0].first);
+  EXPECT_EQ("index i", stats.tags_[1].first);
+  const auto &table_counters = stats.tags_[0].second;
+  EXPECT_EQ(1U, table_counters.hits_);
+  EXPECT_EQ(1U, table_counters.misses_);
+  EXPECT_EQ(1U, table_counters.evictions_);
+  EXPECT_EQ(1U, table_counters.dirty_writes_);
+  EXPECT_DOUBLE_EQ(0.5, table_counters.HitRatio());
+  const auto &index_counters = stats.tags_[1].second;
+  EXPECT_EQ(1U, index_counters.hits_);
+  EXPECT_EQ(1U, index_counters.misses_);
+  EXPECT_EQ(2U, stats.untagged_.evictions_);
+  EXPECT_EQ(2U, stats.untagged_.dirty_writes_);
+  EXPECT_EQ(0U, stats.untagged_.hits_ + stats.untagged_.misses_);
+  EXPECT_EQ(2U, stats.total_.hits_);
+  EXPECT_EQ(4U, stats.total_.evictions_);
+
+  // Scenario: counts from many threads add up, and fetchers of a page that is still being read count a pin wait.
+  const auto before = stats.tags_[0].second;
+  const int reads_before = disk_manager->read_cnt_;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&] { ASSERT_TRUE(bpm->FetchPageRead(0, nullptr, table).IsValid()); });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  stats = bpm->GetStats();
+  const auto &after = stats.tags_[0].second;
+  EXPECT_EQ(4U, after.hits_ + after.misses_ - before.hits_ - before.misses_);
+  EXPECT_EQ(static_cast<uint64_t>(disk_manager->read_cnt_ - reads_before), after.misses_ - before.misses_);
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(BufferPoolManagerInstanceTest, ExtentTest) {
+  const size_t buffer_pool_size = 10;
+  const size_t extent_page_cnt = 4;
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new BufferPoolManagerInstance(buffer_pool_size, disk_manager);
+  ExtentAllocator table(bpm, extent_page_cnt);
+  ExtentAllocator index(bpm, extent_page_cnt);
+
+  // Scenario: two objects growing at the same time get runs of consecutive pages, NewPage works around them.
+  std::vector<page_id_t> table_pages;
+  std::vector<page_id_t> index_pages;
+  std::vector<page_id_t> other_pages;
+  for (size_t i = 0; i < 2 * extent_page_cnt; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, table.NewPage(&page_id));
+    table_pages.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    ASSERT_NE(nullptr, index.NewPage(&page_id));
+    index_pages.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    other_pages.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+  EXPECT_EQ((std::vector<page_id_t>{0, 1, 2, 3, 12, 13, 14, 15}), table_pages);
+  EXPECT_EQ((std::vector<page_id_t>{4, 5, 6, 7, 16, 17, 18, 19}), index_pages);
+  EXPECT_EQ((std::vector<page_id_t>{8, 9, 10, 11, 20, 21, 22, 23}), other_pages);
+
+  // Scenario: a read-ahead over the end of the table loaded the next page of its extent before it was created. The
+  // new page is zeroed in place rather than mapped a second time.
+  page_id_t page_id;
+  ASSERT_NE(nullptr, table.NewPage(&page_id));
+  ASSERT_EQ(24, page_id);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  auto *ahead = bpm->FetchPage(25);
+  ASSERT_NE(nullptr, ahead);
+  snprintf(ahead->GetData(), BUSTUB_PAGE_SIZE, "stale");
+  ASSERT_TRUE(bpm->UnpinPage(25, false));
+  Page *page = table.NewPage(&page_id);
+  ASSERT_EQ(25, page_id);
+  EXPECT_EQ(ahead, page);
+  EXPECT_EQ(1, page->GetPinCount());
+  EXPECT_EQ(std::string(), std::string(page->GetData()));
+  EXPECT_TRUE(page->IsDirty());
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  delete bpm;
+  delete disk_manager;
+}
+
 }  // namespace bustub
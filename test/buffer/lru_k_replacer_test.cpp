@@ -13,10 +13,11 @@
 #include <vector>
 
 #include "gtest/gtest.h"
+#include "legacy_lru_k.h"
 
 namespace bustub {
 
-TEST(LRUKReplacerTest, DISABLED_SampleTest) {
+TEST(LRUKReplacerTest, SampleTest) {
   LRUKReplacer lru_replacer(7, 2);
 
   // Scenario: add six elements to the replacer. We have [1,2,3,4,5]. Frame 6 is non-evictable.
@@ -322,4 +323,85 @@ TEST(LRU_K, ENABLE_LRU_K_SampleTest4) {
   // 20: Insert:3,2
 }
 
+TEST(LRUKReplacerTest, EvictionCandidatesTest) {
+  LRUKReplacer lru_replacer(5, 2);
+  for (frame_id_t frame_id = 0; frame_id < 5; frame_id++) {
+    lru_replacer.RecordAccess(frame_id);
+  }
+  // Frames 0 and 1 reach k accesses, frame 2 is pinned: the eviction order is [3, 4, 0, 1].
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.SetEvictable(2, false);
+
+  EXPECT_EQ((std::vector<frame_id_t>{3, 4, 0}), lru_replacer.EvictionCandidates(3));
+  EXPECT_EQ((std::vector<frame_id_t>{3, 4, 0, 1}), lru_replacer.EvictionCandidates(10));
+
+  // Peeking does not change the replacer.
+  ASSERT_EQ(4, lru_replacer.Size());
+  frame_id_t frame_id;
+  ASSERT_TRUE(lru_replacer.Evict(&frame_id));
+  EXPECT_EQ(3, frame_id);
+}
+
+TEST(LRUKReplacerTest, BackwardKDistanceTest) {
+  LRUKReplacer lru_replacer(4, 2);
+  // Accesses at t0..t6: 0 1 2 1 0 0 3. Frames 2 and 3 have +inf backward k-distance and go first, oldest first. The
+  // 2nd most recent access of frame 1 (t1) is older than that of frame 0 (t4), so 1 goes before 0.
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(2);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(3);
+  ASSERT_EQ(4, lru_replacer.Size());
+
+  frame_id_t frame_id;
+  std::vector<frame_id_t> order;
+  while (lru_replacer.Evict(&frame_id)) {
+    order.push_back(frame_id);
+  }
+  EXPECT_EQ((std::vector<frame_id_t>{2, 3, 1, 0}), order);
+  EXPECT_EQ(0, lru_replacer.Size());
+
+  // An evicted frame starts over with an empty history.
+  lru_replacer.RecordAccess(0);
+  lru_replacer.RecordAccess(1);
+  lru_replacer.RecordAccess(1);
+  ASSERT_TRUE(lru_replacer.Evict(&frame_id));
+  EXPECT_EQ(0, frame_id);
+}
+
+TEST(LRUKReplacerTest, ConcurrentRecordAccessTest) {
+  const size_t num_frames = 1000;
+  const size_t num_threads = 8;
+  LRUKReplacer lru_replacer(num_frames, 3);
+
+  // Every thread touches every frame, far more accesses than the buffers hold, so they are drained along the way.
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < num_frames * 4; i++) {
+        lru_replacer.RecordAccess(static_cast<frame_id_t>((i + t * 7) % num_frames));
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(num_frames, lru_replacer.Size());
+
+  // Pin half of the frames; the other half is evicted exactly once each.
+  for (size_t i = 0; i < num_frames; i += 2) {
+    lru_replacer.SetEvictable(static_cast<frame_id_t>(i), false);
+  }
+  std::set<frame_id_t> evicted;
+  frame_id_t frame_id;
+  while (lru_replacer.Evict(&frame_id)) {
+    EXPECT_EQ(1, frame_id % 2);
+    EXPECT_TRUE(evicted.insert(frame_id).second);
+  }
+  EXPECT_EQ(num_frames / 2, evicted.size());
+}
+
 }  // namespace bustub
@@ -0,0 +1,250 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// parallel_buffer_pool_manager_test.cpp
+//
+// Identification: test/buffer/parallel_buffer_pool_manager_test.cpp
+//
+// Copyright (c) 2015-2021, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/parallel_buffer_pool_manager.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <set>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/extent_allocator.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, SampleTest) {
+  const std::string db_name = "test.db";
+  const size_t buffer_pool_size = 5;
+  const size_t num_instances = 5;
+
+  auto *disk_manager = new DiskManager(db_name);
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+  EXPECT_EQ(buffer_pool_size * num_instances, bpm->GetPoolSize());
+
+  page_id_t page_id_temp;
+  auto *page0 = bpm->NewPage(&page_id_temp);
+
+  // Scenario: The buffer pool is empty. We should be able to create a new page.
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, page_id_temp);
+
+  // Scenario: Once we have a page, we should be able to read and write content.
+  snprintf(page0->GetData(), BUSTUB_PAGE_SIZE, "Hello");
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+
+  // Scenario: We should be able to create new pages until we fill up every instance.
+  for (size_t i = 1; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: Once all instances are full, we should not be able to create any new pages.
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    EXPECT_EQ(nullptr, bpm->NewPage(&page_id_temp));
+  }
+
+  // Scenario: After unpinning pages {0, 1, 2, 3, 4} the owning instances can evict them.
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_EQ(true, bpm->UnpinPage(i, true));
+    bpm->FlushPage(i);
+  }
+  for (int i = 0; i < 5; ++i) {
+    EXPECT_NE(nullptr, bpm->NewPage(&page_id_temp));
+    bpm->UnpinPage(page_id_temp, false);
+  }
+
+  // Scenario: We should be able to fetch the data we wrote a while ago.
+  page0 = bpm->FetchPage(0);
+  ASSERT_NE(nullptr, page0);
+  EXPECT_EQ(0, strcmp(page0->GetData(), "Hello"));
+  EXPECT_EQ(true, bpm->UnpinPage(0, true));
+
+  disk_manager->ShutDown();
+  remove("test.db");
+  remove("test.log");
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, RoutingTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Every page id is allocated by, and only ever served from, the instance it routes to.
+  std::set<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size * num_instances; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_TRUE(page_ids.insert(page_id).second);
+    auto *instance = bpm->GetBufferPoolManager(page_id);
+    EXPECT_EQ(page, instance->FetchPage(page_id));
+    EXPECT_TRUE(instance->UnpinPage(page_id, false));
+    EXPECT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // NewPage is round robin, so the first pool_size * num_instances page ids are dense.
+  EXPECT_EQ(*page_ids.begin(), 0);
+  EXPECT_EQ(*page_ids.rbegin(), static_cast<page_id_t>(buffer_pool_size * num_instances - 1));
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ConcurrentFetchTest) {
+  const size_t buffer_pool_size = 16;
+  const size_t num_instances = 4;
+  const size_t num_threads = 8;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < buffer_pool_size * num_instances / 2; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < num_threads; t++) {
+    threads.emplace_back([&, t] {
+      for (size_t i = 0; i < 1000; i++) {
+        auto page_id = page_ids[(i * num_threads + t) % page_ids.size()];
+        auto *page = bpm->FetchPage(page_id);
+        ASSERT_NE(nullptr, page);
+        EXPECT_EQ(std::to_string(page_id), std::string(page->GetData()));
+        bpm->UnpinPage(page_id, false);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, FetchPagesTest) {
+  const size_t buffer_pool_size = 4;
+  const size_t num_instances = 3;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < 2 * buffer_pool_size * num_instances; ++i) {
+    page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    snprintf(page->GetData(), BUSTUB_PAGE_SIZE, "%d", page_id);
+    bpm->UnpinPage(page_id, true);
+    page_ids.push_back(page_id);
+  }
+
+  // A batch spanning every instance comes back in the order it was asked for.
+  const std::vector<page_id_t> batch = {page_ids[7], page_ids[0], page_ids[22], page_ids[1], page_ids[5]};
+  auto pages = bpm->FetchPages(batch);
+  ASSERT_EQ(batch.size(), pages.size());
+  for (size_t i = 0; i < batch.size(); i++) {
+    ASSERT_NE(nullptr, pages[i]);
+    EXPECT_EQ(batch[i], pages[i]->GetPageId());
+    EXPECT_EQ(std::to_string(batch[i]), std::string(pages[i]->GetData()));
+    EXPECT_TRUE(bpm->UnpinPage(batch[i], false));
+  }
+
+  delete bpm;
+  delete disk_manager;
+}
+
+// NOLINTNEXTLINE
+TEST(ParallelBufferPoolManagerTest, ExtentTest) {
+  const size_t buffer_pool_size = 8;
+  const size_t num_instances = 3;
+  const size_t extent_page_cnt = 8;
+
+  auto *disk_manager = new DiskManagerUnlimitedMemory();
+  auto *bpm = new ParallelBufferPoolManager(num_instances, buffer_pool_size, disk_manager);
+
+  // Round robin: instances 0, 1 and 2 hand out pages 6, 7 and 5 next.
+  std::vector<page_id_t> page_ids;
+  for (size_t i = 0; i < 5; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  ASSERT_EQ((std::vector<page_id_t>{0, 1, 2, 3, 4}), page_ids);
+
+  // Scenario: the extent starts after the highest next page id and spans all instances; every page of it is created in
+  // the instance that owns it.
+  ExtentAllocator allocator(bpm, extent_page_cnt);
+  for (page_id_t expected = 7; expected < 7 + static_cast<page_id_t>(extent_page_cnt); expected++) {
+    page_id_t page_id;
+    auto *page = allocator.NewPage(&page_id);
+    ASSERT_NE(nullptr, page);
+    EXPECT_EQ(expected, page_id);
+    EXPECT_EQ(page, bpm->GetBufferPoolManager(page_id)->FetchPage(page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+  }
+
+  // Scenario: pages 5 and 6, skipped by instances 2 and 0 to line up with the extent, are handed out by NewPage later;
+  // the page ids of the extent are not.
+  page_ids.clear();
+  for (size_t i = 0; i < num_instances; i++) {
+    page_id_t page_id;
+    ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+    ASSERT_TRUE(bpm->UnpinPage(page_id, true));
+    page_ids.push_back(page_id);
+  }
+  std::sort(page_ids.begin(), page_ids.end());
+  EXPECT_EQ((std::vector<page_id_t>{5, 6, 16}), page_ids);
+
+  // Scenario: an extent reserved on one instance but not on the others is given back. Nothing was allocated after it,
+  // so the next page id just moves back; once a page was allocated after it, its page ids go to the free page map.
+  auto *instance = bpm->GetBufferPoolManager(0);
+  const page_id_t next_page_id = instance->GetNextPageId();
+  const size_t free_page_cnt = instance->GetFreePageCount();
+  const auto end_page_id = next_page_id + static_cast<page_id_t>(extent_page_cnt);
+  ASSERT_TRUE(instance->ReservePageIds(next_page_id, end_page_id));
+  instance->FreePageIds(next_page_id, end_page_id);
+  EXPECT_EQ(next_page_id, instance->GetNextPageId());
+  EXPECT_EQ(free_page_cnt, instance->GetFreePageCount());
+  ASSERT_TRUE(instance->ReservePageIds(next_page_id, end_page_id));
+  page_id_t page_id;
+  ASSERT_NE(nullptr, instance->NewPage(&page_id));
+  ASSERT_TRUE(instance->UnpinPage(page_id, true));
+  instance->FreePageIds(next_page_id, end_page_id);
+  EXPECT_LE(end_page_id, page_id);
+  EXPECT_EQ(free_page_cnt + 3, instance->GetFreePageCount());
+
+  delete bpm;
+  delete disk_manager;
+}
+
+}  // namespace bustub
@@ -0,0 +1,239 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// replacer_test.cpp
+//
+// Identification: test/buffer/replacer_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "buffer/replacer.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "buffer/arc_replacer.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/two_queue_replacer.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+static const std::vector<ReplacerType> ALL_REPLACERS{ReplacerType::LRU_K, ReplacerType::LRU,
+                                                     ReplacerType::CLOCK, ReplacerType::ARC,
+                                                     ReplacerType::TWO_QUEUE, ReplacerType::CLOCK_PRO};
+
+/** Replay a page trace through a replacer like the buffer pool would, and count the misses. LRU-K runs with k = 2. */
+static auto CountMisses(ReplacerType type, size_t num_frames, const std::vector<page_id_t> &trace) -> size_t {
+  auto replacer = MakeReplacer(type, num_frames, 2);
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frame_pages(num_frames, INVALID_PAGE_ID);
+  size_t misses = 0;
+  for (auto page_id : trace) {
+    frame_id_t frame_id;
+    if (page_table.count(page_id) > 0) {
+      frame_id = page_table[page_id];
+    } else {
+      misses++;
+      if (page_table.size() < num_frames) {
+        frame_id = static_cast<frame_id_t>(page_table.size());
+      } else {
+        EXPECT_TRUE(replacer->Evict(&frame_id));
+        page_table.erase(frame_pages[frame_id]);
+      }
+      frame_pages[frame_id] = page_id;
+      page_table[page_id] = frame_id;
+    }
+    replacer->RecordAccess(frame_id, page_id);
+  }
+  return misses;
+}
+
+TEST(ReplacerTest, FromStringTest) {
+  for (auto type : ALL_REPLACERS) {
+    EXPECT_EQ(type, ReplacerTypeFromString(ReplacerTypeToString(type)));
+  }
+  EXPECT_EQ(ReplacerType::TWO_QUEUE, ReplacerTypeFromString("2Q"));
+  EXPECT_EQ(ReplacerType::CLOCK_PRO, ReplacerTypeFromString("Clock-Pro"));
+  EXPECT_FALSE(ReplacerTypeFromString("mru").has_value());
+}
+
+// Every policy must honor the evictable flags and the Size / Remove / Evict bookkeeping.
+TEST(ReplacerTest, ContractTest) {
+  for (auto type : ALL_REPLACERS) {
+    SCOPED_TRACE(ReplacerTypeToString(type));
+    auto replacer = MakeReplacer(type, 8);
+    for (frame_id_t frame_id = 0; frame_id < 6; frame_id++) {
+      replacer->RecordAccess(frame_id, frame_id + 100);
+    }
+    replacer->RecordAccess(2, 102);
+    EXPECT_EQ(6, replacer->Size());
+
+    replacer->SetEvictable(1, false);
+    replacer->SetEvictable(3, false);
+    replacer->SetEvictable(3, false);
+    replacer->SetEvictable(7, true);  // not tracked, no effect
+    EXPECT_EQ(4, replacer->Size());
+    auto candidates = replacer->EvictionCandidates(10);
+    std::sort(candidates.begin(), candidates.end());
+    EXPECT_EQ((std::vector<frame_id_t>{0, 2, 4, 5}), candidates);
+
+    replacer->Remove(4);
+    replacer->Remove(4);
+    EXPECT_EQ(3, replacer->Size());
+
+    std::vector<frame_id_t> victims;
+    frame_id_t frame_id;
+    while (replacer->Evict(&frame_id)) {
+      victims.push_back(frame_id);
+    }
+    std::sort(victims.begin(), victims.end());
+    EXPECT_EQ((std::vector<frame_id_t>{0, 2, 5}), victims);
+    EXPECT_EQ(0, replacer->Size());
+
+    replacer->SetEvictable(3, true);
+    EXPECT_EQ(1, replacer->Size());
+    ASSERT_TRUE(replacer->Evict(&frame_id));
+    EXPECT_EQ(3, frame_id);
+    EXPECT_FALSE(replacer->Evict(&frame_id));
+    EXPECT_EQ(0, replacer->Size());
+  }
+}
+
+// Shrinking drops the removed tail frames, growing makes new frames usable.
+TEST(ReplacerTest, ResizeTest) {
+  for (auto type : ALL_REPLACERS) {
+    SCOPED_TRACE(ReplacerTypeToString(type));
+    auto replacer = MakeReplacer(type, 4);
+    for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+      replacer->RecordAccess(frame_id, frame_id + 100);
+    }
+    replacer->Remove(2);
+    replacer->Remove(3);
+    replacer->Resize(2);
+    EXPECT_EQ(2, replacer->Size());
+
+    replacer->Resize(8);
+    for (frame_id_t frame_id = 2; frame_id < 8; frame_id++) {
+      replacer->RecordAccess(frame_id, frame_id + 200);
+    }
+    EXPECT_EQ(8, replacer->Size());
+    std::vector<frame_id_t> victims;
+    frame_id_t frame_id;
+    while (replacer->Evict(&frame_id)) {
+      victims.push_back(frame_id);
+    }
+    std::sort(victims.begin(), victims.end());
+    EXPECT_EQ((std::vector<frame_id_t>{0, 1, 2, 3, 4, 5, 6, 7}), victims);
+  }
+}
+
+// Frames restored coldest first with their saved history are evicted in the original order.
+TEST(ReplacerTest, RestoreAccessHistoryTest) {
+  for (auto type : {ReplacerType::LRU_K, ReplacerType::LRU}) {
+    SCOPED_TRACE(ReplacerTypeToString(type));
+    auto before = MakeReplacer(type, 4, 2);
+    for (frame_id_t frame_id : {0, 1, 2, 3, 3, 1, 0}) {
+      before->RecordAccess(frame_id);
+    }
+    auto order = before->EvictionCandidates(4);
+    ASSERT_EQ(4, order.size());
+
+    // restore into a fresh replacer, with the frames renumbered
+    auto after = MakeReplacer(type, 4, 2);
+    for (size_t i = 0; i < order.size(); i++) {
+      after->RestoreAccessHistory(static_cast<frame_id_t>(3 - i), INVALID_PAGE_ID,
+                                  before->GetAccessHistory(order[i]));
+    }
+    for (size_t i = 0; i < order.size(); i++) {
+      frame_id_t frame_id;
+      ASSERT_TRUE(after->Evict(&frame_id));
+      EXPECT_EQ(static_cast<frame_id_t>(3 - i), frame_id);
+    }
+  }
+
+  LRUKReplacer replacer(2, 3);
+  EXPECT_TRUE(replacer.GetAccessHistory(0).empty());
+  for (int i = 0; i < 4; i++) {
+    replacer.RecordAccess(0);
+  }
+  EXPECT_EQ((std::vector<uint64_t>{1, 2, 3}), replacer.GetAccessHistory(0));
+
+  // accesses recorded after a restore are newer than the restored ones
+  LRUKReplacer restored(2, 2);
+  restored.RestoreAccessHistory(0, INVALID_PAGE_ID, {100, 200});
+  restored.RecordAccess(1);
+  restored.RecordAccess(1);
+  frame_id_t frame_id;
+  ASSERT_TRUE(restored.Evict(&frame_id));
+  EXPECT_EQ(0, frame_id);
+}
+
+// A page read back while remembered in B1 enlarges the target size of T1.
+TEST(ReplacerTest, ARCGhostHitTest) {
+  ARCReplacer replacer(4);
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    replacer.RecordAccess(frame_id, frame_id + 1);  // T1: pages 1 2 3 4
+  }
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(0, frame_id);  // page 1 goes to B1
+
+  replacer.RecordAccess(1, 2);  // page 2 moves to T2
+  replacer.RecordAccess(0, 1);  // B1 hit: page 1 enters T2, target of T1 becomes 1
+
+  // T1 (pages 3 4) is above its target, then T1 (page 4) is at its target and T2 gives up its LRU page.
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(2, frame_id);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(1, frame_id);
+}
+
+// Only a page read again after falling out of A1in makes it to Am.
+TEST(ReplacerTest, TwoQueueAdmissionTest) {
+  TwoQueueReplacer replacer(4);  // Kin = 1, Kout = 2
+  for (frame_id_t frame_id = 0; frame_id < 4; frame_id++) {
+    replacer.RecordAccess(frame_id, frame_id + 1);
+  }
+  replacer.RecordAccess(3, 4);  // a second access in A1in does not make page 4 hot
+  frame_id_t frame_id;
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(0, frame_id);  // page 1 goes to A1out
+
+  replacer.RecordAccess(0, 1);  // page 1 is admitted to Am
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(1, frame_id);
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(2, frame_id);
+  // A1in is down to Kin, so Am gives up page 1 before page 4.
+  ASSERT_TRUE(replacer.Evict(&frame_id));
+  EXPECT_EQ(0, frame_id);
+}
+
+// A hot set that fits in the pool, then mixed with a scan that does not. The scan wipes out the hot set under LRU;
+// LRU-K, ARC and CLOCK-Pro tell the hot pages from the scanned ones and keep them. (2Q only recognizes pages re-read
+// shortly after leaving A1in, which the scan prevents here; see TwoQueueAdmissionTest.)
+TEST(ReplacerTest, ScanResistanceTest) {
+  const size_t num_frames = 32;
+  const page_id_t hot_pages = 16;
+  std::vector<page_id_t> trace;
+  for (int i = 0; i < 2 * hot_pages; i++) {
+    trace.push_back(i % hot_pages);
+  }
+  for (int i = 0; i < 3000; i++) {
+    trace.push_back(i % hot_pages);
+    trace.push_back(1000 + 2 * i);
+    trace.push_back(1000 + 2 * i + 1);
+  }
+  const size_t lru_misses = CountMisses(ReplacerType::LRU, num_frames, trace);
+  EXPECT_GT(lru_misses, trace.size() * 99 / 100);
+  for (auto type : {ReplacerType::LRU_K, ReplacerType::ARC, ReplacerType::CLOCK_PRO}) {
+    EXPECT_LT(CountMisses(type, num_frames, trace), lru_misses * 3 / 4) << ReplacerTypeToString(type);
+  }
+}
+
+}  // namespace bustub
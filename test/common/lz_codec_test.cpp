@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// lz_codec_test.cpp
+//
+// Identification: test/common/lz_codec_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "common/util/lz_codec.h"
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "common/config.h"
+#include "gtest/gtest.h"
+
+namespace bustub {
+
+namespace {
+
+/** Compress data, check the result decompresses to data again, and return the compressed size. */
+auto RoundTrip(const std::vector<char> &data) -> size_t {
+  std::vector<char> compressed;
+  LZCodec::Compress(data.data(), data.size(), &compressed);
+  std::vector<char> decompressed(data.size());
+  EXPECT_TRUE(LZCodec::Decompress(compressed.data(), compressed.size(), decompressed.data(), decompressed.size()));
+  EXPECT_EQ(data, decompressed);
+  return compressed.size();
+}
+
+}  // namespace
+
+// NOLINTNEXTLINE
+TEST(LZCodecTest, RoundTripTest) {
+  std::default_random_engine rng(15445);
+  std::uniform_int_distribution<int> byte(0, 255);
+
+  // empty, short and zeroed inputs
+  EXPECT_EQ(0, RoundTrip({}));
+  RoundTrip({'a'});
+  RoundTrip({'a', 'b', 'c', 'a', 'b', 'c', 'a', 'b'});
+  EXPECT_LT(RoundTrip(std::vector<char>(BUSTUB_PAGE_SIZE, 0)), 32);
+
+  // a page of repeated records with a few random fields compresses well
+  std::vector<char> records;
+  while (records.size() < static_cast<size_t>(BUSTUB_PAGE_SIZE)) {
+    std::string record = "tuple|" + std::to_string(byte(rng)) + "|varchar value|";
+    records.insert(records.end(), record.begin(), record.end());
+  }
+  records.resize(BUSTUB_PAGE_SIZE);
+  EXPECT_LT(RoundTrip(records), records.size() / 2);
+
+  // random bytes do not compress, and only grow by a little
+  std::vector<char> noise(BUSTUB_PAGE_SIZE);
+  for (auto &c : noise) {
+    c = static_cast<char>(byte(rng));
+  }
+  EXPECT_LT(RoundTrip(noise), noise.size() + noise.size() / 100);
+
+  // long literal runs and long matches need extension bytes
+  std::vector<char> mixed(noise.begin(), noise.begin() + 1000);
+  mixed.insert(mixed.end(), 2000, 'x');
+  mixed.insert(mixed.end(), noise.begin(), noise.begin() + 1000);
+  RoundTrip(mixed);
+}
+
+// NOLINTNEXTLINE
+TEST(LZCodecTest, DamagedInputTest) {
+  std::vector<char> page(BUSTUB_PAGE_SIZE);
+  for (size_t i = 0; i < page.size(); i++) {
+    page[i] = static_cast<char>(i % 61);
+  }
+  std::vector<char> compressed;
+  LZCodec::Compress(page.data(), page.size(), &compressed);
+  std::vector<char> out(page.size());
+
+  // truncated input, or a wrong original size
+  EXPECT_FALSE(LZCodec::Decompress(compressed.data(), compressed.size() - 1, out.data(), out.size()));
+  EXPECT_FALSE(LZCodec::Decompress(compressed.data(), compressed.size(), out.data(), out.size() - 1));
+  // a match pointing before the start of the output
+  const char bad_offset[] = {0x10, 'a', 0x10, 0x00};
+  EXPECT_FALSE(LZCodec::Decompress(bad_offset, sizeof(bad_offset), out.data(), out.size()));
+  // every possible damage to one byte fails or stays in bounds
+  std::default_random_engine rng(15445);
+  for (int i = 0; i < 1000; i++) {
+    std::vector<char> damaged = compressed;
+    damaged[rng() % damaged.size()] = static_cast<char>(rng());
+    LZCodec::Decompress(damaged.data(), damaged.size(), out.data(), out.size());
+  }
+}
+
+}  // namespace bustub
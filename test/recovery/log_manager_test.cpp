@@ -0,0 +1,357 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// log_manager_test.cpp
+//
+// Identification: test/recovery/log_manager_test.cpp
+//
+// Copyright (c) 2015-2019, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include <chrono>  // NOLINT
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <thread>  // NOLINT
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "common/bustub_instance.h"
+#include "common/config.h"
+#include "concurrency/transaction_manager.h"
+#include "gtest/gtest.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager.h"
+
+namespace bustub {
+
+class LogManagerTest : public ::testing::Test {
+ protected:
+  // ctest runs the test cases in parallel, each one gets its own files.
+  void SetUp() override {
+    const std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    db_file_ = name + ".db";
+    log_file_ = name + ".log";
+    remove(db_file_.c_str());
+    remove(log_file_.c_str());
+  }
+
+  void TearDown() override {
+    enable_logging = false;
+    remove(db_file_.c_str());
+    remove(log_file_.c_str());
+  }
+
+  /** @return the number of records in the log file, checking that their LSNs are consecutive from 0 */
+  static auto CountLogRecords(DiskManager *disk_manager) -> int {
+    std::vector<char> buffer(LOG_BUFFER_SIZE);
+    int offset = 0;
+    int count = 0;
+    while (disk_manager->ReadLog(buffer.data(), LOG_BUFFER_SIZE, offset)) {
+      int pos = 0;
+      while (pos + 20 <= LOG_BUFFER_SIZE) {
+        int32_t size;
+        lsn_t lsn;
+        memcpy(&size, buffer.data() + pos, sizeof(int32_t));
+        memcpy(&lsn, buffer.data() + pos + 4, sizeof(lsn_t));
+        if (size <= 0 || pos + size > LOG_BUFFER_SIZE) {
+          break;
+        }
+        EXPECT_EQ(count, lsn);
+        count++;
+        pos += size;
+      }
+      if (pos == 0) {
+        break;
+      }
+      offset += pos;
+    }
+    return count;
+  }
+
+  std::string db_file_;
+  std::string log_file_;
+};
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AppendAndFlushTest) {
+  DiskManager disk_manager(db_file_);
+  LogManager log_manager(&disk_manager);
+
+  LogRecord begin(0, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t begin_lsn = log_manager.AppendLogRecord(&begin);
+  LogRecord new_page(0, begin_lsn, LogRecordType::NEWPAGE, INVALID_PAGE_ID, 7);
+  lsn_t new_page_lsn = log_manager.AppendLogRecord(&new_page);
+  LogRecord commit(0, new_page_lsn, LogRecordType::COMMIT);
+  lsn_t commit_lsn = log_manager.AppendLogRecord(&commit);
+  EXPECT_EQ(0, begin_lsn);
+  EXPECT_EQ(1, new_page_lsn);
+  EXPECT_EQ(2, commit_lsn);
+  EXPECT_EQ(INVALID_LSN, log_manager.GetPersistentLSN());
+
+  // Without a flush thread the caller writes the buffer itself; one write covers all three records.
+  log_manager.Flush(commit_lsn);
+  EXPECT_EQ(commit_lsn, log_manager.GetPersistentLSN());
+  EXPECT_EQ(1, disk_manager.GetNumFlushes());
+  log_manager.Flush(begin_lsn);
+  EXPECT_EQ(1, disk_manager.GetNumFlushes());
+
+  char buffer[128];
+  ASSERT_TRUE(disk_manager.ReadLog(buffer, sizeof(buffer), 0));
+  int32_t size;
+  page_id_t page_id;
+  LogRecordType type;
+  memcpy(&size, buffer + 20, sizeof(int32_t));
+  EXPECT_EQ(28, size);
+  memcpy(&page_id, buffer + 20 + 24, sizeof(page_id_t));
+  EXPECT_EQ(7, page_id);
+  memcpy(&type, buffer + 48 + 16, sizeof(LogRecordType));
+  EXPECT_EQ(LogRecordType::COMMIT, type);
+
+  // LSNs that were never assigned, e.g. read from a page that is not logged, do not block.
+  log_manager.Flush(1000);
+  EXPECT_EQ(3, CountLogRecords(&disk_manager));
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, GroupCommitTest) {
+  const int num_threads = 8;
+  const int commits_per_thread = 50;
+  DiskManager disk_manager(db_file_);
+  LogManager log_manager(&disk_manager);
+  log_manager.RunFlushThread();
+  EXPECT_TRUE(enable_logging);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      lsn_t prev_lsn = INVALID_LSN;
+      for (int j = 0; j < commits_per_thread; j++) {
+        LogRecord commit(i, prev_lsn, LogRecordType::COMMIT);
+        prev_lsn = log_manager.AppendLogRecord(&commit);
+        log_manager.Flush(prev_lsn);
+        EXPECT_GE(log_manager.GetPersistentLSN(), prev_lsn);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_threads * commits_per_thread - 1, log_manager.GetPersistentLSN());
+  EXPECT_LE(disk_manager.GetNumFlushes(), num_threads * commits_per_thread);
+
+  log_manager.StopFlushThread();
+  EXPECT_FALSE(enable_logging);
+  EXPECT_EQ(num_threads * commits_per_thread, CountLogRecords(&disk_manager));
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, AsyncCommitTest) {
+  DiskManager disk_manager(db_file_);
+  LogManager log_manager(&disk_manager);
+  log_manager.RunFlushThread();
+  const auto max_lag = async_commit_max_lag;
+  async_commit_max_lag = std::chrono::milliseconds(20);
+
+  LogRecord commit(0, INVALID_LSN, LogRecordType::COMMIT);
+  lsn_t lsn = log_manager.AppendLogRecord(&commit);
+  auto start = std::chrono::steady_clock::now();
+  log_manager.FlushAsync(lsn);
+  // The flush thread writes it well before the next log_timeout.
+  while (log_manager.GetPersistentLSN() < lsn) {
+    ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(500));
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+
+  // Asynchronous commits landing in the same window share one write.
+  const int flushes = disk_manager.GetNumFlushes();
+  for (int i = 0; i < 10; i++) {
+    LogRecord commit(i, INVALID_LSN, LogRecordType::COMMIT);
+    lsn = log_manager.AppendLogRecord(&commit);
+    log_manager.FlushAsync(lsn);
+  }
+  log_manager.Flush(lsn);
+  EXPECT_LE(disk_manager.GetNumFlushes(), flushes + 2);
+
+  async_commit_max_lag = max_lag;
+  log_manager.StopFlushThread();
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, SynchronousCommitSessionTest) {
+  BustubInstance bustub;
+  std::stringstream ss;
+  SimpleStreamWriter writer(ss);
+  EXPECT_TRUE(bustub.IsSynchronousCommit());
+
+  auto *txn = bustub.txn_manager_->Begin();
+  EXPECT_TRUE(txn->IsSynchronousCommit());
+  bustub.ExecuteSqlTxn("SET synchronous_commit = off;", writer, txn);
+  EXPECT_FALSE(bustub.IsSynchronousCommit());
+  EXPECT_FALSE(txn->IsSynchronousCommit());
+  bustub.txn_manager_->Commit(txn);
+  delete txn;
+
+  // Later transactions of the session pick it up, until it is turned back on.
+  txn = bustub.txn_manager_->Begin();
+  bustub.ExecuteSqlTxn("SHOW synchronous_commit;", writer, txn);
+  EXPECT_FALSE(txn->IsSynchronousCommit());
+  bustub.txn_manager_->Commit(txn);
+  delete txn;
+  bustub.ExecuteSql("SET synchronous_commit = on;", writer);
+  EXPECT_TRUE(bustub.IsSynchronousCommit());
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, BufferFullTest) {
+  DiskManager disk_manager(db_file_);
+  LogManager log_manager(&disk_manager);
+  log_manager.RunFlushThread();
+
+  // Several buffers worth of records: appenders wait for the flush thread to swap in an empty buffer.
+  const int num_records = 3 * LOG_BUFFER_SIZE / 28;
+  lsn_t lsn = INVALID_LSN;
+  for (int i = 0; i < num_records; i++) {
+    LogRecord new_page(0, lsn, LogRecordType::NEWPAGE, i - 1, i);
+    lsn = log_manager.AppendLogRecord(&new_page);
+  }
+  EXPECT_GE(disk_manager.GetNumFlushes(), 2);
+
+  // Stopping the flush thread writes out the rest.
+  log_manager.StopFlushThread();
+  EXPECT_EQ(lsn, log_manager.GetPersistentLSN());
+  EXPECT_EQ(num_records, CountLogRecords(&disk_manager));
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, ConcurrentAppendTest) {
+  const int num_threads = 8;
+  const int records_per_thread = 2000;
+  DiskManager disk_manager(db_file_);
+  LogManager log_manager(&disk_manager);
+  log_manager.RunFlushThread();
+
+  // Appenders serialize in parallel into the slices they reserved; the flush thread must only write whole records.
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; i++) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < records_per_thread; j++) {
+        const int32_t tuple_size = 1 + (i * 7 + j) % 100;
+        std::vector<char> storage(sizeof(int32_t) + tuple_size, static_cast<char>('a' + i));
+        memcpy(storage.data(), &tuple_size, sizeof(int32_t));
+        Tuple tuple;
+        tuple.DeserializeFrom(storage.data());
+        LogRecord insert(i, INVALID_LSN, LogRecordType::INSERT, RID(i, j), tuple);
+        log_manager.AppendLogRecord(&insert);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  log_manager.StopFlushThread();
+  EXPECT_EQ(num_threads * records_per_thread - 1, log_manager.GetPersistentLSN());
+  EXPECT_GE(disk_manager.GetNumFlushes(), 2);
+
+  // Every record is intact: its tuple is filled with the character of the thread that appended it.
+  std::vector<char> log(num_threads * records_per_thread * 128);
+  ASSERT_TRUE(disk_manager.ReadLog(log.data(), log.size(), 0));
+  size_t pos = 0;
+  int next_slot[num_threads] = {};
+  for (int lsn = 0; lsn < num_threads * records_per_thread; lsn++) {
+    int32_t size;
+    lsn_t record_lsn;
+    txn_id_t txn_id;
+    RID rid;
+    int32_t tuple_size;
+    memcpy(&size, log.data() + pos, sizeof(int32_t));
+    memcpy(&record_lsn, log.data() + pos + 4, sizeof(lsn_t));
+    memcpy(&txn_id, log.data() + pos + 8, sizeof(txn_id_t));
+    memcpy(&rid, log.data() + pos + 20, sizeof(RID));
+    memcpy(&tuple_size, log.data() + pos + 20 + sizeof(RID), sizeof(int32_t));
+    ASSERT_EQ(lsn, record_lsn);
+    ASSERT_TRUE(txn_id >= 0 && txn_id < num_threads);
+    ASSERT_EQ(txn_id, rid.GetPageId());
+    // Records of one thread are appended in order.
+    ASSERT_EQ(next_slot[txn_id]++, static_cast<int>(rid.GetSlotNum()));
+    ASSERT_EQ(size, static_cast<int32_t>(20 + sizeof(RID) + sizeof(int32_t)) + tuple_size);
+    const char *data = log.data() + pos + 20 + sizeof(RID) + sizeof(int32_t);
+    ASSERT_EQ(std::string(tuple_size, static_cast<char>('a' + txn_id)), std::string(data, tuple_size));
+    pos += size;
+  }
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, WriteAheadTest) {
+  DiskManager disk_manager(db_file_);
+  LogManager log_manager(&disk_manager);
+  BufferPoolManagerInstance bpm(2, &disk_manager, 2, &log_manager);
+  log_manager.RunFlushThread();
+
+  page_id_t page_id;
+  Page *page = bpm.NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  LogRecord new_page(0, INVALID_LSN, LogRecordType::NEWPAGE, INVALID_PAGE_ID, page_id);
+  lsn_t lsn = log_manager.AppendLogRecord(&new_page);
+  page->SetLSN(lsn);
+  EXPECT_LT(log_manager.GetPersistentLSN(), lsn);
+
+  // The page may only reach the disk after its log records did, flushing the page forces the log.
+  bpm.UnpinPage(page_id, true);
+  EXPECT_TRUE(bpm.FlushPage(page_id));
+  EXPECT_GE(log_manager.GetPersistentLSN(), lsn);
+
+  // Evicting a dirty page forces the log, too.
+  page = bpm.FetchPage(page_id);
+  LogRecord commit(0, lsn, LogRecordType::COMMIT);
+  lsn = log_manager.AppendLogRecord(&commit);
+  page->SetLSN(lsn);
+  bpm.UnpinPage(page_id, true);
+  page_id_t other_page_ids[2];
+  ASSERT_NE(nullptr, bpm.NewPage(&other_page_ids[0]));
+  ASSERT_NE(nullptr, bpm.NewPage(&other_page_ids[1]));
+  EXPECT_GE(log_manager.GetPersistentLSN(), lsn);
+
+  log_manager.StopFlushThread();
+  bpm.UnpinPage(other_page_ids[0], false);
+  bpm.UnpinPage(other_page_ids[1], false);
+  disk_manager.ShutDown();
+}
+
+// NOLINTNEXTLINE
+TEST_F(LogManagerTest, FailedWriteTest) {
+  /** A disk whose log writes fail, e.g. because the device is full. */
+  class FailingLogDiskManager : public DiskManager {
+   public:
+    using DiskManager::DiskManager;
+    auto WriteLog(char *log_data, int size) -> bool override { return false; }
+  };
+  FailingLogDiskManager disk_manager(db_file_);
+  LogManager log_manager(&disk_manager);
+  log_manager.RunFlushThread();
+
+  // The commit is not reported durable: persistent_lsn_ stays put and the waiter is woken up with an error.
+  LogRecord begin(0, INVALID_LSN, LogRecordType::BEGIN);
+  lsn_t lsn = log_manager.AppendLogRecord(&begin);
+  LogRecord commit(0, lsn, LogRecordType::COMMIT);
+  lsn = log_manager.AppendLogRecord(&commit);
+  EXPECT_THROW(log_manager.Flush(lsn), std::logic_error);
+  EXPECT_EQ(INVALID_LSN, log_manager.GetPersistentLSN());
+
+  // Later records are not written behind the lost ones either.
+  log_manager.StopFlushThread();
+  LogRecord abort(1, INVALID_LSN, LogRecordType::ABORT);
+  lsn = log_manager.AppendLogRecord(&abort);
+  EXPECT_THROW(log_manager.Flush(lsn), std::logic_error);
+  EXPECT_EQ(INVALID_LSN, log_manager.GetPersistentLSN());
+  disk_manager.ShutDown();
+}
+
+}  // namespace bustub
@@ -10,7 +10,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <filesystem>
+#include <fstream>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include "buffer/buffer_pool_manager_instance.h"
@@ -29,28 +32,40 @@
 #include "storage/table/table_heap.h"
 #include "storage/table/table_iterator.h"
 #include "storage/table/tuple.h"
+#include "type/value_factory.h"
 
 namespace bustub {
 
 class RecoveryTest : public ::testing::Test {
  protected:
-  // This function is called before every test.
+  // This function is called before every test. ctest runs the test cases in parallel, each one gets its own files.
   void SetUp() override {
-    remove("test.db");
-    remove("test.log");
+    const std::string name = ::testing::UnitTest::GetInstance()->current_test_info()->name();
+    db_file_ = name + ".db";
+    log_file_ = name + ".log";
+    master_file_ = name + ".master";
+    remove(db_file_.c_str());
+    remove(log_file_.c_str());
+    remove(master_file_.c_str());
   }
 
   // This function is called after every test.
   void TearDown() override {
     LOG_INFO("Tearing down the system..");
-    remove("test.db");
-    remove("test.log");
+    remove(db_file_.c_str());
+    remove(log_file_.c_str());
+    remove((db_file_ + ".pool").c_str());
+    remove(master_file_.c_str());
   };
+
+  std::string db_file_;
+  std::string log_file_;
+  std::string master_file_;
 };
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_RedoTest) {
-  auto *bustub_instance = new BustubInstance("test.db");
+TEST_F(RecoveryTest, RedoTest) {
+  auto *bustub_instance = new BustubInstance(db_file_);
 
   ASSERT_FALSE(enable_logging);
   LOG_INFO("Skip system recovering...");
@@ -92,7 +107,7 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
   delete bustub_instance;
 
   LOG_INFO("System restart...");
-  bustub_instance = new BustubInstance("test.db");
+  bustub_instance = new BustubInstance(db_file_);
 
   ASSERT_FALSE(enable_logging);
   LOG_INFO("Check if tuple is not in table before recovery");
@@ -107,7 +122,8 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
   delete txn;
 
   LOG_INFO("Begin recovery");
-  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
 
   ASSERT_FALSE(enable_logging);
 
@@ -138,8 +154,8 @@ TEST_F(RecoveryTest, DISABLED_RedoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_UndoTest) {
-  auto *bustub_instance = new BustubInstance("test.db");
+TEST_F(RecoveryTest, UndoTest) {
+  auto *bustub_instance = new BustubInstance(db_file_);
 
   ASSERT_FALSE(enable_logging);
   LOG_INFO("Skip system recovering...");
@@ -176,7 +192,7 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
   delete bustub_instance;
 
   LOG_INFO("System restarted..");
-  bustub_instance = new BustubInstance("test.db");
+  bustub_instance = new BustubInstance(db_file_);
 
   LOG_INFO("Check if tuple exists before recovery");
   Tuple old_tuple;
@@ -191,7 +207,8 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
   delete txn;
 
   LOG_INFO("Recovery started..");
-  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
 
   ASSERT_FALSE(enable_logging);
 
@@ -217,8 +234,8 @@ TEST_F(RecoveryTest, DISABLED_UndoTest) {
 }
 
 // NOLINTNEXTLINE
-TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
-  auto *bustub_instance = new BustubInstance("test.db");
+TEST_F(RecoveryTest, CheckpointTest) {
+  auto *bustub_instance = new BustubInstance(db_file_);
 
   EXPECT_FALSE(enable_logging);
   LOG_INFO("Skip system recovering...");
@@ -231,6 +248,7 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   Transaction *txn = bustub_instance->txn_manager_->Begin();
   auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
                                    bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
   bustub_instance->txn_manager_->Commit(txn);
 
   Column col1{"a", TypeId::VARCHAR, 20};
@@ -242,67 +260,43 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
   auto val_0 = tuple.GetValue(&schema, 0);
   auto val_1 = tuple.GetValue(&schema, 1);
 
-  // set log time out very high so that flush doesn't happen before checkpoint is performed
-  log_timeout = std::chrono::seconds(15);
-
-  // insert a ton of tuples
+  // insert a ton of tuples, and write them out before the checkpoint
+  std::vector<RID> committed_rids;
   Transaction *txn1 = bustub_instance->txn_manager_->Begin();
   for (int i = 0; i < 1000; i++) {
     RID rid;
     EXPECT_TRUE(test_table->InsertTuple(tuple, &rid, txn1));
+    committed_rids.push_back(rid);
   }
+  // the commit record of txn1 starts a new log buffer, redo does not need the buffers before it
+  bustub_instance->log_manager_->Flush(bustub_instance->log_manager_->GetNextLSN() - 1);
   bustub_instance->txn_manager_->Commit(txn1);
+  bustub_instance->buffer_pool_manager_->FlushAllPages();
+
+  // these are only in the buffer pool when the checkpoint is taken
+  Transaction *txn2 = bustub_instance->txn_manager_->Begin();
+  for (int i = 0; i < 10; i++) {
+    RID rid;
+    EXPECT_TRUE(test_table->InsertTuple(tuple, &rid, txn2));
+    committed_rids.push_back(rid);
+  }
+  bustub_instance->txn_manager_->Commit(txn2);
 
   // Do checkpoint
   bustub_instance->checkpoint_manager_->BeginCheckpoint();
   bustub_instance->checkpoint_manager_->EndCheckpoint();
 
-  // Hacky
-  Page *pages = dynamic_cast<BufferPoolManagerInstance *>(bustub_instance->buffer_pool_manager_)->GetPages();
-  size_t pool_size = bustub_instance->buffer_pool_manager_->GetPoolSize();
-
-  // make sure that all pages in the buffer pool are marked as non-dirty
-  bool all_pages_clean = true;
-  for (size_t i = 0; i < pool_size; i++) {
-    Page *page = &pages[i];
-    page_id_t page_id = page->GetPageId();
-
-    if (page_id != INVALID_PAGE_ID && page->IsDirty()) {
-      all_pages_clean = false;
-      break;
-    }
-  }
-  EXPECT_TRUE(all_pages_clean);
-
-  // compare each page in the buffer pool to that page's
-  // data on disk. ensure they match after the checkpoint
-  bool all_pages_match = true;
-  auto *disk_data = new char[BUSTUB_PAGE_SIZE];
-  for (size_t i = 0; i < pool_size; i++) {
-    Page *page = &pages[i];
-    page_id_t page_id = page->GetPageId();
-
-    if (page_id != INVALID_PAGE_ID) {
-      bustub_instance->disk_manager_->ReadPage(page_id, disk_data);
-      if (std::memcmp(disk_data, page->GetData(), BUSTUB_PAGE_SIZE) != 0) {
-        all_pages_match = false;
-        break;
-      }
-    }
-  }
-
-  EXPECT_TRUE(all_pages_match);
-  delete[] disk_data;
-
   // Verify all committed transactions flushed to disk
   lsn_t persistent_lsn = bustub_instance->log_manager_->GetPersistentLSN();
   lsn_t next_lsn = bustub_instance->log_manager_->GetNextLSN();
   EXPECT_EQ(persistent_lsn, (next_lsn - 1));
 
   // verify log was flushed and each page's LSN <= persistent lsn
+  auto *bpm = dynamic_cast<BufferPoolManagerInstance *>(bustub_instance->buffer_pool_manager_);
+  size_t pool_size = bustub_instance->buffer_pool_manager_->GetPoolSize();
   bool all_pages_lte = true;
   for (size_t i = 0; i < pool_size; i++) {
-    Page *page = &pages[i];
+    Page *page = bpm->GetFrame(static_cast<frame_id_t>(i));
     page_id_t page_id = page->GetPageId();
 
     if (page_id != INVALID_PAGE_ID && page->GetLSN() > persistent_lsn) {
@@ -310,14 +304,295 @@ TEST_F(RecoveryTest, DISABLED_CheckpointTest) {
       break;
     }
   }
-
   EXPECT_TRUE(all_pages_lte);
 
+  // the master record points to the checkpoint record, which holds the tables and where redo starts
+  int64_t checkpoint_offset = bustub_instance->disk_manager_->ReadMasterRecord();
+  ASSERT_GT(checkpoint_offset, 0);
+  auto *log_data = new char[LOG_BUFFER_SIZE];
+  ASSERT_TRUE(bustub_instance->disk_manager_->ReadLog(log_data, LOG_BUFFER_SIZE, checkpoint_offset));
+  LogRecord checkpoint;
+  LogRecovery reader(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                     bustub_instance->log_manager_);
+  ASSERT_TRUE(reader.DeserializeLogRecord(log_data, LOG_BUFFER_SIZE, &checkpoint));
+  delete[] log_data;
+  EXPECT_EQ(checkpoint.GetLogRecordType(), LogRecordType::CHECKPOINT);
+  EXPECT_TRUE(checkpoint.GetActiveTxns().empty());
+  EXPECT_FALSE(checkpoint.GetDirtyPages().empty());
+  EXPECT_GT(checkpoint.GetRedoOffset(), 0);
+  EXPECT_LT(checkpoint.GetRedoOffset(), checkpoint_offset);
+
+  // a committed transaction after the checkpoint, and one that is still running at the crash
+  Transaction *txn3 = bustub_instance->txn_manager_->Begin();
+  for (int i = 0; i < 10; i++) {
+    RID rid;
+    EXPECT_TRUE(test_table->InsertTuple(tuple, &rid, txn3));
+    committed_rids.push_back(rid);
+  }
+  bustub_instance->txn_manager_->Commit(txn3);
+  Transaction *txn4 = bustub_instance->txn_manager_->Begin();
+  RID loser_rid;
+  EXPECT_TRUE(test_table->InsertTuple(tuple, &loser_rid, txn4));
+  bustub_instance->log_manager_->Flush(bustub_instance->log_manager_->GetNextLSN() - 1);
+  bustub_instance->buffer_pool_manager_->FlushPage(loser_rid.GetPageId());
+
   delete txn;
   delete txn1;
+  delete txn2;
+  delete txn3;
+  delete txn4;
+  delete test_table;
+
+  LOG_INFO("System crash before txn4 commits");
+  delete bustub_instance;
+
+  LOG_INFO("System restarted..");
+  bustub_instance = new BustubInstance(db_file_);
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+
+  LOG_INFO("Check the committed tuples are recovered and txn4 is undone");
+  txn = bustub_instance->txn_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  for (const auto &rid : committed_rids) {
+    Tuple old_tuple;
+    ASSERT_TRUE(test_table->GetTuple(rid, &old_tuple, txn)) << rid.ToString();
+    ASSERT_EQ(old_tuple.GetValue(&schema, 0).CompareEquals(val_0), CmpBool::CmpTrue);
+    ASSERT_EQ(old_tuple.GetValue(&schema, 1).CompareEquals(val_1), CmpBool::CmpTrue);
+  }
+  Tuple loser_tuple;
+  ASSERT_FALSE(test_table->GetTuple(loser_rid, &loser_tuple, txn));
+  bustub_instance->txn_manager_->Commit(txn);
+
+  delete txn;
+  delete test_table;
+  delete log_recovery;
+
+  LOG_INFO("Shutdown System");
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, RestartTest) {
+  auto *bustub_instance = new BustubInstance(db_file_);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple = ConstructTuple(&schema);
+  const Tuple tuple1 = ConstructTuple(&schema);
+
+  LOG_INFO("Insert a tuple and write the page out, so its LSN on disk is the newest one");
+  Transaction *txn = bustub_instance->txn_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  RID rid;
+  ASSERT_TRUE(test_table->InsertTuple(tuple, &rid, txn));
+  bustub_instance->txn_manager_->Commit(txn);
+  bustub_instance->buffer_pool_manager_->FlushAllPages();
+  const lsn_t next_lsn = bustub_instance->log_manager_->GetNextLSN();
+  delete txn;
+  delete test_table;
+
+  LOG_INFO("System crash while a record was being written, only its first bytes made it to the log");
+  delete bustub_instance;
+  const auto log_size = std::filesystem::file_size(log_file_);
+  {
+    std::ofstream log(log_file_, std::ios::binary | std::ios::app);
+    const int32_t torn_size = 64;
+    log.write(reinterpret_cast<const char *>(&torn_size), sizeof(torn_size));
+  }
+
+  LOG_INFO("System restart, the torn record is cut off and the LSNs continue after the log on disk");
+  bustub_instance = new BustubInstance(db_file_);
+  EXPECT_EQ(log_size, std::filesystem::file_size(log_file_));
+  EXPECT_EQ(next_lsn, bustub_instance->log_manager_->GetNextLSN());
+  EXPECT_EQ(next_lsn - 1, bustub_instance->log_manager_->GetPersistentLSN());
+  auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                       bustub_instance->log_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+
+  LOG_INFO("Commit a second tuple into the same page, it is only in the log when the system crashes again");
+  bustub_instance->log_manager_->RunFlushThread();
+  txn = bustub_instance->txn_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  RID rid1;
+  ASSERT_TRUE(test_table->InsertTuple(tuple1, &rid1, txn));
+  ASSERT_EQ(first_page_id, rid1.GetPageId());
+  bustub_instance->txn_manager_->Commit(txn);
+  EXPECT_LT(next_lsn, bustub_instance->log_manager_->GetNextLSN());
+  delete txn;
+  delete test_table;
+
+  LOG_INFO("System crash");
+  delete bustub_instance;
+
+  LOG_INFO("System restart, redo must not skip the second tuple");
+  bustub_instance = new BustubInstance(db_file_);
+  log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                 bustub_instance->log_manager_);
+  log_recovery->Redo();
+  log_recovery->Undo();
+  delete log_recovery;
+
+  txn = bustub_instance->txn_manager_->Begin();
+  test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                             bustub_instance->log_manager_, first_page_id);
+  Tuple old_tuple;
+  Tuple old_tuple1;
+  ASSERT_TRUE(test_table->GetTuple(rid, &old_tuple, txn));
+  ASSERT_TRUE(test_table->GetTuple(rid1, &old_tuple1, txn));
+  EXPECT_EQ(old_tuple.GetValue(&schema, 0).CompareEquals(tuple.GetValue(&schema, 0)), CmpBool::CmpTrue);
+  EXPECT_EQ(old_tuple1.GetValue(&schema, 0).CompareEquals(tuple1.GetValue(&schema, 0)), CmpBool::CmpTrue);
+  bustub_instance->txn_manager_->Commit(txn);
+  delete txn;
   delete test_table;
 
   LOG_INFO("Shutdown System");
   delete bustub_instance;
 }
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, RepeatedRecoveryTest) {
+  auto *bustub_instance = new BustubInstance(db_file_);
+  bustub_instance->log_manager_->RunFlushThread();
+
+  Column col1{"a", TypeId::VARCHAR, 20};
+  Column col2{"b", TypeId::SMALLINT};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  const Tuple tuple_a = ConstructTuple(&schema);
+  const Tuple tuple_b = ConstructTuple(&schema);
+  const Tuple tuple_c = ConstructTuple(&schema);
+
+  LOG_INFO("Insert two tuples and delete the first one, which frees its slot");
+  Transaction *txn = bustub_instance->txn_manager_->Begin();
+  auto *test_table = new TableHeap(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                                   bustub_instance->log_manager_, txn);
+  page_id_t first_page_id = test_table->GetFirstPageId();
+  RID rid_a;
+  RID rid_b;
+  ASSERT_TRUE(test_table->InsertTuple(tuple_a, &rid_a, txn));
+  ASSERT_TRUE(test_table->InsertTuple(tuple_b, &rid_b, txn));
+  bustub_instance->txn_manager_->Commit(txn);
+  delete txn;
+  txn = bustub_instance->txn_manager_->Begin();
+  ASSERT_TRUE(test_table->MarkDelete(rid_a, txn));
+  bustub_instance->txn_manager_->Commit(txn);
+  delete txn;
+
+  LOG_INFO("A loser deletes the second tuple for good and inserts a third one into the free slot");
+  txn = bustub_instance->txn_manager_->Begin();
+  ASSERT_TRUE(test_table->MarkDelete(rid_b, txn));
+  test_table->ApplyDelete(rid_b, txn);
+  RID rid_c;
+  ASSERT_TRUE(test_table->InsertTuple(tuple_c, &rid_c, txn));
+  ASSERT_EQ(rid_a, rid_c);
+  bustub_instance->buffer_pool_manager_->FlushAllPages();
+  delete txn;
+  delete test_table;
+
+  auto check = [&]() {
+    Transaction *reader = bustub_instance->txn_manager_->Begin();
+    TableHeap table(bustub_instance->buffer_pool_manager_, bustub_instance->lock_manager_,
+                    bustub_instance->log_manager_, first_page_id);
+    Tuple tuple;
+    EXPECT_FALSE(table.GetTuple(rid_a, &tuple, reader));
+    ASSERT_TRUE(table.GetTuple(rid_b, &tuple, reader));
+    EXPECT_EQ(tuple.GetValue(&schema, 0).CompareEquals(tuple_b.GetValue(&schema, 0)), CmpBool::CmpTrue);
+    bustub_instance->txn_manager_->Commit(reader);
+    delete reader;
+  };
+
+  // The second recovery must not roll the loser back again, whether or not the first one wrote its pages back.
+  for (int i = 0; i < 2; i++) {
+    LOG_INFO("System crash");
+    delete bustub_instance;
+
+    LOG_INFO("System restart, the second tuple is back under its RID and the third one is gone");
+    bustub_instance = new BustubInstance(db_file_);
+    auto *log_recovery = new LogRecovery(bustub_instance->disk_manager_, bustub_instance->buffer_pool_manager_,
+                                         bustub_instance->log_manager_);
+    log_recovery->Redo();
+    log_recovery->Undo();
+    delete log_recovery;
+    check();
+    bustub_instance->buffer_pool_manager_->FlushAllPages();
+  }
+
+  LOG_INFO("Shutdown System");
+  delete bustub_instance;
+}
+
+// NOLINTNEXTLINE
+TEST_F(RecoveryTest, ParallelRedoTest) {
+  Column col1{"a", TypeId::INTEGER};
+  Column col2{"b", TypeId::VARCHAR, 200};
+  std::vector<Column> cols{col1, col2};
+  Schema schema{cols};
+  auto make_tuple = [&](int a, char c) {
+    std::vector<Value> values{ValueFactory::GetIntegerValue(a), ValueFactory::GetVarcharValue(std::string(200, c))};
+    return Tuple{values, &schema};
+  };
+
+  // rid -> the value of column b it should hold after recovery, '\0' if deleted
+  std::unordered_map<RID, char> expected;
+  page_id_t first_page_id;
+  {
+    // A pool smaller than the table, so some pages reach the disk before the crash and some do not.
+    DiskManager disk_manager(db_file_);
+    LogManager log_manager(&disk_manager);
+    BufferPoolManagerInstance bpm(64, &disk_manager, LRUK_REPLACER_K, &log_manager);
+    LockManager lock_manager;
+    TransactionManager txn_manager(&lock_manager, &log_manager);
+    log_manager.RunFlushThread();
+
+    Transaction *txn = txn_manager.Begin();
+    TableHeap table(&bpm, &lock_manager, &log_manager, txn);
+    first_page_id = table.GetFirstPageId();
+    std::vector<RID> rids(2000);
+    for (int i = 0; i < 2000; i++) {
+      ASSERT_TRUE(table.InsertTuple(make_tuple(i, 'a'), &rids[i], txn));
+      expected[rids[i]] = 'a';
+    }
+    for (int i = 0; i < 2000; i += 3) {
+      ASSERT_TRUE(table.UpdateTuple(make_tuple(i, 'b'), rids[i], txn));
+      expected[rids[i]] = 'b';
+    }
+    for (int i = 0; i < 2000; i += 5) {
+      ASSERT_TRUE(table.MarkDelete(rids[i], txn));
+      expected[rids[i]] = '\0';
+    }
+    txn_manager.Commit(txn);
+    delete txn;
+    log_manager.StopFlushThread();
+  }
+
+  LOG_INFO("System restart...");
+  DiskManager disk_manager(db_file_);
+  LogManager log_manager(&disk_manager);
+  BufferPoolManagerInstance bpm(64, &disk_manager, LRUK_REPLACER_K, &log_manager);
+  LockManager lock_manager;
+  LogRecovery log_recovery(&disk_manager, &bpm, &log_manager, 4);
+  log_recovery.Redo();
+  log_recovery.Undo();
+
+  TableHeap table(&bpm, &lock_manager, &log_manager, first_page_id);
+  for (const auto &[rid, c] : expected) {
+    Tuple tuple;
+    ASSERT_EQ(table.GetTuple(rid, &tuple, nullptr), c != '\0') << rid.ToString();
+    if (c != '\0') {
+      EXPECT_EQ(tuple.GetValue(&schema, 1).GetData()[0], c) << rid.ToString();
+    }
+  }
+}
 }  // namespace bustub
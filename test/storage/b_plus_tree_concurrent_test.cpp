@@ -10,6 +10,7 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include <atomic>
 #include <chrono>  // NOLINT
 #include <cstdio>
 #include <functional>
@@ -333,4 +334,71 @@ TEST(BPlusTreeConcurrentTest, ENABLE_MixTest) {
   remove("test.log");
 }
 
+TEST(BPlusTreeConcurrentTest, ENABLE_ReadWhileWriteTest) {
+  // create KeyComparator and index schema
+  auto key_schema = ParseCreateStatement("a bigint");
+  GenericComparator<8> comparator(key_schema.get());
+
+  auto *disk_manager = new DiskManager("test.db");
+  BufferPoolManager *bpm = new BufferPoolManagerInstance(50, disk_manager);
+  // small nodes, so the writers split and merge all the time
+  BPlusTree<GenericKey<8>, RID, GenericComparator<8>> tree("foo_pk", bpm, comparator, 3, 4);
+
+  // create and fetch header_page
+  page_id_t page_id;
+  auto header_page = bpm->NewPage(&page_id);
+  (void)header_page;
+  // even keys stay in the tree the whole time
+  std::vector<int64_t> stable_keys;
+  std::vector<int64_t> churn_keys;
+  for (int64_t key = 0; key < 400; key += 2) {
+    stable_keys.push_back(key);
+    churn_keys.push_back(key + 1);
+  }
+  InsertHelper(&tree, stable_keys);
+
+  std::atomic<bool> done{false};
+  std::atomic<int> missing{0};
+  auto reader = [&]() {
+    GenericKey<8> index_key;
+    std::vector<RID> rids;
+    while (!done) {
+      for (auto key : stable_keys) {
+        rids.clear();
+        index_key.SetFromInteger(key);
+        if (!tree.GetValue(index_key, &rids) || rids.size() != 1 || static_cast<int64_t>(rids[0].GetSlotNum()) != key) {
+          missing++;
+        }
+      }
+    }
+  };
+  std::vector<std::thread> readers;
+  for (uint64_t i = 0; i < 2; i++) {
+    readers.emplace_back(reader);
+  }
+  // odd keys go in and out around the even ones
+  for (int round = 0; round < 3; round++) {
+    LaunchParallelTest(2, InsertHelperSplit, &tree, churn_keys, 2);
+    LaunchParallelTest(2, DeleteHelperSplit, &tree, churn_keys, 2);
+  }
+  done = true;
+  for (auto &thread : readers) {
+    thread.join();
+  }
+  EXPECT_EQ(missing, 0);
+
+  int64_t size = 0;
+  for (auto iterator = tree.Begin(); iterator != tree.End(); ++iterator) {
+    EXPECT_EQ(static_cast<int64_t>((*iterator).second.GetSlotNum()), size * 2);
+    size = size + 1;
+  }
+  EXPECT_EQ(size, static_cast<int64_t>(stable_keys.size()));
+
+  bpm->UnpinPage(HEADER_PAGE_ID, true);
+  delete disk_manager;
+  delete bpm;
+  remove("test.db");
+  remove("test.log");
+}
+
 }  // namespace bustub
@@ -48,13 +48,11 @@ TEST(BPlusTreeTests, ENABLE_DeletePre1){
     index_key.SetFromInteger(key);
     tree.Insert(index_key, rid, transaction);
 
-    std::cout<<tree.fetch_count<<","<<tree.unpin_count<<","<<key<<"\n";
+    std::cout<<key<<"\n";
   } // 
   tree.Draw(bpm, "btree.txt");
   char file_name[128];
   int k = 0;
-  tree.fetch_count = 0;
-  tree.unpin_count = 0;
   for (auto key : keys) {
     int64_t value = key & 0xFFFFFFFF;
     rid.Set(static_cast<int32_t>(key >> 32), value);
@@ -62,7 +60,7 @@ TEST(BPlusTreeTests, ENABLE_DeletePre1){
     tree.Remove(index_key, nullptr);
 
     sprintf(file_name, "/data/code/bustub2022/tmp/%d_delete_key_%ld.txt", k++, key);
-    std::cout<<tree.fetch_count<<","<<tree.unpin_count<<","<<key<<"\n";
+    std::cout<<key<<"\n";
 
     tree.Draw(bpm, file_name);
   }
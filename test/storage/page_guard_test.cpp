@@ -0,0 +1,201 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// page_guard_test.cpp
+//
+// Identification: test/storage/page_guard_test.cpp
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#include "storage/page/page_guard.h"
+
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>  // NOLINT
+#include <utility>
+#include <vector>
+
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "gtest/gtest.h"
+#include "storage/disk/disk_manager_memory.h"
+
+namespace bustub {
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, DropAndMoveTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(5, disk_manager.get(), 2);
+
+  page_id_t page_id;
+  Page *page = bpm->NewPage(&page_id);
+  ASSERT_NE(nullptr, page);
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  ASSERT_EQ(0, page->GetPinCount());
+
+  {
+    auto guard = bpm->FetchPageBasic(page_id);
+    EXPECT_TRUE(guard.IsValid());
+    EXPECT_EQ(page_id, guard.PageId());
+    EXPECT_EQ(1, page->GetPinCount());
+
+    // moving hands the pin over, it must not be released twice
+    BasicPageGuard other = std::move(guard);
+    EXPECT_EQ(1, page->GetPinCount());
+    other.Drop();
+    EXPECT_FALSE(other.IsValid());
+    EXPECT_EQ(0, page->GetPinCount());
+    other.Drop();
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  {
+    auto read_guard = bpm->FetchPageRead(page_id);
+    auto another_read_guard = bpm->FetchPageRead(page_id);
+    EXPECT_EQ(2, page->GetPinCount());
+    EXPECT_FALSE(page->IsDirty());
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+
+  {
+    auto write_guard = bpm->FetchPageWrite(page_id);
+    std::strcpy(write_guard.GetDataMut(), "guarded");  // NOLINT
+  }
+  EXPECT_EQ(0, page->GetPinCount());
+  EXPECT_TRUE(page->IsDirty());
+  // the write latch was released, a reader can come in
+  EXPECT_EQ(0, std::strcmp(bpm->FetchPageRead(page_id).GetData(), "guarded"));
+
+  // a fetch that cannot get a frame gives an empty guard
+  std::vector<WritePageGuard> guards;
+  for (int i = 0; i < 5; i++) {
+    page_id_t temp;
+    guards.push_back(bpm->NewPageWrite(&temp));
+    ASSERT_TRUE(guards.back().IsValid());
+  }
+  EXPECT_FALSE(bpm->FetchPageRead(page_id).IsValid());
+  guards.clear();
+  EXPECT_TRUE(bpm->FetchPageRead(page_id).IsValid());
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, UnpinBatchTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<ParallelBufferPoolManager>(3, 4, disk_manager.get(), 2);
+
+  std::vector<page_id_t> page_ids;
+  std::vector<Page *> pages;
+  for (int i = 0; i < 6; i++) {
+    page_id_t page_id;
+    pages.push_back(bpm->NewPage(&page_id));
+    ASSERT_NE(nullptr, pages.back());
+    page_ids.push_back(page_id);
+    ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  }
+
+  {
+    UnpinBatch batch(bpm.get(), 4);
+    for (int i = 0; i < 6; i++) {
+      auto guard = bpm->FetchPageWrite(page_ids[i]);
+      if (i % 2 == 0) {
+        guard.SetDirty();
+      }
+      guard.Drop(&batch);
+      EXPECT_FALSE(guard.IsValid());
+    }
+    // the first four went back to the pool when the batch filled up, the last two are still pinned
+    EXPECT_EQ(2, batch.Size());
+    for (int i = 0; i < 4; i++) {
+      EXPECT_EQ(0, pages[i]->GetPinCount());
+    }
+    EXPECT_EQ(1, pages[4]->GetPinCount());
+    EXPECT_EQ(1, pages[5]->GetPinCount());
+    // but no longer latched
+    EXPECT_TRUE(bpm->FetchPageWrite(page_ids[5]).IsValid());
+  }
+  for (int i = 0; i < 6; i++) {
+    EXPECT_EQ(0, pages[i]->GetPinCount());
+    EXPECT_EQ(i % 2 == 0, pages[i]->IsDirty());
+  }
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, OptimisticTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(5, disk_manager.get(), 2);
+
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  auto guard = bpm->FetchPageOptimistic(page_id);
+  ASSERT_TRUE(guard.IsValid());
+  EXPECT_TRUE(guard.Validate());
+  // readers do not invalidate each other
+  bpm->FetchPageRead(page_id).Drop();
+  EXPECT_TRUE(guard.Validate());
+  {
+    auto write_guard = bpm->FetchPageWrite(page_id);
+    // neither while the writer is active nor after it is gone
+    EXPECT_FALSE(guard.Validate());
+    EXPECT_FALSE(bpm->FetchPageOptimistic(page_id).Validate());
+  }
+  EXPECT_FALSE(guard.Validate());
+  EXPECT_FALSE(guard.UpgradeRead().IsValid());
+  EXPECT_TRUE(guard.IsValid());
+
+  guard = bpm->FetchPageOptimistic(page_id);
+  Page *page = bpm->FetchPage(page_id);
+  EXPECT_EQ(2, page->GetPinCount());
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+  // the pin moves to the read guard
+  auto read_guard = guard.UpgradeRead();
+  ASSERT_TRUE(read_guard.IsValid());
+  EXPECT_FALSE(guard.IsValid());
+  EXPECT_EQ(1, page->GetPinCount());
+  read_guard.Drop();
+  EXPECT_EQ(0, page->GetPinCount());
+}
+
+// NOLINTNEXTLINE
+TEST(PageGuardTest, OptimisticConcurrentTest) {
+  auto disk_manager = std::make_unique<DiskManagerUnlimitedMemory>();
+  auto bpm = std::make_unique<BufferPoolManagerInstance>(5, disk_manager.get(), 2);
+
+  page_id_t page_id;
+  ASSERT_NE(nullptr, bpm->NewPage(&page_id));
+  ASSERT_TRUE(bpm->UnpinPage(page_id, false));
+
+  // the writer keeps both counters equal under the write latch, a validated read must never see them differ
+  const int write_cnt = 20000;
+  std::atomic<bool> done{false};
+  std::thread writer([&] {
+    for (int i = 1; i <= write_cnt; i++) {
+      auto guard = bpm->FetchPageWrite(page_id);
+      auto *counters = guard.AsMut<std::atomic<int>>();
+      counters[0].store(i, std::memory_order_relaxed);
+      counters[1].store(i, std::memory_order_relaxed);
+    }
+    done = true;
+  });
+
+  while (!done) {
+    auto guard = bpm->FetchPageOptimistic(page_id);
+    const auto *counters = guard.As<std::atomic<int>>();
+    int first = counters[0].load(std::memory_order_relaxed);
+    int second = counters[1].load(std::memory_order_relaxed);
+    if (guard.Validate()) {
+      EXPECT_EQ(first, second);
+    }
+  }
+  writer.join();
+  auto guard = bpm->FetchPageOptimistic(page_id);
+  EXPECT_EQ(write_cnt, guard.As<std::atomic<int>>()[1].load());
+  EXPECT_TRUE(guard.Validate());
+}
+
+}  // namespace bustub
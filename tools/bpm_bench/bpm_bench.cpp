@@ -0,0 +1,599 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_access_strategy.h"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "buffer/lru_k_replacer.h"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "buffer/pool_snapshot.h"
+#include "catalog/schema.h"
+#include "concurrency/transaction.h"
+#include "fmt/core.h"
+#include "legacy_lru_k.h"
+#include "storage/disk/disk_manager_memory.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+#include <fcntl.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+static const size_t BUSTUB_BPM_BENCH_DURATION_MS = 1000;
+static const size_t BUSTUB_BPM_BENCH_PAGE_CNT = 1024;
+static const size_t BUSTUB_BPM_BENCH_POOL_SIZE = 2048;
+static const size_t BUSTUB_BPM_BENCH_INSTANCES = 8;
+static const size_t BUSTUB_BPM_BENCH_MAX_THREAD = 32;
+static const size_t BUSTUB_BPM_BENCH_TABLE_POOL_SIZE = 64;
+static const size_t BUSTUB_BPM_BENCH_TABLE_TUPLE_CNT = 2048;
+static const size_t BUSTUB_BPM_BENCH_TABLE_THREAD = 4;
+static const size_t BUSTUB_BPM_BENCH_SCAN_POOL_SIZE = 256;
+static const size_t BUSTUB_BPM_BENCH_SCAN_HOT_PAGE_CNT = 192;
+static const size_t BUSTUB_BPM_BENCH_SCAN_TUPLE_CNT = 8192;
+static const size_t BUSTUB_BPM_BENCH_SCAN_ROUND = 4;
+static const size_t BUSTUB_BPM_BENCH_REPLACER_FRAME_CNT = 1000000;
+static const size_t BUSTUB_BPM_BENCH_REPLACER_MAX_THREAD = 8;
+static const size_t BUSTUB_BPM_BENCH_WARM_POOL_SIZE = 1024;
+static const size_t BUSTUB_BPM_BENCH_WARM_PAGE_CNT = 4096;
+static const size_t BUSTUB_BPM_BENCH_WARM_QUERY_CNT = 20000;
+static const size_t BUSTUB_BPM_BENCH_WARM_THREAD = 4;
+static const uint64_t BUSTUB_BPM_BENCH_WARM_SEEK_US = 1000;
+static const uint64_t BUSTUB_BPM_BENCH_WARM_SEQUENTIAL_READ_US = 50;
+static const size_t BUSTUB_BPM_BENCH_EXTENT_TABLE_CNT = 4;
+static const size_t BUSTUB_BPM_BENCH_EXTENT_TUPLE_CNT = 4096;
+static const size_t BUSTUB_BPM_BENCH_EXTENT_POOL_SIZE = 256;
+
+/** In-memory disk that counts page reads, i.e. buffer pool misses, in total and for the pages below hot_page_end_. */
+class CountingDiskManager : public bustub::DiskManagerUnlimitedMemory {
+ public:
+  explicit CountingDiskManager(bustub::page_id_t hot_page_end) : hot_page_end_(hot_page_end) {}
+
+  auto ReadPage(bustub::page_id_t page_id, char *page_data) -> bool override {
+    read_cnt_++;
+    if (page_id < hot_page_end_) {
+      hot_read_cnt_++;
+    }
+    return DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  const bustub::page_id_t hot_page_end_;
+  std::atomic<uint64_t> read_cnt_{0};
+  std::atomic<uint64_t> hot_read_cnt_{0};
+};
+
+/**
+ * In-memory disk with the read latency of a spinning disk: a read that does not continue the previous read of the same
+ * thread pays for a seek.
+ */
+class LatencyDiskManager : public bustub::DiskManagerUnlimitedMemory {
+ public:
+  auto ReadPage(bustub::page_id_t page_id, char *page_data) -> bool override {
+    thread_local bustub::page_id_t last_page_id = bustub::INVALID_PAGE_ID;
+    read_cnt_++;
+    std::this_thread::sleep_for(std::chrono::microseconds(
+        page_id == last_page_id + 1 ? BUSTUB_BPM_BENCH_WARM_SEQUENTIAL_READ_US : BUSTUB_BPM_BENCH_WARM_SEEK_US));
+    last_page_id = page_id;
+    return DiskManagerUnlimitedMemory::ReadPage(page_id, page_data);
+  }
+
+  std::atomic<uint64_t> read_cnt_{0};
+};
+
+/** A buffer pool without extents: every table page comes from NewPage(), like before extent allocation. */
+class NoExtentBufferPoolManager : public bustub::BufferPoolManagerInstance {
+ public:
+  using BufferPoolManagerInstance::BufferPoolManagerInstance;
+
+  auto AllocateExtent(size_t /*page_cnt*/) -> bustub::page_id_t override { return bustub::INVALID_PAGE_ID; }
+};
+
+struct BpmBenchConfig {
+  uint64_t duration_ms_{BUSTUB_BPM_BENCH_DURATION_MS};
+  size_t page_cnt_{BUSTUB_BPM_BENCH_PAGE_CNT};
+  size_t pool_size_{BUSTUB_BPM_BENCH_POOL_SIZE};
+  size_t max_thread_{BUSTUB_BPM_BENCH_MAX_THREAD};
+};
+
+/**
+ * Build a buffer pool with `instances` shards and `pool_size` frames in total, then pre-populate it with `page_cnt`
+ * pages so that the measured fetches exercise the latching path rather than the disk.
+ */
+auto MakeBufferPool(size_t instances, size_t pool_size, bustub::DiskManager *disk_manager, size_t page_cnt,
+                    std::vector<bustub::page_id_t> *page_ids) -> std::unique_ptr<bustub::BufferPoolManager> {
+  std::unique_ptr<bustub::BufferPoolManager> bpm;
+  if (instances > 1) {
+    bpm = std::make_unique<bustub::ParallelBufferPoolManager>(instances, pool_size / instances, disk_manager);
+  } else {
+    bpm = std::make_unique<bustub::BufferPoolManagerInstance>(pool_size, disk_manager);
+  }
+  for (size_t i = 0; i < page_cnt; i++) {
+    bustub::page_id_t page_id;
+    auto *page = bpm->NewPage(&page_id);
+    if (page == nullptr) {
+      throw std::runtime_error("buffer pool is too small for the bench working set");
+    }
+    bpm->UnpinPage(page_id, true);
+    page_ids->push_back(page_id);
+  }
+  return bpm;
+}
+
+/** @return FetchPage + UnpinPage pairs per second with `thread_cnt` threads hammering the pool. */
+auto RunFetchBench(bustub::BufferPoolManager *bpm, const std::vector<bustub::page_id_t> &page_ids, size_t thread_cnt,
+                   uint64_t duration_ms) -> double {
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_ops{0};
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < thread_cnt; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      std::mt19937 gen(thread_id);
+      std::uniform_int_distribution<size_t> dis(0, page_ids.size() - 1);
+      uint64_t ops = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto page_id = page_ids[dis(gen)];
+        auto *page = bpm->FetchPage(page_id);
+        if (page == nullptr) {
+          continue;
+        }
+        bpm->UnpinPage(page_id, false);
+        ops++;
+      }
+      total_ops += ops;
+    });
+  }
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = ClockMs() - start;
+  return static_cast<double>(total_ops) / static_cast<double>(elapsed) * 1000;
+}
+
+/**
+ * TableHeap write workload: fill a table that is 4x larger than the pool, then let `thread_cnt` threads update random
+ * tuples for `duration_ms`. Every update dirties its page, so most victims are dirty unless the background writer has
+ * cleaned them first. The pages live in a real file, so foreground write-backs pay the disk latency.
+ */
+void RunTableBench(bool bg_writer, const bustub::BackgroundWriterOptions &options, size_t thread_cnt,
+                   uint64_t duration_ms) {
+  const std::string db_name = "bpm_bench.db";
+  bustub::DiskManager disk_manager(db_name);
+  bustub::BufferPoolManagerInstance bpm(BUSTUB_BPM_BENCH_TABLE_POOL_SIZE, &disk_manager);
+
+  bustub::Schema schema({bustub::Column("id", bustub::TypeId::INTEGER),
+                         bustub::Column("payload", bustub::TypeId::VARCHAR, 512)});
+  const std::string payload(400, 'x');
+  auto make_tuple = [&](int32_t id) {
+    return bustub::Tuple({bustub::ValueFactory::GetIntegerValue(id), bustub::ValueFactory::GetVarcharValue(payload)},
+                         &schema);
+  };
+
+  bustub::Transaction load_txn(0);
+  bustub::TableHeap table(&bpm, nullptr, nullptr, &load_txn);
+  std::vector<bustub::RID> rids(BUSTUB_BPM_BENCH_TABLE_TUPLE_CNT);
+  for (size_t i = 0; i < rids.size(); i++) {
+    table.InsertTuple(make_tuple(static_cast<int32_t>(i)), &rids[i], &load_txn);
+    load_txn.GetWriteSet()->clear();
+  }
+
+  if (bg_writer) {
+    bpm.StartBackgroundWriter(options);
+  }
+  const uint64_t fg_writes_before = bpm.GetForegroundWriteCount();
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_ops{0};
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < thread_cnt; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      std::mt19937 gen(thread_id);
+      std::uniform_int_distribution<size_t> dis(0, rids.size() - 1);
+      bustub::Transaction txn(static_cast<bustub::txn_id_t>(thread_id + 1));
+      uint64_t ops = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        auto idx = dis(gen);
+        table.UpdateTuple(make_tuple(static_cast<int32_t>(idx)), rids[idx], &txn);
+        txn.GetWriteSet()->clear();
+        ops++;
+      }
+      total_ops += ops;
+    });
+  }
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = ClockMs() - start;
+  bpm.StopBackgroundWriter();
+
+  fmt::print("{:>10} {:>14.0f} {:>12} {:>12}\n", bg_writer ? "on" : "off",
+             static_cast<double>(total_ops) / static_cast<double>(elapsed) * 1000,
+             bpm.GetForegroundWriteCount() - fg_writes_before, bpm.GetBackgroundWriteCount());
+  disk_manager.ShutDown();
+  std::remove(db_name.c_str());
+}
+
+/**
+ * Mixed OLTP + scan workload: a hot set of three quarters of the pool is fetched at random, one fetch per tuple
+ * returned by a sequential scan over a table about 4x larger than the pool. Prints the hit ratio of the hot fetches and
+ * the disk reads of the whole run, with the scan going through the main replacer and through a ring of
+ * SCAN_RING_BUFFER_SIZE frames.
+ */
+void RunScanBench(bool use_ring) {
+  // The hot pages are allocated first, so they are pages [0, BUSTUB_BPM_BENCH_SCAN_HOT_PAGE_CNT).
+  CountingDiskManager disk_manager(static_cast<bustub::page_id_t>(BUSTUB_BPM_BENCH_SCAN_HOT_PAGE_CNT));
+  std::vector<bustub::page_id_t> hot_page_ids;
+  bustub::page_id_t first_table_page_id;
+  bustub::Transaction txn(0);
+  {
+    // Load through a separate pool: every insert walks the page chain, which would leave the whole table looking hot
+    // to the replacer of the measured pool.
+    bustub::BufferPoolManagerInstance load_bpm(BUSTUB_BPM_BENCH_SCAN_POOL_SIZE, &disk_manager);
+    for (size_t i = 0; i < BUSTUB_BPM_BENCH_SCAN_HOT_PAGE_CNT; i++) {
+      bustub::page_id_t page_id;
+      load_bpm.NewPage(&page_id);
+      load_bpm.UnpinPage(page_id, true);
+      hot_page_ids.push_back(page_id);
+    }
+    bustub::Schema schema({bustub::Column("id", bustub::TypeId::INTEGER),
+                           bustub::Column("payload", bustub::TypeId::VARCHAR, 512)});
+    const std::string payload(400, 'x');
+    bustub::TableHeap table(&load_bpm, nullptr, nullptr, &txn);
+    for (size_t i = 0; i < BUSTUB_BPM_BENCH_SCAN_TUPLE_CNT; i++) {
+      bustub::RID rid;
+      table.InsertTuple(bustub::Tuple({bustub::ValueFactory::GetIntegerValue(static_cast<int32_t>(i)),
+                                       bustub::ValueFactory::GetVarcharValue(payload)},
+                                      &schema),
+                        &rid, &txn);
+      txn.GetWriteSet()->clear();
+    }
+    first_table_page_id = table.GetFirstPageId();
+    load_bpm.FlushAllPages();
+  }
+
+  bustub::BufferPoolManagerInstance bpm(BUSTUB_BPM_BENCH_SCAN_POOL_SIZE, &disk_manager);
+  bustub::TableHeap table(&bpm, nullptr, nullptr, first_table_page_id);
+
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> dis(0, hot_page_ids.size() - 1);
+  auto fetch_hot_page = [&] {
+    auto page_id = hot_page_ids[dis(gen)];
+    bpm.FetchPage(page_id);
+    bpm.UnpinPage(page_id, false);
+  };
+  // Warm up: the hot set is resident and has a full access history before the scans start.
+  for (size_t i = 0; i < hot_page_ids.size() * bustub::LRUK_REPLACER_K * 2; i++) {
+    fetch_hot_page();
+  }
+
+  const uint64_t reads_before = disk_manager.read_cnt_;
+  const uint64_t hot_reads_before = disk_manager.hot_read_cnt_;
+  uint64_t hot_fetches = 0;
+  for (size_t round = 0; round < BUSTUB_BPM_BENCH_SCAN_ROUND; round++) {
+    std::unique_ptr<bustub::BufferAccessStrategy> strategy;
+    if (use_ring) {
+      strategy = std::make_unique<bustub::BufferAccessStrategy>(&bpm, bustub::SCAN_RING_BUFFER_SIZE);
+    }
+    for (auto iter = table.Begin(&txn, strategy.get()); iter != table.End(); ++iter) {
+      fetch_hot_page();
+      hot_fetches++;
+    }
+  }
+
+  fmt::print("{:>10} {:>14.4f} {:>12}\n", use_ring ? "ring" : "replacer",
+             1 - static_cast<double>(disk_manager.hot_read_cnt_ - hot_reads_before) / static_cast<double>(hot_fetches),
+             disk_manager.read_cnt_ - reads_before);
+}
+
+/**
+ * Startup after a restart: a pool serves skewed fetches (90% to a hot eighth of the pages, the rest to a working set
+ * that just fits the pool) until it is warm, then is restarted cold and warm from a PoolSnapshot. Prints the time
+ * the warm-up took, the time until the first BUSTUB_BPM_BENCH_WARM_QUERY_CNT fetches of the same workload are served,
+ * and the disk reads of both phases.
+ */
+void RunWarmUpBench() {
+  LatencyDiskManager disk_manager;
+  std::vector<bustub::page_id_t> page_ids;
+  auto bpm = MakeBufferPool(1, BUSTUB_BPM_BENCH_WARM_POOL_SIZE, &disk_manager, BUSTUB_BPM_BENCH_WARM_PAGE_CNT,
+                            &page_ids);
+  auto run_queries = [&](bustub::BufferPoolManager *pool, size_t query_cnt) {
+    std::vector<std::thread> threads;
+    for (size_t thread_id = 0; thread_id < BUSTUB_BPM_BENCH_WARM_THREAD; thread_id++) {
+      threads.emplace_back([&, thread_id] {
+        std::mt19937 gen(thread_id);
+        std::uniform_int_distribution<size_t> hot(0, page_ids.size() / 8 - 1);
+        std::uniform_int_distribution<size_t> any(0, page_ids.size() / 4 - 1);
+        std::uniform_int_distribution<size_t> percent(0, 99);
+        for (size_t i = 0; i < query_cnt / BUSTUB_BPM_BENCH_WARM_THREAD; i++) {
+          auto page_id = page_ids[percent(gen) < 90 ? hot(gen) : any(gen)];
+          if (pool->FetchPage(page_id) != nullptr) {
+            pool->UnpinPage(page_id, false);
+          }
+        }
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+  };
+  run_queries(bpm.get(), BUSTUB_BPM_BENCH_WARM_QUERY_CNT * 4);
+  bpm->FlushAllPages();
+  const auto snapshot = bpm->SnapshotResidentPages();
+  bpm.reset();
+
+  fmt::print("{:>8} {:>12} {:>14} {:>12}\n", "restart", "warm-up ms", "queries ms", "disk reads");
+  for (bool warm : {false, true}) {
+    bustub::BufferPoolManagerInstance pool(BUSTUB_BPM_BENCH_WARM_POOL_SIZE, &disk_manager);
+    const uint64_t reads_before = disk_manager.read_cnt_;
+    auto start = ClockMs();
+    if (warm) {
+      pool.WarmUp(snapshot, bustub::WARM_UP_THREAD_CNT);
+    }
+    auto warm_up_end = ClockMs();
+    run_queries(&pool, BUSTUB_BPM_BENCH_WARM_QUERY_CNT);
+    fmt::print("{:>8} {:>12} {:>14} {:>12}\n", warm ? "warm" : "cold", warm_up_end - start, ClockMs() - warm_up_end,
+               disk_manager.read_cnt_ - reads_before);
+  }
+}
+
+/** The replacer before the frame-indexed rewrite: the list based LruK behind a single latch. */
+class LegacyLRUKReplacer {
+ public:
+  LegacyLRUKReplacer(size_t num_frames, size_t k) : lru_k_(static_cast<int>(num_frames), static_cast<int>(k)) {}
+
+  auto Evict(bustub::frame_id_t *frame_id) -> bool {
+    std::scoped_lock sl(latch_);
+    return lru_k_.Evict(frame_id);
+  }
+
+  void RecordAccess(bustub::frame_id_t frame_id) {
+    std::scoped_lock sl(latch_);
+    lru_k_.Access(frame_id);
+  }
+
+  void SetEvictable(bustub::frame_id_t frame_id, bool set_evictable) {
+    std::scoped_lock sl(latch_);
+    lru_k_.SetEvictable(frame_id, set_evictable);
+  }
+
+ private:
+  std::mutex latch_;
+  bustub::LruK lru_k_;
+};
+
+/**
+ * Replay a buffer pool style trace against a replacer with `frame_cnt` frames: every operation accesses a frame (90%
+ * of them go to the first 10% of the frames) and pins / unpins it; every 10th operation also evicts a victim and
+ * installs it again, like a miss.
+ * @return operations per second over all threads
+ */
+template <class Replacer>
+auto RunReplacerBench(size_t frame_cnt, size_t thread_cnt, uint64_t duration_ms) -> double {
+  Replacer replacer(frame_cnt, bustub::LRUK_REPLACER_K);
+  for (size_t i = 0; i < frame_cnt; i++) {
+    replacer.RecordAccess(static_cast<bustub::frame_id_t>(i));
+  }
+  auto touch = [&](bustub::frame_id_t frame_id) {
+    replacer.RecordAccess(frame_id);
+    replacer.SetEvictable(frame_id, false);
+    replacer.SetEvictable(frame_id, true);
+  };
+
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_ops{0};
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < thread_cnt; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      std::mt19937 gen(thread_id);
+      std::uniform_int_distribution<size_t> hot(0, frame_cnt / 10 - 1);
+      std::uniform_int_distribution<size_t> any(0, frame_cnt - 1);
+      std::uniform_int_distribution<size_t> percent(0, 99);
+      uint64_t ops = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        touch(static_cast<bustub::frame_id_t>(percent(gen) < 90 ? hot(gen) : any(gen)));
+        bustub::frame_id_t victim;
+        if (++ops % 10 == 0 && replacer.Evict(&victim)) {
+          touch(victim);
+        }
+      }
+      total_ops += ops;
+    });
+  }
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = ClockMs() - start;
+  return static_cast<double>(total_ops) / static_cast<double>(elapsed) * 1000;
+}
+
+/**
+ * Table layout on disk: BUSTUB_BPM_BENCH_EXTENT_TABLE_CNT threads each fill their own table at the same time, then the
+ * file is dropped from the OS page cache and every table is scanned, one after the other, through a cold buffer pool.
+ * Prints how often a scan moves to a page that is not the next one in the file, and the scan time.
+ */
+void RunExtentBench(bool use_extents) {
+  const std::string db_name = "bpm_bench.db";
+  std::vector<bustub::page_id_t> first_page_ids(BUSTUB_BPM_BENCH_EXTENT_TABLE_CNT);
+  {
+    bustub::DiskManager disk_manager(db_name);
+    std::unique_ptr<bustub::BufferPoolManagerInstance> bpm;
+    if (use_extents) {
+      bpm = std::make_unique<bustub::BufferPoolManagerInstance>(BUSTUB_BPM_BENCH_EXTENT_POOL_SIZE, &disk_manager);
+    } else {
+      bpm = std::make_unique<NoExtentBufferPoolManager>(BUSTUB_BPM_BENCH_EXTENT_POOL_SIZE, &disk_manager);
+    }
+    bustub::Schema schema({bustub::Column("id", bustub::TypeId::INTEGER),
+                           bustub::Column("payload", bustub::TypeId::VARCHAR, 512)});
+    const std::string payload(400, 'x');
+    std::vector<std::thread> threads;
+    for (size_t table_id = 0; table_id < first_page_ids.size(); table_id++) {
+      threads.emplace_back([&, table_id] {
+        bustub::Transaction txn(static_cast<bustub::txn_id_t>(table_id));
+        bustub::TableHeap table(bpm.get(), nullptr, nullptr, &txn);
+        for (size_t i = 0; i < BUSTUB_BPM_BENCH_EXTENT_TUPLE_CNT; i++) {
+          bustub::RID rid;
+          table.InsertTuple(bustub::Tuple({bustub::ValueFactory::GetIntegerValue(static_cast<int32_t>(i)),
+                                           bustub::ValueFactory::GetVarcharValue(payload)},
+                                          &schema),
+                            &rid, &txn);
+          txn.GetWriteSet()->clear();
+        }
+        first_page_ids[table_id] = table.GetFirstPageId();
+      });
+    }
+    for (auto &thread : threads) {
+      thread.join();
+    }
+    bpm->FlushAllPages();
+    disk_manager.ShutDown();
+  }
+  // The file was synced by ShutDown(), so its pages can be dropped from the page cache and the scans read the disk.
+  const int fd = open(db_name.c_str(), O_RDONLY);
+  posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+  close(fd);
+
+  bustub::DiskManager disk_manager(db_name);
+  bustub::BufferPoolManagerInstance bpm(BUSTUB_BPM_BENCH_EXTENT_POOL_SIZE, &disk_manager);
+  bustub::Transaction txn(0);
+  uint64_t page_cnt = 0;
+  uint64_t jump_cnt = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (auto first_page_id : first_page_ids) {
+    bustub::TableHeap table(&bpm, nullptr, nullptr, first_page_id);
+    bustub::page_id_t last_page_id = bustub::INVALID_PAGE_ID;
+    for (auto iter = table.Begin(&txn); iter != table.End(); ++iter) {
+      const bustub::page_id_t page_id = iter->GetRid().GetPageId();
+      if (page_id == last_page_id) {
+        continue;
+      }
+      page_cnt++;
+      if (last_page_id != bustub::INVALID_PAGE_ID && page_id != last_page_id + 1) {
+        jump_cnt++;
+      }
+      last_page_id = page_id;
+    }
+  }
+  const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+  fmt::print("{:>10} {:>12} {:>12} {:>12.1f}\n", use_extents ? "extents" : "page", page_cnt, jump_cnt, elapsed_ms);
+  disk_manager.ShutDown();
+  std::remove(db_name.c_str());
+  std::remove("bpm_bench.log");
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-bpm-bench");
+  program.add_argument("--duration").help("run each data point for n milliseconds");
+  program.add_argument("--instances").help("number of shards for the parallel buffer pool");
+  program.add_argument("--max-threads").help("largest thread count to measure");
+  program.add_argument("--workload")
+      .help(
+          "fetch (FetchPage scaling, default), table (TableHeap updates), scan (OLTP mixed with large scans), "
+          "replacer (LRU-K trace replay), warmup (startup after a restart) or extent (scans of tables filled "
+          "concurrently)");
+  program.add_argument("--bg-clean-target").help("table workload: frames the background writer keeps clean");
+  program.add_argument("--bg-max-writes").help("table workload: background writes per round");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  BpmBenchConfig config;
+  size_t instances = BUSTUB_BPM_BENCH_INSTANCES;
+  if (program.present("--duration")) {
+    config.duration_ms_ = std::stoul(program.get("--duration"));
+  }
+  if (program.present("--instances")) {
+    instances = std::stoul(program.get("--instances"));
+  }
+  if (program.present("--max-threads")) {
+    config.max_thread_ = std::stoul(program.get("--max-threads"));
+  }
+
+  if (program.present("--workload") && program.get("--workload") == "table") {
+    bustub::BackgroundWriterOptions options;
+    if (program.present("--bg-clean-target")) {
+      options.clean_frame_target_ = std::stoul(program.get("--bg-clean-target"));
+    }
+    if (program.present("--bg-max-writes")) {
+      options.max_writes_per_round_ = std::stoul(program.get("--bg-max-writes"));
+    }
+    fmt::print("{:>10} {:>14} {:>12} {:>12}\n", "bg writer", "updates/s", "fg writes", "bg writes");
+    RunTableBench(false, options, BUSTUB_BPM_BENCH_TABLE_THREAD, config.duration_ms_);
+    RunTableBench(true, options, BUSTUB_BPM_BENCH_TABLE_THREAD, config.duration_ms_);
+    return 0;
+  }
+
+  if (program.present("--workload") && program.get("--workload") == "replacer") {
+    fmt::print("{:>8} {:>16} {:>16} {:>8}\n", "threads", "list LRU-K", "frame-indexed", "speedup");
+    for (size_t thread_cnt = 1; thread_cnt <= std::min(config.max_thread_, BUSTUB_BPM_BENCH_REPLACER_MAX_THREAD);
+         thread_cnt *= 2) {
+      auto legacy = RunReplacerBench<LegacyLRUKReplacer>(BUSTUB_BPM_BENCH_REPLACER_FRAME_CNT, thread_cnt,
+                                                         config.duration_ms_);
+      auto current = RunReplacerBench<bustub::LRUKReplacer>(BUSTUB_BPM_BENCH_REPLACER_FRAME_CNT, thread_cnt,
+                                                            config.duration_ms_);
+      fmt::print("{:>8} {:>16.0f} {:>16.0f} {:>7.2f}x\n", thread_cnt, legacy, current, current / legacy);
+    }
+    return 0;
+  }
+
+  if (program.present("--workload") && program.get("--workload") == "warmup") {
+    RunWarmUpBench();
+    return 0;
+  }
+
+  if (program.present("--workload") && program.get("--workload") == "extent") {
+    fmt::print("{:>10} {:>12} {:>12} {:>12}\n", "allocation", "table pages", "page jumps", "scan ms");
+    RunExtentBench(false);
+    RunExtentBench(true);
+    return 0;
+  }
+
+  if (program.present("--workload") && program.get("--workload") == "scan") {
+    fmt::print("{:>10} {:>14} {:>12}\n", "scan via", "hot hit ratio", "disk reads");
+    RunScanBench(false);
+    RunScanBench(true);
+    return 0;
+  }
+
+  fmt::print("{:>8} {:>16} {:>16} {:>8}\n", "threads", "1 instance", fmt::format("{} instances", instances),
+             "speedup");
+  for (size_t thread_cnt = 1; thread_cnt <= config.max_thread_; thread_cnt *= 2) {
+    double result[2];
+    size_t shard_cnt[2] = {1, instances};
+    for (size_t i = 0; i < 2; i++) {
+      bustub::DiskManagerUnlimitedMemory disk_manager;
+      std::vector<bustub::page_id_t> page_ids;
+      auto bpm = MakeBufferPool(shard_cnt[i], config.pool_size_, &disk_manager, config.page_cnt_, &page_ids);
+      result[i] = RunFetchBench(bpm.get(), page_ids, thread_cnt, config.duration_ms_);
+    }
+    fmt::print("{:>8} {:>16.0f} {:>16.0f} {:>7.2f}x\n", thread_cnt, result[0], result[1], result[1] / result[0]);
+  }
+
+  return 0;
+}
@@ -0,0 +1,90 @@
+//===----------------------------------------------------------------------===//
+//
+//                         BusTub
+//
+// legacy_lru_k.h
+//
+// Identification: tools/bpm_bench/legacy_lru_k.h
+//
+// Copyright (c) 2015-2022, Carnegie Mellon University Database Group
+//
+//===----------------------------------------------------------------------===//
+
+#pragma once
+
+#include <unordered_map>
+#include <vector>
+
+#include "common/config.h"
+
+namespace bustub {
+/**
+ *
+ *
+ */
+template <class Key>
+class DoubleLinkedList {
+ public:
+  class Node {
+   public:
+    Node *pre_;
+    Node *next_;
+    Key value_;
+    bool evictable_{true};
+    int visite_count_{0};
+    explicit Node(Key frame_id);
+    Node(Key frame_id, int vc);
+  };
+
+ public:
+  DoubleLinkedList();
+
+ public:
+  Node *head_;
+  int size_{0};
+  auto InsertFront(Key frame_id) -> bool;
+  auto InsertTail(Key frame_id) -> bool;
+
+  auto InsertTailNode(Node *temp) -> bool;
+  auto InsertFrontNode(Node *temp) -> bool;
+  auto RemoveTail(Key *frame_id) -> bool;
+  auto RemoveNodeFromList(Node *node) -> bool;
+  auto FindFirstEvictableNode() -> Node *;
+  inline auto Size() -> int { return size_; }
+  auto InsertOrdered(Node *node) -> bool;
+
+  ~DoubleLinkedList();
+};
+
+/**
+ * The original list based LRU-K: lookups go through hash maps and every new entry allocates a list node. LRUKReplacer
+ * no longer uses it; it is only built into bustub-bpm-bench, as the baseline --workload replacer measures against.
+ */
+class LruK {
+  using Node = DoubleLinkedList<frame_id_t>::Node;
+  using LRU_List = DoubleLinkedList<frame_id_t>;
+  using History_List = DoubleLinkedList<frame_id_t>;
+  using Map = std::unordered_map<frame_id_t, Node *>;
+
+  int capacity_;
+  int k_;
+
+  LRU_List lru_cache_;
+  History_List history_cache_;
+  Map history_map_;
+  Map lru_map_;
+
+ public:
+  LruK(int size, int K);
+  void Access(frame_id_t id);
+  auto Evict(frame_id_t *id) -> bool;
+  auto Contained(frame_id_t id) -> bool;
+  auto SetEvictable(frame_id_t id, bool evictable) -> bool;
+  auto Remove(frame_id_t id) -> bool;
+  auto EvictableFrames(size_t max_cnt) -> std::vector<frame_id_t>;
+
+  auto Size() -> int;
+  auto IsFull() -> bool;
+};
+
+}  // namespace bustub
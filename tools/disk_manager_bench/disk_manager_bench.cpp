@@ -0,0 +1,290 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/parallel_buffer_pool_manager.h"
+#include "fmt/core.h"
+#include "storage/disk/async_disk_manager.h"
+#include "storage/disk/disk_manager.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+static const size_t BUSTUB_DM_BENCH_DURATION_MS = 1000;
+static const size_t BUSTUB_DM_BENCH_PAGE_CNT = 16384;
+static const size_t BUSTUB_DM_BENCH_MAX_THREAD = 16;
+static const size_t BUSTUB_DM_BENCH_WRITE_PERCENT = 20;
+static const size_t BUSTUB_DM_BENCH_BATCH = 32;
+static const size_t BUSTUB_DM_BENCH_FLUSH_INSTANCES = 4;
+static const size_t BUSTUB_DM_BENCH_FLUSH_POOL_SIZE = 4096;
+static const char *BUSTUB_DM_BENCH_DB_FILE = "disk_manager_bench.db";
+static const char *BUSTUB_DM_BENCH_LOG_FILE = "disk_manager_bench.log";
+
+/**
+ * The page I/O of DiskManager before positional I/O: one std::fstream whose shared file position is guarded by a
+ * latch, flushed after every page write.
+ */
+class LegacyDiskManager : public bustub::DiskManager {
+ public:
+  explicit LegacyDiskManager(const std::string &db_file) : DiskManager(db_file) {
+    db_io_.open(db_file, std::ios::binary | std::ios::in | std::ios::out);
+  }
+
+  auto WritePage(bustub::page_id_t page_id, const char *page_data) -> bool override {
+    std::scoped_lock sl(db_io_latch_);
+    db_io_.seekp(static_cast<size_t>(page_id) * bustub::BUSTUB_PAGE_SIZE);
+    db_io_.write(page_data, bustub::BUSTUB_PAGE_SIZE);
+    db_io_.flush();
+    return !db_io_.bad();
+  }
+
+  auto ReadPage(bustub::page_id_t page_id, char *page_data) -> bool override {
+    std::scoped_lock sl(db_io_latch_);
+    db_io_.seekp(static_cast<size_t>(page_id) * bustub::BUSTUB_PAGE_SIZE);
+    db_io_.read(page_data, bustub::BUSTUB_PAGE_SIZE);
+    return !db_io_.bad();
+  }
+
+ private:
+  std::fstream db_io_;
+  std::mutex db_io_latch_;
+};
+
+/** The page writes of FlushAllPages before write coalescing: one pwrite per page, in the order they are handed over. */
+class PageAtATimeDiskManager : public bustub::DiskManager {
+ public:
+  using DiskManager::DiskManager;
+
+  void WritePages(std::vector<std::pair<bustub::page_id_t, const char *>> pages) override {
+    for (const auto &[page_id, page_data] : pages) {
+      WritePage(page_id, page_data);
+    }
+  }
+};
+
+/**
+ * Random page I/O from `thread_cnt` threads over a BUSTUB_DM_BENCH_PAGE_CNT page file, `write_percent` of it writes.
+ * With batch_size 1 every thread calls ReadPage / WritePage, otherwise it hands batch_size requests at a time to
+ * Schedule and waits for all of them.
+ * @return page I/Os per second over all threads
+ */
+auto RunIoBench(bustub::DiskManager *disk_manager, size_t thread_cnt, size_t write_percent, size_t batch_size,
+                uint64_t duration_ms) -> double {
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_ops{0};
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < thread_cnt; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      std::mt19937 gen(thread_id);
+      std::uniform_int_distribution<bustub::page_id_t> page(0, BUSTUB_DM_BENCH_PAGE_CNT - 1);
+      std::uniform_int_distribution<size_t> percent(0, 99);
+      std::vector<char> buf(batch_size * bustub::BUSTUB_PAGE_SIZE, static_cast<char>(thread_id));
+      uint64_t ops = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        if (batch_size == 1) {
+          if (percent(gen) < write_percent) {
+            disk_manager->WritePage(page(gen), buf.data());
+          } else {
+            disk_manager->ReadPage(page(gen), buf.data());
+          }
+        } else {
+          std::vector<bustub::DiskRequest> requests;
+          for (size_t i = 0; i < batch_size; i++) {
+            char *data = buf.data() + i * bustub::BUSTUB_PAGE_SIZE;
+            requests.push_back({percent(gen) < write_percent, page(gen), data, {}});
+          }
+          // 同一批里可能抽到同一个页，读写同一页的请求不能同时在路上
+          std::sort(requests.begin(), requests.end(),
+                    [](const auto &a, const auto &b) { return a.page_id_ < b.page_id_; });
+          auto last = std::unique(requests.begin(), requests.end(),
+                                  [](const auto &a, const auto &b) { return a.page_id_ == b.page_id_; });
+          requests.erase(last, requests.end());
+          ops += requests.size();
+          disk_manager->ScheduleAndWait(std::move(requests));
+          continue;
+        }
+        ops++;
+      }
+      total_ops += ops;
+    });
+  }
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = ClockMs() - start;
+  return static_cast<double>(total_ops) / static_cast<double>(elapsed) * 1000;
+}
+
+/** Write every page of the bench file once, so reads are not served past its end. */
+void CreateBenchFile() {
+  bustub::DiskManager disk_manager(BUSTUB_DM_BENCH_DB_FILE);
+  std::vector<char> page(bustub::BUSTUB_PAGE_SIZE, 'x');
+  for (size_t i = 0; i < BUSTUB_DM_BENCH_PAGE_CNT; i++) {
+    disk_manager.WritePage(static_cast<bustub::page_id_t>(i), page.data());
+  }
+  disk_manager.ShutDown();
+}
+
+/** Page I/O scaling of the fstream DiskManager against the pread / pwrite one. */
+void RunSyncBench(size_t max_thread, size_t write_percent, uint64_t duration_ms) {
+  fmt::print("{:>8} {:>16} {:>16} {:>8}\n", "threads", "fstream", "pread/pwrite", "speedup");
+  for (size_t thread_cnt = 1; thread_cnt <= max_thread; thread_cnt *= 2) {
+    LegacyDiskManager legacy(BUSTUB_DM_BENCH_DB_FILE);
+    auto before = RunIoBench(&legacy, thread_cnt, write_percent, 1, duration_ms);
+    legacy.ShutDown();
+    bustub::DiskManager current(BUSTUB_DM_BENCH_DB_FILE);
+    auto after = RunIoBench(&current, thread_cnt, write_percent, 1, duration_ms);
+    current.ShutDown();
+    fmt::print("{:>8} {:>16.0f} {:>16.0f} {:>7.2f}x\n", thread_cnt, before, after, after / before);
+  }
+}
+
+/**
+ * Page I/O of DiskManager against both AsyncDiskManager backends, through ReadPage / WritePage and through batches of
+ * BUSTUB_DM_BENCH_BATCH requests.
+ */
+void RunAsyncBench(size_t max_thread, size_t write_percent, uint64_t duration_ms) {
+  fmt::print("{:>8} {:>14} {:>14} {:>14} {:>14} {:>14}\n", "threads", "sync", "pool", "pool batch", "io_uring",
+             "io_uring batch");
+  for (size_t thread_cnt = 1; thread_cnt <= max_thread; thread_cnt *= 2) {
+    bustub::DiskManager sync(BUSTUB_DM_BENCH_DB_FILE);
+    auto sync_ops = RunIoBench(&sync, thread_cnt, write_percent, 1, duration_ms);
+    sync.ShutDown();
+    double async_ops[2][2];
+    for (auto backend : {bustub::AsyncDiskManager::Backend::THREAD_POOL, bustub::AsyncDiskManager::Backend::IO_URING}) {
+      bustub::AsyncDiskManager async(BUSTUB_DM_BENCH_DB_FILE, bustub::ASYNC_IO_QUEUE_DEPTH, backend);
+      const size_t row = backend == bustub::AsyncDiskManager::Backend::IO_URING ? 1 : 0;
+      if (async.GetBackend() != backend) {
+        fmt::print("io_uring is not available, measuring the thread pool twice\n");
+      }
+      async_ops[row][0] = RunIoBench(&async, thread_cnt, write_percent, 1, duration_ms);
+      async_ops[row][1] = RunIoBench(&async, thread_cnt, write_percent, BUSTUB_DM_BENCH_BATCH, duration_ms);
+      async.ShutDown();
+    }
+    fmt::print("{:>8} {:>14.0f} {:>14.0f} {:>14.0f} {:>14.0f} {:>14.0f}\n", thread_cnt, sync_ops, async_ops[0][0],
+               async_ops[0][1], async_ops[1][0], async_ops[1][1]);
+  }
+}
+
+struct FlushResult {
+  /** pages written per second of FlushAllPages */
+  double pages_per_sec_;
+  /** pwrite / pwritev calls per FlushAllPages */
+  double calls_per_flush_;
+};
+
+/**
+ * Flush a parallel buffer pool holding the first BUSTUB_DM_BENCH_FLUSH_POOL_SIZE pages of the file over and over,
+ * dirtying `dirty_percent` of them at random before each flush. Only FlushAllPages is timed.
+ */
+auto RunFlushRounds(bustub::DiskManager *disk_manager, size_t dirty_percent, uint64_t duration_ms) -> FlushResult {
+  const size_t instance_pool_size = BUSTUB_DM_BENCH_FLUSH_POOL_SIZE / BUSTUB_DM_BENCH_FLUSH_INSTANCES;
+  bustub::ParallelBufferPoolManager bpm(BUSTUB_DM_BENCH_FLUSH_INSTANCES, instance_pool_size, disk_manager);
+  const auto pool_size = static_cast<bustub::page_id_t>(BUSTUB_DM_BENCH_FLUSH_POOL_SIZE);
+  std::mt19937 gen(0);
+  std::uniform_int_distribution<size_t> percent(0, 99);
+  uint64_t pages = 0;
+  uint64_t flushes = 0;
+  std::chrono::nanoseconds flush_time{0};
+  const int calls_before = disk_manager->GetNumWriteCalls();
+  const auto start = ClockMs();
+  while (ClockMs() - start < duration_ms) {
+    for (bustub::page_id_t page_id = 0; page_id < pool_size; page_id++) {
+      if (percent(gen) >= dirty_percent) {
+        continue;
+      }
+      auto *page = bpm.FetchPage(page_id);
+      page->GetData()[0]++;
+      bpm.UnpinPage(page_id, true);
+      pages++;
+    }
+    const auto flush_start = std::chrono::steady_clock::now();
+    bpm.FlushAllPages();
+    flush_time += std::chrono::steady_clock::now() - flush_start;
+    flushes++;
+  }
+  const auto calls = static_cast<double>(disk_manager->GetNumWriteCalls() - calls_before);
+  const double seconds = std::chrono::duration<double>(flush_time).count();
+  return {static_cast<double>(pages) / seconds, calls / static_cast<double>(flushes)};
+}
+
+/** FlushAllPages writing one page at a time against writing runs of adjacent dirty pages with pwritev. */
+void RunFlushBench(uint64_t duration_ms) {
+  fmt::print("{:>8} {:>14} {:>14} {:>8} {:>18} {:>17}\n", "dirty%", "per page", "coalesced", "speedup",
+             "calls/flush before", "calls/flush after");
+  for (size_t dirty_percent : {5, 25, 50, 100}) {
+    PageAtATimeDiskManager before_dm(BUSTUB_DM_BENCH_DB_FILE);
+    auto before = RunFlushRounds(&before_dm, dirty_percent, duration_ms);
+    before_dm.ShutDown();
+    bustub::DiskManager after_dm(BUSTUB_DM_BENCH_DB_FILE);
+    auto after = RunFlushRounds(&after_dm, dirty_percent, duration_ms);
+    after_dm.ShutDown();
+    fmt::print("{:>8} {:>14.0f} {:>14.0f} {:>7.2f}x {:>18.1f} {:>17.1f}\n", dirty_percent, before.pages_per_sec_,
+               after.pages_per_sec_, after.pages_per_sec_ / before.pages_per_sec_, before.calls_per_flush_,
+               after.calls_per_flush_);
+  }
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-disk-manager-bench");
+  program.add_argument("--duration").help("run each data point for n milliseconds");
+  program.add_argument("--max-threads").help("largest thread count to measure");
+  program.add_argument("--write-percent").help("percentage of page I/Os that are writes");
+  program.add_argument("--workload")
+      .help(
+          "sync (fstream against pread / pwrite, default), async (DiskManager against AsyncDiskManager) or flush "
+          "(FlushAllPages page by page against coalesced)");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = BUSTUB_DM_BENCH_DURATION_MS;
+  size_t max_thread = BUSTUB_DM_BENCH_MAX_THREAD;
+  size_t write_percent = BUSTUB_DM_BENCH_WRITE_PERCENT;
+  if (program.present("--duration")) {
+    duration_ms = std::stoul(program.get("--duration"));
+  }
+  if (program.present("--max-threads")) {
+    max_thread = std::stoul(program.get("--max-threads"));
+  }
+  if (program.present("--write-percent")) {
+    write_percent = std::stoul(program.get("--write-percent"));
+  }
+
+  CreateBenchFile();
+  const std::string workload = program.present("--workload") ? program.get("--workload") : "sync";
+  if (workload == "async") {
+    RunAsyncBench(max_thread, write_percent, duration_ms);
+  } else if (workload == "flush") {
+    RunFlushBench(duration_ms);
+  } else {
+    RunSyncBench(max_thread, write_percent, duration_ms);
+  }
+  std::remove(BUSTUB_DM_BENCH_DB_FILE);
+  std::remove(BUSTUB_DM_BENCH_LOG_FILE);
+  return 0;
+}
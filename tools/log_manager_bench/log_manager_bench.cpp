@@ -0,0 +1,140 @@
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "fmt/core.h"
+#include "recovery/log_manager.h"
+#include "storage/disk/disk_manager_memory.h"
+
+#include <sys/time.h>
+
+auto ClockMs() -> uint64_t {
+  struct timeval tm;
+  gettimeofday(&tm, nullptr);
+  return static_cast<uint64_t>(tm.tv_sec * 1000) + static_cast<uint64_t>(tm.tv_usec / 1000);
+}
+
+static const size_t BUSTUB_LOG_BENCH_DURATION_MS = 1000;
+static const size_t BUSTUB_LOG_BENCH_MAX_THREAD = 32;
+static const size_t BUSTUB_LOG_BENCH_TUPLE_SIZE = 64;
+
+/**
+ * AppendLogRecord before reservation: LSN assignment, the space check and the serialization all run under one latch.
+ * A full buffer is swapped for an empty one on the spot, as if the flush thread were infinitely fast.
+ */
+class LatchedLogBuffer {
+ public:
+  LatchedLogBuffer() : buffer_(bustub::LOG_BUFFER_SIZE) {}
+
+  auto AppendLogRecord(bustub::LogRecord *log_record) -> bustub::lsn_t {
+    std::scoped_lock sl(latch_);
+    const auto size = static_cast<size_t>(log_record->GetSize());
+    if (offset_ + size > buffer_.size()) {
+      offset_ = 0;
+    }
+    const bustub::lsn_t lsn = next_lsn_++;
+    char *pos = buffer_.data() + offset_;
+    const int32_t header[] = {log_record->GetSize(), lsn, log_record->GetTxnId(), log_record->GetPrevLSN(),
+                              static_cast<int32_t>(log_record->GetLogRecordType())};
+    memcpy(pos, header, sizeof(header));
+    memcpy(pos + sizeof(header), &log_record->GetInsertRID(), sizeof(bustub::RID));
+    log_record->GetInsertTuple().SerializeTo(pos + sizeof(header) + sizeof(bustub::RID));
+    offset_ += size;
+    return lsn;
+  }
+
+ private:
+  std::mutex latch_;
+  std::vector<char> buffer_;
+  size_t offset_{0};
+  bustub::lsn_t next_lsn_{0};
+};
+
+/**
+ * Append INSERT records of a tuple_size byte tuple from `thread_cnt` threads for duration_ms.
+ * @return records appended per second over all threads
+ */
+template <typename Log>
+auto RunAppendBench(Log *log, size_t thread_cnt, size_t tuple_size, uint64_t duration_ms) -> double {
+  std::atomic<bool> stop{false};
+  std::atomic<uint64_t> total_appends{0};
+  std::vector<std::thread> threads;
+  for (size_t thread_id = 0; thread_id < thread_cnt; thread_id++) {
+    threads.emplace_back([&, thread_id] {
+      // Tuple的序列化格式是 | size | data |
+      std::vector<char> storage(sizeof(int32_t) + tuple_size, static_cast<char>(thread_id));
+      const auto size = static_cast<int32_t>(tuple_size);
+      memcpy(storage.data(), &size, sizeof(int32_t));
+      bustub::Tuple tuple;
+      tuple.DeserializeFrom(storage.data());
+      const auto txn_id = static_cast<bustub::txn_id_t>(thread_id);
+      bustub::lsn_t prev_lsn = bustub::INVALID_LSN;
+      uint64_t appends = 0;
+      while (!stop.load(std::memory_order_relaxed)) {
+        bustub::LogRecord log_record(txn_id, prev_lsn, bustub::LogRecordType::INSERT, bustub::RID(0, static_cast<uint32_t>(appends)), tuple);
+        prev_lsn = log->AppendLogRecord(&log_record);
+        appends++;
+      }
+      total_appends += appends;
+    });
+  }
+  auto start = ClockMs();
+  std::this_thread::sleep_for(std::chrono::milliseconds(duration_ms));
+  stop = true;
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto elapsed = ClockMs() - start;
+  return static_cast<double>(total_appends) / static_cast<double>(elapsed) * 1000;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-log-manager-bench");
+  program.add_argument("--duration").help("run each data point for n milliseconds");
+  program.add_argument("--max-threads").help("largest thread count to measure");
+  program.add_argument("--tuple-size").help("bytes of the tuple in each INSERT record");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  uint64_t duration_ms = BUSTUB_LOG_BENCH_DURATION_MS;
+  size_t max_thread = BUSTUB_LOG_BENCH_MAX_THREAD;
+  size_t tuple_size = BUSTUB_LOG_BENCH_TUPLE_SIZE;
+  if (program.present("--duration")) {
+    duration_ms = std::stoul(program.get("--duration"));
+  }
+  if (program.present("--max-threads")) {
+    max_thread = std::stoul(program.get("--max-threads"));
+  }
+  if (program.present("--tuple-size")) {
+    tuple_size = std::stoul(program.get("--tuple-size"));
+  }
+
+  // 只测追加的路径：内存里的disk manager没有日志文件，刷盘线程的WriteLog不做I/O
+  bustub::DiskManagerUnlimitedMemory disk_manager;
+  bustub::LogManager log_manager(&disk_manager);
+  log_manager.RunFlushThread();
+
+  fmt::print("{:>8} {:>16} {:>16} {:>8}\n", "threads", "latched", "reservation", "speedup");
+  for (size_t thread_cnt = 1; thread_cnt <= max_thread; thread_cnt *= 2) {
+    LatchedLogBuffer latched;
+    auto before = RunAppendBench(&latched, thread_cnt, tuple_size, duration_ms);
+    auto after = RunAppendBench(&log_manager, thread_cnt, tuple_size, duration_ms);
+    fmt::print("{:>8} {:>16.0f} {:>16.0f} {:>7.2f}x\n", thread_cnt, before, after, after / before);
+  }
+
+  log_manager.StopFlushThread();
+  return 0;
+}
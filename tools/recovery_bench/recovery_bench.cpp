@@ -0,0 +1,154 @@
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/buffer_pool_manager_instance.h"
+#include "concurrency/lock_manager.h"
+#include "concurrency/transaction_manager.h"
+#include "fmt/core.h"
+#include "recovery/log_manager.h"
+#include "recovery/log_recovery.h"
+#include "storage/disk/disk_manager.h"
+#include "storage/table/table_heap.h"
+#include "type/value_factory.h"
+
+static const char *BUSTUB_RECOVERY_BENCH_DB = "recovery_bench.db";
+static const char *BUSTUB_RECOVERY_BENCH_LOG = "recovery_bench.log";
+static const size_t BUSTUB_RECOVERY_BENCH_LOG_SIZE_MB = 1024;
+static const size_t BUSTUB_RECOVERY_BENCH_MAX_WORKERS = 8;
+static const size_t BUSTUB_RECOVERY_BENCH_POOL_SIZE = 256;
+static const size_t BUSTUB_RECOVERY_BENCH_ROWS = 8192;
+static const size_t BUSTUB_RECOVERY_BENCH_TUPLE_SIZE = 256;
+static const size_t BUSTUB_RECOVERY_BENCH_TXN_SIZE = 1000;
+
+/** Drop the pages of a file from the OS cache, so every data point starts with a cold cache. */
+void DropFromPageCache(const std::string &file_name) {
+  int fd = open(file_name.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+/**
+ * Load `rows` rows into a table, then update random rows until the log reaches log_size bytes. The buffer pool is
+ * smaller than the table, so the database file ends up holding pages of many ages, like after a crash.
+ */
+void GenerateLog(size_t log_size, size_t pool_size, size_t rows, size_t tuple_size) {
+  bustub::Schema schema{std::vector<bustub::Column>{{"a", bustub::TypeId::INTEGER},
+                                                    {"b", bustub::TypeId::VARCHAR, static_cast<uint32_t>(tuple_size)}}};
+  auto make_tuple = [&](size_t a, char c) {
+    std::vector<bustub::Value> values{bustub::ValueFactory::GetIntegerValue(static_cast<int32_t>(a)),
+                                      bustub::ValueFactory::GetVarcharValue(std::string(tuple_size, c))};
+    return bustub::Tuple{values, &schema};
+  };
+
+  bustub::DiskManager disk_manager(BUSTUB_RECOVERY_BENCH_DB);
+  bustub::LogManager log_manager(&disk_manager);
+  bustub::BufferPoolManagerInstance bpm(pool_size, &disk_manager, bustub::LRUK_REPLACER_K, &log_manager);
+  bustub::LockManager lock_manager;
+  bustub::TransactionManager txn_manager(&lock_manager, &log_manager);
+  log_manager.RunFlushThread();
+
+  auto *txn = txn_manager.Begin();
+  bustub::TableHeap table(&bpm, &lock_manager, &log_manager, txn);
+  std::vector<bustub::RID> rids(rows);
+  for (size_t i = 0; i < rows; i++) {
+    table.InsertTuple(make_tuple(i, 'a'), &rids[i], txn);
+  }
+  txn_manager.Commit(txn);
+  delete txn;
+
+  std::mt19937 gen(15445);
+  std::uniform_int_distribution<size_t> row_dis(0, rows - 1);
+  size_t updates = 0;
+  while (static_cast<size_t>(std::filesystem::file_size(BUSTUB_RECOVERY_BENCH_LOG)) < log_size) {
+    txn = txn_manager.Begin();
+    for (size_t i = 0; i < BUSTUB_RECOVERY_BENCH_TXN_SIZE; i++, updates++) {
+      auto row = row_dis(gen);
+      table.UpdateTuple(make_tuple(row, static_cast<char>('a' + updates % 26)), rids[row], txn);
+    }
+    txn_manager.Commit(txn);
+    delete txn;
+  }
+  log_manager.StopFlushThread();
+  fmt::print("log: {} MB, {} updates over {} rows\n", std::filesystem::file_size(BUSTUB_RECOVERY_BENCH_LOG) >> 20,
+             updates, rows);
+}
+
+/** @return the seconds Redo takes with `workers` threads, starting from the database file as it was at the crash */
+auto RunRedo(size_t workers, size_t pool_size) -> double {
+  const std::string db_file = BUSTUB_RECOVERY_BENCH_DB;
+  std::filesystem::copy_file(db_file + ".crash", db_file, std::filesystem::copy_options::overwrite_existing);
+  DropFromPageCache(db_file);
+  DropFromPageCache(BUSTUB_RECOVERY_BENCH_LOG);
+
+  bustub::DiskManager disk_manager(db_file);
+  bustub::BufferPoolManagerInstance bpm(pool_size, &disk_manager);
+  bustub::LogRecovery log_recovery(&disk_manager, &bpm, nullptr, workers);
+  auto start = std::chrono::steady_clock::now();
+  log_recovery.Redo();
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+  return elapsed.count();
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-recovery-bench");
+  program.add_argument("--log-size").help("MB of log to generate and replay");
+  program.add_argument("--max-workers").help("largest number of redo workers to measure");
+  program.add_argument("--pool-size").help("frames in the buffer pool");
+  program.add_argument("--reuse-log").help("replay the log of the last run instead of generating one")
+      .default_value(false)
+      .implicit_value(true);
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  size_t log_size_mb = BUSTUB_RECOVERY_BENCH_LOG_SIZE_MB;
+  size_t max_workers = BUSTUB_RECOVERY_BENCH_MAX_WORKERS;
+  size_t pool_size = BUSTUB_RECOVERY_BENCH_POOL_SIZE;
+  if (program.present("--log-size")) {
+    log_size_mb = std::stoul(program.get("--log-size"));
+  }
+  if (program.present("--max-workers")) {
+    max_workers = std::stoul(program.get("--max-workers"));
+  }
+  if (program.present("--pool-size")) {
+    pool_size = std::stoul(program.get("--pool-size"));
+  }
+
+  const std::string db_file = BUSTUB_RECOVERY_BENCH_DB;
+  if (!program.get<bool>("--reuse-log") || !std::filesystem::exists(db_file + ".crash")) {
+    std::remove(BUSTUB_RECOVERY_BENCH_DB);
+    std::remove(BUSTUB_RECOVERY_BENCH_LOG);
+    GenerateLog(log_size_mb << 20, pool_size, BUSTUB_RECOVERY_BENCH_ROWS, BUSTUB_RECOVERY_BENCH_TUPLE_SIZE);
+    // 每次重放都从崩溃时的数据文件开始，否则上一次重放写回的页会让后面的重放跳过记录
+    std::filesystem::copy_file(db_file, db_file + ".crash", std::filesystem::copy_options::overwrite_existing);
+  }
+
+  fmt::print("{:>8} {:>12} {:>12} {:>8}\n", "workers", "redo (s)", "MB/s", "speedup");
+  double serial = 0;
+  for (size_t workers = 1; workers <= max_workers; workers *= 2) {
+    auto seconds = RunRedo(workers, pool_size);
+    if (workers == 1) {
+      serial = seconds;
+    }
+    auto log_mb = static_cast<double>(std::filesystem::file_size(BUSTUB_RECOVERY_BENCH_LOG) >> 20);
+    fmt::print("{:>8} {:>12.2f} {:>12.1f} {:>7.2f}x\n", workers, seconds, log_mb / seconds, serial / seconds);
+  }
+  return 0;
+}
@@ -0,0 +1,230 @@
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "argparse/argparse.hpp"
+#include "buffer/replacer.h"
+#include "common/config.h"
+#include "fmt/core.h"
+
+/*
+ * Replays a page access trace against every replacement policy and reports the miss ratio, i.e. the fraction of
+ * accesses that would have to read the page from disk. Only the replacer is exercised: the pool is simulated with a
+ * page table and a free list, pages are pinned and unpinned around each access like the buffer pool does.
+ *
+ * A trace file holds one page id per line; empty lines and lines starting with '#' are ignored. Without --trace, a
+ * synthetic trace is generated (see --workload).
+ */
+
+static const size_t REPLAY_FRAMES = 256;
+static const size_t REPLAY_PAGES = 1024;
+static const size_t REPLAY_ACCESSES = 200000;
+static const double REPLAY_ZIPF_THETA = 0.99;
+
+using bustub::frame_id_t;
+using bustub::page_id_t;
+using bustub::ReplacerType;
+
+struct ReplayResult {
+  size_t accesses_{0};
+  size_t misses_{0};
+};
+
+auto LoadTrace(const std::string &path) -> std::vector<page_id_t> {
+  std::ifstream in(path);
+  if (!in) {
+    throw std::runtime_error(fmt::format("cannot open trace file {}", path));
+  }
+  std::vector<page_id_t> trace;
+  std::string line;
+  while (std::getline(in, line)) {
+    auto start = line.find_first_not_of(" \t\r");
+    if (start == std::string::npos || line[start] == '#') {
+      continue;
+    }
+    trace.push_back(static_cast<page_id_t>(std::stol(line.substr(start))));
+  }
+  return trace;
+}
+
+/** Sample page ids in [0, page_cnt) with a zipfian skew; page 0 is the hottest. */
+class ZipfGenerator {
+ public:
+  ZipfGenerator(size_t page_cnt, double theta) : cdf_(page_cnt) {
+    double sum = 0;
+    for (size_t i = 0; i < page_cnt; i++) {
+      sum += 1.0 / std::pow(static_cast<double>(i + 1), theta);
+      cdf_[i] = sum;
+    }
+    for (auto &value : cdf_) {
+      value /= sum;
+    }
+  }
+
+  auto Next(std::mt19937_64 &gen) -> page_id_t {
+    const double u = std::uniform_real_distribution<double>(0, 1)(gen);
+    const auto it = std::lower_bound(cdf_.begin(), cdf_.end(), u);
+    return static_cast<page_id_t>(std::min<size_t>(it - cdf_.begin(), cdf_.size() - 1));
+  }
+
+ private:
+  std::vector<double> cdf_;
+};
+
+/**
+ * Generate a synthetic trace.
+ * - zipf: skewed point lookups over page_cnt pages.
+ * - loop: a table of page_cnt pages scanned over and over, the classic LRU worst case when it does not fit.
+ * - mixed: zipf lookups interleaved one-to-one with a sequential scan over a table four times as large.
+ */
+auto GenerateTrace(const std::string &workload, size_t page_cnt, size_t access_cnt, double theta, uint64_t seed)
+    -> std::vector<page_id_t> {
+  std::mt19937_64 gen(seed);
+  ZipfGenerator zipf(page_cnt, theta);
+  std::vector<page_id_t> trace;
+  trace.reserve(access_cnt);
+  const size_t scan_pages = 4 * page_cnt;
+  for (size_t i = 0; i < access_cnt; i++) {
+    if (workload == "zipf") {
+      trace.push_back(zipf.Next(gen));
+    } else if (workload == "loop") {
+      trace.push_back(static_cast<page_id_t>(i % page_cnt));
+    } else if (workload == "mixed") {
+      trace.push_back(i % 2 == 0 ? zipf.Next(gen) : static_cast<page_id_t>(page_cnt + (i / 2) % scan_pages));
+    } else {
+      throw std::runtime_error(fmt::format("unknown workload {}", workload));
+    }
+  }
+  return trace;
+}
+
+auto Replay(ReplacerType type, size_t frame_cnt, size_t k, const std::vector<page_id_t> &trace) -> ReplayResult {
+  auto replacer = bustub::MakeReplacer(type, frame_cnt, k);
+  std::unordered_map<page_id_t, frame_id_t> page_table;
+  std::vector<page_id_t> frame_pages(frame_cnt, bustub::INVALID_PAGE_ID);
+  std::vector<frame_id_t> free_list;
+  for (size_t i = frame_cnt; i > 0; i--) {
+    free_list.push_back(static_cast<frame_id_t>(i - 1));
+  }
+
+  ReplayResult result;
+  for (auto page_id : trace) {
+    result.accesses_++;
+    frame_id_t frame_id;
+    auto it = page_table.find(page_id);
+    if (it != page_table.end()) {
+      frame_id = it->second;
+    } else {
+      result.misses_++;
+      if (!free_list.empty()) {
+        frame_id = free_list.back();
+        free_list.pop_back();
+      } else {
+        if (!replacer->Evict(&frame_id)) {
+          throw std::runtime_error("replacer has no evictable frame");
+        }
+        page_table.erase(frame_pages[frame_id]);
+      }
+      frame_pages[frame_id] = page_id;
+      page_table[page_id] = frame_id;
+    }
+    // FetchPage + UnpinPage
+    replacer->RecordAccess(frame_id, page_id);
+    replacer->SetEvictable(frame_id, false);
+    replacer->SetEvictable(frame_id, true);
+  }
+  return result;
+}
+
+auto ParsePolicies(const std::string &list) -> std::vector<ReplacerType> {
+  std::vector<ReplacerType> policies;
+  std::stringstream ss(list);
+  std::string name;
+  while (std::getline(ss, name, ',')) {
+    auto type = bustub::ReplacerTypeFromString(name);
+    if (!type.has_value()) {
+      throw std::runtime_error(fmt::format("unknown replacement policy {}", name));
+    }
+    policies.push_back(*type);
+  }
+  return policies;
+}
+
+// NOLINTNEXTLINE
+auto main(int argc, char **argv) -> int {
+  argparse::ArgumentParser program("bustub-replacer-replay");
+  program.add_argument("--trace").help("trace file, one page id per line");
+  program.add_argument("--workload").help("synthetic trace when no --trace is given: zipf (default), loop or mixed");
+  program.add_argument("--frames").help("buffer pool size in frames");
+  program.add_argument("--k").help("lookback constant of LRU-K");
+  program.add_argument("--pages").help("synthetic trace: number of distinct (hot) pages");
+  program.add_argument("--accesses").help("synthetic trace: number of accesses");
+  program.add_argument("--theta").help("synthetic trace: zipf skew");
+  program.add_argument("--seed").help("synthetic trace: random seed");
+  program.add_argument("--policies").help("comma separated, e.g. lru-k,lru,clock,arc,2q,clock-pro (default all)");
+  program.add_argument("--dump").help("write the replayed trace to this file");
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::runtime_error &err) {
+    std::cerr << err.what() << std::endl;
+    std::cerr << program;
+    return 1;
+  }
+
+  try {
+    size_t frame_cnt = REPLAY_FRAMES;
+    if (program.present("--frames")) {
+      frame_cnt = std::stoul(program.get("--frames"));
+    }
+    size_t k = bustub::LRUK_REPLACER_K;
+    if (program.present("--k")) {
+      k = std::stoul(program.get("--k"));
+    }
+    std::vector<ReplacerType> policies{ReplacerType::LRU_K, ReplacerType::LRU,       ReplacerType::CLOCK,
+                                       ReplacerType::ARC,   ReplacerType::TWO_QUEUE, ReplacerType::CLOCK_PRO};
+    if (program.present("--policies")) {
+      policies = ParsePolicies(program.get("--policies"));
+    }
+
+    std::vector<page_id_t> trace;
+    std::string source;
+    if (program.present("--trace")) {
+      source = program.get("--trace");
+      trace = LoadTrace(source);
+    } else {
+      std::string workload = program.present("--workload") ? program.get("--workload") : "zipf";
+      size_t page_cnt = program.present("--pages") ? std::stoul(program.get("--pages")) : REPLAY_PAGES;
+      size_t access_cnt = program.present("--accesses") ? std::stoul(program.get("--accesses")) : REPLAY_ACCESSES;
+      double theta = program.present("--theta") ? std::stod(program.get("--theta")) : REPLAY_ZIPF_THETA;
+      uint64_t seed = program.present("--seed") ? std::stoull(program.get("--seed")) : 15445;
+      source = fmt::format("{} pages={} theta={}", workload, page_cnt, theta);
+      trace = GenerateTrace(workload, page_cnt, access_cnt, theta, seed);
+    }
+    if (program.present("--dump")) {
+      std::ofstream out(program.get("--dump"));
+      for (auto page_id : trace) {
+        out << page_id << "\n";
+      }
+    }
+
+    fmt::print("trace: {}, {} accesses, {} frames, lru-k k={}\n", source, trace.size(), frame_cnt, k);
+    fmt::print("{:<10} {:>10} {:>10}\n", "policy", "misses", "miss ratio");
+    for (auto type : policies) {
+      auto result = Replay(type, frame_cnt, k, trace);
+      double ratio = result.accesses_ == 0 ? 0 : static_cast<double>(result.misses_) / result.accesses_;
+      fmt::print("{:<10} {:>10} {:>10.4f}\n", bustub::ReplacerTypeToString(type), result.misses_, ratio);
+    }
+  } catch (const std::exception &err) {
+    std::cerr << err.what() << std::endl;
+    return 1;
+  }
+  return 0;
+}
@@ -1,4 +1,5 @@
 #include <chrono>
+#include <cstdio>
 #include <iostream>
 #include <memory>
 #include <mutex>  // NOLINT
@@ -15,6 +16,7 @@
 #include "common/util/string_util.h"
 #include "concurrency/transaction.h"
 #include "concurrency/transaction_manager.h"
+#include "recovery/log_manager.h"
 #include "fmt/core.h"
 #include "fmt/std.h"
 #include "terrier_bench_config.h"
@@ -120,6 +122,9 @@ auto main(int argc, char **argv) -> int {
   program.add_argument("--duration").help("run terrier bench for n milliseconds");
   program.add_argument("--force-create-index").help("create index in terrier bench");
   program.add_argument("--force-enable-update").help("use update statement in terrier bench");
+  program.add_argument("--threads").help("number of update threads");
+  program.add_argument("--enable-logging").help("write-ahead log every transaction to a log file on disk");
+  program.add_argument("--synchronous-commit").help("off to return from commit before the commit record is durable");
 
   try {
     program.parse_args(argc, argv);
@@ -129,7 +134,26 @@ auto main(int argc, char **argv) -> int {
     return 1;
   }
 
-  auto bustub = std::make_unique<bustub::BustubInstance>();
+  bool enable_logging = false;
+  if (program.present("--enable-logging")) {
+    enable_logging = ParseBool(program.get("--enable-logging"));
+  }
+
+  size_t update_threads = BUSTUB_TERRIER_THREAD;
+  if (program.present("--threads")) {
+    update_threads = std::stoi(program.get("--threads"));
+  }
+
+  // 记日志时用磁盘上的db文件，日志写到terrier.log里
+  std::unique_ptr<bustub::BustubInstance> bustub;
+  if (enable_logging) {
+    remove("terrier.db");
+    remove("terrier.log");
+    remove("terrier.db.pool");
+    bustub = std::make_unique<bustub::BustubInstance>("terrier.db");
+  } else {
+    bustub = std::make_unique<bustub::BustubInstance>();
+  }
   auto writer = bustub::SimpleStreamWriter(std::cerr);
 
   // create schema
@@ -205,6 +229,20 @@ auto main(int argc, char **argv) -> int {
     }
   }
 
+  // 初始数据不记日志，只测压测期间的提交
+  int log_flushes_before = 0;
+  if (enable_logging) {
+    std::cerr << "x: write-ahead logging enabled" << std::endl;
+    bustub->log_manager_->RunFlushThread();
+    log_flushes_before = bustub->disk_manager_->GetNumFlushes();
+  }
+  if (program.present("--synchronous-commit")) {
+    auto set = fmt::format("SET synchronous_commit = {};", program.get("--synchronous-commit"));
+    bustub->ExecuteSql(set, writer);
+    std::cerr << "x: synchronous commit " << (bustub->IsSynchronousCommit() ? "on" : "off") << std::endl;
+  }
+  std::cerr << "x: " << update_threads << " update threads" << std::endl;
+
   std::cerr << "x: benchmark start" << std::endl;
 
   std::vector<std::thread> threads;
@@ -212,9 +250,9 @@ auto main(int argc, char **argv) -> int {
 
   total_metrics.Begin();
 
-  for (size_t thread_id = 0; thread_id < BUSTUB_TERRIER_THREAD; thread_id++) {
-    threads.emplace_back(std::thread([thread_id, &bustub, enable_update, duration_ms, &total_metrics] {
-      const size_t nft_range_size = BUSTUB_NFT_NUM / BUSTUB_TERRIER_THREAD;
+  for (size_t thread_id = 0; thread_id < update_threads; thread_id++) {
+    threads.emplace_back(std::thread([thread_id, &bustub, enable_update, duration_ms, update_threads, &total_metrics] {
+      const size_t nft_range_size = BUSTUB_NFT_NUM / update_threads;
       const size_t nft_range_begin = thread_id * nft_range_size;
       const size_t nft_range_end = (thread_id + 1) * nft_range_size;
       std::random_device r;
@@ -360,5 +398,13 @@ auto main(int argc, char **argv) -> int {
 
   total_metrics.Report();
 
+  if (enable_logging) {
+    // 每次刷日志都是一次fdatasync，一次刷盘覆盖的提交越多，group commit的效果越好
+    const int log_flushes = bustub->disk_manager_->GetNumFlushes() - log_flushes_before;
+    const uint64_t commits = total_metrics.committed_update_txn_cnt_ + total_metrics.committed_count_txn_cnt_;
+    fmt::print("log flushes: {}, commits per flush: {:.2f}\n", log_flushes,
+               log_flushes == 0 ? 0.0 : static_cast<double>(commits) / log_flushes);
+  }
+
   return 0;
 }